@@ -772,6 +772,25 @@ gst_dash_demux_setup_mpdparser_streams (GstDashDemux * demux,
   return has_streams;
 }
 
+/* Tells the buffer based bitrate selection which bitrates can be picked */
+static void
+gst_dash_demux_stream_set_abr_bitrates (GstDashDemuxStream * stream,
+    GList * rep_list)
+{
+  GArray *bitrates = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+  for (; rep_list != NULL; rep_list = rep_list->next) {
+    GstMPDRepresentationNode *rep = rep_list->data;
+    guint64 bitrate = rep->bandwidth;
+
+    g_array_append_val (bitrates, bitrate);
+  }
+
+  gst_adaptive_demux_abr_set_bitrates (GST_ADAPTIVE_DEMUX_STREAM_CAST
+      (stream)->abr, (const guint64 *) bitrates->data, bitrates->len);
+  g_array_free (bitrates, TRUE);
+}
+
 static gboolean
 gst_dash_demux_setup_all_streams (GstDashDemux * demux)
 {
@@ -863,6 +882,9 @@ gst_dash_demux_setup_all_streams (GstDashDemux * demux)
     stream->target_time = GST_CLOCK_TIME_NONE;
     /* Set a default average keyframe download time of a quarter of a second */
     stream->average_download_time = 250 * GST_MSECOND;
+    if (active_stream->cur_adapt_set)
+      gst_dash_demux_stream_set_abr_bitrates (stream,
+          active_stream->cur_adapt_set->Representations);
 
     if (active_stream->cur_adapt_set &&
         GST_MPD_REPRESENTATION_BASE_NODE (active_stream->
@@ -109,6 +109,8 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static gboolean gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream *
+    stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
@@ -178,6 +180,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment_info =
+      gst_hls_demux_peek_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
@@ -289,7 +293,7 @@ gst_hls_demux_set_current (GstHLSDemux * self, GstM3U8 * m3u8)
   if (m3u8 != self->current) {
     self->current = m3u8;
     self->current->duration = GST_CLOCK_TIME_NONE;
-    self->current->current_file = NULL;
+    self->current->current_file = -1;
 
 #if 0
     // FIXME: this makes no sense after we just set self->current=m3u8 above (tpm)
@@ -409,15 +413,17 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GList *walk;
-  GstClockTime current_pos;
+  GstM3U8 *m3u8 = hls_stream->playlist;
+  GstClockTime first_pos, current_pos;
   gint64 current_sequence;
   gboolean snap_after, snap_nearest;
   GstM3U8MediaFile *file = NULL;
+  guint n_files, idx;
+  gint target = -1;
 
   current_sequence = 0;
-  current_pos = gst_m3u8_is_live (hls_stream->playlist) ?
-      hls_stream->playlist->first_file_start : 0;
+  first_pos = gst_m3u8_is_live (m3u8) ? m3u8->first_file_start : 0;
+  current_pos = first_pos;
 
   /* Snap to segment boundary. Improves seek performance on slow machines. */
   snap_nearest =
@@ -426,40 +432,60 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
-    file = walk->data;
-
-    current_sequence = file->sequence;
-    if ((forward && snap_after) || snap_nearest) {
-      if (current_pos >= ts)
-        break;
-      if (snap_nearest && ts - current_pos < file->duration / 2)
-        break;
-    } else if (!forward && snap_after) {
-      /* check if the next fragment is our target, in this case we want to
-       * start from the previous fragment */
-      GstClockTime next_pos = current_pos + file->duration;
-
-      if (next_pos <= ts && ts < next_pos + file->duration) {
-        break;
-      }
-    } else if (current_pos <= ts && ts < current_pos + file->duration) {
-      break;
+  n_files = m3u8->files->len;
+  if (ts >= first_pos)
+    idx = gst_m3u8_find_file_index (m3u8, ts - first_pos);
+  else
+    idx = 0;
+
+  if ((forward && snap_after) || snap_nearest) {
+    /* the file containing ts if it starts right there or, when snapping to
+     * the nearest boundary, if its start is closer than its end */
+    if (idx < n_files) {
+      file = g_ptr_array_index (m3u8->files, idx);
+      current_pos = first_pos + file->start;
+      if (current_pos >= ts
+          || (snap_nearest && ts - current_pos < file->duration / 2))
+        target = idx;
+      else if (idx + 1 < n_files)
+        target = idx + 1;
     }
-    current_pos += file->duration;
+  } else if (!forward && snap_after) {
+    /* check if the next fragment is our target, in this case we want to
+     * start from the previous fragment */
+    if (ts >= first_pos && idx > 0) {
+      GstClockTime next_pos;
+
+      file = g_ptr_array_index (m3u8->files, idx - 1);
+      next_pos = first_pos + file->start + file->duration;
+      if (next_pos <= ts && ts < next_pos + file->duration)
+        target = idx - 1;
+    }
+  } else if (ts >= first_pos && idx < n_files) {
+    target = idx;
   }
 
-  if (walk == NULL) {
+  if (target >= 0) {
+    file = g_ptr_array_index (m3u8->files, target);
+    current_sequence = file->sequence;
+    current_pos = first_pos + file->start;
+  } else {
     GST_DEBUG_OBJECT (stream->pad, "seeking further than track duration");
+    file = NULL;
+    if (n_files > 0) {
+      file = g_ptr_array_index (m3u8->files, n_files - 1);
+      current_sequence = file->sequence;
+      current_pos = first_pos + file->start + file->duration;
+    }
     current_sequence++;
   }
 
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
-  hls_stream->playlist->sequence = current_sequence;
-  hls_stream->playlist->current_file = walk;
-  hls_stream->playlist->sequence_position = current_pos;
+  m3u8->sequence = current_sequence;
+  m3u8->current_file = target;
+  m3u8->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -487,6 +513,36 @@ gst_hls_demux_update_manifest (GstAdaptiveDemux * demux)
   return GST_FLOW_OK;
 }
 
+/* Tells the buffer based bitrate selection which bitrates can be picked */
+static void
+gst_hls_demux_stream_set_abr_bitrates (GstHLSDemux * hlsdemux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstHLSVariantStream *current = hlsdemux->current_variant;
+  GArray *bitrates;
+  GList *l;
+
+  if (hlsdemux->master == NULL || hlsdemux->master->is_simple
+      || current == NULL)
+    return;
+
+  bitrates = g_array_new (FALSE, FALSE, sizeof (guint64));
+  if (current->iframe)
+    l = hlsdemux->master->iframe_variants;
+  else
+    l = hlsdemux->master->variants;
+  for (; l != NULL; l = l->next) {
+    GstHLSVariantStream *variant = l->data;
+    guint64 bitrate = MAX (variant->bandwidth, 0);
+
+    g_array_append_val (bitrates, bitrate);
+  }
+
+  gst_adaptive_demux_abr_set_bitrates (stream->abr,
+      (const guint64 *) bitrates->data, bitrates->len);
+  g_array_free (bitrates, TRUE);
+}
+
 static void
 create_stream_for_playlist (GstAdaptiveDemux * demux, GstM3U8 * playlist,
     gboolean is_primary_playlist, gboolean selected)
@@ -514,6 +570,8 @@ create_stream_for_playlist (GstAdaptiveDemux * demux, GstM3U8 * playlist,
 
   hlsdemux_stream->playlist = gst_m3u8_ref (playlist);
   hlsdemux_stream->is_primary_playlist = is_primary_playlist;
+  if (is_primary_playlist)
+    gst_hls_demux_stream_set_abr_bitrates (hlsdemux, stream);
 
   hlsdemux_stream->do_typefind = TRUE;
   hlsdemux_stream->reset_pts = TRUE;
@@ -1303,6 +1361,32 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (GST_HLS_DEMUX_STREAM_CAST (stream));
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, n);
+  if (file == NULL)
+    return FALSE;
+
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1682,10 +1766,10 @@ retry:
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
-    last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+    last_sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->files->len - 1))->sequence;
     first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1703,7 +1787,7 @@ retry:
   } else if (!gst_m3u8_is_live (m3u8)) {
     GstClockTime current_pos, target_pos;
     guint sequence = 0;
-    GList *walk;
+    guint idx;
 
     /* Sequence numbers are not guaranteed to be the same in different
      * playlists, so get the correct fragment here based on the current
@@ -1727,19 +1811,19 @@ retry:
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
     current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
-      GstM3U8MediaFile *file = walk->data;
+    idx = gst_m3u8_find_file_index (m3u8, target_pos);
+    if (idx < m3u8->files->len) {
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, idx);
 
       sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
-      }
-      current_pos += file->duration;
+      current_pos = file->start;
+    } else if (idx > 0) {
+      /* End of playlist */
+      GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, idx - 1);
+
+      sequence = file->sequence + 1;
+      current_pos = file->start + file->duration;
     }
-    /* End of playlist */
-    if (!walk)
-      sequence++;
     m3u8->sequence = sequence;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
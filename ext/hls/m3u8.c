@@ -43,7 +43,9 @@ gst_m3u8_new (void)
 
   m3u8 = g_new0 (GstM3U8, 1);
 
-  m3u8->current_file = NULL;
+  m3u8->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_m3u8_media_file_unref);
+  m3u8->current_file = -1;
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
   m3u8->sequence_position = 0;
@@ -105,8 +107,7 @@ gst_m3u8_unref (GstM3U8 * self)
     g_free (self->base_uri);
     g_free (self->name);
 
-    g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (self->files);
+    g_ptr_array_unref (self->files);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -342,116 +343,47 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
   return vs_a->bandwidth - vs_b->bandwidth;
 }
 
-/* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
- * the client SHOULD halt playback (6.3.4), which is what we do then. */
-static gboolean
-check_media_seqnums (GstM3U8 * self, GList * previous_files)
-{
-  GList *l, *m;
-  GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
-
-  g_return_val_if_fail (previous_files, FALSE);
-
-  if (!self->files) {
-    /* Empty playlists are trivially consistent */
-    return TRUE;
-  }
-
-  /* Find first case of higher/equal sequence number in new playlist.
-   * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (f1->sequence >= f2->sequence) {
-        match = TRUE;
-        break;
-      }
-    }
-    if (match)
-      break;
-  }
-
-  /* We must have seen at least one entry on each list */
-  g_assert (f1 != NULL);
-  g_assert (f2 != NULL);
-
-  if (!l) {
-    /* No match, no sequence in the new playlist was higher than
-     * any in the old. This is bad! */
-    GST_ERROR ("Media sequence doesn't continue: last new %" G_GINT64_FORMAT
-        " < last old %" G_GINT64_FORMAT, f1->sequence, f2->sequence);
-    return FALSE;
-  }
-
-  for (; l && m; l = l->next, m = m->next) {
-    f1 = l->data;
-    f2 = m->data;
-
-    if (f1->sequence == f2->sequence && !g_str_equal (f1->uri, f2->uri)) {
-      /* Same sequence, different URI. This is bad! */
-      GST_ERROR ("Media URIs inconsistent (sequence %" G_GINT64_FORMAT
-          "): had '%s', got '%s'", f1->sequence, f2->uri, f1->uri);
-      return FALSE;
-    } else if (f1->sequence < f2->sequence) {
-      /* Not same sequence but by construction sequence must be higher in the
-       * new one. All good in that case, if it isn't then this means that
-       * sequence numbers are decreasing or files were inserted */
-      GST_ERROR ("Media sequences inconsistent: %" G_GINT64_FORMAT " < %"
-          G_GINT64_FORMAT ": URIs new '%s' old '%s'", f1->sequence,
-          f2->sequence, f1->uri, f2->uri);
-      return FALSE;
-    }
-  }
-
-  /* All good if we're getting here */
-  return TRUE;
-}
-
 /* If we don't have MEDIA-SEQUENCE, we check URIs in the previous and
  * current playlist to calculate the/a correct MEDIA-SEQUENCE for the new
  * playlist in relation to the old. That is, same URIs get the same number
  * and later URIs get higher numbers */
 static void
-generate_media_seqnums (GstM3U8 * self, GList * previous_files)
+generate_media_seqnums (GstM3U8 * self, GPtrArray * previous_files)
 {
-  GList *l, *m;
-  GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
+  GHashTable *previous_uris;
+  GstM3U8MediaFile *f1, *f2 = NULL;
   gint64 mediasequence;
+  guint i, j = 0;
+
+  g_return_if_fail (previous_files && previous_files->len > 0);
 
-  g_return_if_fail (previous_files);
+  /* Index of each URI in the previous playlist, plus one */
+  previous_uris = g_hash_table_new (g_str_hash, g_str_equal);
+  for (j = previous_files->len; j > 0; j--) {
+    f2 = g_ptr_array_index (previous_files, j - 1);
+    g_hash_table_insert (previous_uris, f2->uri, GUINT_TO_POINTER (j));
+  }
 
   /* Find first case of same URI in new playlist.
    * From there on we can linearly step ahead */
-  for (l = self->files; l; l = l->next) {
-    gboolean match = FALSE;
-
-    f1 = l->data;
-    for (m = previous_files; m; m = m->next) {
-      f2 = m->data;
-
-      if (g_str_equal (f1->uri, f2->uri)) {
-        match = TRUE;
-        break;
-      }
-    }
-
-    if (match)
+  for (i = 0; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
+    j = GPOINTER_TO_UINT (g_hash_table_lookup (previous_uris, f1->uri));
+    if (j > 0)
       break;
   }
+  g_hash_table_unref (previous_uris);
 
-  if (l) {
+  if (j > 0) {
     /* Match, check that all following ones are matching too and continue
      * sequence numbers from there on */
+    j--;
+    mediasequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (previous_files,
+            j))->sequence;
 
-    mediasequence = f2->sequence;
-
-    for (; l && m; l = l->next, m = m->next) {
-      f1 = l->data;
-      f2 = m->data;
+    for (; i < self->files->len && j < previous_files->len; i++, j++) {
+      f1 = g_ptr_array_index (self->files, i);
+      f2 = g_ptr_array_index (previous_files, j);
 
       f1->sequence = mediasequence;
       mediasequence++;
@@ -462,20 +394,64 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
       }
     }
   } else {
-    /* No match, this means f2 is the last item in the previous playlist
-     * and we have to start our new playlist at that sequence */
+    /* No match, we have to start our new playlist after the last item in
+     * the previous playlist */
+    f2 = g_ptr_array_index (previous_files, previous_files->len - 1);
     mediasequence = f2->sequence + 1;
-    l = self->files;
+    i = 0;
   }
 
-  for (; l; l = l->next) {
-    f1 = l->data;
+  for (; i < self->files->len; i++) {
+    f1 = g_ptr_array_index (self->files, i);
 
     f1->sequence = mediasequence;
     mediasequence++;
   }
 }
 
+/* Whether @uri is what uri_join() gives for the relative @path, with @prefix
+ * being the result of joining the base URI with an empty path */
+static gboolean
+uri_matches_relative_path (const gchar * uri, const gchar * prefix,
+    const gchar * path)
+{
+  gsize prefix_len;
+
+  if (prefix == NULL || path[0] == '/' || strchr (path, ':') != NULL)
+    return FALSE;
+
+  prefix_len = strlen (prefix);
+
+  return strncmp (uri, prefix, prefix_len) == 0
+      && strcmp (uri + prefix_len, path) == 0;
+}
+
+static gboolean
+gst_m3u8_init_file_equal (const GstM3U8InitFile * a,
+    const GstM3U8InitFile * b)
+{
+  if (a == b)
+    return TRUE;
+  if (a == NULL || b == NULL)
+    return FALSE;
+
+  return a->offset == b->offset && a->size == b->size
+      && g_str_equal (a->uri, b->uri);
+}
+
+static gboolean
+gst_m3u8_media_file_equal (const GstM3U8MediaFile * a,
+    const GstM3U8MediaFile * b)
+{
+  return a->sequence == b->sequence && a->duration == b->duration
+      && a->discont == b->discont && a->offset == b->offset
+      && a->size == b->size && g_str_equal (a->uri, b->uri)
+      && g_strcmp0 (a->title, b->title) == 0
+      && g_strcmp0 (a->key, b->key) == 0
+      && memcmp (a->iv, b->iv, sizeof (a->iv)) == 0
+      && gst_m3u8_init_file_equal (a->init_file, b->init_file);
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -491,8 +467,11 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GPtrArray *previous_files = NULL;
+  gint64 previous_first = 0;
   gboolean have_mediasequence = FALSE;
+  gboolean check_uris = FALSE, consistent = TRUE;
+  gchar *uri_prefix;
   GstM3U8InitFile *last_init_file = NULL;
 
   g_return_val_if_fail (self != NULL, FALSE);
@@ -526,15 +505,25 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   g_free (self->last_data);
   self->last_data = data;
 
-  self->current_file = NULL;
-  previous_files = self->files;
-  self->files = NULL;
+  self->current_file = -1;
+  if (self->files->len > 0) {
+    previous_files = self->files;
+    previous_first =
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (previous_files, 0))->sequence;
+    self->files = g_ptr_array_new_with_free_func ((GDestroyNotify)
+        gst_m3u8_media_file_unref);
+  }
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
 
   /* By default, allow caching */
   self->allowcache = TRUE;
 
+  /* What relative media URIs are resolved to, minus the path */
+  uri_prefix = NULL;
+  if (self->base_uri || self->uri)
+    uri_prefix = uri_join (self->base_uri ? self->base_uri : self->uri, "");
+
   duration = 0;
   title = NULL;
   data += 7;
@@ -550,14 +539,42 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
+      GstM3U8MediaFile *previous = NULL;
+
       if (duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
 
-      data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
+      /* With MEDIA-SEQUENCE the segment this line replaces in the previous
+       * playlist is known without searching, and as long as it did not
+       * change we keep it instead of resolving its URI again */
+      if (have_mediasequence && previous_files) {
+        if (self->files->len == 0)
+          check_uris = mediasequence <= previous_first;
+        if (mediasequence >= previous_first
+            && mediasequence - previous_first < previous_files->len)
+          previous = g_ptr_array_index (previous_files,
+              mediasequence - previous_first);
+      }
+
+      if (previous && uri_matches_relative_path (previous->uri, uri_prefix,
+              data))
+        data = g_strdup (previous->uri);
+      else
+        data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
+
       if (data != NULL) {
         GstM3U8MediaFile *file;
+
+        if (previous && check_uris && consistent
+            && !g_str_equal (previous->uri, data)) {
+          /* Same sequence, different URI. This is bad! */
+          GST_ERROR ("Media URIs inconsistent (sequence %" G_GINT64_FORMAT
+              "): had '%s', got '%s'", mediasequence, previous->uri, data);
+          consistent = FALSE;
+        }
+
         file = gst_m3u8_media_file_new (data, title, duration, mediasequence++);
 
         /* set encryption params */
@@ -576,7 +593,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           if (offset != -1) {
             file->offset = offset;
           } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+            GstM3U8MediaFile *prev = NULL;
+
+            if (self->files->len > 0)
+              prev = g_ptr_array_index (self->files, self->files->len - 1);
 
             if (!prev) {
               offset = 0;
@@ -594,11 +614,16 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         if (last_init_file)
           file->init_file = gst_m3u8_init_file_ref (last_init_file);
 
+        if (previous && gst_m3u8_media_file_equal (file, previous)) {
+          gst_m3u8_media_file_unref (file);
+          file = gst_m3u8_media_file_ref (previous);
+        }
+
         duration = 0;
         title = NULL;
         discontinuity = FALSE;
         size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+        g_ptr_array_add (self->files, file);
       }
 
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
@@ -766,23 +791,32 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (current_key);
   current_key = NULL;
-
-  self->files = g_list_reverse (self->files);
+  g_free (uri_prefix);
 
   if (last_init_file)
     gst_m3u8_init_file_unref (last_init_file);
 
   if (previous_files) {
-    gboolean consistent = TRUE;
-
     if (have_mediasequence) {
-      consistent = check_media_seqnums (self, previous_files);
+      /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
+       * the client SHOULD halt playback (6.3.4), which is what we do then.
+       * URIs were checked while parsing already */
+      if (consistent && self->files->len > 0) {
+        GstM3U8MediaFile *last = g_ptr_array_index (self->files,
+            self->files->len - 1);
+
+        if (last->sequence < previous_first) {
+          GST_ERROR ("Media sequence doesn't continue: last new %"
+              G_GINT64_FORMAT " < first old %" G_GINT64_FORMAT,
+              last->sequence, previous_first);
+          consistent = FALSE;
+        }
+      }
     } else {
       generate_media_seqnums (self, previous_files);
     }
 
-    g_list_foreach (previous_files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (previous_files);
+    g_ptr_array_unref (previous_files);
     previous_files = NULL;
 
     /* error was reported above already */
@@ -792,7 +826,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
     }
   }
 
-  if (self->files == NULL) {
+  if (self->files->len == 0) {
     GST_ERROR ("Invalid media playlist, it does not contain any media files");
     GST_M3U8_UNLOCK (self);
     return FALSE;
@@ -800,14 +834,14 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   /* calculate the start and end times of this media playlist. */
   {
-    GList *walk;
     GstM3U8MediaFile *file;
     GstClockTime duration = 0;
+    guint i;
 
     mediasequence = -1;
 
-    for (walk = self->files; walk; walk = walk->next) {
-      file = walk->data;
+    for (i = 0; i < self->files->len; i++) {
+      file = g_ptr_array_index (self->files, i);
 
       if (mediasequence == -1) {
         mediasequence = file->sequence;
@@ -819,6 +853,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         mediasequence = file->sequence;
       }
 
+      file->start = duration;
       duration += file->duration;
       if (file->sequence > self->highest_sequence_number) {
         if (self->highest_sequence_number >= 0) {
@@ -845,76 +880,86 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
-    GList *file;
+  if (self->sequence == -1) {
+    gint file;
 
     if (GST_M3U8_IS_LIVE (self)) {
       gint i;
       GstClockTime sequence_pos = 0;
 
-      file = g_list_last (self->files);
+      file = self->files->len - 1;
 
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
+      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (g_ptr_array_index
+              (self->files, file))->duration) {
+        sequence_pos = self->last_file_end -
+            GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+                file))->duration;
       }
 
       /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
        * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file > 0 &&
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+                  file - 1))->duration <= sequence_pos; ++i) {
+        file--;
+        sequence_pos -=
+            GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+                file))->duration;
       }
       self->sequence_position = sequence_pos;
     } else {
-      file = g_list_first (self->files);
+      file = 0;
       self->sequence_position = 0;
     }
     self->current_file = file;
-    self->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    self->sequence =
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files, file))->sequence;
     GST_DEBUG ("first sequence: %u", (guint) self->sequence);
   }
 
   GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+      self->files->len);
 
   GST_M3U8_UNLOCK (self);
 
   return TRUE;
 }
 
-/* call with M3U8_LOCK held */
-static GList *
-m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
+/* Returns the index of the first file with a sequence number not lower
+ * than @sequence, or the number of files if there is none.
+ * call with M3U8_LOCK held */
+static guint
+m3u8_find_sequence_index (GstM3U8 * m3u8, gint64 sequence)
 {
-  GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
+  guint lo = 0, hi = m3u8->files->len;
 
-  if (forward) {
-    while (l) {
-      file = l->data;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
 
-      if (file->sequence >= m3u8->sequence)
-        break;
+    if (GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+                mid))->sequence < sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
 
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
+  return lo;
+}
 
-    while (l) {
-      file = l->data;
+/* call with M3U8_LOCK held */
+static gint
+m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
+{
+  guint idx = m3u8_find_sequence_index (m3u8, m3u8->sequence);
 
-      if (file->sequence <= m3u8->sequence)
-        break;
+  if (forward)
+    return idx < m3u8->files->len ? (gint) idx : -1;
 
-      l = l->prev;
-    }
-  }
+  if (idx < m3u8->files->len && GST_M3U8_MEDIA_FILE (g_ptr_array_index
+          (m3u8->files, idx))->sequence == m3u8->sequence)
+    return idx;
 
-  return l;
+  return (gint) idx - 1;
 }
 
 GstM3U8MediaFile *
@@ -932,13 +977,14 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file == -1)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file == -1)
     goto out;
 
-  file = gst_m3u8_media_file_ref (m3u8->current_file->data);
+  file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files,
+          m3u8->current_file));
 
   GST_DEBUG ("Got fragment with sequence %u (current sequence %u)",
       (guint) file->sequence, (guint) m3u8->sequence);
@@ -962,7 +1008,7 @@ gboolean
 gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   gboolean have_next;
-  GList *cur;
+  gint cur;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
@@ -971,26 +1017,63 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
-  if (m3u8->current_file) {
+  if (m3u8->current_file != -1) {
     cur = m3u8->current_file;
   } else {
     cur = m3u8_find_next_fragment (m3u8, forward);
   }
 
-  have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+  have_next = cur != -1 && ((forward && (guint) cur + 1 < m3u8->files->len)
+      || (!forward && cur > 0));
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the file @n positions after the next fragment in the playback
+ * direction, without changing the playlist state */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint n)
+{
+  GstM3U8MediaFile *file = NULL;
+  gint cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->current_file != -1) {
+    cur = m3u8->current_file;
+  } else {
+    cur = m3u8_find_next_fragment (m3u8, forward);
+  }
+
+  if (cur == -1)
+    goto out;
+
+  if (forward && (guint) cur + n < m3u8->files->len)
+    file = g_ptr_array_index (m3u8->files, cur + n);
+  else if (!forward && (guint) cur >= n)
+    file = g_ptr_array_index (m3u8->files, cur - n);
+
+  if (file)
+    gst_m3u8_media_file_ref (file);
+
+out:
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
-  GList *tmp;
-  GstM3U8MediaFile *mf;
+  guint idx;
+  GstM3U8MediaFile *mf = NULL;
 
   /* figure out the target seqnum */
   if (forward)
@@ -998,18 +1081,16 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
-  if (tmp == NULL) {
+  idx = m3u8_find_sequence_index (m3u8, targetnum);
+  if (idx < m3u8->files->len)
+    mf = g_ptr_array_index (m3u8->files, idx);
+  if (mf == NULL || mf->sequence != targetnum) {
     GST_WARNING ("Can't find next fragment");
     return;
   }
-  m3u8->current_file = tmp;
+  m3u8->current_file = idx;
   m3u8->sequence = targetnum;
-  m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (tmp->data)->duration;
+  m3u8->current_file_duration = mf->duration;
 }
 
 void
@@ -1035,30 +1116,30 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
-  if (!m3u8->current_file) {
-    GList *l;
+  if (m3u8->current_file == -1) {
+    guint idx;
 
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
-    if (m3u8->current_file == NULL) {
+    idx = m3u8_find_sequence_index (m3u8, m3u8->sequence);
+    if (idx < m3u8->files->len && GST_M3U8_MEDIA_FILE (g_ptr_array_index
+            (m3u8->files, idx))->sequence == m3u8->sequence)
+      m3u8->current_file = idx;
+
+    if (m3u8->current_file == -1) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
       m3u8_alternate_advance (m3u8, forward);
 
       /* Resync sequence number if the above has failed for live streams */
-      if (m3u8->current_file == NULL && GST_M3U8_IS_LIVE (m3u8)) {
+      if (m3u8->current_file == -1 && GST_M3U8_IS_LIVE (m3u8)) {
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
         gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+            (gint) m3u8->files->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file = pos >= 0 ? pos : 0;
         m3u8->current_file_duration =
-            GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+            GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+                m3u8->current_file))->duration;
 
         GST_WARNING ("Resyncing live playlist");
       }
@@ -1066,28 +1147,26 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     }
   }
 
-  file = GST_M3U8_MEDIA_FILE (m3u8->current_file->data);
+  file = g_ptr_array_index (m3u8->files, m3u8->current_file);
   GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
   if (forward) {
-    m3u8->current_file = m3u8->current_file->next;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if ((guint) m3u8->current_file + 1 < m3u8->files->len) {
+      m3u8->current_file++;
     } else {
+      m3u8->current_file = -1;
       m3u8->sequence = file->sequence + 1;
     }
   } else {
-    m3u8->current_file = m3u8->current_file->prev;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
-    } else {
+    m3u8->current_file--;
+    if (m3u8->current_file == -1)
       m3u8->sequence = file->sequence - 1;
-    }
   }
-  if (m3u8->current_file) {
+  if (m3u8->current_file != -1) {
     /* Store duration of the fragment we're using to update the position 
      * the next time we advance */
-    m3u8->current_file_duration =
-        GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+    file = g_ptr_array_index (m3u8->files, m3u8->current_file);
+    m3u8->sequence = file->sequence;
+    m3u8->current_file_duration = file->duration;
   }
 
 out:
@@ -1108,12 +1187,11 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
   if (!m3u8->endlist)
     goto out;
 
-  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
+  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files->len > 0) {
+    GstM3U8MediaFile *last;
 
-    m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    last = g_ptr_array_index (m3u8->files, m3u8->files->len - 1);
+    m3u8->duration = last->start + last->duration;
   }
   duration = m3u8->duration;
 
@@ -1124,6 +1202,46 @@ out:
   return duration;
 }
 
+/* Returns the index of the file containing @position, counted from the
+ * start of the first file, or the number of files if @position is after the
+ * end of the playlist */
+guint
+gst_m3u8_find_file_index (GstM3U8 * m3u8, GstClockTime position)
+{
+  GstM3U8MediaFile *file;
+  guint lo = 0, hi;
+
+  g_return_val_if_fail (m3u8 != NULL, 0);
+
+  GST_M3U8_LOCK (m3u8);
+
+  hi = m3u8->files->len;
+  if (hi == 0)
+    goto out;
+
+  file = g_ptr_array_index (m3u8->files, hi - 1);
+  if (position >= file->start + file->duration) {
+    lo = hi;
+    goto out;
+  }
+
+  /* find the last file starting at or before position */
+  while (hi - lo > 1) {
+    guint mid = lo + (hi - lo) / 2;
+
+    file = g_ptr_array_index (m3u8->files, mid);
+    if (file->start <= position)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return lo;
+}
+
 GstClockTime
 gst_m3u8_get_target_duration (GstM3U8 * m3u8)
 {
@@ -1224,7 +1342,6 @@ gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
   GstM3U8MediaFile *file;
   guint count;
   guint min_distance = 0;
@@ -1233,7 +1350,7 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 
   GST_M3U8_LOCK (m3u8);
 
-  if (m3u8->files == NULL)
+  if (m3u8->files->len == 0)
     goto out;
 
   if (GST_M3U8_IS_LIVE (m3u8)) {
@@ -1242,12 +1359,11 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
+  count = m3u8->files->len;
 
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
+  if (count > min_distance) {
+    file = g_ptr_array_index (m3u8->files, count - min_distance - 1);
+    duration = file->start + file->duration;
   }
 
   if (duration <= 0)
@@ -64,10 +64,10 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
-  GList *files;
+  GPtrArray *files;             /* GstM3U8MediaFile, by increasing sequence */
 
   /* state */
-  GList *current_file;
+  gint current_file;            /* index in files, -1 if not known */
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
   GstClockTime sequence_position;     /* position of this sequence */
@@ -99,6 +99,7 @@ struct _GstM3U8MediaFile
   gchar *key;
   guint8 iv[16];
   gint64 offset, size;
+  GstClockTime start;           /* position from the start of the first file */
   gint ref_count;               /* ATOMIC */
   GstM3U8InitFile *init_file;   /* Media Initialization (hold ref) */
 };
@@ -132,11 +133,18 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8  * m3u8,
+                                                  gboolean   forward,
+                                                  guint      n);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
 GstClockTime       gst_m3u8_get_duration         (GstM3U8 * m3u8);
 
+guint              gst_m3u8_find_file_index      (GstM3U8      * m3u8,
+                                                  GstClockTime   position);
+
 GstClockTime       gst_m3u8_get_target_duration  (GstM3U8 * m3u8);
 
 gchar *            gst_m3u8_get_uri              (GstM3U8 * m3u8);
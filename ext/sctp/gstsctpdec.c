@@ -152,6 +152,8 @@ static GstStateChangeReturn gst_sctp_dec_change_state (GstElement * element,
     GstStateChange transition);
 static GstFlowReturn gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self,
     GstBuffer * buf);
+static GstFlowReturn gst_sctp_dec_packet_chain_list (GstPad * pad,
+    GstSctpDec * self, GstBufferList * list);
 static gboolean gst_sctp_dec_packet_event (GstPad * pad, GstSctpDec * self,
     GstEvent * event);
 static void gst_sctp_data_srcpad_loop (GstPad * pad);
@@ -243,6 +245,9 @@ gst_sctp_dec_init (GstSctpDec * self)
   self->sink_pad = gst_pad_new_from_static_template (&sink_template, "sink");
   gst_pad_set_chain_function (self->sink_pad,
       GST_DEBUG_FUNCPTR ((GstPadChainFunction) gst_sctp_dec_packet_chain));
+  gst_pad_set_chain_list_function (self->sink_pad,
+      GST_DEBUG_FUNCPTR ((GstPadChainListFunction)
+          gst_sctp_dec_packet_chain_list));
   gst_pad_set_event_function (self->sink_pad,
       GST_DEBUG_FUNCPTR ((GstPadEventFunction) gst_sctp_dec_packet_event));
 
@@ -343,18 +348,14 @@ gst_sctp_dec_change_state (GstElement * element, GstStateChange transition)
   return ret;
 }
 
-static GstFlowReturn
-gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
+static gboolean
+gst_sctp_dec_process_packet (GstSctpDec * self, GstBuffer * buf)
 {
-  GstFlowReturn flow_ret;
   GstMapInfo map;
 
-  GST_DEBUG_OBJECT (self, "Processing received buffer %" GST_PTR_FORMAT, buf);
-
   if (!gst_buffer_map (buf, &map, GST_MAP_READ)) {
     GST_ERROR_OBJECT (self, "Could not map GstBuffer");
-    gst_buffer_unref (buf);
-    return GST_FLOW_ERROR;
+    return FALSE;
   }
 
   if (self->sctp_association != NULL) {
@@ -362,7 +363,14 @@ gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
         (const guint8 *) map.data, (guint32) map.size);
   }
   gst_buffer_unmap (buf, &map);
-  gst_buffer_unref (buf);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_sctp_dec_combined_flow (GstSctpDec * self)
+{
+  GstFlowReturn flow_ret;
 
   GST_OBJECT_LOCK (self);
   /* This gets the last combined flow return from all source pads */
@@ -376,6 +384,43 @@ gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
   return flow_ret;
 }
 
+/* All packets received in one go are fed to usrsctp before the flow
+ * return is looked at, instead of going through the default per buffer
+ * chain function */
+static GstFlowReturn
+gst_sctp_dec_packet_chain_list (GstPad * pad, GstSctpDec * self,
+    GstBufferList * list)
+{
+  guint i, len = gst_buffer_list_length (list);
+
+  GST_DEBUG_OBJECT (self, "Processing %u received buffers", len);
+
+  for (i = 0; i < len; i++) {
+    if (!gst_sctp_dec_process_packet (self, gst_buffer_list_get (list, i))) {
+      gst_buffer_list_unref (list);
+      return GST_FLOW_ERROR;
+    }
+  }
+  gst_buffer_list_unref (list);
+
+  return gst_sctp_dec_combined_flow (self);
+}
+
+static GstFlowReturn
+gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
+{
+  gboolean ret;
+
+  GST_DEBUG_OBJECT (self, "Processing received buffer %" GST_PTR_FORMAT, buf);
+
+  ret = gst_sctp_dec_process_packet (self, buf);
+  gst_buffer_unref (buf);
+  if (!ret)
+    return GST_FLOW_ERROR;
+
+  return gst_sctp_dec_combined_flow (self);
+}
+
 static void
 flush_srcpad (const GValue * item, gpointer user_data)
 {
@@ -151,6 +151,8 @@ static void gst_sctp_enc_release_pad (GstElement * element, GstPad * pad);
 static void gst_sctp_enc_srcpad_loop (GstPad * pad);
 static GstFlowReturn gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_sctp_enc_sink_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_sctp_enc_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_sctp_enc_src_event (GstPad * pad, GstObject * parent,
@@ -471,6 +473,8 @@ gst_sctp_enc_request_new_pad (GstElement * element, GstPadTemplate * template,
       template->direction, "template", template, NULL);
   gst_pad_set_chain_function (new_pad,
       GST_DEBUG_FUNCPTR (gst_sctp_enc_sink_chain));
+  gst_pad_set_chain_list_function (new_pad,
+      GST_DEBUG_FUNCPTR (gst_sctp_enc_sink_chain_list));
   gst_pad_set_event_function (new_pad,
       GST_DEBUG_FUNCPTR (gst_sctp_enc_sink_event));
 
@@ -565,11 +569,31 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
 
   if (gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
     GstBuffer *buffer = GST_BUFFER (item->object);
+    GstBufferList *list = NULL;
 
-    GST_DEBUG_OBJECT (self, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
-
-    flow_ret = gst_pad_push (self->src_pad, buffer);
     item->object = NULL;
+    item->destroy (item);
+
+    /* Forward everything usrsctp produced since the last wakeup at once */
+    while (!gst_data_queue_is_empty (self->outbound_sctp_packet_queue)
+        && gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
+      if (!list) {
+        list = gst_buffer_list_new ();
+        gst_buffer_list_add (list, buffer);
+      }
+      gst_buffer_list_add (list, GST_BUFFER (item->object));
+      item->object = NULL;
+      item->destroy (item);
+    }
+
+    if (list) {
+      GST_DEBUG_OBJECT (self, "Forwarding %u buffers",
+          gst_buffer_list_length (list));
+      flow_ret = gst_pad_push_list (self->src_pad, list);
+    } else {
+      GST_DEBUG_OBJECT (self, "Forwarding buffer %" GST_PTR_FORMAT, buffer);
+      flow_ret = gst_pad_push (self->src_pad, buffer);
+    }
 
     GST_OBJECT_LOCK (self);
     self->src_ret = flow_ret;
@@ -590,8 +614,6 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
       gst_data_queue_flush (self->outbound_sctp_packet_queue);
       gst_pad_pause_task (pad);
     }
-
-    item->destroy (item);
   } else {
     GST_OBJECT_LOCK (self);
     self->src_ret = GST_FLOW_FLUSHING;
@@ -602,12 +624,13 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
   }
 }
 
+/* Sends @buffer as one message on the stream of @sctpenc_pad, waiting for
+ * room in the send buffer as needed */
 static GstFlowReturn
-gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_sctp_enc_send_buffer (GstSctpEnc * self, GstSctpEncPad * sctpenc_pad,
+    GstBuffer * buffer)
 {
-  GstSctpEnc *self = GST_SCTP_ENC (parent);
-  GstSctpEncPad *sctpenc_pad = GST_SCTP_ENC_PAD (pad);
-  GstMapInfo map;
+  GstPad *pad = GST_PAD (sctpenc_pad);
   guint32 ppid;
   gboolean ordered;
   GstSctpAssociationPartialReliability pr;
@@ -615,20 +638,8 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   gpointer state = NULL;
   GstMeta *meta;
   const GstMetaInfo *meta_info = GST_SCTP_SEND_META_INFO;
-  GstFlowReturn flow_ret = GST_FLOW_ERROR;
-  const guint8 *data;
-  guint32 length;
-
-  GST_OBJECT_LOCK (self);
-  if (self->src_ret != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (pad, "Pushing on source pad failed before: %s",
-        gst_flow_get_name (self->src_ret));
-    flow_ret = self->src_ret;
-    GST_OBJECT_UNLOCK (self);
-    gst_buffer_unref (buffer);
-    return flow_ret;
-  }
-  GST_OBJECT_UNLOCK (self);
+  GstFlowReturn flow_ret;
+  gsize offset = 0, size;
 
   ppid = sctpenc_pad->ppid;
   ordered = sctpenc_pad->ordered;
@@ -665,23 +676,19 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       " with ppid %u ordered %d pr %d pr_param %u", buffer, ppid, ordered, pr,
       pr_param);
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
-    GST_ERROR_OBJECT (pad, "Could not map GstBuffer");
-    goto error;
-  }
-
-  data = map.data;
-  length = map.size;
+  size = gst_buffer_get_size (buffer);
 
   g_mutex_lock (&sctpenc_pad->lock);
   while (!sctpenc_pad->flushing) {
-    guint32 bytes_sent;
+    gsize bytes_sent;
 
     g_mutex_unlock (&sctpenc_pad->lock);
 
+    /* The buffer memory is handed to usrsctp as is, without mapping
+     * the whole buffer */
     flow_ret =
-        gst_sctp_association_send_data (self->sctp_association, data,
-        length, sctpenc_pad->stream_id, ppid, ordered, pr, pr_param,
+        gst_sctp_association_send_buffer (self->sctp_association, buffer,
+        offset, sctpenc_pad->stream_id, ppid, ordered, pr, pr_param,
         &bytes_sent);
 
     g_mutex_lock (&sctpenc_pad->lock);
@@ -691,15 +698,19 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             ("Failed to send data"));
       }
       goto out;
-    } else if (bytes_sent < length && !sctpenc_pad->flushing) {
-      gint64 end_time = g_get_monotonic_time () + BUFFER_FULL_SLEEP_TIME;
+    }
+
+    sctpenc_pad->bytes_sent += bytes_sent;
+    offset += bytes_sent;
 
-      GST_TRACE_OBJECT (pad, "Sent only %u of %u remaining bytes, waiting",
-          bytes_sent, length);
+    if (offset == size) {
+      GST_DEBUG_OBJECT (pad, "Successfully sent buffer");
+      break;
+    } else if (!sctpenc_pad->flushing) {
+      gint64 end_time = g_get_monotonic_time () + BUFFER_FULL_SLEEP_TIME;
 
-      sctpenc_pad->bytes_sent += bytes_sent;
-      data += bytes_sent;
-      length -= bytes_sent;
+      GST_TRACE_OBJECT (pad, "Sent only %" G_GSIZE_FORMAT " of %"
+          G_GSIZE_FORMAT " bytes, waiting", offset, size);
 
       /* The buffer was probably full. Retry in a while */
       GST_OBJECT_LOCK (self);
@@ -711,10 +722,6 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       GST_OBJECT_LOCK (self);
       g_queue_remove (&self->pending_pads, sctpenc_pad);
       GST_OBJECT_UNLOCK (self);
-    } else if (bytes_sent == length) {
-      GST_DEBUG_OBJECT (pad, "Successfully sent buffer");
-      sctpenc_pad->bytes_sent += bytes_sent;
-      break;
     }
   }
   flow_ret = sctpenc_pad->flushing ? GST_FLOW_FLUSHING : GST_FLOW_OK;
@@ -722,12 +729,68 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 out:
   g_mutex_unlock (&sctpenc_pad->lock);
 
-  gst_buffer_unmap (buffer, &map);
-error:
+  /* The association sends the rest of the message, the peer must not get
+   * it truncated */
+  if (flow_ret == GST_FLOW_FLUSHING && offset > 0 && offset < size)
+    gst_sctp_association_abandon_message (self->sctp_association,
+        sctpenc_pad->stream_id, buffer, offset);
+
+  return flow_ret;
+}
+
+static GstFlowReturn
+gst_sctp_enc_check_src_ret (GstSctpEnc * self, GstPad * pad)
+{
+  GstFlowReturn flow_ret;
+
+  GST_OBJECT_LOCK (self);
+  flow_ret = self->src_ret;
+  GST_OBJECT_UNLOCK (self);
+
+  if (flow_ret != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (pad, "Pushing on source pad failed before: %s",
+        gst_flow_get_name (flow_ret));
+  }
+
+  return flow_ret;
+}
+
+static GstFlowReturn
+gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstSctpEnc *self = GST_SCTP_ENC (parent);
+  GstFlowReturn flow_ret;
+
+  flow_ret = gst_sctp_enc_check_src_ret (self, pad);
+  if (flow_ret == GST_FLOW_OK)
+    flow_ret = gst_sctp_enc_send_buffer (self, GST_SCTP_ENC_PAD (pad), buffer);
+
   gst_buffer_unref (buffer);
   return flow_ret;
 }
 
+/* Every buffer of the list is sent as its own message, the state of the
+ * source pad is only checked once for the whole list */
+static GstFlowReturn
+gst_sctp_enc_sink_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstSctpEnc *self = GST_SCTP_ENC (parent);
+  GstFlowReturn flow_ret;
+  guint i, len;
+
+  flow_ret = gst_sctp_enc_check_src_ret (self, pad);
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && flow_ret == GST_FLOW_OK; i++) {
+    flow_ret = gst_sctp_enc_send_buffer (self, GST_SCTP_ENC_PAD (pad),
+        gst_buffer_list_get (list, i));
+  }
+
+  gst_buffer_list_unref (list);
+  return flow_ret;
+}
+
 static gboolean
 gst_sctp_enc_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -99,11 +99,43 @@ static GParamSpec *properties[NUM_PROPERTIES];
 #define DEFAULT_LOCAL_SCTP_PORT 0
 #define DEFAULT_REMOTE_SCTP_PORT 0
 
-G_LOCK_DEFINE_STATIC (associations_lock);
-static GHashTable *associations_by_id = NULL;
-static GHashTable *ids_by_association = NULL;
+/* The association registry is split into shards with their own lock so
+ * that the lookups done for every packet of every association don't all
+ * contend on a single lock in processes with many associations.
+ * Associations are looked up by id in the id shards, and the validity of
+ * association pointers passed back by usrsctp is checked in the valid
+ * shards. A valid shard lock can be taken while holding an id shard lock,
+ * never the other way around. */
+#define N_ASSOCIATION_SHARDS 16
+
+typedef struct
+{
+  GMutex lock;
+  GHashTable *associations;
+} AssociationShard;
+
+static AssociationShard id_shards[N_ASSOCIATION_SHARDS];
+static AssociationShard valid_shards[N_ASSOCIATION_SHARDS];
+
+#define ID_SHARD(id) (&id_shards[(id) % N_ASSOCIATION_SHARDS])
+#define VALID_SHARD(assoc) \
+    (&valid_shards[(GPOINTER_TO_SIZE (assoc) >> 4) % N_ASSOCIATION_SHARDS])
+
+/* Protects the usrsctp stack initialisation and the timer thread */
+G_LOCK_DEFINE_STATIC (usrsctp_lock);
 static guint32 number_of_associations = 0;
 
+#ifdef HAVE_USRSCTP_INIT_NOTHREADS
+/* Without the usrsctp internal threads the stack is driven by a single
+ * timer thread of ours, which also avoids the raw socket receive threads
+ * usrsctp would otherwise start and that are never used here as all
+ * packets are passed in and out through the AF_CONN callbacks */
+#define USRSCTP_TIMER_TICK_MS 10
+
+static GThread *usrsctp_timer_thread = NULL;
+static gint usrsctp_timer_running = 0;
+#endif
+
 /* Interface implementations */
 static void gst_sctp_association_dispose (GObject * object);
 static void gst_sctp_association_finalize (GObject * object);
@@ -208,15 +240,48 @@ gst_usrsctp_debug (const gchar * format, ...)
 }
 #endif
 
+#ifdef HAVE_USRSCTP_INIT_NOTHREADS
+static gpointer
+gst_usrsctp_timer_thread_func (gpointer user_data)
+{
+  gint64 last = g_get_monotonic_time ();
+
+  while (g_atomic_int_get (&usrsctp_timer_running)) {
+    gint64 now;
+    guint32 elapsed_ms;
+
+    g_usleep (USRSCTP_TIMER_TICK_MS * 1000);
+
+    now = g_get_monotonic_time ();
+    elapsed_ms = (now - last) / 1000;
+    if (elapsed_ms > 0) {
+      /* keep the sub-millisecond remainder for the next tick */
+      last += (gint64) elapsed_ms * 1000;
+      usrsctp_handle_timers (elapsed_ms);
+    }
+  }
+
+  return NULL;
+}
+#endif
+
 static void
-gst_sctp_association_init (GstSctpAssociation * self)
+gst_usrsctp_stack_ref (void)
 {
-  /* No need to lock mutex here as long as the function is only called from gst_sctp_association_get */
+  G_LOCK (usrsctp_lock);
   if (number_of_associations == 0) {
+#ifdef HAVE_USRSCTP_INIT_NOTHREADS
+#if defined(SCTP_DEBUG) && !defined(GST_DISABLE_GST_DEBUG)
+    usrsctp_init_nothreads (0, sctp_packet_out, gst_usrsctp_debug);
+#else
+    usrsctp_init_nothreads (0, sctp_packet_out, NULL);
+#endif
+#else
 #if defined(SCTP_DEBUG) && !defined(GST_DISABLE_GST_DEBUG)
     usrsctp_init (0, sctp_packet_out, gst_usrsctp_debug);
 #else
     usrsctp_init (0, sctp_packet_out, NULL);
+#endif
 #endif
 
     /* Explicit Congestion Notification */
@@ -243,15 +308,45 @@ gst_sctp_association_init (GstSctpAssociation * self)
       usrsctp_sysctl_set_sctp_debug_on (SCTP_DEBUG_ALL);
     }
 #endif
+
+#ifdef HAVE_USRSCTP_INIT_NOTHREADS
+    g_atomic_int_set (&usrsctp_timer_running, 1);
+    usrsctp_timer_thread = g_thread_new ("sctp-timer",
+        gst_usrsctp_timer_thread_func, NULL);
+#endif
   }
   number_of_associations++;
+  G_UNLOCK (usrsctp_lock);
+}
 
+static void
+gst_usrsctp_stack_unref (void)
+{
+  G_LOCK (usrsctp_lock);
+  number_of_associations--;
+  if (number_of_associations == 0) {
+#ifdef HAVE_USRSCTP_INIT_NOTHREADS
+    g_atomic_int_set (&usrsctp_timer_running, 0);
+    g_thread_join (usrsctp_timer_thread);
+    usrsctp_timer_thread = NULL;
+#endif
+    usrsctp_finish ();
+  }
+  G_UNLOCK (usrsctp_lock);
+}
+
+static void
+gst_sctp_association_init (GstSctpAssociation * self)
+{
+  /* The usrsctp stack reference is taken by gst_sctp_association_get() */
   self->local_port = DEFAULT_LOCAL_SCTP_PORT;
   self->remote_port = DEFAULT_REMOTE_SCTP_PORT;
   self->sctp_ass_sock = NULL;
 
   g_mutex_init (&self->association_mutex);
   g_mutex_init (&self->usrsctp_disconnect_mutex);
+  g_mutex_init (&self->send_mutex);
+  self->send_stream_id = -1;
 
   self->state = GST_SCTP_ASSOCIATION_STATE_NEW;
 
@@ -264,18 +359,23 @@ static void
 gst_sctp_association_dispose (GObject * object)
 {
   GstSctpAssociation *self = GST_SCTP_ASSOCIATION (object);
+  AssociationShard *shard;
 
-  G_LOCK (associations_lock);
+  shard = ID_SHARD (self->association_id);
+  g_mutex_lock (&shard->lock);
+  if (g_hash_table_lookup (shard->associations,
+          GUINT_TO_POINTER (self->association_id)) == self)
+    g_hash_table_remove (shard->associations,
+        GUINT_TO_POINTER (self->association_id));
+  g_mutex_unlock (&shard->lock);
 
-  g_hash_table_remove (associations_by_id, GUINT_TO_POINTER (self->association_id));
-  g_hash_table_remove (ids_by_association, self);
+  shard = VALID_SHARD (self);
+  g_mutex_lock (&shard->lock);
+  g_hash_table_remove (shard->associations, self);
+  g_mutex_unlock (&shard->lock);
 
   usrsctp_deregister_address ((void *) self);
-  number_of_associations--;
-  if (number_of_associations == 0) {
-    usrsctp_finish ();
-  }
-  G_UNLOCK (associations_lock);
+  gst_usrsctp_stack_unref ();
 
   if (G_OBJECT_CLASS (gst_sctp_association_parent_class)->dispose) {
     G_OBJECT_CLASS (gst_sctp_association_parent_class)->dispose (object);
@@ -289,6 +389,8 @@ gst_sctp_association_finalize (GObject * object)
 
   g_mutex_clear (&self->association_mutex);
   g_mutex_clear (&self->usrsctp_disconnect_mutex);
+  g_mutex_clear (&self->send_mutex);
+  gst_buffer_replace (&self->send_rest, NULL);
 
   G_OBJECT_CLASS (gst_sctp_association_parent_class)->finalize (object);
 }
@@ -391,36 +493,59 @@ gst_sctp_association_get_property (GObject * object, guint prop_id,
 GstSctpAssociation *
 gst_sctp_association_get (guint32 association_id)
 {
+  static gsize shards_initialized = 0;
   GstSctpAssociation *association;
+  AssociationShard *shard, *valid_shard;
+
+  if (g_once_init_enter (&shards_initialized)) {
+    guint i;
+
+    GST_DEBUG_CATEGORY_INIT (gst_sctp_association_debug_category,
+        "sctpassociation", 0, "debug category for sctpassociation");
+    GST_DEBUG_CATEGORY_INIT (gst_sctp_debug_category,
+        "sctplib", 0, "debug category for messages from usrsctp");
+
+    for (i = 0; i < N_ASSOCIATION_SHARDS; i++) {
+      g_mutex_init (&id_shards[i].lock);
+      id_shards[i].associations =
+          g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_mutex_init (&valid_shards[i].lock);
+      valid_shards[i].associations =
+          g_hash_table_new (g_direct_hash, g_direct_equal);
+    }
 
-  G_LOCK (associations_lock);
-  GST_DEBUG_CATEGORY_INIT (gst_sctp_association_debug_category,
-      "sctpassociation", 0, "debug category for sctpassociation");
-  GST_DEBUG_CATEGORY_INIT (gst_sctp_debug_category,
-      "sctplib", 0, "debug category for messages from usrsctp");
-
-  if (!associations_by_id) {
-    associations_by_id =
-        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, NULL);
-    ids_by_association =
-        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, NULL);
+    g_once_init_leave (&shards_initialized, 1);
   }
 
+  /* Taken before any shard lock as stopping the timer thread waits for
+   * packets it is sending out, which look up the shard locks */
+  gst_usrsctp_stack_ref ();
+
+  shard = ID_SHARD (association_id);
+  g_mutex_lock (&shard->lock);
   association =
-      g_hash_table_lookup (associations_by_id,
-          GUINT_TO_POINTER (association_id));
+      g_hash_table_lookup (shard->associations,
+      GUINT_TO_POINTER (association_id));
   if (!association) {
     association =
         g_object_new (GST_SCTP_TYPE_ASSOCIATION, "association-id",
         association_id, NULL);
-    g_hash_table_insert (associations_by_id, GUINT_TO_POINTER (association_id),
-        association);
-    g_hash_table_insert (ids_by_association, association,
-        GUINT_TO_POINTER (association_id));
+    g_hash_table_insert (shard->associations,
+        GUINT_TO_POINTER (association_id), association);
+
+    valid_shard = VALID_SHARD (association);
+    g_mutex_lock (&valid_shard->lock);
+    g_hash_table_add (valid_shard->associations, association);
+    g_mutex_unlock (&valid_shard->lock);
+    g_mutex_unlock (&shard->lock);
   } else {
     g_object_ref (association);
+    g_mutex_unlock (&shard->lock);
+
+    /* The existing association already holds a stack reference */
+    gst_usrsctp_stack_unref ();
   }
-  G_UNLOCK (associations_lock);
+
   return association;
 }
 
@@ -499,16 +624,190 @@ gst_sctp_association_incoming_packet (GstSctpAssociation * self,
   usrsctp_conninput ((void *) self, (const void *) buf, (size_t) length, 0);
 }
 
-GstFlowReturn
-gst_sctp_association_send_data (GstSctpAssociation * self, const guint8 * buf,
-    guint32 length, guint16 stream_id, guint32 ppid, gboolean ordered,
-    GstSctpAssociationPartialReliability pr, guint32 reliability_param,
-    guint32 * bytes_sent_)
+/* Sends one fragment of a message, the SCTP_EOR flag is only set on the
+ * last one. @bytes_sent is the number of bytes usrsctp took, which can be
+ * less than @length when the send buffer is full. */
+static gboolean
+send_fragment (GstSctpAssociation * self, const guint8 * data, gsize length,
+    gboolean last, struct sctp_sendv_spa *spa, struct sockaddr_conn *remote_addr,
+    gsize * bytes_sent)
+{
+  gssize ret;
+
+  if (last)
+    spa->sendv_sndinfo.snd_flags |= SCTP_EOR;
+  else
+    spa->sendv_sndinfo.snd_flags &= ~SCTP_EOR;
+
+  ret = usrsctp_sendv (self->sctp_ass_sock, data, length,
+      (struct sockaddr *) remote_addr, 1, (void *) spa,
+      (socklen_t) sizeof (struct sctp_sendv_spa), SCTP_SENDV_SPA, 0);
+  if (ret < 0) {
+    *bytes_sent = 0;
+    /* Resending the rest is taken care of by the gstsctpenc */
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return TRUE;
+
+    GST_ERROR_OBJECT (self, "Error sending data on stream %u: (%u) %s",
+        spa->sendv_sndinfo.snd_sid, errno, g_strerror (errno));
+    return FALSE;
+  }
+
+  *bytes_sent = ret;
+  return TRUE;
+}
+
+/* Sends the bytes of @buffer from @offset on as the rest of one message.
+ *
+ * The memories of the buffer are mapped one by one and handed to usrsctp
+ * without merging them, in fragments of at most
+ * GST_SCTP_ASSOCIATION_MAX_FRAGMENT_SIZE bytes. @bytes_sent is less than
+ * what is left when the send buffer is full. Must be called with
+ * send_mutex held */
+static GstFlowReturn
+send_message_data (GstSctpAssociation * self, GstBuffer * buffer,
+    gsize offset, struct sctp_sendv_spa *spa,
+    struct sockaddr_conn *remote_addr, gsize * bytes_sent_)
+{
+  GstFlowReturn flow_ret = GST_FLOW_OK;
+  gsize bytes_sent = 0;
+  gsize size, mem_length, skip;
+  guint idx, n_mem, mem_idx;
+
+  size = gst_buffer_get_size (buffer);
+
+  /* Empty messages still need their end of record */
+  if (size == 0) {
+    if (!send_fragment (self, NULL, 0, TRUE, spa, remote_addr, &bytes_sent))
+      goto send_error;
+    goto done;
+  }
+
+  if (!gst_buffer_find_memory (buffer, offset, size - offset, &idx, &n_mem,
+          &skip))
+    goto done;
+
+  for (mem_idx = idx; mem_idx < idx + n_mem; mem_idx++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, mem_idx);
+    GstMapInfo map;
+    const guint8 *data;
+
+    if (!gst_memory_map (mem, &map, GST_MAP_READ)) {
+      GST_ERROR_OBJECT (self, "Could not map memory");
+      flow_ret = GST_FLOW_ERROR;
+      goto done;
+    }
+
+    data = map.data + skip;
+    mem_length = map.size - skip;
+    skip = 0;
+
+    while (mem_length > 0) {
+      gsize length = MIN (mem_length, GST_SCTP_ASSOCIATION_MAX_FRAGMENT_SIZE);
+      gboolean last = offset + bytes_sent + length == size;
+      gsize fragment_sent;
+
+      if (!send_fragment (self, data, length, last, spa, remote_addr,
+              &fragment_sent)) {
+        gst_memory_unmap (mem, &map);
+        goto send_error;
+      }
+
+      bytes_sent += fragment_sent;
+      if (fragment_sent < length) {
+        /* The send buffer is full, the rest is sent later */
+        gst_memory_unmap (mem, &map);
+        goto done;
+      }
+
+      data += length;
+      mem_length -= length;
+    }
+
+    gst_memory_unmap (mem, &map);
+  }
+
+done:
+  *bytes_sent_ = bytes_sent;
+  return flow_ret;
+
+send_error:
+  flow_ret = GST_FLOW_ERROR;
+  goto done;
+}
+
+/* Sends what is left of a message its sender gave up on, see
+ * gst_sctp_association_abandon_message(). Returns TRUE once nothing is
+ * left. Must be called with send_mutex held */
+static gboolean
+send_abandoned_message (GstSctpAssociation * self,
+    struct sockaddr_conn *remote_addr)
 {
   GstFlowReturn flow_ret;
+  gsize bytes_sent;
+
+  if (!self->send_rest)
+    return TRUE;
+
+  flow_ret = send_message_data (self, self->send_rest, self->send_rest_offset,
+      &self->send_spa, remote_addr, &bytes_sent);
+  self->send_rest_offset += bytes_sent;
+  if (flow_ret == GST_FLOW_OK
+      && self->send_rest_offset < gst_buffer_get_size (self->send_rest))
+    return FALSE;
+
+  GST_DEBUG_OBJECT (self, "Abandoned message on stream %d %s",
+      self->send_stream_id, flow_ret == GST_FLOW_OK ? "complete" : "failed");
+  gst_buffer_replace (&self->send_rest, NULL);
+  self->send_stream_id = -1;
+
+  return TRUE;
+}
+
+/* Called when all data was acknowledged, nothing else drives the sending of
+ * an abandoned message while no buffer comes in */
+static void
+resume_abandoned_message (GstSctpAssociation * self)
+{
+  struct sockaddr_conn remote_addr;
+
+  g_mutex_lock (&self->association_mutex);
+  remote_addr = get_sctp_socket_address (self, self->remote_port);
+  g_mutex_unlock (&self->association_mutex);
+
+  /* Whoever holds the lock sends it anyway */
+  if (!g_mutex_trylock (&self->send_mutex))
+    return;
+  send_abandoned_message (self, &remote_addr);
+  g_mutex_unlock (&self->send_mutex);
+}
+
+/* Sends the bytes of @buffer from @offset on as the rest of one message.
+ *
+ * The association runs with SCTP_EXPLICIT_EOR so the buffer can be handed
+ * to usrsctp in fragments and the receiver still gets a single message, and
+ * a message only partly accepted because the send buffer is full can be
+ * resumed from @offset + @bytes_sent later.
+ *
+ * Until a message got its SCTP_EOR usrsctp refuses data for any other
+ * stream, so while a message is in progress nothing is sent for the other
+ * streams and @bytes_sent is 0, as if the send buffer was full. This is
+ * head-of-line blocking: a large message waiting for room in the send
+ * buffer holds back the small messages of all other streams. I-DATA chunks
+ * (RFC 8260) would let usrsctp interleave the messages, but they need the
+ * receiver to put partly delivered messages of several streams back
+ * together, which it does not do. */
+GstFlowReturn
+gst_sctp_association_send_buffer (GstSctpAssociation * self,
+    GstBuffer * buffer, gsize offset, guint16 stream_id, guint32 ppid,
+    gboolean ordered, GstSctpAssociationPartialReliability pr,
+    guint32 reliability_param, gsize * bytes_sent_)
+{
+  GstFlowReturn flow_ret = GST_FLOW_OK;
   struct sctp_sendv_spa spa;
-  gint32 bytes_sent = 0;
+  gsize bytes_sent = 0;
   struct sockaddr_conn remote_addr;
+  gsize size;
 
   g_mutex_lock (&self->association_mutex);
   if (self->state != GST_SCTP_ASSOCIATION_STATE_CONNECTED) {
@@ -517,6 +816,10 @@ gst_sctp_association_send_data (GstSctpAssociation * self, const guint8 * buf,
       GST_INFO_OBJECT (self, "Disconnected");
       flow_ret = GST_FLOW_EOS;
       g_mutex_unlock (&self->association_mutex);
+      g_mutex_lock (&self->send_mutex);
+      self->send_stream_id = -1;
+      gst_buffer_replace (&self->send_rest, NULL);
+      g_mutex_unlock (&self->send_mutex);
       goto end;
     } else {
       GST_ERROR_OBJECT (self, "Association not connected yet");
@@ -528,15 +831,11 @@ gst_sctp_association_send_data (GstSctpAssociation * self, const guint8 * buf,
   remote_addr = get_sctp_socket_address (self, self->remote_port);
   g_mutex_unlock (&self->association_mutex);
 
-  /* TODO: We probably want to split too large chunks into multiple packets
-   * and only set the SCTP_EOR flag on the last one. Firefox is using 0x4000
-   * as the maximum packet size
-   */
   memset (&spa, 0, sizeof (spa));
 
   spa.sendv_sndinfo.snd_ppid = g_htonl (ppid);
   spa.sendv_sndinfo.snd_sid = stream_id;
-  spa.sendv_sndinfo.snd_flags = SCTP_EOR | (ordered ? 0 : SCTP_UNORDERED);
+  spa.sendv_sndinfo.snd_flags = ordered ? 0 : SCTP_UNORDERED;
   spa.sendv_sndinfo.snd_context = 0;
   spa.sendv_sndinfo.snd_assoc_id = 0;
   spa.sendv_flags = SCTP_SEND_SNDINFO_VALID;
@@ -551,24 +850,34 @@ gst_sctp_association_send_data (GstSctpAssociation * self, const guint8 * buf,
       spa.sendv_prinfo.pr_policy = SCTP_PR_SCTP_BUF;
   }
 
-  bytes_sent =
-      usrsctp_sendv (self->sctp_ass_sock, buf, length,
-      (struct sockaddr *) &remote_addr, 1, (void *) &spa,
-      (socklen_t) sizeof (struct sctp_sendv_spa), SCTP_SENDV_SPA, 0);
-  if (bytes_sent < 0) {
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-      bytes_sent = 0;
-      /* Resending this buffer is taken care of by the gstsctpenc */
-      flow_ret = GST_FLOW_OK;
-      goto end;
-    } else {
-      GST_ERROR_OBJECT (self, "Error sending data on stream %u: (%u) %s",
-          stream_id, errno, g_strerror (errno));
-      flow_ret = GST_FLOW_ERROR;
-      goto end;
-    }
+  size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&self->send_mutex);
+  if (!send_abandoned_message (self, &remote_addr)) {
+    GST_LOG_OBJECT (self, "Abandoned message on stream %d not complete, "
+        "stream %u has to wait", self->send_stream_id, stream_id);
+    g_mutex_unlock (&self->send_mutex);
+    goto end;
+  }
+
+  if (self->send_stream_id >= 0 && self->send_stream_id != stream_id) {
+    GST_LOG_OBJECT (self, "Message on stream %d not complete, stream %u "
+        "has to wait", self->send_stream_id, stream_id);
+    g_mutex_unlock (&self->send_mutex);
+    goto end;
+  }
+
+  flow_ret = send_message_data (self, buffer, offset, &spa, &remote_addr,
+      &bytes_sent);
+
+  /* A message given up on because of an error is not resumed */
+  if (flow_ret != GST_FLOW_OK || offset + bytes_sent == size) {
+    self->send_stream_id = -1;
+  } else if (offset + bytes_sent > 0) {
+    self->send_stream_id = stream_id;
+    self->send_spa = spa;
   }
-  flow_ret = GST_FLOW_OK;
+  g_mutex_unlock (&self->send_mutex);
 
 end:
   if (bytes_sent_)
@@ -577,6 +886,39 @@ end:
   return flow_ret;
 }
 
+/* Hands the rest of the message in progress on @stream_id, the bytes of
+ * @buffer from @offset on, over to the association when its sender gives up
+ * on it. usrsctp cannot abort a message it got part of: ending it early
+ * delivers it truncated, and leaving it open appends the next message of
+ * the stream to it. So the association sends the rest before anything else
+ * and the peer gets the whole message. */
+void
+gst_sctp_association_abandon_message (GstSctpAssociation * self,
+    guint16 stream_id, GstBuffer * buffer, gsize offset)
+{
+  struct sockaddr_conn remote_addr;
+  gboolean connected;
+
+  g_mutex_lock (&self->association_mutex);
+  connected = self->state == GST_SCTP_ASSOCIATION_STATE_CONNECTED;
+  remote_addr = get_sctp_socket_address (self, self->remote_port);
+  g_mutex_unlock (&self->association_mutex);
+
+  g_mutex_lock (&self->send_mutex);
+  if (self->send_stream_id == stream_id && !self->send_rest) {
+    if (connected) {
+      GST_DEBUG_OBJECT (self, "Finishing abandoned message on stream %u",
+          stream_id);
+      self->send_rest = gst_buffer_ref (buffer);
+      self->send_rest_offset = offset;
+      send_abandoned_message (self, &remote_addr);
+    } else {
+      self->send_stream_id = -1;
+    }
+  }
+  g_mutex_unlock (&self->send_mutex);
+}
+
 void
 gst_sctp_association_reset_stream (GstSctpAssociation * self, guint16 stream_id)
 {
@@ -686,7 +1028,7 @@ create_sctp_socket (GstSctpAssociation * self)
     SCTP_PARTIAL_DELIVERY_EVENT,
     /*SCTP_AUTHENTICATION_EVENT, */
     SCTP_STREAM_RESET_EVENT,
-    /*SCTP_SENDER_DRY_EVENT, */
+    SCTP_SENDER_DRY_EVENT,
     /*SCTP_NOTIFICATIONS_STOPPED_EVENT, */
     /*SCTP_ASSOC_RESET_EVENT, */
     SCTP_STREAM_CHANGE_EVENT
@@ -886,13 +1228,12 @@ error:
 static gboolean
 association_is_valid (GstSctpAssociation * self)
 {
-  gboolean valid = FALSE;
-
-  G_LOCK (associations_lock);
-
-  valid = g_hash_table_contains (ids_by_association, self);
+  AssociationShard *shard = VALID_SHARD (self);
+  gboolean valid;
 
-  G_UNLOCK (associations_lock);
+  g_mutex_lock (&shard->lock);
+  valid = g_hash_table_contains (shard->associations, self);
+  g_mutex_unlock (&shard->lock);
 
   return valid;
 }
@@ -1000,6 +1341,7 @@ handle_notification (GstSctpAssociation * self,
       break;
     case SCTP_SENDER_DRY_EVENT:
       GST_DEBUG_OBJECT (self, "Event: SCTP_SENDER_DRY_EVENT");
+      resume_abandoned_message (self);
       break;
     case SCTP_NOTIFICATIONS_STOPPED_EVENT:
       GST_DEBUG_OBJECT (self, "Event: SCTP_NOTIFICATIONS_STOPPED_EVENT");
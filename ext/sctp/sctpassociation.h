@@ -53,6 +53,9 @@ typedef enum
   GST_SCTP_ASSOCIATION_STATE_ERROR
 } GstSctpAssociationState;
 
+/* Firefox uses this as the maximum size of a single send */
+#define GST_SCTP_ASSOCIATION_MAX_FRAGMENT_SIZE 0x4000
+
 typedef enum
 {
   GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_NONE = 0x0000,
@@ -82,6 +85,16 @@ struct _GstSctpAssociation
   GMutex association_mutex;
   GMutex usrsctp_disconnect_mutex;
 
+  /* Serializes usrsctp_sendv() calls. With SCTP_EXPLICIT_EOR no other
+   * stream can send until the message in progress got its SCTP_EOR, which
+   * blocks all streams behind one waiting for room in the send buffer */
+  GMutex send_mutex;
+  gint send_stream_id;          /* -1 if no message is in progress */
+  struct sctp_sendv_spa send_spa;
+  /* rest of a message abandoned by its sender, sent before anything else */
+  GstBuffer *send_rest;
+  gsize send_rest_offset;
+
   GstSctpAssociationState state;
 
   guint32 sctp_assoc_id;
@@ -115,10 +128,12 @@ void gst_sctp_association_set_on_packet_received (GstSctpAssociation * self,
     GstSctpAssociationPacketReceivedCb packet_received_cb, gpointer user_data, GDestroyNotify destroy_notify);
 void gst_sctp_association_incoming_packet (GstSctpAssociation * self,
     const guint8 * buf, guint32 length);
-GstFlowReturn gst_sctp_association_send_data (GstSctpAssociation * self,
-    const guint8 * buf, guint32 length, guint16 stream_id, guint32 ppid,
+GstFlowReturn gst_sctp_association_send_buffer (GstSctpAssociation * self,
+    GstBuffer * buffer, gsize offset, guint16 stream_id, guint32 ppid,
     gboolean ordered, GstSctpAssociationPartialReliability pr,
-    guint32 reliability_param, guint32 *bytes_sent);
+    guint32 reliability_param, gsize *bytes_sent);
+void gst_sctp_association_abandon_message (GstSctpAssociation * self,
+    guint16 stream_id, GstBuffer * buffer, gsize offset);
 void gst_sctp_association_reset_stream (GstSctpAssociation * self,
     guint16 stream_id);
 void gst_sctp_association_force_close (GstSctpAssociation * self);
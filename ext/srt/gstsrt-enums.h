@@ -62,6 +62,23 @@ typedef enum
   GST_SRT_KEY_LENGTH_32 = 32,
 } GstSRTKeyLength;
 
+/**
+ * GstSRTCallerDropPolicy:
+ * @GST_SRT_CALLER_DROP_POLICY_DROP_OLDEST: drop the oldest queued buffer
+ * @GST_SRT_CALLER_DROP_POLICY_DROP_NEWEST: drop the buffer being queued
+ * @GST_SRT_CALLER_DROP_POLICY_DISCONNECT: disconnect the caller
+ *
+ * What to do when the send queue of a caller is full in listener mode
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_SRT_CALLER_DROP_POLICY_DROP_OLDEST = 0,
+  GST_SRT_CALLER_DROP_POLICY_DROP_NEWEST,
+  GST_SRT_CALLER_DROP_POLICY_DISCONNECT,
+} GstSRTCallerDropPolicy;
+
 G_END_DECLS
 
 #endif // __GST_SRT_ENUM_H__
@@ -71,17 +71,44 @@ enum
   PROP_WAIT_FOR_CONNECTION,
   PROP_STREAMID,
   PROP_AUTHENTICATION,
+  PROP_CALLER_QUEUE_SIZE,
+  PROP_CALLER_DROP_POLICY,
   PROP_LAST
 };
 
+/* How long the sender thread waits for blocked callers to become writable
+ * before checking whether it has to stop */
+#define SENDER_POLL_TIMEOUT 100
+#define SENDER_MAX_EVENTS 64
+
 typedef struct
 {
   SRTSOCKET sock;
   gint poll_id;
   GSocketAddress *sockaddr;
   gboolean sent_headers;
+
+  gint payload_size;
+
+  /* Buffers waiting to be sent, the first one may be partially sent up to
+   * offset */
+  GQueue queue;
+  gsize offset;
+  /* Set when the socket send buffer was full, the sender thread then takes
+   * care of the queue until it is empty again */
+  gboolean blocked;
+
+  guint64 dropped_buffers;
+  guint64 dropped_bytes;
 } SRTCaller;
 
+typedef enum
+{
+  SRT_CALLER_DRAINED,
+  SRT_CALLER_BLOCKED,
+  SRT_CALLER_ERROR,
+} SRTCallerFlushResult;
+
 static GstStructure *gst_srt_object_accumulate_stats (GstSRTObject * srtobject,
     SRTSOCKET srtsock);
 
@@ -92,6 +119,8 @@ srt_caller_new (void)
   caller->sock = SRT_INVALID_SOCK;
   caller->poll_id = SRT_ERROR;
   caller->sent_headers = FALSE;
+  caller->payload_size = GST_SRT_DEFAULT_MSG_SIZE;
+  g_queue_init (&caller->queue);
 
   return caller;
 }
@@ -102,6 +131,8 @@ srt_caller_free (SRTCaller * caller)
   g_return_if_fail (caller != NULL);
 
   g_clear_object (&caller->sockaddr);
+  g_queue_foreach (&caller->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&caller->queue);
 
   if (caller->sock != SRT_INVALID_SOCK) {
     srt_close (caller->sock);
@@ -361,13 +392,18 @@ gst_srt_object_new (GstElement * element)
   srtobject->element = element;
   srtobject->parameters = gst_structure_new_empty ("application/x-srt-params");
   srtobject->sock = SRT_INVALID_SOCK;
+  srtobject->read_sock = SRT_INVALID_SOCK;
   srtobject->poll_id = srt_epoll_create ();
   srtobject->listener_sock = SRT_INVALID_SOCK;
   srtobject->listener_poll_id = SRT_ERROR;
   srtobject->sent_headers = FALSE;
   srtobject->wait_for_connection = GST_SRT_DEFAULT_WAIT_FOR_CONNECTION;
+  srtobject->sender_poll_id = SRT_ERROR;
+  srtobject->caller_queue_size = GST_SRT_DEFAULT_CALLER_QUEUE_SIZE;
+  srtobject->caller_drop_policy = GST_SRT_DEFAULT_CALLER_DROP_POLICY;
 
   g_cond_init (&srtobject->sock_cond);
+  g_cond_init (&srtobject->sender_cond);
   return srtobject;
 }
 
@@ -382,6 +418,7 @@ gst_srt_object_destroy (GstSRTObject * srtobject)
   }
 
   g_cond_clear (&srtobject->sock_cond);
+  g_cond_clear (&srtobject->sender_cond);
 
   GST_DEBUG_OBJECT (srtobject->element, "Destroying srtobject");
   gst_structure_free (srtobject->parameters);
@@ -437,6 +474,12 @@ gst_srt_object_set_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       srtobject->authentication = g_value_get_boolean (value);
       break;
+    case PROP_CALLER_QUEUE_SIZE:
+      srtobject->caller_queue_size = g_value_get_uint (value);
+      break;
+    case PROP_CALLER_DROP_POLICY:
+      srtobject->caller_drop_policy = g_value_get_enum (value);
+      break;
     default:
       goto err;
   }
@@ -544,6 +587,16 @@ gst_srt_object_get_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       g_value_set_boolean (value, srtobject->authentication);
       break;
+    case PROP_CALLER_QUEUE_SIZE:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->caller_queue_size);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_CALLER_DROP_POLICY:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_enum (value, srtobject->caller_drop_policy);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
     default:
       return FALSE;
   }
@@ -704,6 +757,36 @@ gst_srt_object_install_properties_helper (GObjectClass * gobject_class)
           "Authentication",
           "Authenticate a connection",
           FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:caller-queue-size:
+   *
+   * The maximum number of buffers queued for each caller in listener mode.
+   * Callers whose socket can't take more data are served by a separate
+   * thread, so that they don't delay the other callers and the streaming
+   * thread. When the queue is full, #GstSRTSink:caller-drop-policy applies.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_QUEUE_SIZE,
+      g_param_spec_uint ("caller-queue-size", "Caller queue size",
+          "Maximum number of buffers queued for each caller in listener mode",
+          1, G_MAXUINT, GST_SRT_DEFAULT_CALLER_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:caller-drop-policy:
+   *
+   * What to do when the queue of a caller is full in listener mode.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_DROP_POLICY,
+      g_param_spec_enum ("caller-drop-policy", "Caller drop policy",
+          "What to do when the queue of a caller is full in listener mode",
+          GST_TYPE_SRT_CALLER_DROP_POLICY, GST_SRT_DEFAULT_CALLER_DROP_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  gst_type_mark_as_plugin_api (GST_TYPE_SRT_CALLER_DROP_POLICY, 0);
 }
 
 static void
@@ -981,6 +1064,19 @@ thread_func (gpointer data)
         continue;
       }
 
+      if (gst_uri_handler_get_uri_type (GST_URI_HANDLER
+              (srtobject->element)) == GST_URI_SINK) {
+        gint optlen = sizeof (caller->payload_size);
+
+        if (srt_getsockflag (caller_sock, SRTO_PAYLOADSIZE,
+                &caller->payload_size, &optlen)) {
+          GST_WARNING_OBJECT (srtobject->element, "%s",
+              srt_getlasterror_str ());
+          srt_caller_free (caller);
+          continue;
+        }
+      }
+
       GST_DEBUG_OBJECT (srtobject->element, "Accept to connect %d",
           caller->sock);
 
@@ -1000,6 +1096,195 @@ thread_func (gpointer data)
   }
 }
 
+/* called with sock_lock */
+static void
+gst_srt_object_remove_caller (GstSRTObject * srtobject, SRTCaller * caller)
+{
+  srtobject->callers = g_list_remove (srtobject->callers, caller);
+
+  if (caller->blocked) {
+    srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+    srtobject->n_blocked_callers--;
+  }
+
+  srt_caller_signal_removed (caller, srtobject);
+  srt_caller_free (caller);
+}
+
+/* called with sock_lock */
+static gboolean
+srt_caller_enqueue (SRTCaller * caller, GstSRTObject * srtobject,
+    GstBuffer * buffer, guint max_size, GstSRTCallerDropPolicy drop_policy)
+{
+  if (g_queue_get_length (&caller->queue) >= max_size) {
+    GstBuffer *dropped;
+
+    switch (drop_policy) {
+      case GST_SRT_CALLER_DROP_POLICY_DISCONNECT:
+        GST_WARNING_OBJECT (srtobject->element, "Queue of caller %d is full,"
+            " disconnecting", caller->sock);
+        return FALSE;
+      case GST_SRT_CALLER_DROP_POLICY_DROP_NEWEST:
+        dropped = gst_buffer_ref (buffer);
+        break;
+      case GST_SRT_CALLER_DROP_POLICY_DROP_OLDEST:
+      default:
+        /* Don't cut the message that is being sent */
+        if (caller->offset > 0 && g_queue_get_length (&caller->queue) > 1)
+          dropped = g_queue_pop_nth (&caller->queue, 1);
+        else if (caller->offset > 0)
+          dropped = gst_buffer_ref (buffer);
+        else
+          dropped = g_queue_pop_head (&caller->queue);
+        break;
+    }
+
+    caller->dropped_buffers++;
+    caller->dropped_bytes += gst_buffer_get_size (dropped);
+    GST_LOG_OBJECT (srtobject->element, "Queue of caller %d is full, dropped"
+        " %" GST_PTR_FORMAT, caller->sock, dropped);
+
+    if (dropped == buffer) {
+      gst_buffer_unref (dropped);
+      return TRUE;
+    }
+    gst_buffer_unref (dropped);
+  }
+
+  g_queue_push_tail (&caller->queue, gst_buffer_ref (buffer));
+
+  return TRUE;
+}
+
+/* Sends as much of the queue of the caller as its socket takes without
+ * blocking.
+ * called with sock_lock */
+static SRTCallerFlushResult
+srt_caller_flush (SRTCaller * caller, GstSRTObject * srtobject)
+{
+  GstBuffer *buffer;
+
+  while ((buffer = g_queue_peek_head (&caller->queue))) {
+    GstMapInfo mapinfo;
+
+    if (!gst_buffer_map (buffer, &mapinfo, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (srtobject->element, RESOURCE, READ,
+          ("Could not map the input stream"), (NULL));
+      return SRT_CALLER_ERROR;
+    }
+
+    while (caller->offset < mapinfo.size) {
+      gint rest = MIN (mapinfo.size - caller->offset, caller->payload_size);
+      gint sent;
+
+      sent = srt_sendmsg2 (caller->sock,
+          (char *) (mapinfo.data + caller->offset), rest, 0);
+      if (sent < 0) {
+        gst_buffer_unmap (buffer, &mapinfo);
+
+        if (srt_getlasterror (NULL) == SRT_EASYNCSND)
+          return SRT_CALLER_BLOCKED;
+
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            caller->sock, srt_getlasterror_str ());
+        return SRT_CALLER_ERROR;
+      }
+      caller->offset += sent;
+    }
+
+    gst_buffer_unmap (buffer, &mapinfo);
+    gst_buffer_unref (g_queue_pop_head (&caller->queue));
+    caller->offset = 0;
+  }
+
+  return SRT_CALLER_DRAINED;
+}
+
+/* called with sock_lock */
+static gboolean
+gst_srt_object_block_caller (GstSRTObject * srtobject, SRTCaller * caller)
+{
+  gint flag = SRT_EPOLL_OUT | SRT_EPOLL_ERR;
+
+  GST_LOG_OBJECT (srtobject->element, "Caller %d is congested, %u buffers"
+      " queued", caller->sock, g_queue_get_length (&caller->queue));
+
+  if (srt_epoll_add_usock (srtobject->sender_poll_id, caller->sock, &flag)) {
+    GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+        caller->sock, srt_getlasterror_str ());
+    return FALSE;
+  }
+
+  caller->blocked = TRUE;
+  srtobject->n_blocked_callers++;
+  g_cond_signal (&srtobject->sender_cond);
+
+  return TRUE;
+}
+
+static gpointer
+sender_thread_func (gpointer data)
+{
+  GstSRTObject *srtobject = data;
+  SRTSOCKET wsocks[SENDER_MAX_EVENTS];
+
+  g_mutex_lock (&srtobject->sock_lock);
+
+  while (srtobject->sender_running) {
+    gint wsocklen = SENDER_MAX_EVENTS;
+    gint i;
+
+    if (srtobject->n_blocked_callers == 0) {
+      g_cond_wait (&srtobject->sender_cond, &srtobject->sock_lock);
+      continue;
+    }
+
+    g_mutex_unlock (&srtobject->sock_lock);
+    if (srt_epoll_wait (srtobject->sender_poll_id, NULL, 0, wsocks,
+            &wsocklen, SENDER_POLL_TIMEOUT, NULL, 0, NULL, 0) < 0) {
+      /* The last blocked caller may just have been removed */
+      if (srt_getlasterror (NULL) != SRT_ETIMEOUT)
+        g_usleep (G_USEC_PER_SEC / 100);
+      wsocklen = 0;
+    }
+    g_mutex_lock (&srtobject->sock_lock);
+
+    for (i = 0; i < wsocklen; i++) {
+      SRTCaller *caller = NULL;
+      GList *item;
+
+      for (item = srtobject->callers; item; item = item->next) {
+        if (((SRTCaller *) item->data)->sock == wsocks[i]) {
+          caller = item->data;
+          break;
+        }
+      }
+
+      if (!caller || !caller->blocked)
+        continue;
+
+      switch (srt_caller_flush (caller, srtobject)) {
+        case SRT_CALLER_DRAINED:
+          GST_LOG_OBJECT (srtobject->element, "Caller %d caught up",
+              caller->sock);
+          srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+          caller->blocked = FALSE;
+          srtobject->n_blocked_callers--;
+          break;
+        case SRT_CALLER_BLOCKED:
+          break;
+        case SRT_CALLER_ERROR:
+          gst_srt_object_remove_caller (srtobject, caller);
+          break;
+      }
+    }
+  }
+
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  return NULL;
+}
+
 static GSocketAddress *
 peeraddr_to_g_socket_address (const struct sockaddr *peeraddr)
 {
@@ -1147,6 +1432,20 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
     goto failed;
   }
 
+  if (gst_uri_handler_get_uri_type (GST_URI_HANDLER (srtobject->element)) ==
+      GST_URI_SINK) {
+    srtobject->sender_poll_id = srt_epoll_create ();
+    srtobject->sender_running = TRUE;
+    srtobject->sender_thread =
+        g_thread_try_new ("GstSRTObjectSender", sender_thread_func, srtobject,
+        error);
+    if (srtobject->sender_thread == NULL) {
+      GST_ERROR_OBJECT (srtobject->element, "Failed to start sender thread");
+      /* The listener thread is stopped on close */
+      return FALSE;
+    }
+  }
+
   return TRUE;
 
 failed:
@@ -1413,6 +1712,8 @@ gst_srt_object_close (GstSRTObject * srtobject)
     srtobject->sock = SRT_INVALID_SOCK;
   }
 
+  srtobject->read_sock = SRT_INVALID_SOCK;
+
   if (srtobject->listener_poll_id != SRT_ERROR) {
     if (srtobject->listener_sock != SRT_INVALID_SOCK) {
       srt_epoll_remove_usock (srtobject->listener_poll_id,
@@ -1429,6 +1730,15 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_mutex_lock (&srtobject->sock_lock);
   }
 
+  if (srtobject->sender_thread) {
+    GThread *thread = g_steal_pointer (&srtobject->sender_thread);
+    srtobject->sender_running = FALSE;
+    g_cond_signal (&srtobject->sender_cond);
+    g_mutex_unlock (&srtobject->sock_lock);
+    g_thread_join (thread);
+    g_mutex_lock (&srtobject->sock_lock);
+  }
+
   if (srtobject->listener_sock != SRT_INVALID_SOCK) {
     GST_DEBUG_OBJECT (srtobject->element, "Closing SRT listener socket (0x%x)",
         srtobject->listener_sock);
@@ -1443,6 +1753,12 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_list_free_full (callers, (GDestroyNotify) srt_caller_free);
   }
 
+  if (srtobject->sender_poll_id != SRT_ERROR) {
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+  }
+  srtobject->n_blocked_callers = 0;
+
   g_mutex_unlock (&srtobject->sock_lock);
 
   GST_OBJECT_LOCK (srtobject->element);
@@ -1584,12 +1900,43 @@ gst_srt_object_read (GstSRTObject * srtobject,
         return -1;
       }
     }
+    srtobject->read_sock = rsock;
     break;
   }
 
   return len;
 }
 
+/* Reads the next message already received on the socket of the last
+ * gst_srt_object_read() without waiting for it. Returns 0 once the receive
+ * buffer is drained; errors are left for the next gst_srt_object_read() to
+ * report, as it polls the socket again. */
+gssize
+gst_srt_object_read_pending (GstSRTObject * srtobject,
+    guint8 * data, gsize size, SRT_MSGCTRL * mctrl)
+{
+  gssize len;
+
+  if (srtobject->read_sock == SRT_INVALID_SOCK)
+    return 0;
+
+  srt_msgctrl_init (mctrl);
+  len = srt_recvmsg2 (srtobject->read_sock, (char *) (data), size, mctrl);
+
+  if (len == SRT_ERROR) {
+    gint srt_errno = srt_getlasterror (NULL);
+
+    if (srt_errno != SRT_EASYNCRCV) {
+      GST_DEBUG_OBJECT (srtobject->element,
+          "Stopped draining SRT socket: %s", srt_getlasterror_str ());
+    }
+    srt_clearlasterror ();
+    return 0;
+  }
+
+  return len;
+}
+
 void
 gst_srt_object_wakeup (GstSRTObject * srtobject, GCancellable * cancellable)
 {
@@ -1665,21 +2012,26 @@ gst_srt_object_send_headers (GstSRTObject * srtobject, SRTSOCKET sock,
   return TRUE;
 }
 
+/* Queues the buffer for every caller and sends right away to the ones that
+ * are not congested. The congested ones are left to the sender thread, so
+ * that they delay neither the other callers nor the streaming thread. */
 static gssize
 gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     GstBufferList * headers,
-    const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
+    GstBuffer * buffer, GCancellable * cancellable, GError ** error)
 {
   GList *callers;
+  guint max_size;
+  GstSRTCallerDropPolicy drop_policy;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  max_size = srtobject->caller_queue_size;
+  drop_policy = srtobject->caller_drop_policy;
+  GST_OBJECT_UNLOCK (srtobject->element);
 
   g_mutex_lock (&srtobject->sock_lock);
   callers = srtobject->callers;
   while (callers != NULL) {
-    gssize len = 0;
-    const guint8 *msg = mapinfo->data;
-    gint sent;
-    gint payload_size, optlen = sizeof (payload_size);
-
     SRTCaller *caller = callers->data;
     callers = callers->next;
 
@@ -1688,40 +2040,40 @@ gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     }
 
     if (!caller->sent_headers) {
-      if (!gst_srt_object_send_headers (srtobject, caller->sock, -1,
-              -1, headers, cancellable)) {
-        goto err;
-      }
+      guint i, n_headers = headers ? gst_buffer_list_length (headers) : 0;
+
+      GST_DEBUG_OBJECT (srtobject->element, "Queuing %u stream headers",
+          n_headers);
+
+      for (i = 0; i < n_headers; i++)
+        g_queue_push_tail (&caller->queue,
+            gst_buffer_ref (gst_buffer_list_get (headers, i)));
       caller->sent_headers = TRUE;
     }
 
-    if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &payload_size,
-            &optlen)) {
-      GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
+    if (!srt_caller_enqueue (caller, srtobject, buffer, max_size, drop_policy))
       goto err;
-    }
 
-    while (len < mapinfo->size) {
-      gint rest = MIN (mapinfo->size - len, payload_size);
-      sent = srt_sendmsg2 (caller->sock, (char *) (msg + len), rest, 0);
-      if (sent < 0) {
-        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
-            caller->sock, srt_getlasterror_str ());
-        goto err;
-      }
-      len += sent;
-    }
+    if (caller->blocked)
+      continue;
 
-    continue;
+    switch (srt_caller_flush (caller, srtobject)) {
+      case SRT_CALLER_DRAINED:
+        continue;
+      case SRT_CALLER_BLOCKED:
+        if (gst_srt_object_block_caller (srtobject, caller))
+          continue;
+        break;
+      case SRT_CALLER_ERROR:
+        break;
+    }
 
   err:
-    srtobject->callers = g_list_remove (srtobject->callers, caller);
-    srt_caller_signal_removed (caller, srtobject);
-    srt_caller_free (caller);
+    gst_srt_object_remove_caller (srtobject, caller);
   }
 
   g_mutex_unlock (&srtobject->sock_lock);
-  return mapinfo->size;
+  return gst_buffer_get_size (buffer);
 
 cancelled:
   g_mutex_unlock (&srtobject->sock_lock);
@@ -1820,7 +2172,7 @@ gst_srt_object_write_one (GstSRTObject * srtobject,
 gssize
 gst_srt_object_write (GstSRTObject * srtobject,
     GstBufferList * headers,
-    const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
+    GstBuffer * buffer, GCancellable * cancellable, GError ** error)
 {
   gssize len = 0;
   GstSRTConnectionMode connection_mode = GST_SRT_CONNECTION_MODE_NONE;
@@ -1842,12 +2194,22 @@ gst_srt_object_write (GstSRTObject * srtobject,
         return -1;
     }
     len =
-        gst_srt_object_write_to_callers (srtobject, headers, mapinfo,
+        gst_srt_object_write_to_callers (srtobject, headers, buffer,
         cancellable, error);
   } else {
+    GstMapInfo mapinfo;
+
+    if (!gst_buffer_map (buffer, &mapinfo, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (srtobject->element, RESOURCE, READ,
+          ("Could not map the input stream"), (NULL));
+      return -1;
+    }
+
     len =
-        gst_srt_object_write_one (srtobject, headers, mapinfo, cancellable,
+        gst_srt_object_write_one (srtobject, headers, &mapinfo, cancellable,
         error);
+
+    gst_buffer_unmap (buffer, &mapinfo);
   }
 
   return len;
@@ -1949,6 +2311,15 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
       gst_structure_set (tmp, "caller-address", G_TYPE_SOCKET_ADDRESS,
           caller->sockaddr, NULL);
 
+      if (is_sender) {
+        gst_structure_set (tmp,
+            /* buffers waiting in the queue of the caller */
+            "queued-buffers", G_TYPE_UINT, g_queue_get_length (&caller->queue),
+            /* buffers dropped because the queue of the caller was full */
+            "dropped-buffers", G_TYPE_UINT64, caller->dropped_buffers,
+            "dropped-bytes", G_TYPE_UINT64, caller->dropped_bytes, NULL);
+      }
+
       g_value_array_append (callers_stats, NULL);
       v = g_value_array_get_nth (callers_stats, callers_stats->n_values - 1);
       g_value_init (v, GST_TYPE_STRUCTURE);
@@ -42,6 +42,8 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_LATENCY 125
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define GST_SRT_DEFAULT_CALLER_QUEUE_SIZE 1000
+#define GST_SRT_DEFAULT_CALLER_DROP_POLICY GST_SRT_CALLER_DROP_POLICY_DROP_OLDEST
 
 typedef struct _GstSRTObject GstSRTObject;
 
@@ -56,6 +58,10 @@ struct _GstSRTObject
   gint                          poll_id;
   gboolean                      sent_headers;
 
+  /* Socket the last message was read from, drained by
+   * gst_srt_object_read_pending() */
+  SRTSOCKET                     read_sock;
+
   GTask                        *listener_task;
   SRTSOCKET                     listener_sock;
   gint                          listener_poll_id;
@@ -68,6 +74,17 @@ struct _GstSRTObject
 
   GList                        *callers;
 
+  /* Sends the queued buffers of the callers whose socket was full in
+   * listener mode */
+  GThread                      *sender_thread;
+  gint                          sender_poll_id;
+  gboolean                      sender_running;
+  GCond                         sender_cond;
+  guint                         n_blocked_callers;
+
+  guint                        caller_queue_size;
+  GstSRTCallerDropPolicy       caller_drop_policy;
+
   gboolean                     wait_for_connection;
 
   gboolean                     authentication;
@@ -103,9 +120,13 @@ gssize          gst_srt_object_read     (GstSRTObject * srtobject,
                                          GError **err,
 					 SRT_MSGCTRL *mctrl);
 
+gssize          gst_srt_object_read_pending (GstSRTObject * srtobject,
+                                         guint8 *data, gsize size,
+                                         SRT_MSGCTRL *mctrl);
+
 gssize          gst_srt_object_write    (GstSRTObject * srtobject,
                                          GstBufferList * headers,
-                                         const GstMapInfo * mapinfo,
+                                         GstBuffer * buffer,
                                          GCancellable *cancellable,
                                          GError **err);
 
@@ -180,7 +180,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstSRTSink *self = GST_SRT_SINK (sink);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
   GError *error = NULL;
 
   if (g_cancellable_is_cancelled (self->cancellable)) {
@@ -193,13 +192,7 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     return GST_FLOW_OK;
   }
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    GST_ELEMENT_ERROR (self, RESOURCE, READ,
-        ("Could not map the input stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-
-  if (gst_srt_object_write (self->srtobject, self->headers, &info,
+  if (gst_srt_object_write (self->srtobject, self->headers, buffer,
           self->cancellable, &error) < 0) {
     GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
         ("Failed to write to SRT socket: %s",
@@ -208,8 +201,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     ret = GST_FLOW_ERROR;
   }
 
-  gst_buffer_unmap (buffer, &info);
-
   GST_TRACE_OBJECT (self, "sending buffer %p, offset %"
       G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT
       ", timestamp %" GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
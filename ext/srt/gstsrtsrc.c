@@ -104,6 +104,38 @@ src_authentication_accumulator (GSignalInvocationHint * ihint,
   return ret;
 }
 
+/* Maximum number of messages drained from the socket per wakeup and pushed
+ * downstream as one buffer list */
+#define MAX_MESSAGES_PER_LIST 64
+
+static gboolean
+gst_srt_src_start_pool (GstSRTSrc * self)
+{
+  GstStructure *config;
+  guint blocksize = gst_base_src_get_blocksize (GST_BASE_SRC (self));
+
+  self->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (self->pool);
+  gst_buffer_pool_config_set_params (config, NULL, blocksize, 0, 0);
+
+  if (!gst_buffer_pool_set_config (self->pool, config) ||
+      !gst_buffer_pool_set_active (self->pool, TRUE)) {
+    gst_clear_object (&self->pool);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_srt_src_stop_pool (GstSRTSrc * self)
+{
+  if (self->pool) {
+    gst_buffer_pool_set_active (self->pool, FALSE);
+    gst_clear_object (&self->pool);
+  }
+}
+
 static gboolean
 gst_srt_src_start (GstBaseSrc * bsrc)
 {
@@ -115,6 +147,12 @@ gst_srt_src_start (GstBaseSrc * bsrc)
   gst_structure_get_enum (self->srtobject->parameters, "mode",
       GST_TYPE_SRT_CONNECTION_MODE, (gint *) & connection_mode);
 
+  if (!gst_srt_src_start_pool (self)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS, (NULL),
+        ("Failed to configure the buffer pool"));
+    return FALSE;
+  }
+
   ret = gst_srt_object_open (self->srtobject, self->cancellable, &error);
 
   if (!ret) {
@@ -122,6 +160,7 @@ gst_srt_src_start (GstBaseSrc * bsrc)
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
         ("Failed to open SRT: %s", error->message));
     g_clear_error (&error);
+    gst_srt_src_stop_pool (self);
   }
 
   /* Reset expected pktseq */
@@ -136,60 +175,172 @@ gst_srt_src_stop (GstBaseSrc * bsrc)
   GstSRTSrc *self = GST_SRT_SRC (bsrc);
 
   gst_srt_object_close (self->srtobject);
+  gst_srt_src_stop_pool (self);
 
   return TRUE;
 }
 
+/* Flags discontinuities and timestamps @buffer with the pipeline running
+ * time at which the message was sent, from the SRT source time of @mctrl */
+static void
+gst_srt_src_stamp_buffer (GstSRTSrc * self, GstBuffer * buffer,
+    const SRT_MSGCTRL * mctrl, GstClockTime capture_time,
+    GstClockTime base_time, int64_t srt_time)
+{
+  GstClockTimeDiff delay;
+
+  /* Detect discontinuities */
+  if (mctrl->pktseq != self->next_pktseq) {
+    GST_WARNING_OBJECT (self, "discont detected %d (expected: %d)",
+        mctrl->pktseq, self->next_pktseq);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  }
+  /* pktseq is a 31bit field */
+  self->next_pktseq = (mctrl->pktseq + 1) % G_MAXINT32;
+
+  /* 0 means we do not have a srctime */
+  if (mctrl->srctime != 0)
+    delay = (srt_time - mctrl->srctime) * GST_USECOND;
+  else
+    delay = 0;
+
+  GST_LOG_OBJECT (self, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
+
+  if (delay < 0) {
+    GST_WARNING_OBJECT (self,
+        "Calculated SRT delay %" GST_STIME_FORMAT " is negative, clamping to 0",
+        GST_STIME_ARGS (delay));
+    delay = 0;
+  }
+
+  /* Subtract the base_time (since the pipeline started) ... */
+  if (capture_time > base_time)
+    capture_time -= base_time;
+  else
+    capture_time = 0;
+  /* And adjust by the delay */
+  if (capture_time > delay)
+    capture_time -= delay;
+  else
+    capture_time = 0;
+  GST_BUFFER_TIMESTAMP (buffer) = capture_time;
+
+  GST_LOG_OBJECT (self,
+      "filled buffer of size %" G_GSIZE_FORMAT ", ts %" GST_TIME_FORMAT,
+      gst_buffer_get_size (buffer),
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)));
+}
+
+static int64_t
+gst_srt_src_get_srt_time (void)
+{
+#if SRT_VERSION_VALUE >= 0x10402
+  /* Use SRT clock value if available (SRT > 1.4.2) */
+  return srt_time_now ();
+#else
+  /* Else use the unix epoch monotonic clock */
+  return g_get_real_time ();
+#endif
+}
+
+/* Reads the messages already received after the first one of a wakeup into
+ * pooled buffers. Returns NULL if there were none. */
+static GstBufferList *
+gst_srt_src_drain (GstSRTSrc * self, GstClock * clock, GstClockTime base_time)
+{
+  GstBufferList *list = NULL;
+
+  while (!list || gst_buffer_list_length (list) < MAX_MESSAGES_PER_LIST - 1) {
+    GstBuffer *buffer = NULL;
+    GstMapInfo info;
+    SRT_MSGCTRL mctrl;
+    gssize recv_len;
+
+    if (gst_buffer_pool_acquire_buffer (self->pool, &buffer,
+            NULL) != GST_FLOW_OK)
+      break;
+
+    if (!gst_buffer_map (buffer, &info, GST_MAP_WRITE)) {
+      gst_buffer_unref (buffer);
+      break;
+    }
+
+    recv_len = gst_srt_object_read_pending (self->srtobject, info.data,
+        info.size, &mctrl);
+    gst_buffer_unmap (buffer, &info);
+
+    if (recv_len <= 0) {
+      gst_buffer_unref (buffer);
+      break;
+    }
+
+    GST_LOG_OBJECT (self,
+        "recv_len:%" G_GSIZE_FORMAT " pktseq:%d msgno:%d srctime:%"
+        G_GINT64_FORMAT " (pending)", recv_len, mctrl.pktseq, mctrl.msgno,
+        mctrl.srctime);
+
+    gst_buffer_resize (buffer, 0, recv_len);
+    gst_srt_src_stamp_buffer (self, buffer, &mctrl, gst_clock_get_time (clock),
+        base_time, gst_srt_src_get_srt_time ());
+
+    if (!list)
+      list = gst_buffer_list_new_sized (MAX_MESSAGES_PER_LIST);
+    gst_buffer_list_add (list, buffer);
+  }
+
+  return list;
+}
+
 static GstFlowReturn
-gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+gst_srt_src_create (GstPushSrc * src, GstBuffer ** outbuf)
 {
   GstSRTSrc *self = GST_SRT_SRC (src);
   GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buffer = NULL;
+  GstBufferList *list;
   GstMapInfo info;
   GError *err = NULL;
   gssize recv_len;
   GstClock *clock;
   GstClockTime base_time;
   GstClockTime capture_time;
-  GstClockTimeDiff delay;
   int64_t srt_time;
   SRT_MSGCTRL mctrl;
 
   if (g_cancellable_is_cancelled (self->cancellable)) {
-    ret = GST_FLOW_FLUSHING;
+    return GST_FLOW_FLUSHING;
   }
 
-  if (!gst_buffer_map (outbuf, &info, GST_MAP_WRITE)) {
+  ret = gst_buffer_pool_acquire_buffer (self->pool, &buffer, NULL);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (!gst_buffer_map (buffer, &info, GST_MAP_WRITE)) {
     GST_ELEMENT_ERROR (src, RESOURCE, READ,
         ("Could not map the buffer for writing "), (NULL));
-    ret = GST_FLOW_ERROR;
-    goto out;
+    gst_buffer_unref (buffer);
+    return GST_FLOW_ERROR;
   }
 
   /* Get clock and values */
   clock = gst_element_get_clock (GST_ELEMENT (src));
   if (!clock) {
     GST_DEBUG_OBJECT (src, "Clock missing, flushing");
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
     return GST_FLOW_FLUSHING;
   }
 
   base_time = gst_element_get_base_time (GST_ELEMENT (src));
 
-  recv_len = gst_srt_object_read (self->srtobject, info.data,
-      gst_buffer_get_size (outbuf), self->cancellable, &err, &mctrl);
+  recv_len = gst_srt_object_read (self->srtobject, info.data, info.size,
+      self->cancellable, &err, &mctrl);
 
   /* Capture clock values ASAP */
   capture_time = gst_clock_get_time (clock);
-#if SRT_VERSION_VALUE >= 0x10402
-  /* Use SRT clock value if available (SRT > 1.4.2) */
-  srt_time = srt_time_now ();
-#else
-  /* Else use the unix epoch monotonic clock */
-  srt_time = g_get_real_time ();
-#endif
-  gst_object_unref (clock);
+  srt_time = gst_srt_src_get_srt_time ();
 
-  gst_buffer_unmap (outbuf, &info);
+  gst_buffer_unmap (buffer, &info);
 
   GST_LOG_OBJECT (src,
       "recv_len:%" G_GSIZE_FORMAT " pktseq:%d msgno:%d srctime:%"
@@ -210,54 +361,29 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
     goto out;
   }
 
-  /* Detect discontinuities */
-  if (mctrl.pktseq != self->next_pktseq) {
-    GST_WARNING_OBJECT (src, "discont detected %d (expected: %d)",
-        mctrl.pktseq, self->next_pktseq);
-    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
-  }
-  /* pktseq is a 31bit field */
-  self->next_pktseq = (mctrl.pktseq + 1) % G_MAXINT32;
+  gst_buffer_resize (buffer, 0, recv_len);
+  gst_srt_src_stamp_buffer (self, buffer, &mctrl, capture_time, base_time,
+      srt_time);
 
-  /* 0 means we do not have a srctime */
-  if (mctrl.srctime != 0)
-    delay = (srt_time - mctrl.srctime) * GST_USECOND;
-  else
-    delay = 0;
-
-  GST_LOG_OBJECT (src, "delay: %" GST_STIME_FORMAT, GST_STIME_ARGS (delay));
+  /* Drain whatever else arrived with this wakeup, keeping one buffer per
+   * message so that message boundaries and timestamps are preserved */
+  list = gst_srt_src_drain (self, clock, base_time);
 
-  if (delay < 0) {
-    GST_WARNING_OBJECT (src,
-        "Calculated SRT delay %" GST_STIME_FORMAT " is negative, clamping to 0",
-        GST_STIME_ARGS (delay));
-    delay = 0;
+  if (list) {
+    gst_buffer_list_insert (list, 0, g_steal_pointer (&buffer));
+    GST_LOG_OBJECT (src, "pushing %u messages as a buffer list",
+        gst_buffer_list_length (list));
+    gst_base_src_submit_buffer_list (GST_BASE_SRC (src), list);
+    *outbuf = NULL;
+  } else {
+    *outbuf = g_steal_pointer (&buffer);
   }
 
-  /* Subtract the base_time (since the pipeline started) ... */
-  if (capture_time > base_time)
-    capture_time -= base_time;
-  else
-    capture_time = 0;
-  /* And adjust by the delay */
-  if (capture_time > delay)
-    capture_time -= delay;
-  else
-    capture_time = 0;
-  GST_BUFFER_TIMESTAMP (outbuf) = capture_time;
-
-  gst_buffer_resize (outbuf, 0, recv_len);
-
-  GST_LOG_OBJECT (src,
-      "filled buffer from _get of size %" G_GSIZE_FORMAT ", ts %"
-      GST_TIME_FORMAT ", dur %" GST_TIME_FORMAT
-      ", offset %" G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT,
-      gst_buffer_get_size (outbuf),
-      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (outbuf)),
-      GST_TIME_ARGS (GST_BUFFER_DURATION (outbuf)),
-      GST_BUFFER_OFFSET (outbuf), GST_BUFFER_OFFSET_END (outbuf));
-
 out:
+  gst_object_unref (clock);
+  if (buffer)
+    gst_buffer_unref (buffer);
+
   return ret;
 }
 
@@ -438,7 +564,7 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_srt_src_unlock_stop);
   gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_srt_src_query);
 
-  gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_src_fill);
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_src_create);
 }
 
 static GstURIType
@@ -50,6 +50,9 @@ struct _GstSRTSrc {
   GstSRTObject *srtobject;
   GCancellable *cancellable;
 
+  /* Receive buffers, one per SRT message */
+  GstBufferPool *pool;
+
   guint32       next_pktseq;
 };
 
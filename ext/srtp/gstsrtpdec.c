@@ -221,6 +221,15 @@ static GstSrtpDecSsrcStream *request_key_with_signal (GstSrtpDec * filter,
 struct _GstSrtpDecSsrcStream
 {
   guint32 ssrc;
+  gint refcount;
+
+  /* Protects the session, held while unprotecting packets of this SSRC */
+  GMutex lock;
+  srtp_t session;
+#ifndef HAVE_SRTP2
+  /* the ROC was set, the RTP sequence number must be set too */
+  gboolean roc_changed;
+#endif
 
   guint32 roc;
   GstBuffer *key;
@@ -417,8 +426,6 @@ gst_srtp_dec_init (GstSrtpDec * filter)
 
   gst_element_add_pad (GST_ELEMENT (filter), filter->rtcp_sinkpad);
   gst_element_add_pad (GST_ELEMENT (filter), filter->rtcp_srcpad);
-
-  filter->first_session = TRUE;
 }
 
 static GstStructure *
@@ -433,18 +440,21 @@ gst_srtp_dec_create_stats (GstSrtpDec * filter)
   g_value_init (&va, GST_TYPE_ARRAY);
   g_value_init (&v, GST_TYPE_STRUCTURE);
 
-  if (filter->session) {
+  if (filter->streams) {
     GHashTableIter iter;
-    gpointer key;
+    gpointer key, value;
 
     g_hash_table_iter_init (&iter, filter->streams);
-    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+      GstSrtpDecSsrcStream *stream = value;
       GstStructure *ss;
       guint32 ssrc = GPOINTER_TO_UINT (key);
       srtp_err_status_t status;
       guint32 roc;
 
-      status = srtp_get_stream_roc (filter->session, ssrc, &roc);
+      g_mutex_lock (&stream->lock);
+      status = srtp_get_stream_roc (stream->session, ssrc, &roc);
+      g_mutex_unlock (&stream->lock);
       if (status != srtp_err_status_ok) {
         continue;
       }
@@ -517,7 +527,9 @@ gst_srtp_dec_remove_stream (GstSrtpDec * filter, guint ssrc)
   stream = g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
 
   if (stream) {
-    srtp_remove_stream (filter->session, ssrc);
+    if (filter->last_stream == stream)
+      filter->last_stream = NULL;
+    /* The session goes away with the last packet using it */
     g_hash_table_remove (filter->streams, GUINT_TO_POINTER (ssrc));
   }
 }
@@ -525,7 +537,40 @@ gst_srtp_dec_remove_stream (GstSrtpDec * filter, guint ssrc)
 static GstSrtpDecSsrcStream *
 find_stream_by_ssrc (GstSrtpDec * filter, guint32 ssrc)
 {
-  return g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
+  GstSrtpDecSsrcStream *stream = filter->last_stream;
+
+  if (stream && stream->ssrc == ssrc)
+    return stream;
+
+  stream = g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
+  if (stream)
+    filter->last_stream = stream;
+
+  return stream;
+}
+
+static GstSrtpDecSsrcStream *
+ssrc_stream_ref (GstSrtpDecSsrcStream * stream)
+{
+  g_atomic_int_inc (&stream->refcount);
+
+  return stream;
+}
+
+static void
+ssrc_stream_unref (GstSrtpDecSsrcStream * stream)
+{
+  if (!g_atomic_int_dec_and_test (&stream->refcount))
+    return;
+
+  if (stream->session)
+    srtp_dealloc (stream->session);
+  if (stream->key)
+    gst_buffer_unref (stream->key);
+  if (stream->keys)
+    g_array_free (stream->keys, TRUE);
+  g_mutex_clear (&stream->lock);
+  g_slice_free (GstSrtpDecSsrcStream, stream);
 }
 
 #ifdef HAVE_SRTP2
@@ -553,6 +598,8 @@ get_stream_from_caps (GstSrtpDec * filter, GstCaps * caps, guint32 ssrc)
   /* Create new stream structure and set default values */
   stream = g_slice_new0 (GstSrtpDecSsrcStream);
   stream->ssrc = ssrc;
+  stream->refcount = 1;
+  g_mutex_init (&stream->lock);
   stream->key = NULL;
 
   /* Get info from caps */
@@ -661,7 +708,7 @@ get_stream_from_caps (GstSrtpDec * filter, GstCaps * caps, guint32 ssrc)
   return stream;
 
 error:
-  g_slice_free (GstSrtpDecSsrcStream, stream);
+  ssrc_stream_unref (stream);
   return NULL;
 }
 
@@ -680,7 +727,7 @@ signal_get_srtp_params (GstSrtpDec * filter, guint32 ssrc, gint signal)
   return caps;
 }
 
-/* Create a stream in the session
+/* Create the session of a stream and add the stream to the list
  */
 static srtp_err_status_t
 init_session_stream (GstSrtpDec * filter, guint32 ssrc,
@@ -744,13 +791,7 @@ init_session_stream (GstSrtpDec * filter, guint32 ssrc,
   policy.window_size = filter->replay_window_size;
   policy.next = NULL;
 
-  /* If it is the first stream, create the session
-   * If not, add the stream policy to the session
-   */
-  if (filter->first_session)
-    ret = srtp_create (&filter->session, &policy);
-  else
-    ret = srtp_add_stream (filter->session, &policy);
+  ret = srtp_create (&stream->session, &policy);
 
   if (stream->key)
     gst_buffer_unmap (stream->key, &map);
@@ -772,7 +813,7 @@ init_session_stream (GstSrtpDec * filter, guint32 ssrc,
   if (ret == srtp_err_status_ok) {
     srtp_err_status_t status;
 
-    status = srtp_set_stream_roc (filter->session, ssrc, stream->roc);
+    status = srtp_set_stream_roc (stream->session, ssrc, stream->roc);
 #ifdef HAVE_SRTP2
     (void) status;              /* Ignore unused variable */
 #else
@@ -780,11 +821,10 @@ init_session_stream (GstSrtpDec * filter, guint32 ssrc,
       /* Here, we just set the ROC, but we also need to set the initial
        * RTP sequence number later, otherwise libsrtp will not be able
        * to get the right packet index. */
-      g_hash_table_add (filter->streams_roc_changed, GUINT_TO_POINTER (ssrc));
+      stream->roc_changed = TRUE;
     }
 #endif
 
-    filter->first_session = FALSE;
     g_hash_table_insert (filter->streams, GUINT_TO_POINTER (stream->ssrc),
         stream);
   }
@@ -831,16 +871,6 @@ have_ssrc:
   return request_key_with_signal (filter, *ssrc, SIGNAL_REQUEST_KEY);
 }
 
-static void
-free_stream (GstSrtpDecSsrcStream * stream)
-{
-  if (stream->key)
-    gst_buffer_unref (stream->key);
-  if (stream->keys)
-    g_array_free (stream->keys, TRUE);
-  g_slice_free (GstSrtpDecSsrcStream, stream);
-}
-
 static gboolean
 buffers_are_equal (GstBuffer * a, GstBuffer * b)
 {
@@ -924,7 +954,7 @@ update_session_stream_from_caps (GstSrtpDec * filter, guint32 ssrc,
       stream->rtcp_auth == old_stream->rtcp_auth &&
       ((stream->keys && keys_are_equal (stream->keys, old_stream->keys)) ||
           buffers_are_equal (stream->key, old_stream->key))) {
-    free_stream (stream);
+    ssrc_stream_unref (stream);
     return old_stream;
   }
 
@@ -937,9 +967,7 @@ update_session_stream_from_caps (GstSrtpDec * filter, guint32 ssrc,
 
     if (err != srtp_err_status_ok) {
       GST_WARNING_OBJECT (filter, "Failed to create the stream (err: %d)", err);
-      if (stream->key)
-        gst_buffer_unref (stream->key);
-      g_slice_free (GstSrtpDecSsrcStream, stream);
+      ssrc_stream_unref (stream);
       stream = NULL;
     }
   }
@@ -962,16 +990,10 @@ gst_srtp_dec_clear_streams (GstSrtpDec * filter)
 
   GST_OBJECT_LOCK (filter);
 
-  if (!filter->first_session) {
-    srtp_dealloc (filter->session);
-    filter->session = NULL;
-  }
-
+  filter->last_stream = NULL;
   if (filter->streams)
     nb = g_hash_table_foreach_remove (filter->streams, remove_yes, NULL);
 
-  filter->first_session = TRUE;
-
   GST_OBJECT_UNLOCK (filter);
 
   GST_DEBUG_OBJECT (filter, "Cleared %d streams", nb);
@@ -1316,14 +1338,15 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * Takes ownership of @stream, which may be replaced on re-keying
  */
 static gboolean
 gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+    gboolean is_rtcp, GstSrtpDecSsrcStream * stream)
 {
   GstMapInfo map;
   srtp_err_status_t err;
+  guint32 ssrc = stream->ssrc;
   gint size;
 
   GST_LOG_OBJECT (pad, "Received %s buffer of size %" G_GSIZE_FORMAT
@@ -1338,28 +1361,27 @@ gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
 
 unprotect:
 
+  g_mutex_lock (&stream->lock);
+
   gst_srtp_init_event_reporter ();
 
   if (is_rtcp) {
 #ifdef HAVE_SRTP2
-    GstSrtpDecSsrcStream *stream = find_stream_by_ssrc (filter, ssrc);
-
-    err = srtp_unprotect_rtcp_mki (filter->session, map.data, &size,
-        stream && stream->keys);
+    err = srtp_unprotect_rtcp_mki (stream->session, map.data, &size,
+        stream->keys != NULL);
 #else
-    err = srtp_unprotect_rtcp (filter->session, map.data, &size);
+    err = srtp_unprotect_rtcp (stream->session, map.data, &size);
 #endif
   } else {
 #ifndef HAVE_SRTP2
     /* If ROC has changed, we know we need to set the initial RTP
      * sequence number too. */
-    if (g_hash_table_contains (filter->streams_roc_changed,
-            GUINT_TO_POINTER (ssrc))) {
-      srtp_stream_t stream;
+    if (stream->roc_changed) {
+      srtp_stream_t srtp_stream;
 
-      stream = srtp_get_stream (filter->session, htonl (ssrc));
+      srtp_stream = srtp_get_stream (stream->session, htonl (ssrc));
 
-      if (stream) {
+      if (srtp_stream) {
         guint16 seqnum = 0;
         GstRTPBuffer rtpbuf = GST_RTP_BUFFER_INIT;
 
@@ -1370,27 +1392,24 @@ unprotect:
 
         /* We finally add the RTP sequence number to the current
          * rollover counter. */
-        stream->rtp_rdbx.index &= ~0xFFFF;
-        stream->rtp_rdbx.index |= seqnum;
+        srtp_stream->rtp_rdbx.index &= ~0xFFFF;
+        srtp_stream->rtp_rdbx.index |= seqnum;
       }
 
-      g_hash_table_remove (filter->streams_roc_changed,
-          GUINT_TO_POINTER (ssrc));
+      stream->roc_changed = FALSE;
     }
 #endif
 
 #ifdef HAVE_SRTP2
-    {
-      GstSrtpDecSsrcStream *stream = find_stream_by_ssrc (filter, ssrc);
-
-      err = srtp_unprotect_mki (filter->session, map.data, &size,
-          stream && stream->keys);
-    }
+    err = srtp_unprotect_mki (stream->session, map.data, &size,
+        stream->keys != NULL);
 #else
-    err = srtp_unprotect (filter->session, map.data, &size);
+    err = srtp_unprotect (stream->session, map.data, &size);
 #endif
   }
 
+  g_mutex_unlock (&stream->lock);
+
   /* Signal user depending on type of error */
   switch (err) {
     case srtp_err_status_ok:
@@ -1405,20 +1424,19 @@ unprotect:
           "Dropping replayed old packet, probably retransmission");
       goto err;
     case srtp_err_status_key_expired:{
-      GstSrtpDecSsrcStream *stream;
+      GstSrtpDecSsrcStream *new_stream;
 
-      /* Check we have an existing stream to rekey */
-      stream = find_stream_by_ssrc (filter, ssrc);
-      if (stream == NULL) {
-        GST_WARNING_OBJECT (filter, "Could not find matching stream, dropping");
-        goto err;
-      }
+      ssrc_stream_unref (stream);
 
-      GST_OBJECT_UNLOCK (filter);
-      stream = request_key_with_signal (filter, ssrc, SIGNAL_HARD_LIMIT);
-      GST_OBJECT_LOCK (filter);
+      new_stream = request_key_with_signal (filter, ssrc, SIGNAL_HARD_LIMIT);
 
       /* Check the key request created a new stream */
+      GST_OBJECT_LOCK (filter);
+      stream = new_stream ? find_stream_by_ssrc (filter, ssrc) : NULL;
+      if (stream)
+        ssrc_stream_ref (stream);
+      GST_OBJECT_UNLOCK (filter);
+
       if (stream == NULL) {
         GST_WARNING_OBJECT (filter, "Hard limit reached, no new key, dropping");
         goto err;
@@ -1438,11 +1456,14 @@ unprotect:
       goto err;
   }
 
+  ssrc_stream_unref (stream);
   gst_buffer_unmap (buf, &map);
   gst_buffer_set_size (buf, size);
   return TRUE;
 
 err:
+  if (stream)
+    ssrc_stream_unref (stream);
   gst_buffer_unmap (buf, &map);
   return FALSE;
 }
@@ -1472,13 +1493,15 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
-    GST_OBJECT_UNLOCK (filter);
-    goto drop_buffer;
-  }
+  /* Only the stream is locked while unprotecting, so other SSRCs and the
+   * RTCP pad are not blocked */
+  ssrc_stream_ref (stream);
 
   GST_OBJECT_UNLOCK (filter);
 
+  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, stream))
+    goto drop_buffer;
+
   /* If all is well, we may have reached soft limit */
   if (gst_srtp_get_soft_limit_reached ())
     request_key_with_signal (filter, ssrc, SIGNAL_SOFT_LIMIT);
@@ -1532,12 +1555,7 @@ gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       filter->streams = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-          NULL, (GDestroyNotify) free_stream);
-
-#ifndef HAVE_SRTP2
-      filter->streams_roc_changed =
-          g_hash_table_new (g_direct_hash, g_direct_equal);
-#endif
+          NULL, (GDestroyNotify) ssrc_stream_unref);
 
       filter->rtp_has_segment = FALSE;
       filter->rtcp_has_segment = FALSE;
@@ -1561,11 +1579,6 @@ gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
       g_hash_table_unref (filter->streams);
       filter->streams = NULL;
 
-#ifndef HAVE_SRTP2
-      g_hash_table_unref (filter->streams_roc_changed);
-      filter->streams_roc_changed = NULL;
-#endif
-
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
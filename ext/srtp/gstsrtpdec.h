@@ -76,16 +76,13 @@ struct _GstSrtpDec
   GstPad *rtcp_sinkpad, *rtcp_srcpad;
 
   gboolean ask_update;
-  srtp_t session;
-  gboolean first_session;
+  /* ssrc -> GstSrtpDecSsrcStream, each with its own libsrtp session */
   GHashTable *streams;
+  /* stream of the last packet, saves a lookup for runs of the same SSRC */
+  GstSrtpDecSsrcStream *last_stream;
 
   gboolean rtp_has_segment;
   gboolean rtcp_has_segment;
-
-#ifndef HAVE_SRTP2
-  GHashTable *streams_roc_changed;
-#endif
 };
 
 struct _GstSrtpDecClass
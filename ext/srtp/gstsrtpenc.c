@@ -104,6 +104,12 @@
  * This element supports sending with a single Master Key, it is possible to set the
  * Master Key Identifier (MKI) using the "mki" property. If this property is set, the MKI
  * will be added to every buffer.
+ *
+ * Packets are protected in place, without any copy, when the incoming buffer
+ * is writable, made of a single memory and has enough spare room after the
+ * payload for the authentication tag and MKI (see #GstAllocationParams.padding).
+ * Otherwise the packet is copied into a buffer taken from an internal pool of
+ * recycled packet-sized buffers.
  */
 
 #include "gstsrtpelements.h"
@@ -132,6 +138,17 @@ GST_DEBUG_CATEGORY_STATIC (gst_srtp_enc_debug);
 #define DEFAULT_RANDOM_KEY      FALSE
 #define DEFAULT_REPLAY_WINDOW_SIZE 128
 #define DEFAULT_ALLOW_REPEAT_TX FALSE
+#define DEFAULT_N_THREADS       1
+
+/* Room needed after the payload for the authentication tag and MKI */
+#define SRTP_ENC_TRAILER_LEN (SRTP_MAX_TRAILER_LEN + 10)
+
+/* Size of the recycled output buffers, large enough for any packet that
+ * fits in a typical MTU once protected */
+#define SRTP_ENC_POOL_BUFFER_SIZE (1500 + SRTP_ENC_TRAILER_LEN)
+
+/* Buffer lists shorter than this are never split across worker threads */
+#define MIN_PARALLEL_LIST_LENGTH 16
 
 #define HAS_CRYPTO(filter) (filter->rtp_cipher != GST_SRTP_CIPHER_NULL || \
       filter->rtcp_cipher != GST_SRTP_CIPHER_NULL ||                      \
@@ -158,17 +175,46 @@ enum
   PROP_REPLAY_WINDOW_SIZE,
   PROP_ALLOW_REPEAT_TX,
   PROP_STATS,
-  PROP_MKI
+  PROP_MKI,
+  PROP_N_THREADS
 };
 
-typedef struct ProcessBufferItData
+struct _GstSrtpEncSsrcStream
+{
+  guint32 ssrc;
+  gint refcount;
+
+  /* Protects the session, held while protecting packets of this SSRC */
+  GMutex lock;
+  srtp_t session;
+  gboolean use_mki;
+};
+
+/* State shared by the jobs protecting one buffer list */
+typedef struct
 {
   GstSrtpEnc *filter;
-  GstPad *pad;
-  GstBufferList *out_list;
-  GstFlowReturn flowret;
   gboolean is_rtcp;
-} ProcessBufferItData;
+  GstBuffer **buffers;
+  /* index of the next buffer with the same SSRC, G_MAXUINT for the last */
+  guint *next;
+
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} ProtectListData;
+
+/* Protects, in order, all the buffers of a list with the same SSRC */
+typedef struct
+{
+  ProtectListData *data;
+  guint32 ssrc;
+  guint first;
+  guint last;
+
+  GstFlowReturn ret;
+  gboolean soft_limit_reached;
+} ProtectListJob;
 
 /* the capabilities of the inputs and outputs.
  *
@@ -335,6 +381,22 @@ gst_srtp_enc_class_init (GstSrtpEncClass * klass)
           GST_PARAM_MUTABLE_PLAYING));
 #endif
 
+  /**
+   * GstSrtpEnc:n-threads:
+   *
+   * Number of threads used to protect buffer lists. Packets of the same
+   * SSRC are always protected in order by the same thread, so this only
+   * helps with lists carrying several SSRCs, as with bundling.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Number of threads used to protect buffer lists "
+          "(0 = number of processors)", 0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   /**
    * GstSrtpEnc::soft-limit:
    * @gstsrtpenc: the element on which the signal is emitted
@@ -349,6 +411,26 @@ gst_srtp_enc_class_init (GstSrtpEncClass * klass)
 }
 
 
+static GstSrtpEncSsrcStream *
+ssrc_stream_ref (GstSrtpEncSsrcStream * stream)
+{
+  g_atomic_int_inc (&stream->refcount);
+
+  return stream;
+}
+
+static void
+ssrc_stream_unref (GstSrtpEncSsrcStream * stream)
+{
+  if (!g_atomic_int_dec_and_test (&stream->refcount))
+    return;
+
+  if (stream->session)
+    srtp_dealloc (stream->session);
+  g_mutex_clear (&stream->lock);
+  g_slice_free (GstSrtpEncSsrcStream, stream);
+}
+
 /* initialize the new element
  */
 static void
@@ -363,7 +445,9 @@ gst_srtp_enc_init (GstSrtpEnc * filter)
   filter->rtcp_auth = DEFAULT_RTCP_AUTH;
   filter->replay_window_size = DEFAULT_REPLAY_WINDOW_SIZE;
   filter->allow_repeat_tx = DEFAULT_ALLOW_REPEAT_TX;
-  filter->ssrcs_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+  filter->n_threads = DEFAULT_N_THREADS;
+  filter->streams = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) ssrc_stream_unref);
 }
 
 static guint
@@ -377,26 +461,13 @@ max_cipher_key_size (GstSrtpEnc * filter)
   return (rtp_size > rtcp_size) ? rtp_size : rtcp_size;
 }
 
-/* Create stream
+/* Check that the key matches the ciphers
  *
  * Should be called with the filter locked
  */
-static srtp_err_status_t
-gst_srtp_enc_create_session (GstSrtpEnc * filter)
+static gboolean
+gst_srtp_enc_check_key (GstSrtpEnc * filter)
 {
-  srtp_err_status_t ret;
-  srtp_policy_t policy;
-  GstMapInfo map;
-  guchar tmp[1];
-#ifdef HAVE_SRTP2
-  srtp_master_key_t mkey;
-  srtp_master_key_t *mkey_ptr = &mkey;
-  gboolean has_mki = FALSE;
-  GstMapInfo mki_map;
-#endif
-
-  memset (&policy, 0, sizeof (srtp_policy_t));
-
   if (HAS_CRYPTO (filter)) {
     guint expected;
     gsize keysize;
@@ -407,7 +478,7 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
           ("Cipher is not NULL, key must be set"),
           ("Cipher is not NULL, key must be set"));
       GST_OBJECT_LOCK (filter);
-      return srtp_err_status_fail;
+      return FALSE;
     }
 
     expected = max_cipher_key_size (filter);
@@ -420,10 +491,36 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
           ("Expected master key of %d bytes, but received %" G_GSIZE_FORMAT
               " bytes", expected, keysize));
       GST_OBJECT_LOCK (filter);
-      return srtp_err_status_fail;
+      return FALSE;
     }
   }
 
+  return TRUE;
+}
+
+/* Create the libsrtp session protecting one SSRC
+ *
+ * Should be called with the filter locked
+ */
+static srtp_err_status_t
+gst_srtp_enc_create_session (GstSrtpEnc * filter, srtp_t * session)
+{
+  srtp_err_status_t ret;
+  srtp_policy_t policy;
+  GstMapInfo map;
+  guchar tmp[1];
+#ifdef HAVE_SRTP2
+  srtp_master_key_t mkey;
+  srtp_master_key_t *mkey_ptr = &mkey;
+  gboolean has_mki = FALSE;
+  GstMapInfo mki_map;
+#endif
+
+  memset (&policy, 0, sizeof (srtp_policy_t));
+
+  if (!gst_srtp_enc_check_key (filter))
+    return srtp_err_status_fail;
+
   GST_DEBUG_OBJECT (filter, "Setting RTP/RTCP policy to %d / %d",
       filter->rtp_cipher, filter->rtcp_cipher);
   set_crypto_policy_cipher_auth (filter->rtp_cipher, filter->rtp_auth,
@@ -468,11 +565,7 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
   policy.window_size = filter->replay_window_size;
   policy.allow_repeat_tx = filter->allow_repeat_tx;
 
-  /* If it is the first stream, create the session
-   * If not, add the stream to the session
-   */
-  ret = srtp_create (&filter->session, &policy);
-  filter->first_session = FALSE;
+  ret = srtp_create (session, &policy);
 
 #ifdef HAVE_SRTP2
 done:
@@ -493,19 +586,67 @@ done:
 static void
 gst_srtp_enc_reset_no_lock (GstSrtpEnc * filter)
 {
-  if (!filter->first_session) {
-    if (filter->session) {
-      srtp_dealloc (filter->session);
-      filter->session = NULL;
-    }
-
-    g_hash_table_remove_all (filter->ssrcs_set);
-  }
+  if (!filter->first_session)
+    g_hash_table_remove_all (filter->streams);
 
   filter->first_session = TRUE;
   filter->key_changed = FALSE;
 }
 
+static void
+gst_srtp_enc_start_pool (GstSrtpEnc * filter)
+{
+  GstStructure *config;
+
+  filter->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (filter->pool);
+  gst_buffer_pool_config_set_params (config, NULL, SRTP_ENC_POOL_BUFFER_SIZE,
+      0, 0);
+  if (!gst_buffer_pool_set_config (filter->pool, config) ||
+      !gst_buffer_pool_set_active (filter->pool, TRUE)) {
+    GST_WARNING_OBJECT (filter, "Could not activate output buffer pool");
+    gst_clear_object (&filter->pool);
+  }
+}
+
+static void
+gst_srtp_enc_stop_pool (GstSrtpEnc * filter)
+{
+  if (filter->pool) {
+    gst_buffer_pool_set_active (filter->pool, FALSE);
+    gst_clear_object (&filter->pool);
+  }
+}
+
+static void protect_list_job_func (gpointer job, gpointer user_data);
+
+static void
+gst_srtp_enc_start_thread_pool (GstSrtpEnc * filter)
+{
+  guint n_threads;
+
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  /* The streaming thread takes its share of the jobs too */
+  if (n_threads > 1)
+    filter->thread_pool = g_thread_pool_new (protect_list_job_func, NULL,
+        n_threads - 1, FALSE, NULL);
+}
+
+static void
+gst_srtp_enc_stop_thread_pool (GstSrtpEnc * filter)
+{
+  if (filter->thread_pool) {
+    g_thread_pool_free (filter->thread_pool, FALSE, TRUE);
+    filter->thread_pool = NULL;
+  }
+}
+
 static void
 gst_srtp_enc_reset (GstSrtpEnc * filter)
 {
@@ -653,9 +794,12 @@ gst_srtp_enc_dispose (GObject * object)
   gst_buffer_replace (&filter->key, NULL);
   gst_buffer_replace (&filter->mki, NULL);
 
-  if (filter->ssrcs_set)
-    g_hash_table_unref (filter->ssrcs_set);
-  filter->ssrcs_set = NULL;
+  gst_srtp_enc_stop_pool (filter);
+  gst_srtp_enc_stop_thread_pool (filter);
+
+  if (filter->streams)
+    g_hash_table_unref (filter->streams);
+  filter->streams = NULL;
 
   G_OBJECT_CLASS (gst_srtp_enc_parent_class)->dispose (object);
 }
@@ -672,24 +816,26 @@ gst_srtp_enc_create_stats (GstSrtpEnc * filter)
   g_value_init (&va, GST_TYPE_ARRAY);
   g_value_init (&v, GST_TYPE_STRUCTURE);
 
-  if (filter->session) {
+  if (filter->streams) {
     GHashTableIter iter;
-    gpointer key;
+    gpointer value;
 
-    g_hash_table_iter_init (&iter, filter->ssrcs_set);
-    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    g_hash_table_iter_init (&iter, filter->streams);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+      GstSrtpEncSsrcStream *stream = value;
       GstStructure *ss;
-      guint32 ssrc = GPOINTER_TO_UINT (key);
       srtp_err_status_t status;
       guint32 roc;
 
-      status = srtp_get_stream_roc (filter->session, ssrc, &roc);
+      g_mutex_lock (&stream->lock);
+      status = srtp_get_stream_roc (stream->session, stream->ssrc, &roc);
+      g_mutex_unlock (&stream->lock);
       if (status != srtp_err_status_ok) {
         continue;
       }
 
       ss = gst_structure_new ("application/x-srtp-stream",
-          "ssrc", G_TYPE_UINT, ssrc, "roc", G_TYPE_UINT, roc, NULL);
+          "ssrc", G_TYPE_UINT, stream->ssrc, "roc", G_TYPE_UINT, roc, NULL);
 
       g_value_take_boxed (&v, ss);
       gst_value_array_append_value (&va, &v);
@@ -758,6 +904,9 @@ gst_srtp_enc_set_property (GObject * object, guint prop_id,
       GST_INFO_OBJECT (object, "Set property: mki=[%p]", filter->mki);
       break;
 #endif
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -808,6 +957,9 @@ gst_srtp_enc_get_property (GObject * object, guint prop_id,
         g_value_set_boxed (value, filter->mki);
       break;
 #endif
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -824,16 +976,6 @@ get_rtp_other_pad (GstPad * pad)
   return GST_PAD (gst_pad_get_element_private (pad));
 }
 
-static void
-gst_srtp_enc_add_ssrc (GstSrtpEnc * filter, guint ssrc)
-{
-  gboolean is_added =
-      g_hash_table_add (filter->ssrcs_set, GUINT_TO_POINTER (ssrc));
-  if (is_added) {
-    GST_DEBUG_OBJECT (filter, "Added ssrc %u", ssrc);
-  }
-}
-
 /* Release a sink pad and it's linked source pad
  */
 static void
@@ -883,12 +1025,6 @@ gst_srtp_enc_sink_setcaps (GstPad * pad, GstSrtpEnc * filter,
 
   GST_OBJECT_LOCK (filter);
 
-  if (gst_structure_has_field_typed (ps, "ssrc", G_TYPE_UINT)) {
-    guint ssrc;
-    gst_structure_get_uint (ps, "ssrc", &ssrc);
-    gst_srtp_enc_add_ssrc (filter, ssrc);
-  }
-
   if (HAS_CRYPTO (filter))
     gst_structure_set (ps, "srtp-key", GST_TYPE_BUFFER, filter->key, NULL);
 
@@ -1082,16 +1218,13 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
     do_setcaps = TRUE;
   }
 
+  /* The per-SSRC sessions are created when their first packet shows up */
   if (filter->first_session) {
-    srtp_err_status_t status = gst_srtp_enc_create_session (filter);
-
-    if (status != srtp_err_status_ok) {
+    if (!gst_srtp_enc_check_key (filter)) {
       GST_OBJECT_UNLOCK (filter);
-      GST_ELEMENT_ERROR (filter, LIBRARY, INIT,
-          ("Could not initialize SRTP encoder"),
-          ("Failed to add stream to SRTP encoder (err: %d)", status));
       return GST_FLOW_ERROR;
     }
+    filter->first_session = FALSE;
   }
 
   GST_OBJECT_UNLOCK (filter);
@@ -1111,97 +1244,236 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
-static void
-gst_srtp_enc_ensure_ssrc (GstSrtpEnc * filter, GstBuffer * buf)
+/* Returns a new reference to the stream protecting the packets with @ssrc,
+ * creating it if needed, or NULL with @ret set.
+ */
+static GstSrtpEncSsrcStream *
+gst_srtp_enc_get_stream (GstSrtpEnc * filter, guint32 ssrc,
+    GstFlowReturn * ret)
 {
-  GstRTPBuffer rtpbuf = GST_RTP_BUFFER_INIT;
-  if (gst_rtp_buffer_map (buf,
-          GST_MAP_READ | GST_RTP_BUFFER_MAP_FLAG_SKIP_PADDING, &rtpbuf)) {
-    guint32 ssrc = gst_rtp_buffer_get_ssrc (&rtpbuf);
-    gst_srtp_enc_add_ssrc (filter, ssrc);
-    gst_rtp_buffer_unmap (&rtpbuf);
+  GstSrtpEncSsrcStream *stream;
+  srtp_err_status_t status;
+
+  GST_OBJECT_LOCK (filter);
+
+  if (filter->first_session) {
+    /* The sessions disappeared (element shutting down) */
+    GST_OBJECT_UNLOCK (filter);
+    *ret = GST_FLOW_FLUSHING;
+    return NULL;
+  }
+
+  stream = g_hash_table_lookup (filter->streams, GUINT_TO_POINTER (ssrc));
+  if (stream) {
+    ssrc_stream_ref (stream);
+    GST_OBJECT_UNLOCK (filter);
+    return stream;
   }
+
+  stream = g_slice_new0 (GstSrtpEncSsrcStream);
+  stream->ssrc = ssrc;
+  stream->refcount = 1;
+  g_mutex_init (&stream->lock);
+#ifdef HAVE_SRTP2
+  stream->use_mki = (filter->mki != NULL);
+#endif
+
+  status = gst_srtp_enc_create_session (filter, &stream->session);
+  if (status != srtp_err_status_ok) {
+    GST_OBJECT_UNLOCK (filter);
+    ssrc_stream_unref (stream);
+    GST_ELEMENT_ERROR (filter, LIBRARY, INIT,
+        ("Could not initialize SRTP encoder"),
+        ("Failed to add stream to SRTP encoder (err: %d)", status));
+    *ret = GST_FLOW_ERROR;
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (filter, "Added ssrc %u", ssrc);
+  g_hash_table_insert (filter->streams, GUINT_TO_POINTER (ssrc),
+      ssrc_stream_ref (stream));
+
+  GST_OBJECT_UNLOCK (filter);
+
+  return stream;
 }
 
-static GstFlowReturn
-gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
-    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf_ptr)
+/* Get the SSRC libsrtp will look the stream up with */
+static gboolean
+gst_srtp_enc_get_ssrc (GstBuffer * buf, gboolean is_rtcp, guint32 * ssrc)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint size_max, size;
-  GstBuffer *bufout = NULL;
-  GstMapInfo mapout;
-  srtp_err_status_t err;
+  guint32 ssrc_be;
 
-  /* Create a bigger buffer to add protection */
-  size = gst_buffer_get_size (buf);
-  size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
+  if (gst_buffer_extract (buf, is_rtcp ? 4 : 8, &ssrc_be, 4) != 4)
+    return FALSE;
 
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  *ssrc = GUINT32_FROM_BE (ssrc_be);
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
+  return TRUE;
+}
 
-  GST_OBJECT_LOCK (filter);
+/* Returns TRUE if @buf can be protected without copying it: it must be
+ * writable, made of a single writable memory and have enough room after the
+ * payload for the SRTP trailer.
+ */
+static gboolean
+gst_srtp_enc_can_protect_in_place (GstBuffer * buf)
+{
+  GstMemory *mem;
 
-  gst_srtp_init_event_reporter ();
+  if (!gst_buffer_is_writable (buf) || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
 
-  if (filter->session == NULL) {
-    /* The rtcp session disappeared (element shutting down) */
-    GST_OBJECT_UNLOCK (filter);
-    ret = GST_FLOW_FLUSHING;
-    goto fail;
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (!gst_memory_is_writable (mem))
+    return FALSE;
+
+  return mem->maxsize - mem->offset - mem->size >= SRTP_ENC_TRAILER_LEN;
+}
+
+/* Returns a buffer of @size bytes with at least SRTP_ENC_TRAILER_LEN bytes of
+ * spare room after it. It comes from the pool unless the packet is too big
+ * for the pooled buffers.
+ */
+static GstBuffer *
+gst_srtp_enc_acquire_output_buffer (GstSrtpEnc * filter, gsize size)
+{
+  GstBuffer *bufout = NULL;
+
+  if (filter->pool && size + SRTP_ENC_TRAILER_LEN <= SRTP_ENC_POOL_BUFFER_SIZE) {
+    if (gst_buffer_pool_acquire_buffer (filter->pool, &bufout,
+            NULL) != GST_FLOW_OK)
+      bufout = NULL;
   }
 
-  gst_srtp_enc_ensure_ssrc (filter, buf);
+  if (!bufout)
+    bufout = gst_buffer_new_allocate (NULL, size + SRTP_ENC_TRAILER_LEN, NULL);
+
+  gst_buffer_set_size (bufout, size);
+
+  return bufout;
+}
+
+/* Returns a buffer with the content of @buf that can be protected in place,
+ * which is @buf itself when possible.
+ *
+ * Takes ownership of @buf
+ */
+static GstBuffer *
+gst_srtp_enc_prepare_buffer (GstSrtpEnc * filter, GstBuffer * buf)
+{
+  GstBuffer *bufout;
+  GstMapInfo mapout;
+  gsize size;
+
+  if (gst_srtp_enc_can_protect_in_place (buf))
+    return buf;
+
+  size = gst_buffer_get_size (buf);
+  bufout = gst_srtp_enc_acquire_output_buffer (filter, size);
+  gst_buffer_map (bufout, &mapout, GST_MAP_WRITE);
+  gst_buffer_extract (buf, 0, mapout.data, size);
+  gst_buffer_unmap (bufout, &mapout);
+  gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_unref (buf);
+
+  return bufout;
+}
+
+/* Protect a buffer returned by gst_srtp_enc_prepare_buffer()
+ *
+ * Should be called with the stream locked
+ */
+static srtp_err_status_t
+gst_srtp_enc_protect_buffer (GstSrtpEncSsrcStream * stream, GstBuffer * buf,
+    gboolean is_rtcp)
+{
+  GstMapInfo map;
+  srtp_err_status_t err;
+  gint size;
+
+  /* The mapping only covers the payload, libsrtp writes the trailer in the
+   * spare room that follows it in the same memory */
+  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  size = map.size;
 
 #ifdef HAVE_SRTP2
   if (is_rtcp)
-    err = srtp_protect_rtcp_mki (filter->session, mapout.data, &size,
-        (filter->mki != NULL), 0);
+    err = srtp_protect_rtcp_mki (stream->session, map.data, &size,
+        stream->use_mki, 0);
   else
-    err = srtp_protect_mki (filter->session, mapout.data, &size,
-        (filter->mki != NULL), 0);
+    err = srtp_protect_mki (stream->session, map.data, &size,
+        stream->use_mki, 0);
 #else
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    err = srtp_protect_rtcp (stream->session, map.data, &size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
+    err = srtp_protect (stream->session, map.data, &size);
 #endif
 
-  GST_OBJECT_UNLOCK (filter);
-
-  gst_buffer_unmap (bufout, &mapout);
-
-  if (err == srtp_err_status_ok) {
-    /* Buffer protected */
-    gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_unmap (buf, &map);
 
-    GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
-        is_rtcp ? "RTCP" : "RTP", size);
+  if (err == srtp_err_status_ok)
+    gst_buffer_set_size (buf, size);
 
-  } else if (err == srtp_err_status_key_expired) {
+  return err;
+}
 
+static GstFlowReturn
+gst_srtp_enc_protect_error (GstSrtpEnc * filter, srtp_err_status_t err)
+{
+  if (err == srtp_err_status_key_expired) {
     GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
         ("Key usage limit has been reached"),
         ("Unable to protect buffer (hard key usage limit reached)"));
-    ret = GST_FLOW_ERROR;
-    goto fail;
-
   } else {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
         ("Unable to protect buffer (protect failed) code %d", err));
-    ret = GST_FLOW_ERROR;
-    goto fail;
   }
 
-  *outbuf_ptr = bufout;
-  return ret;
+  return GST_FLOW_ERROR;
+}
+
+/* Takes ownership of @buf */
+static GstFlowReturn
+gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
+    GstBuffer * buf, gboolean is_rtcp, GstBuffer ** outbuf_ptr)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstSrtpEncSsrcStream *stream;
+  srtp_err_status_t err;
+  guint32 ssrc;
 
-fail:
-  gst_buffer_unref (bufout);
+  if (!gst_srtp_enc_get_ssrc (buf, is_rtcp, &ssrc)) {
+    gst_buffer_unref (buf);
+    return gst_srtp_enc_protect_error (filter, srtp_err_status_bad_param);
+  }
+
+  stream = gst_srtp_enc_get_stream (filter, ssrc, &ret);
+  if (!stream) {
+    gst_buffer_unref (buf);
+    return ret;
+  }
+
+  buf = gst_srtp_enc_prepare_buffer (filter, buf);
+
+  g_mutex_lock (&stream->lock);
+  gst_srtp_init_event_reporter ();
+  err = gst_srtp_enc_protect_buffer (stream, buf, is_rtcp);
+  g_mutex_unlock (&stream->lock);
+
+  ssrc_stream_unref (stream);
+
+  if (err != srtp_err_status_ok) {
+    gst_buffer_unref (buf);
+    return gst_srtp_enc_protect_error (filter, err);
+  }
+
+  GST_LOG_OBJECT (pad, "Encoding %s buffer of size %" G_GSIZE_FORMAT,
+      is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf));
+
+  *outbuf_ptr = buf;
   return ret;
 }
 
@@ -1215,6 +1487,7 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   GstBuffer *bufout = NULL;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK) {
+    gst_buffer_unref (buf);
     goto out;
   }
 
@@ -1253,27 +1526,55 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
   GST_OBJECT_UNLOCK (filter);
 
 out:
-  gst_buffer_unref (buf);
   return ret;
 }
 
-static gboolean
-process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
+static void
+gst_srtp_enc_protect_list_job (ProtectListJob * job)
 {
-  ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
-  GstFlowReturn ret;
+  ProtectListData *data = job->data;
+  GstSrtpEncSsrcStream *stream;
+  srtp_err_status_t err = srtp_err_status_ok;
+  guint i;
 
-  ret = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-      data->is_rtcp, &bufout);
-  if (ret != GST_FLOW_OK) {
-    data->flowret = ret;
-    return FALSE;
+  stream = gst_srtp_enc_get_stream (data->filter, job->ssrc, &job->ret);
+  if (!stream)
+    return;
+
+  /* Copy what can't be protected in place before taking the stream lock */
+  for (i = job->first; i != G_MAXUINT; i = data->next[i])
+    data->buffers[i] = gst_srtp_enc_prepare_buffer (data->filter,
+        data->buffers[i]);
+
+  g_mutex_lock (&stream->lock);
+  gst_srtp_init_event_reporter ();
+  for (i = job->first; i != G_MAXUINT; i = data->next[i]) {
+    err = gst_srtp_enc_protect_buffer (stream, data->buffers[i],
+        data->is_rtcp);
+    if (err != srtp_err_status_ok)
+      break;
   }
+  job->soft_limit_reached = gst_srtp_get_soft_limit_reached ();
+  g_mutex_unlock (&stream->lock);
 
-  gst_buffer_list_add (data->out_list, bufout);
+  ssrc_stream_unref (stream);
 
-  return TRUE;
+  if (err != srtp_err_status_ok)
+    job->ret = gst_srtp_enc_protect_error (data->filter, err);
+}
+
+static void
+protect_list_job_func (gpointer job_ptr, gpointer user_data)
+{
+  ProtectListJob *job = job_ptr;
+  ProtectListData *data = job->data;
+
+  gst_srtp_enc_protect_list_job (job);
+
+  g_mutex_lock (&data->lock);
+  if (--data->pending == 0)
+    g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
 }
 
 static GstFlowReturn
@@ -1283,13 +1584,16 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
-  ProcessBufferItData process_data;
+  ProtectListData data;
+  GArray *jobs;
+  gboolean soft_limit_reached = FALSE;
+  guint i, j, len;
+
+  len = gst_buffer_list_length (buf_list);
 
-  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
-      gst_buffer_list_length (buf_list));
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d", len);
 
-  if (!gst_buffer_list_length (buf_list))
+  if (!len)
     goto out;
 
   if ((ret = gst_srtp_enc_check_set_caps (filter, pad, is_rtcp)) != GST_FLOW_OK)
@@ -1305,50 +1609,121 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
   GST_OBJECT_UNLOCK (filter);
 
-  out_list = gst_buffer_list_new ();
+  /* Take the buffers out of the list, it is refilled with the protected
+   * ones afterwards. If the list was shared, only the list itself is copied
+   * and the buffers, which are then not writable, go through the pool. */
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  data.filter = filter;
+  data.is_rtcp = is_rtcp;
+  data.buffers = g_new (GstBuffer *, len);
+  data.next = g_new (guint, len);
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+
+  for (i = 0; i < len; i++) {
+    data.buffers[i] = gst_buffer_ref (gst_buffer_list_get (buf_list, i));
+    data.next[i] = G_MAXUINT;
+  }
+  gst_buffer_list_remove (buf_list, 0, len);
 
-  process_data.filter = filter;
-  process_data.pad = pad;
-  process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
-  process_data.flowret = GST_FLOW_OK;
+  /* One job per SSRC so each libsrtp stream sees its packets in order */
+  jobs = g_array_new (FALSE, FALSE, sizeof (ProtectListJob));
+  for (i = 0; i < len; i++) {
+    ProtectListJob *job = NULL;
+    guint32 ssrc;
 
-  if (!gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data)) {
-    ret = process_data.flowret;
-    goto out;
+    if (!gst_srtp_enc_get_ssrc (data.buffers[i], is_rtcp, &ssrc)) {
+      ret = gst_srtp_enc_protect_error (filter, srtp_err_status_bad_param);
+      goto done;
+    }
+
+    for (j = jobs->len; j > 0; j--) {
+      if (g_array_index (jobs, ProtectListJob, j - 1).ssrc == ssrc) {
+        job = &g_array_index (jobs, ProtectListJob, j - 1);
+        break;
+      }
+    }
+
+    if (job) {
+      data.next[job->last] = i;
+      job->last = i;
+    } else {
+      ProtectListJob new_job = { &data, ssrc, i, i, GST_FLOW_OK, FALSE };
+
+      g_array_append_val (jobs, new_job);
+    }
   }
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
-    ret = GST_FLOW_OK;
-    goto out;
+  if (filter->thread_pool && jobs->len > 1 && len >= MIN_PARALLEL_LIST_LENGTH) {
+    data.pending = jobs->len;
+
+    for (j = 1; j < jobs->len; j++)
+      g_thread_pool_push (filter->thread_pool,
+          &g_array_index (jobs, ProtectListJob, j), NULL);
+    protect_list_job_func (&g_array_index (jobs, ProtectListJob, 0), NULL);
+
+    g_mutex_lock (&data.lock);
+    while (data.pending > 0)
+      g_cond_wait (&data.cond, &data.lock);
+    g_mutex_unlock (&data.lock);
+  } else {
+    for (j = 0; j < jobs->len; j++)
+      gst_srtp_enc_protect_list_job (&g_array_index (jobs, ProtectListJob, j));
+  }
+
+  for (j = 0; j < jobs->len; j++) {
+    ProtectListJob *job = &g_array_index (jobs, ProtectListJob, j);
+
+    if (ret == GST_FLOW_OK)
+      ret = job->ret;
+    soft_limit_reached |= job->soft_limit_reached;
+  }
+
+  if (ret != GST_FLOW_OK)
+    goto done;
+
+  for (i = 0; i < len; i++) {
+    gst_buffer_list_add (buf_list, data.buffers[i]);
+    data.buffers[i] = NULL;
+  }
+
+done:
+  for (i = 0; i < len; i++) {
+    if (data.buffers[i])
+      gst_buffer_unref (data.buffers[i]);
   }
+  g_free (data.buffers);
+  g_free (data.next);
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+  g_array_free (jobs, TRUE);
+
+  if (ret != GST_FLOW_OK)
+    goto out;
 
   /* Push buffer to source pad */
   otherpad = get_rtp_other_pad (pad);
-  GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
-      gst_buffer_list_length (buf_list));
-  ret = gst_pad_push_list (otherpad, out_list);
+  GST_LOG_OBJECT (pad, "Pushing buffer chain of %d", len);
+  ret = gst_pad_push_list (otherpad, buf_list);
+  buf_list = NULL;
 
   if (ret != GST_FLOW_OK) {
     goto out;
   }
 
-  GST_OBJECT_LOCK (filter);
-
-  if (gst_srtp_get_soft_limit_reached ()) {
-    GST_OBJECT_UNLOCK (filter);
+  if (soft_limit_reached) {
     g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
     GST_OBJECT_LOCK (filter);
     if (filter->random_key && !filter->key_changed)
       gst_srtp_enc_replace_random_key (filter);
+    GST_OBJECT_UNLOCK (filter);
   }
 
-  GST_OBJECT_UNLOCK (filter);
-
 out:
 
-  gst_buffer_list_unref (buf_list);
+  if (buf_list)
+    gst_buffer_list_unref (buf_list);
 
   return ret;
 }
@@ -1423,6 +1798,8 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       GST_OBJECT_UNLOCK (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_srtp_enc_start_pool (filter);
+      gst_srtp_enc_start_thread_pool (filter);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -1438,6 +1815,8 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_srtp_enc_reset (filter);
+      gst_srtp_enc_stop_pool (filter);
+      gst_srtp_enc_stop_thread_pool (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -64,6 +64,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstSrtpEnc      GstSrtpEnc;
 typedef struct _GstSrtpEncClass GstSrtpEncClass;
+typedef struct _GstSrtpEncSsrcStream GstSrtpEncSsrcStream;
 
 struct _GstSrtpEnc
 {
@@ -78,14 +79,20 @@ struct _GstSrtpEnc
   guint rtcp_auth;
   GstBuffer *mki;
 
-  srtp_t session;
   gboolean first_session;
   gboolean key_changed;
 
   guint replay_window_size;
   gboolean allow_repeat_tx;
 
-  GHashTable *ssrcs_set;
+  /* ssrc -> GstSrtpEncSsrcStream, each with its own libsrtp session */
+  GHashTable *streams;
+
+  guint n_threads;
+  GThreadPool *thread_pool;
+
+  /* recycled output buffers for packets that can't be protected in place */
+  GstBufferPool *pool;
 };
 
 struct _GstSrtpEncClass
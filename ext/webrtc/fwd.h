@@ -45,6 +45,9 @@ typedef struct _GstWebRTCSCTPTransport GstWebRTCSCTPTransport;
 typedef struct _GstWebRTCSCTPTransportClass GstWebRTCSCTPTransportClass;
 typedef struct _GstWebRTCSCTPTransportPrivate GstWebRTCSCTPTransportPrivate;
 
+typedef struct _GstWebRTCStatsCache GstWebRTCStatsCache;
+typedef struct _GstWebRTCStatsSnapshot GstWebRTCStatsSnapshot;
+
 typedef struct _TransportStream TransportStream;
 typedef struct _TransportStreamClass TransportStreamClass;
 
@@ -440,6 +440,7 @@ enum
   ON_ICE_CANDIDATE_SIGNAL,
   ON_NEW_TRANSCEIVER_SIGNAL,
   GET_STATS_SIGNAL,
+  GET_CHANGED_STATS_SIGNAL,
   ADD_TRANSCEIVER_SIGNAL,
   GET_TRANSCEIVER_SIGNAL,
   GET_TRANSCEIVERS_SIGNAL,
@@ -822,6 +823,22 @@ _start_thread (GstWebRTCBin * webrtc)
   PC_UNLOCK (webrtc);
 }
 
+/* Waits for the stats requests in flight, which reply that the webrtcbin
+ * is closed once is_closed is set */
+static void
+_drain_stats_pool (GstWebRTCBin * webrtc)
+{
+  GThreadPool *pool;
+
+  GST_OBJECT_LOCK (webrtc);
+  pool = webrtc->priv->stats_pool;
+  webrtc->priv->stats_pool = NULL;
+  GST_OBJECT_UNLOCK (webrtc);
+
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+}
+
 static void
 _stop_thread (GstWebRTCBin * webrtc)
 {
@@ -836,6 +853,9 @@ _stop_thread (GstWebRTCBin * webrtc)
   PC_UNLOCK (webrtc);
 
   g_thread_unref (webrtc->priv->thread);
+
+  /* no more stats requests can be queued by the pc thread */
+  _drain_stats_pool (webrtc);
 }
 
 static gboolean
@@ -5654,57 +5674,130 @@ _on_local_ice_candidate_cb (GstWebRTCICE * ice, guint session_id,
 struct get_stats
 {
   GstPad *pad;
+  double since;
   GstPromise *promise;
+  GstWebRTCStatsSnapshot *snapshot;
 };
 
+static void
+_reply_stats_closed (GstPromise * promise)
+{
+  GError *error =
+      g_error_new (GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_CLOSED,
+      "Could not retrieve statistics. webrtcbin is closed.");
+  GstStructure *s = gst_structure_new ("application/x-gst-promise-error",
+      "error", G_TYPE_ERROR, error, NULL);
+
+  gst_promise_reply (promise, s);
+
+  g_clear_error (&error);
+}
+
 static void
 _free_get_stats (struct get_stats *stats)
 {
+  /* still there if the request never made it to the stats thread */
+  if (stats->promise) {
+    _reply_stats_closed (stats->promise);
+    gst_promise_unref (stats->promise);
+  }
   if (stats->pad)
     gst_object_unref (stats->pad);
-  if (stats->promise)
-    gst_promise_unref (stats->promise);
+  if (stats->snapshot)
+    gst_webrtc_stats_snapshot_free (stats->snapshot);
   g_free (stats);
 }
 
-/* https://www.w3.org/TR/webrtc/#dom-rtcpeerconnection-getstats() */
+/* https://www.w3.org/TR/webrtc/#dom-rtcpeerconnection-getstats()
+ *
+ * Runs in the stats thread of the webrtcbin. The pads to collect the stats
+ * of were looked up by _get_stats_task(), querying the rtp elements and
+ * building the structures happens here so that it doesn't hold up the pc
+ * thread. */
+static void
+_get_stats_func (struct get_stats *stats, GstWebRTCBin * webrtc)
+{
+  gboolean is_closed;
+
+  GST_OBJECT_LOCK (webrtc);
+  is_closed = webrtc->priv->is_closed;
+  GST_OBJECT_UNLOCK (webrtc);
+
+  if (!is_closed) {
+    gst_promise_reply (stats->promise,
+        gst_webrtc_bin_create_stats (webrtc, stats->snapshot, stats->since));
+    gst_clear_pointer (&stats->promise, gst_promise_unref);
+  }
+
+  _free_get_stats (stats);
+}
+
+/* Runs as a pc thread task so that the stats reflect the operations queued
+ * before the request, then hands the collection over to the stats thread.
+ * The stats thread has a single worker, so replies keep the order of the
+ * requests. */
 static GstStructure *
-_get_stats_task (GstWebRTCBin * webrtc, struct get_stats *stats)
+_get_stats_task (GstWebRTCBin * webrtc, struct get_stats *request)
 {
+  struct get_stats *stats;
+  GThreadPool *pool;
+
   /* Our selector is the pad,
    * https://www.w3.org/TR/webrtc/#dfn-stats-selection-algorithm
    */
+  stats = g_new0 (struct get_stats, 1);
+  stats->since = request->since;
+  stats->promise = g_steal_pointer (&request->promise);
+  stats->snapshot = gst_webrtc_stats_snapshot_new (webrtc, request->pad);
 
-  return gst_webrtc_bin_create_stats (webrtc, stats->pad);
+  GST_OBJECT_LOCK (webrtc);
+  if (!webrtc->priv->stats_pool)
+    webrtc->priv->stats_pool = g_thread_pool_new ((GFunc) _get_stats_func,
+        webrtc, 1, FALSE, NULL);
+  pool = webrtc->priv->stats_pool;
+  GST_OBJECT_UNLOCK (webrtc);
+
+  g_thread_pool_push (pool, stats, NULL);
+
+  return NULL;
 }
 
 static void
-gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
+_queue_get_stats (GstWebRTCBin * webrtc, GstPad * pad, double since,
     GstPromise * promise)
 {
   struct get_stats *stats;
 
-  g_return_if_fail (promise != NULL);
-  g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
-
   stats = g_new0 (struct get_stats, 1);
   stats->promise = gst_promise_ref (promise);
+  stats->since = since;
   /* FIXME: check that pad exists in element */
   if (pad)
     stats->pad = gst_object_ref (pad);
 
-  if (!gst_webrtc_bin_enqueue_task (webrtc, (GstWebRTCBinFunc) _get_stats_task,
-          stats, (GDestroyNotify) _free_get_stats, promise)) {
-    GError *error =
-        g_error_new (GST_WEBRTC_BIN_ERROR, GST_WEBRTC_BIN_ERROR_CLOSED,
-        "Could not retrieve statistics. webrtcbin is closed.");
-    GstStructure *s = gst_structure_new ("application/x-gst-promise-error",
-        "error", G_TYPE_ERROR, error, NULL);
+  /* replies to the promise if the request is not executed */
+  gst_webrtc_bin_enqueue_task (webrtc, (GstWebRTCBinFunc) _get_stats_task,
+      stats, (GDestroyNotify) _free_get_stats, NULL);
+}
 
-    gst_promise_reply (promise, s);
+static void
+gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
+    GstPromise * promise)
+{
+  g_return_if_fail (promise != NULL);
+  g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
 
-    g_clear_error (&error);
-  }
+  _queue_get_stats (webrtc, pad, -1.0, promise);
+}
+
+static void
+gst_webrtc_bin_get_changed_stats (GstWebRTCBin * webrtc, GstPad * pad,
+    gdouble since, GstPromise * promise)
+{
+  g_return_if_fail (promise != NULL);
+  g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
+
+  _queue_get_stats (webrtc, pad, MAX (since, 0.0), promise);
 }
 
 static GstWebRTCRTPTransceiver *
@@ -7024,6 +7117,10 @@ gst_webrtc_bin_finalize (GObject * object)
     gst_webrtc_session_description_free (webrtc->priv->last_generated_offer);
   webrtc->priv->last_generated_offer = NULL;
 
+  _drain_stats_pool (webrtc);
+  gst_webrtc_stats_cache_free (webrtc->priv->stats_cache);
+  webrtc->priv->stats_cache = NULL;
+
   g_mutex_clear (DC_GET_LOCK (webrtc));
   g_mutex_clear (ICE_GET_LOCK (webrtc));
   g_mutex_clear (PC_GET_LOCK (webrtc));
@@ -7289,6 +7386,13 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
    * (https://www.w3.org/TR/webrtc/#rtcstatsreport-object).  Each supported
    * field in the RTCStats subclass is outlined below.
    *
+   * The statistics are collected outside of the streaming and signalling
+   * threads, but the replies are in the same order as the requests and
+   * reflect all the operations queued on the webrtcbin before them.
+   *
+   * Use #GstWebRTCBin::get-changed-stats to only get the statistics that
+   * changed since a previous request.
+   *
    * Each statistics structure contains the following values as defined by
    * the RTCStats dictionary (https://www.w3.org/TR/webrtc/#rtcstats-dictionary).
    *
@@ -7346,6 +7450,28 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
       G_CALLBACK (gst_webrtc_bin_get_stats), NULL, NULL, NULL,
       G_TYPE_NONE, 2, GST_TYPE_PAD, GST_TYPE_PROMISE);
 
+  /**
+   * GstWebRTCBin::get-changed-stats:
+   * @object: the #webrtcbin
+   * @pad: (nullable): A #GstPad to get the stats for, or %NULL for all
+   * @since: a "timestamp" of a previously returned statistics structure
+   * @promise: a #GstPromise for the result
+   *
+   * Same as #GstWebRTCBin::get-stats, but the result only contains the
+   * statistics structures whose values changed after @since, and their
+   * "timestamp" is the time their values last changed instead of the time
+   * of the request. Passing the largest timestamp of a previous result of
+   * either signal returns the ones that changed since then. Statistics that
+   * went away are not reported.
+   *
+   * Since: 1.20
+   */
+  gst_webrtc_bin_signals[GET_CHANGED_STATS_SIGNAL] =
+      g_signal_new_class_handler ("get-changed-stats",
+      G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_webrtc_bin_get_changed_stats), NULL, NULL, NULL,
+      G_TYPE_NONE, 3, GST_TYPE_PAD, G_TYPE_DOUBLE, GST_TYPE_PROMISE);
+
   /**
    * GstWebRTCBin::on-negotiation-needed:
    * @object: the #webrtcbin
@@ -7505,6 +7631,8 @@ gst_webrtc_bin_init (GstWebRTCBin * webrtc)
   g_mutex_init (ICE_GET_LOCK (webrtc));
   g_mutex_init (DC_GET_LOCK (webrtc));
 
+  webrtc->priv->stats_cache = gst_webrtc_stats_cache_new ();
+
   webrtc->rtpbin = _create_rtpbin (webrtc);
   gst_bin_add (GST_BIN (webrtc), webrtc->rtpbin);
 
@@ -142,6 +142,12 @@ struct _GstWebRTCBinPrivate
   GstWebRTCSessionDescription *last_generated_answer;
 
   gboolean tos_attached;
+
+  /* the last stats objects, to only report what changed */
+  GstWebRTCStatsCache *stats_cache;
+  /* collects stats off the pc thread, created on the first request and
+   * protected by the object lock */
+  GThreadPool *stats_pool;
 };
 
 typedef GstStructure *(*GstWebRTCBinFunc) (GstWebRTCBin * webrtc, gpointer data);
@@ -81,18 +81,214 @@ _get_peer_connection_stats (GstWebRTCBin * webrtc)
   return s;
 }
 
+struct _GstWebRTCStatsCache
+{
+  GMutex lock;
+  /* incremented for each collection, to tell which objects are current */
+  guint64 generation;
+  GHashTable *stats;            /* id -> StatsCacheEntry */
+  GHashTable *sources;          /* key -> SourceCacheEntry */
+};
+
+/* The last version of an RTCStats object. Its timestamp is the time the
+ * values last changed */
+typedef struct
+{
+  GstStructure *stats;
+  guint64 generation;
+} StatsCacheEntry;
+
+/* The inputs the RTCStats objects of an rtp source were last built from,
+ * and the ids of those objects */
+typedef struct
+{
+  GstStructure *source_stats;
+  GstStructure *jb_stats;
+  gchar *codec_id;
+  gchar *transport_id;
+  gboolean have_remote;
+  GPtrArray *ids;
+  guint64 generation;
+} SourceCacheEntry;
+
+typedef struct
+{
+  guint32 ssrc;
+  GObject *jitterbuffer;
+} SsrcJitterBuffer;
+
+/* What is needed to collect the stats of a pad without the pc lock */
+typedef struct
+{
+  GstPad *pad;
+  guint session_id;
+  GstWebRTCDTLSTransport *transport;
+  GArray *jitterbuffers;        /* SsrcJitterBuffer */
+} PadStats;
+
+/* The pads to collect the stats of, taken with the pc lock */
+struct _GstWebRTCStatsSnapshot
+{
+  GPtrArray *pads;              /* PadStats */
+  gboolean all_pads;
+};
+
+typedef struct
+{
+  GstWebRTCBin *webrtc;
+  GstWebRTCStatsCache *cache;
+  GstStructure *s;
+  double ts;
+  double since;
+  /* collects the ids added while building the stats of an rtp source */
+  GPtrArray *added_ids;
+} StatsContext;
+
+static void
+_free_stats_cache_entry (StatsCacheEntry * entry)
+{
+  gst_structure_free (entry->stats);
+  g_free (entry);
+}
+
+static void
+_clear_source_cache_entry (SourceCacheEntry * entry)
+{
+  g_clear_pointer (&entry->source_stats, gst_structure_free);
+  g_clear_pointer (&entry->jb_stats, gst_structure_free);
+  g_clear_pointer (&entry->codec_id, g_free);
+  g_clear_pointer (&entry->transport_id, g_free);
+  g_clear_pointer (&entry->ids, g_ptr_array_unref);
+}
+
+static void
+_free_source_cache_entry (SourceCacheEntry * entry)
+{
+  _clear_source_cache_entry (entry);
+  g_free (entry);
+}
+
+GstWebRTCStatsCache *
+gst_webrtc_stats_cache_new (void)
+{
+  GstWebRTCStatsCache *cache = g_new0 (GstWebRTCStatsCache, 1);
+
+  g_mutex_init (&cache->lock);
+  cache->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) _free_stats_cache_entry);
+  cache->sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) _free_source_cache_entry);
+
+  return cache;
+}
+
+void
+gst_webrtc_stats_cache_free (GstWebRTCStatsCache * cache)
+{
+  g_hash_table_unref (cache->stats);
+  g_hash_table_unref (cache->sources);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+static gboolean
+_field_equal (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  const GstStructure *other = user_data;
+  const GValue *other_value;
+
+  if (field_id == g_quark_from_static_string ("timestamp"))
+    return TRUE;
+
+  other_value = gst_structure_id_get_value (other, field_id);
+
+  return other_value && gst_value_compare (value,
+      other_value) == GST_VALUE_EQUAL;
+}
+
+/* compares everything but the timestamps */
+static gboolean
+_stats_equal (const GstStructure * a, const GstStructure * b)
+{
+  if (gst_structure_n_fields (a) != gst_structure_n_fields (b))
+    return FALSE;
+
+  return gst_structure_foreach (a, _field_equal, (gpointer) b);
+}
+
+static gboolean
+_structure_equal (const GstStructure * a, const GstStructure * b)
+{
+  if (!a || !b)
+    return a == b;
+
+  return gst_structure_is_equal (a, b);
+}
+
+static void
+_output_stats (StatsContext * ctx, const gchar * id, StatsCacheEntry * entry)
+{
+  double ts = 0.0;
+
+  entry->generation = ctx->cache->generation;
+
+  /* a plain request reports every object with its own time */
+  if (ctx->since < 0) {
+    GValue value = G_VALUE_INIT;
+    GstStructure *stats = gst_structure_copy (entry->stats);
+
+    gst_structure_set (stats, "timestamp", G_TYPE_DOUBLE, ctx->ts, NULL);
+    g_value_init (&value, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&value, stats);
+    gst_structure_take_value (ctx->s, id, &value);
+    return;
+  }
+
+  gst_structure_get_double (entry->stats, "timestamp", &ts);
+  if (ts > ctx->since)
+    gst_structure_set (ctx->s, id, GST_TYPE_STRUCTURE, entry->stats, NULL);
+}
+
+/* Takes ownership of @stats. If the cached object with the same @id has the
+ * same values, that one is used instead and keeps its timestamp */
 static void
-_gst_structure_take_structure (GstStructure * s, const char *fieldname,
-    GstStructure ** value_s)
+_add_stats (StatsContext * ctx, const gchar * id, GstStructure * stats)
 {
-  GValue v = G_VALUE_INIT;
+  StatsCacheEntry *entry = g_hash_table_lookup (ctx->cache->stats, id);
 
-  g_value_init (&v, GST_TYPE_STRUCTURE);
-  g_value_take_boxed (&v, *value_s);
+  if (entry && _stats_equal (entry->stats, stats)) {
+    gst_structure_free (stats);
+  } else if (entry) {
+    gst_structure_free (entry->stats);
+    entry->stats = stats;
+  } else {
+    entry = g_new0 (StatsCacheEntry, 1);
+    entry->stats = stats;
+    g_hash_table_insert (ctx->cache->stats, g_strdup (id), entry);
+  }
+
+  if (ctx->added_ids)
+    g_ptr_array_add (ctx->added_ids, g_strdup (id));
+
+  _output_stats (ctx, id, entry);
+}
+
+static void
+_reuse_stats (StatsContext * ctx, const gchar * id)
+{
+  StatsCacheEntry *entry = g_hash_table_lookup (ctx->cache->stats, id);
+
+  if (entry)
+    _output_stats (ctx, id, entry);
+}
 
-  gst_structure_take_value (s, fieldname, &v);
+/* whether the object was added by the current collection */
+static gboolean
+_have_stats (StatsContext * ctx, const gchar * id)
+{
+  StatsCacheEntry *entry = g_hash_table_lookup (ctx->cache->stats, id);
 
-  *value_s = NULL;
+  return entry && entry->generation == ctx->cache->generation;
 }
 
 #define CLOCK_RATE_VALUE_TO_SECONDS(v,r) ((double) v / (double) clock_rate)
@@ -101,10 +297,9 @@ _gst_structure_take_structure (GstStructure * s, const char *fieldname,
 
 /* https://www.w3.org/TR/webrtc-stats/#remoteinboundrtpstats-dict* */
 static gboolean
-_get_stats_from_remote_rtp_source_stats (GstWebRTCBin * webrtc,
-    TransportStream * stream, const GstStructure * source_stats,
-    guint ssrc, guint clock_rate, const gchar * codec_id,
-    const gchar * transport_id, GstStructure * s)
+_get_stats_from_remote_rtp_source_stats (StatsContext * ctx,
+    const GstStructure * source_stats, guint ssrc, guint clock_rate,
+    const gchar * codec_id, const gchar * transport_id)
 {
   gboolean have_rb = FALSE, internal = FALSE;
   int lost;
@@ -112,9 +307,8 @@ _get_stats_from_remote_rtp_source_stats (GstWebRTCBin * webrtc,
   gchar *r_in_id, *out_id;
   guint32 rtt;
   guint fraction_lost, jitter;
-  double ts;
+  double ts = ctx->ts;
 
-  gst_structure_get_double (s, "timestamp", &ts);
   gst_structure_get (source_stats, "internal", G_TYPE_BOOLEAN, &internal,
       "have-rb", G_TYPE_BOOLEAN, &have_rb, NULL);
 
@@ -190,7 +384,7 @@ _get_stats_from_remote_rtp_source_stats (GstWebRTCBin * webrtc,
   gst_structure_set (r_in, "gst-rtpsource-stats", GST_TYPE_STRUCTURE,
       source_stats, NULL);
 
-  _gst_structure_take_structure (s, r_in_id, &r_in);
+  _add_stats (ctx, r_in_id, r_in);
 
   g_free (r_in_id);
   g_free (out_id);
@@ -201,17 +395,16 @@ _get_stats_from_remote_rtp_source_stats (GstWebRTCBin * webrtc,
 /* https://www.w3.org/TR/webrtc-stats/#inboundrtpstats-dict*
    https://www.w3.org/TR/webrtc-stats/#outboundrtpstats-dict* */
 static void
-_get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
-    TransportStream * stream, const GstStructure * source_stats,
-    const gchar * codec_id, const gchar * transport_id, GstStructure * s)
+_get_stats_from_rtp_source_stats (StatsContext * ctx,
+    const GstStructure * source_stats, const GstStructure * jb_stats,
+    const gchar * codec_id, const gchar * transport_id)
 {
   guint ssrc, fir, pli, nack, jitter;
   int clock_rate;
   guint64 packets, bytes;
   gboolean internal;
-  double ts;
+  double ts = ctx->ts;
 
-  gst_structure_get_double (s, "timestamp", &ts);
   gst_structure_get (source_stats, "ssrc", G_TYPE_UINT, &ssrc, "clock-rate",
       G_TYPE_INT, &clock_rate, "internal", G_TYPE_BOOLEAN, &internal, NULL);
 
@@ -248,7 +441,7 @@ _get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
     /* XXX: mediaType, trackId, sliCount, qpSum */
 
     r_in_id = g_strdup_printf ("rtp-remote-inbound-stream-stats_%u", ssrc);
-    if (gst_structure_has_field (s, r_in_id))
+    if (_have_stats (ctx, r_in_id))
       gst_structure_set (out, "remote-id", G_TYPE_STRING, r_in_id, NULL);
     g_free (r_in_id);
 
@@ -304,33 +497,17 @@ _get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
     gst_structure_set (out, "gst-rtpsource-stats", GST_TYPE_STRUCTURE,
         source_stats, NULL);
 
-    _gst_structure_take_structure (s, out_id, &out);
+    _add_stats (ctx, out_id, out);
 
     g_free (out_id);
   } else {
     GstStructure *in, *r_out;
     gchar *r_out_id, *in_id;
     gboolean have_sr = FALSE;
-    GstStructure *jb_stats = NULL;
-    guint i;
     guint64 jb_lost, duplicates, late, rtx_success;
 
     gst_structure_get (source_stats, "have-sr", G_TYPE_BOOLEAN, &have_sr, NULL);
 
-    for (i = 0; i < stream->remote_ssrcmap->len; i++) {
-      SsrcMapItem *item = g_ptr_array_index (stream->remote_ssrcmap, i);
-
-      if (item->ssrc == ssrc) {
-        GObject *jb = g_weak_ref_get (&item->rtpjitterbuffer);
-
-        if (jb) {
-          g_object_get (jb, "stats", &jb_stats, NULL);
-          g_object_unref (jb);
-        }
-        break;
-      }
-    }
-
     if (jb_stats)
       gst_structure_get (jb_stats, "num-lost", G_TYPE_UINT64, &jb_lost,
           "num-duplicates", G_TYPE_UINT64, &duplicates, "num-late",
@@ -541,13 +718,14 @@ _get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
     /* Store the raw stats from GStreamer into the structure for advanced
      * information.
      */
-    _gst_structure_take_structure (in, "gst-rtpjitterbuffer-stats", &jb_stats);
+    gst_structure_set (in, "gst-rtpjitterbuffer-stats", GST_TYPE_STRUCTURE,
+        jb_stats, NULL);
 
     gst_structure_set (in, "gst-rtpsource-stats", GST_TYPE_STRUCTURE,
         source_stats, NULL);
 
-    _gst_structure_take_structure (s, in_id, &in);
-    _gst_structure_take_structure (s, r_out_id, &r_out);
+    _add_stats (ctx, in_id, in);
+    _add_stats (ctx, r_out_id, r_out);
 
     g_free (in_id);
     g_free (r_out_id);
@@ -556,15 +734,12 @@ _get_stats_from_rtp_source_stats (GstWebRTCBin * webrtc,
 
 /* https://www.w3.org/TR/webrtc-stats/#candidatepair-dict* */
 static gchar *
-_get_stats_from_ice_transport (GstWebRTCBin * webrtc,
-    GstWebRTCICETransport * transport, const GstStructure * twcc_stats,
-    GstStructure * s)
+_get_stats_from_ice_transport (StatsContext * ctx,
+    GstWebRTCICETransport * transport, const GstStructure * twcc_stats)
 {
   GstStructure *stats;
   gchar *id;
-  double ts;
-
-  gst_structure_get_double (s, "timestamp", &ts);
+  double ts = ctx->ts;
 
   id = g_strdup_printf ("ice-candidate-pair_%s", GST_OBJECT_NAME (transport));
   stats = gst_structure_new_empty (id);
@@ -624,25 +799,21 @@ _get_stats_from_ice_transport (GstWebRTCBin * webrtc,
     gst_structure_set (stats, "gst-twcc-stats", GST_TYPE_STRUCTURE, twcc_stats,
         NULL);
 
-  gst_structure_set (s, id, GST_TYPE_STRUCTURE, stats, NULL);
-  gst_structure_free (stats);
+  _add_stats (ctx, id, stats);
 
   return id;
 }
 
 /* https://www.w3.org/TR/webrtc-stats/#dom-rtctransportstats */
 static gchar *
-_get_stats_from_dtls_transport (GstWebRTCBin * webrtc,
-    GstWebRTCDTLSTransport * transport, const GstStructure * twcc_stats,
-    GstStructure * s)
+_get_stats_from_dtls_transport (StatsContext * ctx,
+    GstWebRTCDTLSTransport * transport, const GstStructure * twcc_stats)
 {
   GstStructure *stats;
   gchar *id;
-  double ts;
+  double ts = ctx->ts;
   gchar *ice_id;
 
-  gst_structure_get_double (s, "timestamp", &ts);
-
   id = g_strdup_printf ("transport-stats_%s", GST_OBJECT_NAME (transport));
   stats = gst_structure_new_empty (id);
   _set_base_stats (stats, GST_WEBRTC_STATS_TRANSPORT, ts, id);
@@ -679,54 +850,138 @@ _get_stats_from_dtls_transport (GstWebRTCBin * webrtc,
     boolean             deleted = false;
 */
 
-  gst_structure_set (s, id, GST_TYPE_STRUCTURE, stats, NULL);
-  gst_structure_free (stats);
+  _add_stats (ctx, id, stats);
 
-  ice_id =
-      _get_stats_from_ice_transport (webrtc, transport->transport, twcc_stats,
-      s);
+  ice_id = _get_stats_from_ice_transport (ctx, transport->transport,
+      twcc_stats);
   g_free (ice_id);
 
   return id;
 }
 
+static GstStructure *
+_get_jitterbuffer_stats (PadStats * pstats, guint ssrc)
+{
+  GstStructure *jb_stats = NULL;
+  guint i;
+
+  for (i = 0; i < pstats->jitterbuffers->len; i++) {
+    SsrcJitterBuffer *item =
+        &g_array_index (pstats->jitterbuffers, SsrcJitterBuffer, i);
+
+    if (item->ssrc == ssrc) {
+      g_object_get (item->jitterbuffer, "stats", &jb_stats, NULL);
+      break;
+    }
+  }
+
+  return jb_stats;
+}
+
+/* Builds the RTCStats objects of an rtp source, or outputs the ones built
+ * previously if the rtp source stats didn't change since */
 static void
-_get_stats_from_transport_channel (GstWebRTCBin * webrtc,
-    TransportStream * stream, const gchar * codec_id, guint ssrc,
-    guint clock_rate, GstStructure * s)
+_get_stats_from_source (StatsContext * ctx, PadStats * pstats,
+    const GstStructure * source_stats, gboolean remote, guint ssrc,
+    guint clock_rate, const gchar * codec_id, const gchar * transport_id)
 {
-  GstWebRTCDTLSTransport *transport;
+  GstWebRTCStatsCache *cache = ctx->cache;
+  SourceCacheEntry *entry;
+  GstStructure *jb_stats = NULL;
+  gboolean internal = FALSE, have_remote = FALSE;
+  gchar *key;
+  guint i;
+
+  if (!remote) {
+    gst_structure_get (source_stats, "internal", G_TYPE_BOOLEAN, &internal,
+        NULL);
+    if (internal) {
+      gchar *r_in_id =
+          g_strdup_printf ("rtp-remote-inbound-stream-stats_%u", ssrc);
+
+      have_remote = _have_stats (ctx, r_in_id);
+      g_free (r_in_id);
+    } else {
+      jb_stats = _get_jitterbuffer_stats (pstats, ssrc);
+    }
+  }
+
+  key = g_strdup_printf ("%s_%u_%u", remote ? "remote" : "local",
+      pstats->session_id, ssrc);
+  entry = g_hash_table_lookup (cache->sources, key);
+
+  if (entry && entry->have_remote == have_remote &&
+      _structure_equal (entry->source_stats, source_stats) &&
+      _structure_equal (entry->jb_stats, jb_stats) &&
+      g_strcmp0 (entry->codec_id, codec_id) == 0 &&
+      g_strcmp0 (entry->transport_id, transport_id) == 0) {
+    GST_TRACE_OBJECT (ctx->webrtc, "reusing stats of %s", key);
+
+    for (i = 0; i < entry->ids->len; i++)
+      _reuse_stats (ctx, g_ptr_array_index (entry->ids, i));
+    entry->generation = cache->generation;
+
+    if (jb_stats)
+      gst_structure_free (jb_stats);
+    g_free (key);
+    return;
+  }
+
+  if (entry) {
+    _clear_source_cache_entry (entry);
+    g_free (key);
+  } else {
+    entry = g_new0 (SourceCacheEntry, 1);
+    g_hash_table_insert (cache->sources, key, entry);
+  }
+
+  entry->source_stats = gst_structure_copy (source_stats);
+  entry->jb_stats = jb_stats;
+  entry->codec_id = g_strdup (codec_id);
+  entry->transport_id = g_strdup (transport_id);
+  entry->have_remote = have_remote;
+  entry->ids = g_ptr_array_new_with_free_func (g_free);
+  entry->generation = cache->generation;
+
+  ctx->added_ids = entry->ids;
+  if (remote)
+    _get_stats_from_remote_rtp_source_stats (ctx, source_stats, ssrc,
+        clock_rate, codec_id, transport_id);
+  else
+    _get_stats_from_rtp_source_stats (ctx, source_stats, jb_stats, codec_id,
+        transport_id);
+  ctx->added_ids = NULL;
+}
+
+static void
+_get_stats_from_transport_channel (StatsContext * ctx, PadStats * pstats,
+    const gchar * codec_id, guint ssrc, guint clock_rate)
+{
+  GstWebRTCBin *webrtc = ctx->webrtc;
   GObject *rtp_session;
   GObject *gst_rtp_session;
   GstStructure *rtp_stats, *twcc_stats;
   GValueArray *source_stats;
   gchar *transport_id;
-  double ts;
   int i;
 
-  gst_structure_get_double (s, "timestamp", &ts);
-
-  transport = stream->transport;
-  if (!transport)
-    return;
-
   g_signal_emit_by_name (webrtc->rtpbin, "get-internal-session",
-      stream->session_id, &rtp_session);
+      pstats->session_id, &rtp_session);
   g_object_get (rtp_session, "stats", &rtp_stats, NULL);
   g_signal_emit_by_name (webrtc->rtpbin, "get-session",
-      stream->session_id, &gst_rtp_session);
+      pstats->session_id, &gst_rtp_session);
   g_object_get (gst_rtp_session, "twcc-stats", &twcc_stats, NULL);
 
   gst_structure_get (rtp_stats, "source-stats", G_TYPE_VALUE_ARRAY,
       &source_stats, NULL);
 
-  GST_DEBUG_OBJECT (webrtc, "retrieving rtp stream stats from transport %"
-      GST_PTR_FORMAT " rtp session %" GST_PTR_FORMAT " with %u rtp sources, "
-      "transport %" GST_PTR_FORMAT, stream, rtp_session, source_stats->n_values,
-      transport);
+  GST_DEBUG_OBJECT (webrtc, "retrieving rtp stream stats from session %u "
+      "rtp session %" GST_PTR_FORMAT " with %u rtp sources, transport %"
+      GST_PTR_FORMAT, pstats->session_id, rtp_session, source_stats->n_values,
+      pstats->transport);
 
   transport_id =
-      _get_stats_from_dtls_transport (webrtc, transport, twcc_stats, s);
+      _get_stats_from_dtls_transport (ctx, pstats->transport, twcc_stats);
 
   /* construct stats objects */
   for (i = 0; i < source_stats->n_values; i++) {
@@ -737,15 +992,14 @@ _get_stats_from_transport_channel (GstWebRTCBin * webrtc,
     stats = gst_value_get_structure (val);
 
     /* skip foreign sources */
-    gst_structure_get (stats, "ssrc", G_TYPE_UINT, &stats_ssrc, NULL);
     if (gst_structure_get_uint (stats, "ssrc", &stats_ssrc) &&
         ssrc == stats_ssrc)
-      _get_stats_from_rtp_source_stats (webrtc, stream, stats, codec_id,
-          transport_id, s);
+      _get_stats_from_source (ctx, pstats, stats, FALSE, ssrc, clock_rate,
+          codec_id, transport_id);
     else if (gst_structure_get_uint (stats, "rb-ssrc", &stats_ssrc) &&
         ssrc == stats_ssrc)
-      _get_stats_from_remote_rtp_source_stats (webrtc, stream, stats, ssrc,
-          clock_rate, codec_id, transport_id, s);
+      _get_stats_from_source (ctx, pstats, stats, TRUE, ssrc, clock_rate,
+          codec_id, transport_id);
   }
 
   g_object_unref (rtp_session);
@@ -759,18 +1013,16 @@ _get_stats_from_transport_channel (GstWebRTCBin * webrtc,
 
 /* https://www.w3.org/TR/webrtc-stats/#codec-dict* */
 static void
-_get_codec_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad,
-    GstStructure * s, gchar ** out_id, guint * out_ssrc, guint * out_clock_rate)
+_get_codec_stats_from_pad (StatsContext * ctx, GstPad * pad,
+    gchar ** out_id, guint * out_ssrc, guint * out_clock_rate)
 {
   GstStructure *stats;
   GstCaps *caps;
   gchar *id;
-  double ts;
+  double ts = ctx->ts;
   guint ssrc = 0;
   gint clock_rate = 0;
 
-  gst_structure_get_double (s, "timestamp", &ts);
-
   stats = gst_structure_new_empty ("unused");
   id = g_strdup_printf ("codec-stats-%s", GST_OBJECT_NAME (pad));
   _set_base_stats (stats, GST_WEBRTC_STATS_CODEC, ts, id);
@@ -795,8 +1047,7 @@ _get_codec_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad,
   if (caps)
     gst_caps_unref (caps);
 
-  gst_structure_set (s, id, GST_TYPE_STRUCTURE, stats, NULL);
-  gst_structure_free (stats);
+  _add_stats (ctx, id, stats);
 
   if (out_id)
     *out_id = id;
@@ -810,62 +1061,167 @@ _get_codec_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad,
     *out_clock_rate = clock_rate;
 }
 
-static gboolean
-_get_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad, GstStructure * s)
+static void
+_get_stats_from_pad (StatsContext * ctx, PadStats * pstats)
 {
-  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
-  TransportStream *stream;
   gchar *codec_id;
   guint ssrc, clock_rate;
 
-  _get_codec_stats_from_pad (webrtc, pad, s, &codec_id, &ssrc, &clock_rate);
+  _get_codec_stats_from_pad (ctx, pstats->pad, &codec_id, &ssrc, &clock_rate);
 
-  if (!wpad->trans)
-    goto out;
+  if (pstats->transport)
+    _get_stats_from_transport_channel (ctx, pstats, codec_id, ssrc,
+        clock_rate);
 
-  stream = WEBRTC_TRANSCEIVER (wpad->trans)->stream;
-  if (!stream)
-    goto out;
+  g_free (codec_id);
+}
 
-  _get_stats_from_transport_channel (webrtc, stream, codec_id, ssrc,
-      clock_rate, s);
+static void
+_free_pad_stats (PadStats * pstats)
+{
+  guint i;
+
+  for (i = 0; i < pstats->jitterbuffers->len; i++)
+    g_object_unref (g_array_index (pstats->jitterbuffers, SsrcJitterBuffer,
+            i).jitterbuffer);
+  g_array_free (pstats->jitterbuffers, TRUE);
+  if (pstats->transport)
+    gst_object_unref (pstats->transport);
+  gst_object_unref (pstats->pad);
+  g_free (pstats);
+}
+
+/* with pc lock */
+static gboolean
+_snapshot_pad (GstElement * element, GstPad * pad, GPtrArray * pads)
+{
+  GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
+  TransportStream *stream = NULL;
+  PadStats *pstats;
+  guint i;
+
+  pstats = g_new0 (PadStats, 1);
+  pstats->pad = gst_object_ref (pad);
+  pstats->jitterbuffers =
+      g_array_new (FALSE, FALSE, sizeof (SsrcJitterBuffer));
+
+  if (wpad->trans)
+    stream = WEBRTC_TRANSCEIVER (wpad->trans)->stream;
+
+  if (stream && stream->transport) {
+    pstats->session_id = stream->session_id;
+    pstats->transport = gst_object_ref (stream->transport);
+
+    for (i = 0; i < stream->remote_ssrcmap->len; i++) {
+      SsrcMapItem *item = g_ptr_array_index (stream->remote_ssrcmap, i);
+      SsrcJitterBuffer jb;
+
+      jb.ssrc = item->ssrc;
+      jb.jitterbuffer = g_weak_ref_get (&item->rtpjitterbuffer);
+      if (jb.jitterbuffer)
+        g_array_append_val (pstats->jitterbuffers, jb);
+    }
+  }
+
+  g_ptr_array_add (pads, pstats);
 
-out:
-  g_free (codec_id);
   return TRUE;
 }
 
+static gboolean
+_remove_stale_stats (gpointer key, StatsCacheEntry * entry,
+    GstWebRTCStatsCache * cache)
+{
+  return entry->generation != cache->generation;
+}
+
+static gboolean
+_remove_stale_source (gpointer key, SourceCacheEntry * entry,
+    GstWebRTCStatsCache * cache)
+{
+  return entry->generation != cache->generation;
+}
+
+/*
+ * Must be called with the pc lock. Looks up the transports, session ids and
+ * jitterbuffers of @pad, or of all the pads if %NULL, so that
+ * gst_webrtc_bin_create_stats() can collect their stats without the pc
+ * lock.
+ */
+GstWebRTCStatsSnapshot *
+gst_webrtc_stats_snapshot_new (GstWebRTCBin * webrtc, GstPad * pad)
+{
+  GstWebRTCStatsSnapshot *snapshot = g_new0 (GstWebRTCStatsSnapshot, 1);
+
+  snapshot->pads =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) _free_pad_stats);
+  snapshot->all_pads = pad == NULL;
+
+  if (pad)
+    _snapshot_pad (GST_ELEMENT (webrtc), pad, snapshot->pads);
+  else
+    gst_element_foreach_pad (GST_ELEMENT (webrtc),
+        (GstElementForeachPadFunc) _snapshot_pad, snapshot->pads);
+
+  return snapshot;
+}
+
+void
+gst_webrtc_stats_snapshot_free (GstWebRTCStatsSnapshot * snapshot)
+{
+  g_ptr_array_unref (snapshot->pads);
+  g_free (snapshot);
+}
+
+/*
+ * Must be called without the pc lock, so that collecting the stats never
+ * holds up the pc thread.
+ *
+ * If @since is negative, all objects are returned with the timestamp of
+ * this call. Otherwise the objects are returned with the timestamp of the
+ * call that last changed their values, and only if it is more recent than
+ * @since.
+ */
 GstStructure *
-gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
+gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc,
+    GstWebRTCStatsSnapshot * snapshot, double since)
 {
-  GstStructure *s = gst_structure_new_empty ("application/x-webrtc-stats");
-  double ts = monotonic_time_as_double_milliseconds ();
+  StatsContext ctx = { NULL, };
   GstStructure *pc_stats;
+  guint i;
 
   _init_debug ();
 
-  gst_structure_set (s, "timestamp", G_TYPE_DOUBLE, ts, NULL);
+  ctx.webrtc = webrtc;
+  ctx.cache = webrtc->priv->stats_cache;
+  ctx.s = gst_structure_new_empty ("application/x-webrtc-stats");
+  ctx.ts = monotonic_time_as_double_milliseconds ();
+  ctx.since = since;
 
   /* FIXME: better unique IDs */
-  /* FIXME: rate limitting stat updates? */
-  /* FIXME: all stats need to be kept forever */
 
-  GST_DEBUG_OBJECT (webrtc, "updating stats at time %f", ts);
+  GST_DEBUG_OBJECT (webrtc, "updating stats at time %f", ctx.ts);
+
+  g_mutex_lock (&ctx.cache->lock);
+  ctx.cache->generation++;
 
   if ((pc_stats = _get_peer_connection_stats (webrtc))) {
     const gchar *id = "peer-connection-stats";
-    _set_base_stats (pc_stats, GST_WEBRTC_STATS_PEER_CONNECTION, ts, id);
-    gst_structure_set (s, id, GST_TYPE_STRUCTURE, pc_stats, NULL);
-    gst_structure_free (pc_stats);
+    _set_base_stats (pc_stats, GST_WEBRTC_STATS_PEER_CONNECTION, ctx.ts, id);
+    _add_stats (&ctx, id, pc_stats);
   }
 
-  if (pad)
-    _get_stats_from_pad (webrtc, pad, s);
-  else
-    gst_element_foreach_pad (GST_ELEMENT (webrtc),
-        (GstElementForeachPadFunc) _get_stats_from_pad, s);
+  for (i = 0; i < snapshot->pads->len; i++)
+    _get_stats_from_pad (&ctx, g_ptr_array_index (snapshot->pads, i));
 
-  gst_structure_remove_field (s, "timestamp");
+  /* forget about the objects that went away */
+  if (snapshot->all_pads) {
+    g_hash_table_foreach_remove (ctx.cache->stats,
+        (GHRFunc) _remove_stale_stats, ctx.cache);
+    g_hash_table_foreach_remove (ctx.cache->sources,
+        (GHRFunc) _remove_stale_source, ctx.cache);
+  }
+  g_mutex_unlock (&ctx.cache->lock);
 
-  return s;
+  return ctx.s;
 }
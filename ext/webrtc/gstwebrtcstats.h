@@ -28,8 +28,20 @@
 G_BEGIN_DECLS
 
 G_GNUC_INTERNAL
-GstStructure *     gst_webrtc_bin_create_stats         (GstWebRTCBin * webrtc,
+GstWebRTCStatsCache * gst_webrtc_stats_cache_new       (void);
+G_GNUC_INTERNAL
+void               gst_webrtc_stats_cache_free         (GstWebRTCStatsCache * cache);
+
+G_GNUC_INTERNAL
+GstWebRTCStatsSnapshot * gst_webrtc_stats_snapshot_new (GstWebRTCBin * webrtc,
                                                         GstPad * pad);
+G_GNUC_INTERNAL
+void               gst_webrtc_stats_snapshot_free      (GstWebRTCStatsSnapshot * snapshot);
+
+G_GNUC_INTERNAL
+GstStructure *     gst_webrtc_bin_create_stats         (GstWebRTCBin * webrtc,
+                                                        GstWebRTCStatsSnapshot * snapshot,
+                                                        double since);
 
 G_END_DECLS
 
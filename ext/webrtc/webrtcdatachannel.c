@@ -536,6 +536,42 @@ _emit_have_string (GstWebRTCDataChannel * channel, gchar * str)
       str);
 }
 
+/* Binary messages go to the on-message-buffer handlers as they were
+ * received, or are mapped for on-message-data if there are none. Either way
+ * they are emitted from the same thread and in the same order as the string
+ * messages. */
+static void
+_emit_have_buffer (WebRTCDataChannel * channel, GstBuffer * buffer)
+{
+  struct map_info *info;
+  GBytes *data;
+
+  if (gst_webrtc_data_channel_on_message_buffer (GST_WEBRTC_DATA_CHANNEL
+          (channel), buffer))
+    return;
+
+  if (gst_buffer_get_size (buffer) == 0) {
+    _emit_have_data (channel, NULL);
+    return;
+  }
+
+  info = g_new0 (struct map_info, 1);
+  if (!gst_buffer_map (buffer, &info->map_info, GST_MAP_READ)) {
+    g_free (info);
+    _channel_store_error (channel, g_error_new (GST_WEBRTC_BIN_ERROR,
+            GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE,
+            "Failed to map received buffer"));
+    _close_procedure (channel, NULL);
+    return;
+  }
+
+  info->buffer = gst_buffer_ref (buffer);
+  data = g_bytes_new_with_free_func (info->map_info.data,
+      info->map_info.size, (GDestroyNotify) buffer_unmap_and_unref, info);
+  _emit_have_data (channel, data);
+  g_bytes_unref (data);
+}
+
 static GstFlowReturn
 _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
     GError ** error)
@@ -593,25 +629,13 @@ _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
       break;
     }
     case DATA_CHANNEL_PPID_WEBRTC_BINARY:
-    case DATA_CHANNEL_PPID_WEBRTC_BINARY_PARTIAL:{
-      struct map_info *info = g_new0 (struct map_info, 1);
-      if (!gst_buffer_map (buffer, &info->map_info, GST_MAP_READ)) {
-        g_set_error (error, GST_WEBRTC_BIN_ERROR,
-            GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE,
-            "Failed to map received buffer");
-        ret = GST_FLOW_ERROR;
-      } else {
-        GBytes *data = g_bytes_new_with_free_func (info->map_info.data,
-            info->map_info.size, (GDestroyNotify) buffer_unmap_and_unref, info);
-        info->buffer = gst_buffer_ref (buffer);
-        _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, data,
-            (GDestroyNotify) g_bytes_unref);
-      }
+    case DATA_CHANNEL_PPID_WEBRTC_BINARY_PARTIAL:
+      _channel_enqueue_task (channel, (ChannelTask) _emit_have_buffer,
+          gst_buffer_ref (buffer), (GDestroyNotify) gst_buffer_unref);
       break;
-    }
     case DATA_CHANNEL_PPID_WEBRTC_BINARY_EMPTY:
-      _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, NULL,
-          NULL);
+      _channel_enqueue_task (channel, (ChannelTask) _emit_have_buffer,
+          gst_buffer_new (), (GDestroyNotify) gst_buffer_unref);
       break;
     case DATA_CHANNEL_PPID_WEBRTC_STRING_EMPTY:
       _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, NULL,
@@ -861,6 +885,158 @@ webrtc_data_channel_send_string (GstWebRTCDataChannel * base_channel,
   }
 }
 
+static gboolean
+_can_send (WebRTCDataChannel * channel)
+{
+  if (!channel->parent.negotiated)
+    g_return_val_if_fail (channel->opened, FALSE);
+  g_return_val_if_fail (channel->sctp_transport != NULL, FALSE);
+
+  return TRUE;
+}
+
+/* Checks the size of a binary message and attaches the SCTP send meta,
+ * without touching the payload */
+static gboolean
+_prepare_binary_buffer (WebRTCDataChannel * channel, GstBuffer ** buffer,
+    GstSctpSendMetaPartiallyReliability reliability, guint rel_param)
+{
+  gsize size = gst_buffer_get_size (*buffer);
+  guint32 ppid;
+
+  if (!_is_within_max_message_size (channel, size))
+    return FALSE;
+
+  ppid = size > 0 ? DATA_CHANNEL_PPID_WEBRTC_BINARY :
+      DATA_CHANNEL_PPID_WEBRTC_BINARY_EMPTY;
+
+  *buffer = gst_buffer_make_writable (*buffer);
+  gst_sctp_buffer_add_send_meta (*buffer, ppid, channel->parent.ordered,
+      reliability, rel_param);
+
+  return TRUE;
+}
+
+struct prepare_list
+{
+  WebRTCDataChannel *channel;
+  GstSctpSendMetaPartiallyReliability reliability;
+  guint rel_param;
+  gsize size;
+  gboolean too_large;
+};
+
+static gboolean
+_prepare_list_buffer (GstBuffer ** buffer, guint idx, struct prepare_list *data)
+{
+  if (!_prepare_binary_buffer (data->channel, buffer, data->reliability,
+          data->rel_param)) {
+    data->too_large = TRUE;
+    return FALSE;
+  }
+
+  data->size += gst_buffer_get_size (*buffer);
+
+  return TRUE;
+}
+
+static void
+webrtc_data_channel_send_buffer_list (GstWebRTCDataChannel * base_channel,
+    GstBufferList * list)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (base_channel);
+  struct prepare_list data = { channel, };
+  GstFlowReturn ret;
+
+  if (!_can_send (channel)) {
+    gst_buffer_list_unref (list);
+    return;
+  }
+
+  if (gst_buffer_list_length (list) == 0) {
+    gst_buffer_list_unref (list);
+    return;
+  }
+
+  _get_sctp_reliability (channel, &data.reliability, &data.rel_param);
+  list = gst_buffer_list_make_writable (list);
+  gst_buffer_list_foreach (list, (GstBufferListFunc) _prepare_list_buffer,
+      &data);
+
+  if (data.too_large) {
+    GError *error = NULL;
+    g_set_error (&error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE,
+        "Requested to send data that is too large");
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+    gst_buffer_list_unref (list);
+    return;
+  }
+
+  GST_LOG_OBJECT (channel, "Sending %u messages, %" G_GSIZE_FORMAT " bytes",
+      gst_buffer_list_length (list), data.size);
+
+  /* accounted once for the whole list, the appsrc probe subtracts it again
+   * once the list was handed to sctpenc */
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  channel->parent.buffered_amount += data.size;
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  ret = gst_app_src_push_buffer_list (GST_APP_SRC (channel->appsrc), list);
+
+  if (ret != GST_FLOW_OK) {
+    GError *error = NULL;
+    g_set_error (&error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE, "Failed to send data");
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+  }
+}
+
+static void
+webrtc_data_channel_send_buffer (GstWebRTCDataChannel * base_channel,
+    GstBuffer * buffer)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (base_channel);
+  GstSctpSendMetaPartiallyReliability reliability;
+  guint rel_param;
+  GstFlowReturn ret;
+
+  if (!_can_send (channel)) {
+    gst_buffer_unref (buffer);
+    return;
+  }
+
+  _get_sctp_reliability (channel, &reliability, &rel_param);
+  if (!_prepare_binary_buffer (channel, &buffer, reliability, rel_param)) {
+    GError *error = NULL;
+    g_set_error (&error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE,
+        "Requested to send data that is too large");
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+    gst_buffer_unref (buffer);
+    return;
+  }
+
+  GST_LOG_OBJECT (channel, "Sending buffer %" GST_PTR_FORMAT, buffer);
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  channel->parent.buffered_amount += gst_buffer_get_size (buffer);
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  ret = gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc), buffer);
+
+  if (ret != GST_FLOW_OK) {
+    GError *error = NULL;
+    g_set_error (&error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE, "Failed to send data");
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+  }
+}
+
 static void
 _on_sctp_notify_state_unlocked (GObject * sctp_transport,
     WebRTCDataChannel * channel)
@@ -993,6 +1169,8 @@ webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
 
   channel_class->send_data = webrtc_data_channel_send_data;
   channel_class->send_string = webrtc_data_channel_send_string;
+  channel_class->send_buffer = webrtc_data_channel_send_buffer;
+  channel_class->send_buffer_list = webrtc_data_channel_send_buffer_list;
   channel_class->close = webrtc_data_channel_close;
 }
 
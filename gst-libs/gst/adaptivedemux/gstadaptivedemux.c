@@ -59,6 +59,18 @@
  *                       interrupted to save network bandwidth. When they are
  *                       relinked a reconfigure event is received and the
  *                       stream is restarted.
+ * - Prefetching: When the "prefetch-fragments" property is set and the
+ *                subclass implements stream_peek_fragment_info(), a single
+ *                prefetch task downloads the upcoming fragments of all
+ *                streams ahead of time over one persistent connection,
+ *                serving first the stream with the least prefetched media.
+ *                The download tasks then push the prefetched data instead
+ *                of requesting the fragment again.
+ * - Bitrate adaptation: The bitrate passed to stream_select_bitrate() comes
+ *                       from the stream's #GstAdaptiveDemuxAbr, using the
+ *                       algorithm set in the "abr-algorithm" property. Each
+ *                       decision is posted as an element message named
+ *                       %GST_ADAPTIVE_DEMUX_ABR_MESSAGE_NAME.
  *
  * Subclasses:
  * While GstAdaptiveDemux is responsible for the workflow, it knows nothing
@@ -130,7 +142,9 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
-#define NUM_LOOKBACK_FRAGMENTS 3
+#define DEFAULT_ABR_ALGORITHM GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE
+#define DEFAULT_PREFETCH_FRAGMENTS 0
+#define MAX_PREFETCH_FRAGMENTS 16
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,6 +171,8 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_FRAGMENTS,
+  PROP_ABR_ALGORITHM,
   PROP_LAST
 };
 
@@ -207,8 +223,40 @@ struct _GstAdaptiveDemuxPrivate
   GMutex segment_lock;
 
   GstClockTime qos_earliest_time;
+
+  /* Downloads the upcoming fragments of all streams ahead of time. See
+   * gst_adaptive_demux_prefetch_loop() */
+  guint prefetch_fragments;     /* protected by manifest_lock */
+  GstTask *prefetch_task;       /* MT safe */
+  GRecMutex prefetch_task_lock;
+  GstUriDownloader *prefetch_downloader;        /* MT safe */
+
+  /* Protects the streams' prefetched queues and the fields below. Can be
+   * taken with manifest_lock held, but not the other way around */
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  gboolean stop_prefetch_task;
+  struct _GstAdaptiveDemuxPrefetch *prefetch_pending;   /* being downloaded */
+  guint prefetch_seqnum;        /* bumped when prefetch_pending is done */
+
+  GstAdaptiveDemuxAbrAlgorithm abr_algorithm;   /* protected by manifest_lock */
 };
 
+/* A fragment downloaded by the prefetch task */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  /* NULL once the stream does not want the fragment anymore */
+  GstAdaptiveDemuxStream *stream;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+  GstClockTime duration;
+
+  GstBuffer *buffer;            /* NULL if the download failed */
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   gint ref_count;
@@ -243,6 +291,7 @@ static gboolean
 gst_adaptive_demux_push_src_event (GstAdaptiveDemux * demux, GstEvent * event);
 
 static void gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_prefetch_loop (GstAdaptiveDemux * demux);
 static void gst_adaptive_demux_stream_download_loop (GstAdaptiveDemuxStream *
     stream);
 static void gst_adaptive_demux_reset (GstAdaptiveDemux * demux);
@@ -284,6 +333,11 @@ static void gst_adaptive_demux_start_tasks (GstAdaptiveDemux * demux,
     gboolean start_preroll_streams);
 static void gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux,
     gboolean stop_updates);
+static void gst_adaptive_demux_start_prefetch_task (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_stop_prefetch_task (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_signal_prefetch (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_stream_flush_prefetch (GstAdaptiveDemuxStream *
+    stream);
 static GstFlowReturn gst_adaptive_demux_combine_flows (GstAdaptiveDemux *
     demux);
 static void
@@ -363,6 +417,22 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_FRAGMENTS:{
+      GstAdaptiveDemuxStream *stream =
+          demux->streams ? demux->streams->data : NULL;
+
+      demux->priv->prefetch_fragments = g_value_get_uint (value);
+      /* the prefetch task is started along with the streams' tasks, unless
+       * prefetching was disabled at that time */
+      if (stream && gst_adaptive_demux_is_running (demux) &&
+          GST_TASK_STATE (stream->download_task) == GST_TASK_STARTED)
+        gst_adaptive_demux_start_prefetch_task (demux);
+      gst_adaptive_demux_signal_prefetch (demux);
+      break;
+    }
+    case PROP_ABR_ALGORITHM:
+      demux->priv->abr_algorithm = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -387,6 +457,12 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->prefetch_fragments);
+      break;
+    case PROP_ABR_ALGORITHM:
+      g_value_set_enum (value, demux->priv->abr_algorithm);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -432,6 +508,41 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-fragments:
+   *
+   * Number of upcoming fragments to download ahead of time for each stream,
+   * if supported by the subclass. The fragments of all streams are fetched
+   * by a single task over a persistent connection, starting with the stream
+   * that has the least prefetched media. Prefetched fragments are kept in
+   * memory until they are pushed. The property can be changed at any time,
+   * including enabling prefetching while playing.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of upcoming fragments to download ahead of time for each "
+          "stream (0 = disabled)", 0, MAX_PREFETCH_FRAGMENTS,
+          DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-algorithm:
+   *
+   * Algorithm used to estimate the bandwidth and pick the bitrate after each
+   * fragment. Ignored if #GstAdaptiveDemux:connection-speed is set.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_ALGORITHM,
+      g_param_spec_enum ("abr-algorithm", "ABR algorithm",
+          "Algorithm used to select the bitrate of the next fragments",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM, DEFAULT_ABR_ALGORITHM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM, 0);
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -509,6 +620,18 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   g_cond_init (&demux->priv->preroll_cond);
   g_mutex_init (&demux->priv->preroll_lock);
 
+  demux->priv->prefetch_downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_parent (demux->priv->prefetch_downloader,
+      GST_ELEMENT_CAST (demux));
+  g_rec_mutex_init (&demux->priv->prefetch_task_lock);
+  demux->priv->prefetch_task =
+      gst_task_new ((GstTaskFunction) gst_adaptive_demux_prefetch_loop,
+      demux, NULL);
+  gst_task_set_lock (demux->priv->prefetch_task,
+      &demux->priv->prefetch_task_lock);
+  g_mutex_init (&demux->priv->prefetch_lock);
+  g_cond_init (&demux->priv->prefetch_cond);
+
   pad_template =
       gst_element_class_get_pad_template (GST_ELEMENT_CLASS (klass), "sink");
   g_return_if_fail (pad_template != NULL);
@@ -522,6 +645,8 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
+  demux->priv->abr_algorithm = DEFAULT_ABR_ALGORITHM;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -554,6 +679,12 @@ gst_adaptive_demux_finalize (GObject * object)
   g_cond_clear (&demux->priv->preroll_cond);
   g_mutex_clear (&demux->priv->preroll_lock);
 
+  g_object_unref (priv->prefetch_downloader);
+  g_object_unref (priv->prefetch_task);
+  g_rec_mutex_clear (&priv->prefetch_task_lock);
+  g_mutex_clear (&priv->prefetch_lock);
+  g_cond_clear (&priv->prefetch_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -569,6 +700,7 @@ gst_adaptive_demux_change_state (GstElement * element,
       if (g_atomic_int_compare_and_exchange (&demux->running, TRUE, FALSE))
         GST_DEBUG_OBJECT (demux, "demuxer has stopped running");
       gst_uri_downloader_cancel (demux->downloader);
+      gst_uri_downloader_cancel (demux->priv->prefetch_downloader);
 
       GST_API_LOCK (demux);
       GST_MANIFEST_LOCK (demux);
@@ -1321,8 +1453,7 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
 
   stream->pad = pad;
   stream->demux = demux;
-  stream->fragment_bitrates =
-      g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+  stream->abr = gst_adaptive_demux_abr_new ();
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1375,6 +1506,9 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
   if (klass->stream_free)
     klass->stream_free (stream);
 
+  /* also wakes up the download task if it waits for a prefetch */
+  gst_adaptive_demux_stream_flush_prefetch (stream);
+
   g_clear_error (&stream->last_error);
   if (stream->download_task) {
     if (GST_TASK_STATE (stream->download_task) != GST_TASK_STOPPED) {
@@ -1438,7 +1572,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
-  g_free (stream->fragment_bitrates);
+  gst_adaptive_demux_abr_free (stream->abr);
 
   if (stream->pad) {
     gst_object_unref (stream->pad);
@@ -2081,6 +2215,8 @@ gst_adaptive_demux_start_tasks (GstAdaptiveDemux * demux,
     stream->last_ret = GST_FLOW_OK;
     gst_task_start (stream->download_task);
   }
+
+  gst_adaptive_demux_start_prefetch_task (demux);
 }
 
 /* must be called with manifest_lock taken */
@@ -2117,6 +2253,40 @@ gst_adaptive_demux_start_manifest_update_task (GstAdaptiveDemux * demux)
   }
 }
 
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_start_prefetch_task (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+
+  if (demux->priv->prefetch_fragments == 0 ||
+      klass->stream_peek_fragment_info == NULL)
+    return;
+
+  gst_uri_downloader_reset (demux->priv->prefetch_downloader);
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  demux->priv->stop_prefetch_task = FALSE;
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+
+  GST_DEBUG_OBJECT (demux, "requesting start of the prefetch task");
+  gst_task_start (demux->priv->prefetch_task);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stop_prefetch_task (GstAdaptiveDemux * demux)
+{
+  gst_task_stop (demux->priv->prefetch_task);
+
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  GST_DEBUG_OBJECT (demux, "requesting stop of the prefetch task");
+  demux->priv->stop_prefetch_task = TRUE;
+  if (demux->priv->prefetch_pending)
+    gst_uri_downloader_cancel (demux->priv->prefetch_downloader);
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+}
+
 /* must be called with manifest_lock taken
  * This function will temporarily release manifest_lock in order to join the
  * download threads.
@@ -2134,6 +2304,7 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
 
   if (stop_updates)
     gst_adaptive_demux_stop_manifest_update_task (demux);
+  gst_adaptive_demux_stop_prefetch_task (demux);
 
   list_to_process = demux->streams;
   for (i = 0; i < 2; ++i) {
@@ -2190,6 +2361,7 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
   GST_MANIFEST_UNLOCK (demux);
   if (stop_updates)
     gst_task_join (demux->priv->updates_task);
+  gst_task_join (demux->priv->prefetch_task);
 
   GST_MANIFEST_LOCK (demux);
 
@@ -2200,6 +2372,7 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
 
       stream->download_error_count = 0;
       stream->need_header = TRUE;
+      gst_adaptive_demux_stream_flush_prefetch (stream);
     }
     list_to_process = demux->prepared_streams;
   }
@@ -2254,31 +2427,55 @@ gst_adaptive_demux_stream_queue_event (GstAdaptiveDemuxStream * stream,
   stream->pending_events = g_list_append (stream->pending_events, event);
 }
 
-/* must be called with manifest_lock taken */
-static guint64
-_update_average_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream, guint64 new_bitrate)
+/* must be called with manifest_lock taken.
+ * Estimates the duration of the data pushed downstream that was not played
+ * yet from the stream position and the running time of the pipeline.
+ * Returns GST_CLOCK_TIME_NONE when not playing.
+ */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
 {
-  gint index = stream->moving_index % NUM_LOOKBACK_FRAGMENTS;
+  GstClockTime base_time, now, position;
+  GstClock *clock;
 
-  stream->moving_bitrate -= stream->fragment_bitrates[index];
-  stream->fragment_bitrates[index] = new_bitrate;
-  stream->moving_bitrate += new_bitrate;
+  GST_OBJECT_LOCK (demux);
+  if (GST_STATE (demux) != GST_STATE_PLAYING
+      || GST_ELEMENT_CLOCK (demux) == NULL) {
+    GST_OBJECT_UNLOCK (demux);
+    return GST_CLOCK_TIME_NONE;
+  }
+  clock = gst_object_ref (GST_ELEMENT_CLOCK (demux));
+  base_time = GST_ELEMENT_CAST (demux)->base_time;
+  GST_OBJECT_UNLOCK (demux);
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
 
-  stream->moving_index += 1;
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
 
-  if (stream->moving_index > NUM_LOOKBACK_FRAGMENTS)
-    return stream->moving_bitrate / NUM_LOOKBACK_FRAGMENTS;
-  return stream->moving_bitrate / stream->moving_index;
+  if (!GST_CLOCK_TIME_IS_VALID (position) || now < base_time)
+    return GST_CLOCK_TIME_NONE;
+
+  now -= base_time;
+  return position > now ? position - now : 0;
 }
 
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
-    GstAdaptiveDemuxStream * stream)
+    GstAdaptiveDemuxStream * stream, GstClockTime * buffer_level)
 {
-  guint64 average_bitrate;
-  guint64 fragment_bitrate;
+  *buffer_level = gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+
+  /* the size is derived from the bitrate as fragment_bytes_downloaded might
+   * already count the next download if the subclass advanced early */
+  gst_adaptive_demux_abr_add_sample (stream->abr,
+      gst_util_uint64_scale (stream->last_bitrate, stream->last_download_time,
+          8 * GST_SECOND), stream->last_download_time, stream->last_latency);
 
   if (demux->connection_speed) {
     GST_LOG_OBJECT (demux, "Connection-speed is set to %u kbps, using it",
@@ -2287,22 +2484,19 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
     return demux->connection_speed;
   }
 
-  fragment_bitrate = stream->last_bitrate;
-  GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
-      fragment_bitrate);
-
-  average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
-
-  GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
-      "last fragment bitrate was %" G_GUINT64_FORMAT, fragment_bitrate);
   GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
-      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
-      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
+      "last fragment bitrate was %" G_GUINT64_FORMAT, stream->last_bitrate);
 
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  gst_adaptive_demux_abr_set_algorithm (stream->abr,
+      demux->priv->abr_algorithm);
+  GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
+      "Estimated bandwidth is %" G_GUINT64_FORMAT ", buffer level %"
+      GST_TIME_FORMAT, gst_adaptive_demux_abr_get_bandwidth (stream->abr),
+      GST_TIME_ARGS (*buffer_level));
 
-  stream->current_download_rate *= demux->bitrate_limit;
+  stream->current_download_rate =
+      gst_adaptive_demux_abr_select_bitrate (stream->abr,
+      demux->bitrate_limit, stream->fragment.duration, *buffer_level);
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
       G_GUINT64_FORMAT, demux->bitrate_limit, stream->current_download_rate);
 
@@ -2321,6 +2515,28 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   return stream->current_download_rate;
 }
 
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_post_abr_message (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 bitrate,
+    GstClockTime buffer_level, gboolean switched)
+{
+  gst_element_post_message (GST_ELEMENT_CAST (demux),
+      gst_message_new_element (GST_OBJECT_CAST (demux),
+          gst_structure_new (GST_ADAPTIVE_DEMUX_ABR_MESSAGE_NAME,
+              "manifest-uri", G_TYPE_STRING, demux->manifest_uri,
+              "uri", G_TYPE_STRING, stream->fragment.uri,
+              "algorithm", GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM,
+              gst_adaptive_demux_abr_get_algorithm (stream->abr),
+              "bandwidth", G_TYPE_UINT64,
+              gst_adaptive_demux_abr_get_bandwidth (stream->abr),
+              "latency", GST_TYPE_CLOCK_TIME,
+              gst_adaptive_demux_abr_get_latency (stream->abr),
+              "buffer-level", GST_TYPE_CLOCK_TIME, buffer_level,
+              "bitrate", G_TYPE_UINT64, bitrate,
+              "switched", G_TYPE_BOOLEAN, switched, NULL)));
+}
+
 /* must be called with manifest_lock taken */
 static GstFlowReturn
 gst_adaptive_demux_combine_flows (GstAdaptiveDemux * demux)
@@ -3385,6 +3601,166 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static void
+gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_free (prefetch->uri);
+  if (prefetch->buffer)
+    gst_buffer_unref (prefetch->buffer);
+  g_free (prefetch);
+}
+
+static gboolean
+gst_adaptive_demux_prefetch_matches (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  return fragment->uri != NULL && g_str_equal (prefetch->uri, fragment->uri)
+      && prefetch->range_start == fragment->range_start
+      && prefetch->range_end == fragment->range_end;
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_signal_prefetch (GstAdaptiveDemux * demux)
+{
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_flush_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrivate *priv = stream->demux->priv;
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  g_mutex_lock (&priv->prefetch_lock);
+  while ((prefetch = g_queue_pop_head (&stream->prefetched)))
+    gst_adaptive_demux_prefetch_free (prefetch);
+
+  /* the prefetch task drops it when the download returns */
+  if (priv->prefetch_pending && priv->prefetch_pending->stream == stream) {
+    priv->prefetch_pending->stream = NULL;
+    gst_uri_downloader_cancel (priv->prefetch_downloader);
+  }
+  g_mutex_unlock (&priv->prefetch_lock);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Pushes the current fragment from the prefetched data as if it was
+ * downloaded by the source element, waiting for the prefetch task if it is
+ * still downloading it. Returns FALSE if the fragment was not prefetched.
+ */
+static gboolean
+gst_adaptive_demux_stream_push_prefetched (GstAdaptiveDemuxStream * stream,
+    GstFlowReturn * ret)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GstBuffer *buffer;
+  GList *iter;
+  gsize size;
+
+  /* the data goes through the internal pad, which only exists once the
+   * source element was set up */
+  if (stream->internal_pad == NULL)
+    return FALSE;
+
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  prefetch = demux->priv->prefetch_pending;
+  if (prefetch && prefetch->stream == stream &&
+      gst_adaptive_demux_prefetch_matches (prefetch, &stream->fragment)) {
+    guint seqnum = demux->priv->prefetch_seqnum;
+
+    GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s",
+        prefetch->uri);
+
+    /* prefetch may be freed once done, and a new one allocated at the same
+     * address */
+    GST_MANIFEST_UNLOCK (demux);
+    while (demux->priv->prefetch_seqnum == seqnum)
+      g_cond_wait (&demux->priv->prefetch_cond, &demux->priv->prefetch_lock);
+    g_mutex_unlock (&demux->priv->prefetch_lock);
+
+    GST_MANIFEST_LOCK (demux);
+    g_mutex_lock (&stream->fragment_download_lock);
+    if (G_UNLIKELY (stream->cancelled)) {
+      g_mutex_unlock (&stream->fragment_download_lock);
+      *ret = stream->last_ret = GST_FLOW_FLUSHING;
+      return TRUE;
+    }
+    g_mutex_unlock (&stream->fragment_download_lock);
+
+    g_mutex_lock (&demux->priv->prefetch_lock);
+  }
+
+  for (iter = stream->prefetched.head; iter; iter = g_list_next (iter)) {
+    if (gst_adaptive_demux_prefetch_matches (iter->data, &stream->fragment))
+      break;
+  }
+  if (iter == NULL) {
+    g_mutex_unlock (&demux->priv->prefetch_lock);
+    return FALSE;
+  }
+
+  prefetch = iter->data;
+  g_queue_delete_link (&stream->prefetched, iter);
+  /* there is room for another prefetch now */
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+
+  buffer = prefetch->buffer;
+  prefetch->buffer = NULL;
+  if (buffer == NULL) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s failed", prefetch->uri);
+    gst_adaptive_demux_prefetch_free (prefetch);
+    return FALSE;
+  }
+
+  size = gst_buffer_get_size (buffer);
+  GST_DEBUG_OBJECT (stream->pad, "Pushing prefetched %s, %" G_GSIZE_FORMAT
+      " bytes downloaded in %" GST_TIME_FORMAT, prefetch->uri, size,
+      GST_TIME_ARGS (prefetch->download_time));
+
+  /* same statistics as _uri_handler_probe() collects for the source */
+  stream->fragment_bytes_downloaded = size;
+  stream->last_download_time = MAX (prefetch->download_time, 1);
+  stream->last_latency = GST_CLOCK_TIME_NONE;
+  stream->last_bitrate = gst_util_uint64_scale (size, 8 * GST_SECOND,
+      stream->last_download_time);
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux) -
+      stream->last_download_time);
+  /* the source would have reported the size as its duration */
+  if (stream->fragment.bitrate == 0 && stream->fragment.duration != 0) {
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+  }
+  gst_adaptive_demux_prefetch_free (prefetch);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  *ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  /* behave as if the source reached EOS */
+  if (*ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled))
+    stream->last_ret = GST_FLOW_FLUSHING;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  *ret = stream->last_ret;
+
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3502,6 +3878,9 @@ again:
       if (range_end != -1)
         chunk_end = MIN (chunk_end, range_end);
     }
+  } else if (gst_adaptive_demux_stream_push_prefetched (stream, &ret)) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetched fragment result: %s",
+        gst_flow_get_name (ret));
   } else {
     ret =
         gst_adaptive_demux_stream_download_uri (demux, stream, url,
@@ -3630,6 +4009,180 @@ no_url_error:
   }
 }
 
+/* must be called with manifest_lock and prefetch_lock taken.
+ * Drops the prefetched fragments that the stream will not push anymore and
+ * returns the next fragment to prefetch for it, if any. @level is set to the
+ * duration of the fragments already prefetched.
+ */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_next_prefetch (GstAdaptiveDemuxStream * stream,
+    GstClockTime * level)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxStreamFragment *upcoming;
+  GstAdaptiveDemuxPrefetch *prefetch = NULL;
+  guint i, n_upcoming, n_max;
+  GList *iter, *next;
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (stream->cancelled) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    return NULL;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  /* the current fragment, which the download task fetches itself if it was
+   * not prefetched, followed by the ones to prefetch */
+  n_max = demux->priv->prefetch_fragments + 1;
+  upcoming = g_new0 (GstAdaptiveDemuxStreamFragment, n_max);
+  for (n_upcoming = 0; n_upcoming < n_max; n_upcoming++) {
+    gst_adaptive_demux_stream_fragment_clear (&upcoming[n_upcoming]);
+    if (!klass->stream_peek_fragment_info (stream, n_upcoming,
+            &upcoming[n_upcoming]) || upcoming[n_upcoming].uri == NULL)
+      break;
+  }
+
+  *level = 0;
+  for (iter = stream->prefetched.head; iter; iter = next) {
+    GstAdaptiveDemuxPrefetch *cur = iter->data;
+
+    next = g_list_next (iter);
+    for (i = 0; i < n_upcoming; i++) {
+      if (gst_adaptive_demux_prefetch_matches (cur, &upcoming[i]))
+        break;
+    }
+
+    if (i == n_upcoming) {
+      GST_DEBUG_OBJECT (stream->pad, "Dropping prefetched %s", cur->uri);
+      g_queue_delete_link (&stream->prefetched, iter);
+      gst_adaptive_demux_prefetch_free (cur);
+    } else if (GST_CLOCK_TIME_IS_VALID (cur->duration)) {
+      *level += cur->duration;
+    }
+  }
+
+  for (i = 1; i < n_upcoming && prefetch == NULL; i++) {
+    for (iter = stream->prefetched.head; iter; iter = g_list_next (iter)) {
+      if (gst_adaptive_demux_prefetch_matches (iter->data, &upcoming[i]))
+        break;
+    }
+    if (iter)
+      continue;
+
+    prefetch = g_new0 (GstAdaptiveDemuxPrefetch, 1);
+    prefetch->stream = stream;
+    prefetch->uri = g_strdup (upcoming[i].uri);
+    prefetch->range_start = upcoming[i].range_start;
+    prefetch->range_end = upcoming[i].range_end;
+    prefetch->duration = upcoming[i].duration;
+  }
+
+  for (i = 0; i < n_max; i++)
+    gst_adaptive_demux_stream_fragment_clear (&upcoming[i]);
+  g_free (upcoming);
+
+  return prefetch;
+}
+
+/* Downloads the upcoming fragments of all streams one at a time, reusing the
+ * same source element and connection. The stream with the least prefetched
+ * media is served first as it is the closest to running out of data.
+ * The manifest_lock is only held while picking the next fragment.
+ */
+static void
+gst_adaptive_demux_prefetch_loop (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = NULL;
+  GstClockTime best_level = GST_CLOCK_TIME_NONE;
+  GstFragment *download;
+  GError *err = NULL;
+  GList *iter;
+
+  GST_MANIFEST_LOCK (demux);
+  g_mutex_lock (&demux->priv->prefetch_lock);
+
+  if (demux->priv->stop_prefetch_task) {
+    g_mutex_unlock (&demux->priv->prefetch_lock);
+    GST_MANIFEST_UNLOCK (demux);
+    GST_DEBUG_OBJECT (demux, "Stop prefetch task request detected.");
+    return;
+  }
+
+  for (iter = demux->streams; iter; iter = g_list_next (iter)) {
+    GstAdaptiveDemuxPrefetch *next;
+    GstClockTime level;
+
+    next = gst_adaptive_demux_stream_next_prefetch (iter->data, &level);
+    if (next == NULL)
+      continue;
+
+    if (prefetch == NULL || level < best_level) {
+      if (prefetch)
+        gst_adaptive_demux_prefetch_free (prefetch);
+      prefetch = next;
+      best_level = level;
+    } else {
+      gst_adaptive_demux_prefetch_free (next);
+    }
+  }
+
+  if (prefetch == NULL) {
+    GST_MANIFEST_UNLOCK (demux);
+    /* woken up when a stream advances, the manifest gets updated or the task
+     * is stopped */
+    GST_LOG_OBJECT (demux, "Nothing to prefetch");
+    g_cond_wait (&demux->priv->prefetch_cond, &demux->priv->prefetch_lock);
+    g_mutex_unlock (&demux->priv->prefetch_lock);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (prefetch->stream->pad, "Prefetching %s, range %"
+      G_GINT64_FORMAT " - %" G_GINT64_FORMAT ", %" GST_TIME_FORMAT
+      " already prefetched", prefetch->uri, prefetch->range_start,
+      prefetch->range_end, GST_TIME_ARGS (best_level));
+
+  /* from now on the stream clears prefetch->stream if it goes away */
+  demux->priv->prefetch_pending = prefetch;
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+
+  /* HTTP ranges are inclusive, GStreamer segments are exclusive for the
+   * stop position */
+  download =
+      gst_uri_downloader_fetch_uri_with_range (demux->priv->prefetch_downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      prefetch->range_end != -1 ? prefetch->range_end + 1 : -1, &err);
+
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  if (download) {
+    prefetch->buffer = gst_fragment_get_buffer (download);
+    prefetch->download_time =
+        download->download_stop_time - download->download_start_time;
+    g_object_unref (download);
+  } else {
+    /* kept so it is not retried, the download task fetches it itself */
+    GST_DEBUG_OBJECT (demux, "Failed to prefetch %s: %s", prefetch->uri,
+        err ? err->message : "unknown error");
+    g_clear_error (&err);
+  }
+
+  demux->priv->prefetch_pending = NULL;
+  demux->priv->prefetch_seqnum++;
+  if (demux->priv->stop_prefetch_task) {
+    gst_adaptive_demux_prefetch_free (prefetch);
+  } else if (prefetch->stream == NULL) {
+    /* the download was cancelled for a stream that went away, clear the
+     * cancelled state for the next one */
+    gst_uri_downloader_reset (demux->priv->prefetch_downloader);
+    gst_adaptive_demux_prefetch_free (prefetch);
+  } else {
+    g_queue_push_tail (&prefetch->stream->prefetched, prefetch);
+  }
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+}
+
 /* this function will take the manifest_lock and will keep it until the end.
  * It will release it temporarily only when going to sleep.
  * Every time it takes the manifest_lock, it will check for cancelled condition
@@ -4116,6 +4669,9 @@ gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux)
       g_mutex_lock (&demux->priv->manifest_update_lock);
       g_cond_broadcast (&demux->priv->manifest_cond);
       g_mutex_unlock (&demux->priv->manifest_update_lock);
+
+      /* and the prefetch task, there might be new fragments */
+      gst_adaptive_demux_signal_prefetch (demux);
     }
   }
 
@@ -4287,12 +4843,25 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
     ret = GST_FLOW_EOS;
   }
 
+  /* the prefetch window moved */
+  gst_adaptive_demux_signal_prefetch (demux);
+
   stream->download_start_time =
       GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
 
   if (ret == GST_FLOW_OK) {
-    if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
-            gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+    GstClockTime buffer_level;
+    guint64 bitrate;
+    gboolean switched;
+
+    bitrate = gst_adaptive_demux_stream_update_current_bitrate (demux, stream,
+        &buffer_level);
+    switched = gst_adaptive_demux_stream_select_bitrate (demux, stream,
+        bitrate);
+    gst_adaptive_demux_stream_post_abr_message (demux, stream, bitrate,
+        buffer_level, switched);
+
+    if (switched) {
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
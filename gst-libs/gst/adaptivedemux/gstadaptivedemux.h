@@ -26,6 +26,7 @@
 #include <gst/base/gstadapter.h>
 #include <gst/uridownloader/gsturidownloader.h>
 #include <gst/adaptivedemux/adaptive-demux-prelude.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
 
 G_BEGIN_DECLS
 
@@ -75,6 +76,16 @@ G_BEGIN_DECLS
  */
 #define GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME "adaptive-streaming-statistics"
 
+/**
+ * GST_ADAPTIVE_DEMUX_ABR_MESSAGE_NAME:
+ *
+ * Name of the ELEMENT type messages posted by adaptive demuxers with the
+ * bandwidth estimate and the bitrate selected after each fragment.
+ *
+ * Since: 1.20
+ */
+#define GST_ADAPTIVE_DEMUX_ABR_MESSAGE_NAME "adaptive-streaming-abr"
+
 #define GST_ELEMENT_ERROR_FROM_ERROR(el, msg, err) G_STMT_START { \
   gchar *__dbg = g_strdup_printf ("%s: %s", msg, err->message);         \
   GST_WARNING_OBJECT (el, "error: %s", __dbg);                          \
@@ -179,10 +190,10 @@ struct _GstAdaptiveDemuxStream
   GstClockTime last_latency;
   GstClockTime last_download_time;
 
-  /* Average for the last fragments */
-  guint64 moving_bitrate;
-  guint moving_index;
-  guint64 *fragment_bitrates;
+  /* Bandwidth estimation from the last fragments. Subclasses can set the
+   * bitrates of the stream representations on it for the buffer based
+   * algorithm */
+  GstAdaptiveDemuxAbr *abr;
 
   /* QoS data : UNUSED !!! */
   GstClockTime qos_earliest_time;
@@ -195,6 +206,10 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* upcoming fragments downloaded ahead of time, see the
+   * "prefetch-fragments" property. Protected by the demux prefetch lock */
+  GQueue prefetched;
 };
 
 /**
@@ -482,6 +497,23 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment_info:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n: number of fragments after the current one
+   * @fragment: (out): #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Optional. Fills the uri, range and duration of @fragment with the
+   * information of the fragment @n positions after the current one, without
+   * changing the stream state. Used to download upcoming fragments ahead of
+   * time when the "prefetch-fragments" property is set.
+   *
+   * Returns: %TRUE if there is such a fragment
+   *
+   * Since: 1.20
+   */
+  gboolean (*stream_peek_fragment_info) (GstAdaptiveDemuxStream * stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 };
 
 GST_ADAPTIVE_DEMUX_API
@@ -0,0 +1,547 @@
+/* GStreamer
+ *
+ * gstadaptivedemuxabr.c: bandwidth estimation and bitrate selection for
+ * adaptive streaming demuxers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstadaptivedemuxabr
+ * @short_description: Bitrate adaptation for adaptive streaming demuxers
+ *
+ * #GstAdaptiveDemuxAbr collects the download statistics of the fragments of
+ * a stream and picks the bitrate to use for the next fragments with one of
+ * the #GstAdaptiveDemuxAbrAlgorithm. All the estimators are fed with every
+ * fragment, so the algorithm can be changed at any time.
+ *
+ * It does not look at any clock, all times are passed in by the caller, so
+ * that a download trace replayed through it always leads to the same
+ * decisions.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gstadaptivedemuxabr.h"
+
+#ifndef GST_DISABLE_GST_DEBUG
+#define GST_CAT_DEFAULT ensure_debug_category()
+static GstDebugCategory *
+ensure_debug_category (void)
+{
+  static gsize cat_gonce = 0;
+
+  if (g_once_init_enter (&cat_gonce)) {
+    gsize cat_done;
+
+    cat_done = (gsize) _gst_debug_category_new ("adaptivedemuxabr", 0,
+        "Adaptive demux bitrate adaptation");
+
+    g_once_init_leave (&cat_gonce, cat_done);
+  }
+
+  return (GstDebugCategory *) cat_gonce;
+}
+#else
+#define ensure_debug_category()
+#endif /* GST_DISABLE_GST_DEBUG */
+
+#define MOVING_AVERAGE_FRAGMENTS 3
+#define HARMONIC_MEAN_FRAGMENTS 5
+
+/* half-lives of the averages, in seconds of download time */
+#define EWMA_FAST_HALF_LIFE 3.0
+#define EWMA_SLOW_HALF_LIFE 8.0
+
+/* weight of the last fragment in the time to first byte estimate */
+#define LATENCY_WEIGHT 0.25
+
+/* BOLA parameters: the buffer level to aim for and the weight of avoiding
+ * rebuffering against picking a higher bitrate (gamma * p in the paper) */
+#define BOLA_BUFFER_TARGET (20 * GST_SECOND)
+#define BOLA_GAMMA_P 5.0
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;
+  /* part of the estimate still coming from the initial 0 */
+  gdouble zero_factor;
+} GstAdaptiveDemuxAbrEwma;
+
+struct _GstAdaptiveDemuxAbr
+{
+  GstAdaptiveDemuxAbrAlgorithm algorithm;
+
+  /* bitrate of the last fragments including the time to first byte */
+  guint64 bitrates[MOVING_AVERAGE_FRAGMENTS];
+  guint64 bitrates_sum;
+  guint64 last_bitrate;
+  guint n_bitrates;
+
+  /* throughput of the last fragments, without the time to first byte */
+  guint64 throughputs[HARMONIC_MEAN_FRAGMENTS];
+  guint n_throughputs;
+
+  GstAdaptiveDemuxAbrEwma fast;
+  GstAdaptiveDemuxAbrEwma slow;
+
+  GstClockTime latency;
+
+  /* bitrates that can be selected, sorted from low to high */
+  guint64 *available;
+  guint n_available;
+  gint last_index;
+};
+
+GType
+gst_adaptive_demux_abr_algorithm_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE,
+        "Moving average of the last fragments", "moving-average"},
+    {GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_EWMA,
+        "Exponentially weighted moving average of the throughput", "ewma"},
+    {GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN,
+        "Harmonic mean of the throughput of the last fragments",
+        "harmonic-mean"},
+    {GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED,
+        "Buffer level based (BOLA)", "buffer-based"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstAdaptiveDemuxAbrAlgorithm", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+static void
+gst_adaptive_demux_abr_ewma_init (GstAdaptiveDemuxAbrEwma * ewma,
+    gdouble half_life)
+{
+  ewma->half_life = half_life;
+  ewma->estimate = 0;
+  ewma->zero_factor = 1;
+}
+
+static void
+gst_adaptive_demux_abr_ewma_add (GstAdaptiveDemuxAbrEwma * ewma,
+    gdouble weight, gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = alpha * ewma->estimate + (1 - alpha) * value;
+  ewma->zero_factor *= alpha;
+}
+
+static gdouble
+gst_adaptive_demux_abr_ewma_get (GstAdaptiveDemuxAbrEwma * ewma)
+{
+  if (ewma->zero_factor >= 1)
+    return 0;
+
+  return ewma->estimate / (1 - ewma->zero_factor);
+}
+
+/**
+ * gst_adaptive_demux_abr_new:
+ *
+ * Returns: (transfer full): a new #GstAdaptiveDemuxAbr using
+ *   %GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE
+ *
+ * Since: 1.20
+ */
+GstAdaptiveDemuxAbr *
+gst_adaptive_demux_abr_new (void)
+{
+  GstAdaptiveDemuxAbr *abr = g_new0 (GstAdaptiveDemuxAbr, 1);
+
+  ensure_debug_category ();
+
+  abr->algorithm = GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE;
+  gst_adaptive_demux_abr_reset (abr);
+
+  return abr;
+}
+
+/**
+ * gst_adaptive_demux_abr_free:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_free (abr->available);
+  g_free (abr);
+}
+
+/**
+ * gst_adaptive_demux_abr_reset:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Forgets all the download statistics. The algorithm and the available
+ * bitrates are kept.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_reset (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  memset (abr->bitrates, 0, sizeof (abr->bitrates));
+  abr->bitrates_sum = 0;
+  abr->last_bitrate = 0;
+  abr->n_bitrates = 0;
+
+  memset (abr->throughputs, 0, sizeof (abr->throughputs));
+  abr->n_throughputs = 0;
+
+  gst_adaptive_demux_abr_ewma_init (&abr->fast, EWMA_FAST_HALF_LIFE);
+  gst_adaptive_demux_abr_ewma_init (&abr->slow, EWMA_SLOW_HALF_LIFE);
+
+  abr->latency = GST_CLOCK_TIME_NONE;
+  abr->last_index = -1;
+}
+
+/**
+ * gst_adaptive_demux_abr_set_algorithm:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @algorithm: the #GstAdaptiveDemuxAbrAlgorithm to use
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_set_algorithm (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxAbrAlgorithm algorithm)
+{
+  g_return_if_fail (abr != NULL);
+
+  abr->algorithm = algorithm;
+}
+
+/**
+ * gst_adaptive_demux_abr_get_algorithm:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Returns: the #GstAdaptiveDemuxAbrAlgorithm in use
+ *
+ * Since: 1.20
+ */
+GstAdaptiveDemuxAbrAlgorithm
+gst_adaptive_demux_abr_get_algorithm (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_val_if_fail (abr != NULL,
+      GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE);
+
+  return abr->algorithm;
+}
+
+static gint
+compare_bitrates (gconstpointer a, gconstpointer b)
+{
+  guint64 bitrate_a = *(const guint64 *) a;
+  guint64 bitrate_b = *(const guint64 *) b;
+
+  return bitrate_a < bitrate_b ? -1 : bitrate_a > bitrate_b;
+}
+
+/**
+ * gst_adaptive_demux_abr_set_bitrates:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bitrates: (array length=n_bitrates) (allow-none): the bitrates of the
+ *   representations of the stream, in bits per second
+ * @n_bitrates: number of elements in @bitrates
+ *
+ * Sets the bitrates that can be switched to. They are required by
+ * %GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED, which otherwise behaves as
+ * %GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_set_bitrates (GstAdaptiveDemuxAbr * abr,
+    const guint64 * bitrates, guint n_bitrates)
+{
+  guint i;
+
+  g_return_if_fail (abr != NULL);
+  g_return_if_fail (bitrates != NULL || n_bitrates == 0);
+
+  g_free (abr->available);
+  abr->available = g_new (guint64, MAX (n_bitrates, 1));
+  abr->n_available = 0;
+  for (i = 0; i < n_bitrates; i++) {
+    if (bitrates[i] > 0)
+      abr->available[abr->n_available++] = bitrates[i];
+  }
+  qsort (abr->available, abr->n_available, sizeof (guint64),
+      compare_bitrates);
+
+  abr->last_index = -1;
+}
+
+/**
+ * gst_adaptive_demux_abr_add_sample:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bytes: size of the downloaded fragment
+ * @download_time: time from the request to the end of the download
+ * @latency: time from the request to the first byte, or
+ *   %GST_CLOCK_TIME_NONE if unknown
+ *
+ * Adds the download statistics of a fragment to the estimates.
+ *
+ * Since: 1.20
+ */
+void
+gst_adaptive_demux_abr_add_sample (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime download_time, GstClockTime latency)
+{
+  GstClockTime transfer_time;
+  guint64 bitrate, throughput;
+  guint index;
+
+  g_return_if_fail (abr != NULL);
+
+  if (!GST_CLOCK_TIME_IS_VALID (download_time) || download_time == 0)
+    download_time = 1;
+
+  bitrate = gst_util_uint64_scale (bytes, 8 * GST_SECOND, download_time);
+  index = abr->n_bitrates % MOVING_AVERAGE_FRAGMENTS;
+  abr->bitrates_sum -= abr->bitrates[index];
+  abr->bitrates[index] = bitrate;
+  abr->bitrates_sum += bitrate;
+  abr->last_bitrate = bitrate;
+  abr->n_bitrates++;
+
+  /* nothing was received, the throughput is unknown */
+  if (bytes == 0)
+    return;
+
+  transfer_time = download_time;
+  if (GST_CLOCK_TIME_IS_VALID (latency) && latency < download_time) {
+    transfer_time -= latency;
+
+    if (GST_CLOCK_TIME_IS_VALID (abr->latency))
+      abr->latency = (1 - LATENCY_WEIGHT) * abr->latency +
+          LATENCY_WEIGHT * latency;
+    else
+      abr->latency = latency;
+  }
+
+  throughput = gst_util_uint64_scale (bytes, 8 * GST_SECOND, transfer_time);
+  abr->throughputs[abr->n_throughputs % HARMONIC_MEAN_FRAGMENTS] =
+      MAX (throughput, 1);
+  abr->n_throughputs++;
+
+  gst_adaptive_demux_abr_ewma_add (&abr->fast,
+      (gdouble) transfer_time / GST_SECOND, throughput);
+  gst_adaptive_demux_abr_ewma_add (&abr->slow,
+      (gdouble) transfer_time / GST_SECOND, throughput);
+
+  GST_LOG ("%" G_GUINT64_FORMAT " bytes in %" GST_TIME_FORMAT
+      ", latency %" GST_TIME_FORMAT ": bitrate %" G_GUINT64_FORMAT
+      " bps, throughput %" G_GUINT64_FORMAT " bps", bytes,
+      GST_TIME_ARGS (download_time), GST_TIME_ARGS (latency), bitrate,
+      throughput);
+}
+
+static guint64
+gst_adaptive_demux_abr_harmonic_mean (GstAdaptiveDemuxAbr * abr)
+{
+  guint i, n = MIN (abr->n_throughputs, HARMONIC_MEAN_FRAGMENTS);
+  gdouble sum = 0;
+
+  if (n == 0)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    sum += 1.0 / abr->throughputs[i];
+
+  return n / sum;
+}
+
+/**
+ * gst_adaptive_demux_abr_get_bandwidth:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Returns: the estimated bandwidth of the algorithm in use, in bits per
+ *   second. The time to first byte is only included for
+ *   %GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE.
+ *
+ * Since: 1.20
+ */
+guint64
+gst_adaptive_demux_abr_get_bandwidth (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_val_if_fail (abr != NULL, 0);
+
+  switch (abr->algorithm) {
+    case GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE:
+    {
+      guint64 average;
+
+      if (abr->n_bitrates == 0)
+        return 0;
+
+      average = abr->bitrates_sum / MIN (abr->n_bitrates,
+          MOVING_AVERAGE_FRAGMENTS);
+      /* Conservative approach, make sure we don't upgrade too fast */
+      return MIN (average, abr->last_bitrate);
+    }
+    case GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_EWMA:
+      /* the fast average follows drops, the slow one avoids upgrading on
+       * short peaks */
+      return MIN (gst_adaptive_demux_abr_ewma_get (&abr->fast),
+          gst_adaptive_demux_abr_ewma_get (&abr->slow));
+    case GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN:
+    case GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED:
+      return gst_adaptive_demux_abr_harmonic_mean (abr);
+    default:
+      g_assert_not_reached ();
+      return 0;
+  }
+}
+
+/**
+ * gst_adaptive_demux_abr_get_latency:
+ * @abr: a #GstAdaptiveDemuxAbr
+ *
+ * Returns: the estimated time to first byte, or %GST_CLOCK_TIME_NONE if
+ *   unknown
+ *
+ * Since: 1.20
+ */
+GstClockTime
+gst_adaptive_demux_abr_get_latency (GstAdaptiveDemuxAbr * abr)
+{
+  g_return_val_if_fail (abr != NULL, GST_CLOCK_TIME_NONE);
+
+  return abr->latency;
+}
+
+/* BOLA-BASIC from "BOLA: Near-Optimal Bitrate Adaptation for Online Videos"
+ * (Spiteri et al.), with fragment sizes proportional to the bitrates */
+static guint
+gst_adaptive_demux_abr_bola_index (GstAdaptiveDemuxAbr * abr,
+    GstClockTime fragment_duration, GstClockTime buffer_level)
+{
+  gdouble level, target, max_utility, v, best_score = 0;
+  guint i, best = 0;
+
+  /* the buffer level and target in number of fragments */
+  level = (gdouble) buffer_level / fragment_duration;
+  target = MAX ((gdouble) BOLA_BUFFER_TARGET / fragment_duration, 2.0);
+
+  max_utility = log ((gdouble) abr->available[abr->n_available - 1] /
+      abr->available[0]);
+  v = (target - 1) / (max_utility + BOLA_GAMMA_P);
+
+  for (i = 0; i < abr->n_available; i++) {
+    gdouble utility = log ((gdouble) abr->available[i] / abr->available[0]);
+    gdouble score = (v * (utility + BOLA_GAMMA_P) - level) /
+        abr->available[i];
+
+    if (i == 0 || score > best_score) {
+      best = i;
+      best_score = score;
+    }
+  }
+
+  return best;
+}
+
+/**
+ * gst_adaptive_demux_abr_select_bitrate:
+ * @abr: a #GstAdaptiveDemuxAbr
+ * @bitrate_limit: fraction of the estimated bandwidth that can be used
+ * @fragment_duration: duration of the next fragment, or
+ *   %GST_CLOCK_TIME_NONE if unknown
+ * @buffer_level: duration of the media downloaded but not played yet, or
+ *   %GST_CLOCK_TIME_NONE if unknown
+ *
+ * Returns: the highest bitrate the next fragments should use, in bits per
+ *   second
+ *
+ * Since: 1.20
+ */
+guint64
+gst_adaptive_demux_abr_select_bitrate (GstAdaptiveDemuxAbr * abr,
+    gdouble bitrate_limit, GstClockTime fragment_duration,
+    GstClockTime buffer_level)
+{
+  guint64 bitrate;
+  guint index, rate_index;
+
+  g_return_val_if_fail (abr != NULL, 0);
+
+  bitrate = gst_adaptive_demux_abr_get_bandwidth (abr);
+
+  /* the samples already include the time to first byte */
+  if (abr->algorithm == GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE)
+    return bitrate * bitrate_limit;
+
+  /* each fragment starts with a round trip without data, which leaves less
+   * of the fragment duration for the transfer */
+  if (GST_CLOCK_TIME_IS_VALID (abr->latency) &&
+      GST_CLOCK_TIME_IS_VALID (fragment_duration) && fragment_duration > 0) {
+    GstClockTime latency = MIN (abr->latency, fragment_duration / 2);
+
+    bitrate = gst_util_uint64_scale (bitrate, fragment_duration - latency,
+        fragment_duration);
+  }
+  bitrate *= bitrate_limit;
+
+  if (abr->algorithm != GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED ||
+      abr->n_available == 0 || !GST_CLOCK_TIME_IS_VALID (fragment_duration)
+      || fragment_duration == 0 || !GST_CLOCK_TIME_IS_VALID (buffer_level))
+    return bitrate;
+
+  for (rate_index = abr->n_available - 1; rate_index > 0; rate_index--) {
+    if (abr->available[rate_index] <= bitrate)
+      break;
+  }
+
+  index = gst_adaptive_demux_abr_bola_index (abr, fragment_duration,
+      buffer_level);
+  /* BOLA-O: only go above the sustainable bitrate to stay at the current
+   * one, which avoids oscillating around it */
+  if (index > rate_index)
+    index = MIN (index, (guint) MAX ((gint) rate_index, abr->last_index));
+  abr->last_index = index;
+
+  GST_DEBUG ("buffer level %" GST_TIME_FORMAT ", bandwidth %"
+      G_GUINT64_FORMAT " bps: selected %" G_GUINT64_FORMAT " bps",
+      GST_TIME_ARGS (buffer_level), bitrate, abr->available[index]);
+
+  return abr->available[index];
+}
@@ -0,0 +1,105 @@
+/* GStreamer
+ *
+ * gstadaptivedemuxabr.h: bandwidth estimation and bitrate selection for
+ * adaptive streaming demuxers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_ADAPTIVE_DEMUX_ABR_H_
+#define _GST_ADAPTIVE_DEMUX_ABR_H_
+
+#include <gst/gst.h>
+#include <gst/adaptivedemux/adaptive-demux-prelude.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstAdaptiveDemuxAbrAlgorithm:
+ * @GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE: the lowest of the last
+ *   fragment bitrate and the average of the last 3 fragments
+ * @GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_EWMA: the lowest of a fast and a slow
+ *   exponentially weighted moving average of the throughput
+ * @GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN: the harmonic mean of the
+ *   throughput of the last 5 fragments
+ * @GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED: picks one of the available
+ *   bitrates from the buffer level (BOLA), capped by the harmonic mean
+ *   throughput
+ *
+ * Algorithms used to pick the bitrate of the next fragments. Except for
+ * the moving average, the throughput is measured without the time to first
+ * byte, which is accounted for separately for each fragment.
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE,
+  GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_EWMA,
+  GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN,
+  GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED,
+} GstAdaptiveDemuxAbrAlgorithm;
+
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM \
+  (gst_adaptive_demux_abr_algorithm_get_type ())
+
+typedef struct _GstAdaptiveDemuxAbr GstAdaptiveDemuxAbr;
+
+GST_ADAPTIVE_DEMUX_API
+GType gst_adaptive_demux_abr_algorithm_get_type (void);
+
+GST_ADAPTIVE_DEMUX_API
+GstAdaptiveDemuxAbr * gst_adaptive_demux_abr_new (void);
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_reset (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_set_algorithm (GstAdaptiveDemuxAbr * abr,
+                                           GstAdaptiveDemuxAbrAlgorithm algorithm);
+
+GST_ADAPTIVE_DEMUX_API
+GstAdaptiveDemuxAbrAlgorithm gst_adaptive_demux_abr_get_algorithm (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_set_bitrates (GstAdaptiveDemuxAbr * abr,
+                                          const guint64 * bitrates,
+                                          guint n_bitrates);
+
+GST_ADAPTIVE_DEMUX_API
+void gst_adaptive_demux_abr_add_sample (GstAdaptiveDemuxAbr * abr,
+                                        guint64 bytes,
+                                        GstClockTime download_time,
+                                        GstClockTime latency);
+
+GST_ADAPTIVE_DEMUX_API
+guint64 gst_adaptive_demux_abr_get_bandwidth (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+GstClockTime gst_adaptive_demux_abr_get_latency (GstAdaptiveDemuxAbr * abr);
+
+GST_ADAPTIVE_DEMUX_API
+guint64 gst_adaptive_demux_abr_select_bitrate (GstAdaptiveDemuxAbr * abr,
+                                               gdouble bitrate_limit,
+                                               GstClockTime fragment_duration,
+                                               GstClockTime buffer_level);
+
+G_END_DECLS
+
+#endif /* _GST_ADAPTIVE_DEMUX_ABR_H_ */
@@ -62,8 +62,69 @@ ceil_log2 (guint32 v)
   return r + 1;
 }
 
+/* Number of bytes checked for emulation prevention bytes at once, kept
+ * small since only the headers of slice NAL units are usually read */
+#define NAL_READER_EPB_WINDOW 32
+
+/* Checks whether any of the 8 bytes of @w is zero */
+#define HAS_ZERO_BYTE(w) \
+  (((w) - G_GUINT64_CONSTANT (0x0101010101010101)) & ~(w) & \
+      G_GUINT64_CONSTANT (0x8080808080808080))
+
+/* Returns the position of the first 0x00 0x00 @third byte sequence starting
+ * at or after @pos and ending before @size, or -1. Words without any zero
+ * byte can't start such a sequence and are skipped 8 bytes at a time, the
+ * remaining ones are checked skipping as many bytes as possible after each
+ * mismatch. @third must not be 0 */
+static inline gint
+find_zero_zero_byte (const guint8 * data, guint pos, guint size, guint8 third)
+{
+  guint64 w;
+
+  while (pos + 2 < size) {
+    if (pos + 8 <= size) {
+      memcpy (&w, data + pos, 8);
+      if (!HAS_ZERO_BYTE (w)) {
+        pos += 8;
+        continue;
+      }
+    }
+
+    if (data[pos + 2] != third && data[pos + 2] != 0)
+      pos += 3;
+    else if (data[pos + 1] != 0)
+      pos += 2;
+    else if (data[pos] != 0 || data[pos + 2] != third)
+      pos++;
+    else
+      return pos;
+  }
+
+  return -1;
+}
+
 /****** Nal parser ******/
 
+/* Returns the position of the first emulation prevention byte at or after
+ * @pos within the next NAL_READER_EPB_WINDOW bytes, or the end of the
+ * window if there is none */
+static guint
+nal_reader_find_epb (const NalReader * nr, guint pos)
+{
+  guint start, end;
+  gint epb;
+
+  /* the 0x00 0x00 prefix is part of the window so that it can be found */
+  start = pos >= 2 ? pos - 2 : 0;
+  end = MIN (pos + NAL_READER_EPB_WINDOW, nr->size);
+
+  epb = find_zero_zero_byte (nr->data, start, end, 0x03);
+  if (epb < 0)
+    return end;
+
+  return epb + 2;
+}
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -73,9 +134,8 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
   nr->first_byte = 0xff;
-  nr->epb_cache = 0xff;
+  nr->epb_end = 0;
   nr->cache = 0xff;
 }
 
@@ -91,18 +151,22 @@ nal_reader_read (NalReader * nr, guint nbits)
   while (nr->bits_in_cache < nbits) {
     guint8 byte;
 
-  next_byte:
+    /* bytes before epb_end are known not to be
+     * emulation_prevention_three_bytes, look further ahead once reached */
+    if (G_UNLIKELY (nr->byte >= nr->epb_end)) {
+      if (nr->byte >= 2 && nr->byte < nr->size &&
+          nr->data[nr->byte] == 0x03 && nr->data[nr->byte - 1] == 0x00 &&
+          nr->data[nr->byte - 2] == 0x00) {
+        nr->byte++;
+        nr->n_epb++;
+      }
+      nr->epb_end = nal_reader_find_epb (nr, nr->byte);
+    }
+
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
     byte = nr->data[nr->byte++];
-    nr->epb_cache = (nr->epb_cache << 8) | byte;
-
-    /* check if the byte is a emulation_prevention_three_byte */
-    if ((nr->epb_cache & 0xffffff) == 0x3) {
-      nr->n_epb++;
-      goto next_byte;
-    }
     nr->cache = (nr->cache << 8) | nr->first_byte;
     nr->first_byte = byte;
     nr->bits_in_cache += 8;
@@ -298,12 +362,11 @@ nal_reader_has_more_data (NalReader * nr)
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  if (size < 4)
+    return -1;
+
+  return find_zero_zero_byte (data, 0, size - 1, 0x01);
 }
 
 void
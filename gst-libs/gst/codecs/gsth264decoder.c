@@ -78,6 +78,20 @@ typedef enum
   GST_H264_DECODER_ALIGN_AU
 } GstH264DecoderAlign;
 
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+  /* Input buffer, mapped until the frame is decoded as the parsed slices
+   * point into it */
+  GstBuffer *buffer;
+  GstMapInfo map;
+  /* GstH264Slice of the slices parsed ahead */
+  GArray *slices;
+  /* Offset of the first NAL unit left for the streaming thread, or -1 if
+   * the whole frame was parsed */
+  gint resume_offset;
+} GstH264DecoderParseJob;
+
 struct _GstH264DecoderPrivate
 {
   GstH264DecoderCompliance compliance;
@@ -140,6 +154,13 @@ struct _GstH264DecoderPrivate
   GArray *ref_pic_list_b0;
   GArray *ref_pic_list_b1;
 
+  /* Whether ref_pic_list0 and ref_pic_list1 were built for a previous slice
+   * of the current picture, and for which kind of slice */
+  gboolean ref_pic_lists_valid;
+  guint ref_pic_lists_slice_type;
+  guint ref_pic_lists_num_ref_idx_l0_active_minus1;
+  guint ref_pic_lists_num_ref_idx_l1_active_minus1;
+
   /* Temporary picture list, for reference picture lists in fields,
    * corresponding to 8.2.4.2.2 refFrameList0ShortTerm, refFrameList0LongTerm
    * and 8.2.4.2.5 refFrameList1ShortTerm and refFrameListLongTerm */
@@ -153,6 +174,22 @@ struct _GstH264DecoderPrivate
 
   /* For delayed output */
   GstQueueArray *output_queue;
+
+  /* Parsing of the next frames on a helper thread, see
+   * GstH264Decoder:parse-ahead */
+  guint parse_ahead;
+  GThread *parse_thread;
+  GMutex parse_lock;
+  GCond parse_cond;
+  gboolean parse_running;
+  /* Frames waiting to be parsed, and parsed frames waiting to be decoded,
+   * both in decoding order */
+  GQueue parse_pending;
+  GQueue parse_done;
+  /* The frame being parsed, and the frame the parse thread waits on before
+   * parsing further */
+  GstH264DecoderParseJob *parsing;
+  GstH264DecoderParseJob *parse_barrier;
 };
 
 typedef struct
@@ -164,6 +201,9 @@ typedef struct
   GstH264Decoder *self;
 } GstH264DecoderOutputFrame;
 
+/* Upper bound of GstH264Decoder:parse-ahead */
+#define MAX_PARSE_AHEAD 16
+
 #define parent_class gst_h264_decoder_parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH264Decoder, gst_h264_decoder,
     GST_TYPE_VIDEO_DECODER,
@@ -187,6 +227,7 @@ static GstFlowReturn gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
 static gboolean gst_h264_decoder_process_sps (GstH264Decoder * self,
     GstH264SPS * sps);
 static gboolean gst_h264_decoder_decode_slice (GstH264Decoder * self);
+static gboolean gst_h264_decoder_process_slice (GstH264Decoder * self);
 static gboolean gst_h264_decoder_decode_nal (GstH264Decoder * self,
     GstH264NalUnit * nalu);
 static gboolean gst_h264_decoder_fill_picture_from_slice (GstH264Decoder * self,
@@ -196,6 +237,10 @@ static gboolean gst_h264_decoder_calculate_poc (GstH264Decoder * self,
 static gboolean gst_h264_decoder_init_gap_picture (GstH264Decoder * self,
     GstH264Picture * picture, gint frame_num);
 static gboolean gst_h264_decoder_drain_internal (GstH264Decoder * self);
+static void gst_h264_decoder_stop_parse_thread (GstH264Decoder * self);
+static void gst_h264_decoder_discard_parse_jobs (GstH264Decoder * self);
+static GstFlowReturn gst_h264_decoder_decode_parse_jobs (GstH264Decoder * self,
+    guint keep);
 static gboolean gst_h264_decoder_finish_current_picture (GstH264Decoder * self);
 static gboolean gst_h264_decoder_finish_picture (GstH264Decoder * self,
     GstH264Picture * picture);
@@ -217,6 +262,7 @@ enum
 {
   PROP_0,
   PROP_COMPLIANCE,
+  PROP_PARSE_AHEAD,
 };
 
 /**
@@ -266,6 +312,11 @@ gst_h264_decoder_get_property (GObject * object, guint property_id,
       g_value_set_enum (value, priv->compliance);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_PARSE_AHEAD:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, priv->parse_ahead);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -285,6 +336,11 @@ gst_h264_decoder_set_property (GObject * object, guint property_id,
       priv->compliance = g_value_get_enum (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_PARSE_AHEAD:
+      GST_OBJECT_LOCK (self);
+      priv->parse_ahead = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -325,6 +381,23 @@ gst_h264_decoder_class_init (GstH264DecoderClass * klass)
           "The decoder's behavior in compliance with the h264 spec.",
           GST_TYPE_H264_DECODER_COMPLIANCE, GST_H264_DECODER_COMPLIANCE_AUTO,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT));
+
+  /**
+   * GstH264Decoder:parse-ahead:
+   *
+   * The number of input frames whose NAL units and slice headers are parsed
+   * on a helper thread while the subclass decodes the previous frames.
+   * Decoded picture buffer management, reference picture lists and all
+   * subclass calls stay on the streaming thread, in decoding order.
+   * Each frame parsed ahead adds a frame of latency. 0 disables the
+   * helper thread.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_PARSE_AHEAD,
+      g_param_spec_uint ("parse-ahead", "Parse ahead",
+          "Number of frames parsed ahead on a helper thread (0 = disabled)",
+          0, MAX_PARSE_AHEAD, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -377,6 +450,11 @@ gst_h264_decoder_init (GstH264Decoder * self)
       gst_queue_array_new_for_struct (sizeof (GstH264DecoderOutputFrame), 1);
   gst_queue_array_set_clear_func (priv->output_queue,
       (GDestroyNotify) gst_h264_decoder_clear_output_frame);
+
+  g_mutex_init (&priv->parse_lock);
+  g_cond_init (&priv->parse_cond);
+  g_queue_init (&priv->parse_pending);
+  g_queue_init (&priv->parse_done);
 }
 
 static void
@@ -394,6 +472,8 @@ gst_h264_decoder_finalize (GObject * object)
   g_array_unref (priv->ref_pic_list0);
   g_array_unref (priv->ref_pic_list1);
   gst_queue_array_free (priv->output_queue);
+  g_mutex_clear (&priv->parse_lock);
+  g_cond_clear (&priv->parse_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -434,6 +514,7 @@ gst_h264_decoder_stop (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
 
+  gst_h264_decoder_stop_parse_thread (self);
   gst_h264_decoder_reset (self);
 
   return TRUE;
@@ -486,6 +567,7 @@ gst_h264_decoder_flush (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
 
+  gst_h264_decoder_discard_parse_jobs (self);
   gst_h264_decoder_clear_dpb (self, TRUE);
 
   return TRUE;
@@ -496,11 +578,18 @@ gst_h264_decoder_drain (GstVideoDecoder * decoder)
 {
   GstH264Decoder *self = GST_H264_DECODER (decoder);
   GstH264DecoderPrivate *priv = self->priv;
+  GstFlowReturn ret;
+
+  /* Frames parsed ahead go first */
+  ret = gst_h264_decoder_decode_parse_jobs (self, 0);
 
   priv->last_ret = GST_FLOW_OK;
   /* dpb will be cleared by this method */
   gst_h264_decoder_drain_internal (self);
 
+  if (ret != GST_FLOW_OK)
+    return ret;
+
   return priv->last_ret;
 }
 
@@ -510,41 +599,31 @@ gst_h264_decoder_finish (GstVideoDecoder * decoder)
   return gst_h264_decoder_drain (decoder);
 }
 
-static GstFlowReturn
-gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+/* Decodes the NAL units of @map from @offset on, stops at the first one that
+ * fails */
+static gboolean
+gst_h264_decoder_decode_nals (GstH264Decoder * self, const GstMapInfo * map,
+    guint offset)
 {
-  GstH264Decoder *self = GST_H264_DECODER (decoder);
   GstH264DecoderPrivate *priv = self->priv;
-  GstBuffer *in_buf = frame->input_buffer;
   GstH264NalUnit nalu;
   GstH264ParserResult pres;
-  GstMapInfo map;
   gboolean decode_ret = TRUE;
 
-  GST_LOG_OBJECT (self,
-      "handle frame, PTS: %" GST_TIME_FORMAT ", DTS: %"
-      GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
-      GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
-
-  priv->current_frame = frame;
-  priv->last_ret = GST_FLOW_OK;
-
-  gst_buffer_map (in_buf, &map, GST_MAP_READ);
   if (priv->in_format == GST_H264_DECODER_FORMAT_AVC) {
     pres = gst_h264_parser_identify_nalu_avc (priv->parser,
-        map.data, 0, map.size, priv->nal_length_size, &nalu);
+        map->data, offset, map->size, priv->nal_length_size, &nalu);
 
     while (pres == GST_H264_PARSER_OK && decode_ret) {
       decode_ret = gst_h264_decoder_decode_nal (self, &nalu);
 
       pres = gst_h264_parser_identify_nalu_avc (priv->parser,
-          map.data, nalu.offset + nalu.size, map.size, priv->nal_length_size,
+          map->data, nalu.offset + nalu.size, map->size, priv->nal_length_size,
           &nalu);
     }
   } else {
     pres = gst_h264_parser_identify_nalu (priv->parser,
-        map.data, 0, map.size, &nalu);
+        map->data, offset, map->size, &nalu);
 
     if (pres == GST_H264_PARSER_NO_NAL_END)
       pres = GST_H264_PARSER_OK;
@@ -553,19 +632,29 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
       decode_ret = gst_h264_decoder_decode_nal (self, &nalu);
 
       pres = gst_h264_parser_identify_nalu (priv->parser,
-          map.data, nalu.offset + nalu.size, map.size, &nalu);
+          map->data, nalu.offset + nalu.size, map->size, &nalu);
 
       if (pres == GST_H264_PARSER_NO_NAL_END)
         pres = GST_H264_PARSER_OK;
     }
   }
 
-  gst_buffer_unmap (in_buf, &map);
+  return decode_ret;
+}
+
+/* Finishes the picture of priv->current_frame once all its NAL units were
+ * decoded, or drops the frame if @decode_ret is FALSE */
+static GstFlowReturn
+gst_h264_decoder_finish_frame_decoding (GstH264Decoder * self,
+    gboolean decode_ret)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstVideoCodecFrame *frame = priv->current_frame;
 
   if (!decode_ret) {
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
         ("Failed to decode data"), (NULL), priv->last_ret);
-    gst_video_decoder_drop_frame (decoder, frame);
+    gst_video_decoder_drop_frame (GST_VIDEO_DECODER (self), frame);
 
     gst_h264_picture_clear (&priv->current_picture);
     priv->current_frame = NULL;
@@ -580,6 +669,272 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
   return priv->last_ret;
 }
 
+static void
+gst_h264_decoder_free_parse_job (GstH264DecoderParseJob * job)
+{
+  gst_buffer_unmap (job->buffer, &job->map);
+  gst_buffer_unref (job->buffer);
+  gst_video_codec_frame_unref (job->frame);
+  g_array_unref (job->slices);
+  g_free (job);
+}
+
+/* Called on the parse thread. Identifies the NAL units of the job and parses
+ * its slice headers. Parameter sets update the parser state the following
+ * slice headers depend on, so parsing stops at the first one and the rest
+ * of the frame is left to the streaming thread, as are slice headers that
+ * fail to parse so that errors are reported in decoding order. */
+static void
+gst_h264_decoder_parse_job (GstH264Decoder * self,
+    GstH264DecoderParseJob * job)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstH264NalUnit nalu;
+  GstH264ParserResult pres;
+  GstH264Slice slice;
+  guint offset = 0;
+
+  while (TRUE) {
+    if (priv->in_format == GST_H264_DECODER_FORMAT_AVC) {
+      pres = gst_h264_parser_identify_nalu_avc (priv->parser,
+          job->map.data, offset, job->map.size, priv->nal_length_size, &nalu);
+    } else {
+      pres = gst_h264_parser_identify_nalu (priv->parser,
+          job->map.data, offset, job->map.size, &nalu);
+
+      if (pres == GST_H264_PARSER_NO_NAL_END)
+        pres = GST_H264_PARSER_OK;
+    }
+
+    if (pres != GST_H264_PARSER_OK)
+      return;
+
+    switch (nalu.type) {
+      case GST_H264_NAL_SPS:
+      case GST_H264_NAL_PPS:
+        job->resume_offset = offset;
+        return;
+      case GST_H264_NAL_SLICE:
+      case GST_H264_NAL_SLICE_DPA:
+      case GST_H264_NAL_SLICE_DPB:
+      case GST_H264_NAL_SLICE_DPC:
+      case GST_H264_NAL_SLICE_IDR:
+      case GST_H264_NAL_SLICE_EXT:
+        memset (&slice, 0, sizeof (GstH264Slice));
+        pres = gst_h264_parser_parse_slice_hdr (priv->parser, &nalu,
+            &slice.header, TRUE, TRUE);
+        if (pres != GST_H264_PARSER_OK) {
+          job->resume_offset = offset;
+          return;
+        }
+
+        slice.nalu = nalu;
+        g_array_append_val (job->slices, slice);
+        break;
+      default:
+        break;
+    }
+
+    offset = nalu.offset + nalu.size;
+  }
+}
+
+static gpointer
+gst_h264_decoder_parse_thread (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstH264DecoderParseJob *job;
+
+  g_mutex_lock (&priv->parse_lock);
+  while (priv->parse_running) {
+    if (priv->parse_barrier ||
+        !(job = g_queue_pop_head (&priv->parse_pending))) {
+      g_cond_wait (&priv->parse_cond, &priv->parse_lock);
+      continue;
+    }
+
+    priv->parsing = job;
+    g_mutex_unlock (&priv->parse_lock);
+
+    gst_h264_decoder_parse_job (self, job);
+
+    g_mutex_lock (&priv->parse_lock);
+    priv->parsing = NULL;
+    g_queue_push_tail (&priv->parse_done, job);
+    /* Wait for the parameter sets of this frame before parsing further */
+    if (job->resume_offset >= 0)
+      priv->parse_barrier = job;
+    g_cond_broadcast (&priv->parse_cond);
+  }
+  g_mutex_unlock (&priv->parse_lock);
+
+  return NULL;
+}
+
+static void
+gst_h264_decoder_discard_parse_jobs (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstH264DecoderParseJob *job;
+
+  g_mutex_lock (&priv->parse_lock);
+  while (priv->parsing)
+    g_cond_wait (&priv->parse_cond, &priv->parse_lock);
+
+  while ((job = g_queue_pop_head (&priv->parse_pending)))
+    gst_h264_decoder_free_parse_job (job);
+  while ((job = g_queue_pop_head (&priv->parse_done)))
+    gst_h264_decoder_free_parse_job (job);
+  priv->parse_barrier = NULL;
+  g_mutex_unlock (&priv->parse_lock);
+}
+
+static void
+gst_h264_decoder_stop_parse_thread (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
+  if (!priv->parse_thread)
+    return;
+
+  gst_h264_decoder_discard_parse_jobs (self);
+
+  g_mutex_lock (&priv->parse_lock);
+  priv->parse_running = FALSE;
+  g_cond_broadcast (&priv->parse_cond);
+  g_mutex_unlock (&priv->parse_lock);
+
+  g_thread_join (priv->parse_thread);
+  priv->parse_thread = NULL;
+}
+
+static GstFlowReturn
+gst_h264_decoder_decode_parse_job (GstH264Decoder * self,
+    GstH264DecoderParseJob * job)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  gboolean decode_ret = TRUE;
+  GstFlowReturn ret;
+  guint i;
+
+  priv->current_frame = gst_video_codec_frame_ref (job->frame);
+  priv->last_ret = GST_FLOW_OK;
+
+  for (i = 0; i < job->slices->len && decode_ret; i++) {
+    GstH264Slice *slice = &g_array_index (job->slices, GstH264Slice, i);
+
+    GST_LOG_OBJECT (self, "Parsed ahead nal type: %d, offset %d, size %d",
+        slice->nalu.type, slice->nalu.offset, slice->nalu.size);
+
+    priv->current_slice = *slice;
+    decode_ret = gst_h264_decoder_process_slice (self);
+  }
+
+  if (decode_ret && job->resume_offset >= 0)
+    decode_ret = gst_h264_decoder_decode_nals (self, &job->map,
+        job->resume_offset);
+
+  ret = gst_h264_decoder_finish_frame_decoding (self, decode_ret);
+
+  g_mutex_lock (&priv->parse_lock);
+  if (priv->parse_barrier == job) {
+    priv->parse_barrier = NULL;
+    g_cond_broadcast (&priv->parse_cond);
+  }
+  g_mutex_unlock (&priv->parse_lock);
+
+  gst_h264_decoder_free_parse_job (job);
+
+  return ret;
+}
+
+/* Decodes the frames handed to the parse thread, in decoding order, until at
+ * most @keep of them are left in flight */
+static GstFlowReturn
+gst_h264_decoder_decode_parse_jobs (GstH264Decoder * self, guint keep)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstH264DecoderParseJob *job;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&priv->parse_lock);
+  while (ret == GST_FLOW_OK && g_queue_get_length (&priv->parse_pending) +
+      g_queue_get_length (&priv->parse_done) + (priv->parsing ? 1 : 0) > keep) {
+    while (!(job = g_queue_pop_head (&priv->parse_done)))
+      g_cond_wait (&priv->parse_cond, &priv->parse_lock);
+    g_mutex_unlock (&priv->parse_lock);
+
+    ret = gst_h264_decoder_decode_parse_job (self, job);
+
+    g_mutex_lock (&priv->parse_lock);
+  }
+  g_mutex_unlock (&priv->parse_lock);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstH264Decoder *self = GST_H264_DECODER (decoder);
+  GstH264DecoderPrivate *priv = self->priv;
+  GstBuffer *in_buf = frame->input_buffer;
+  GstMapInfo map;
+  gboolean decode_ret;
+  guint parse_ahead;
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (self,
+      "handle frame, PTS: %" GST_TIME_FORMAT ", DTS: %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
+      GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
+
+  GST_OBJECT_LOCK (self);
+  parse_ahead = priv->parse_ahead;
+  GST_OBJECT_UNLOCK (self);
+
+  if (parse_ahead > 0) {
+    GstH264DecoderParseJob *job;
+
+    if (!priv->parse_thread) {
+      priv->parse_running = TRUE;
+      priv->parse_thread = g_thread_new ("h264-parse",
+          (GThreadFunc) gst_h264_decoder_parse_thread, self);
+    }
+
+    job = g_new0 (GstH264DecoderParseJob, 1);
+    job->frame = frame;
+    job->buffer = gst_buffer_ref (in_buf);
+    job->slices = g_array_new (FALSE, FALSE, sizeof (GstH264Slice));
+    job->resume_offset = -1;
+    gst_buffer_map (in_buf, &job->map, GST_MAP_READ);
+
+    g_mutex_lock (&priv->parse_lock);
+    g_queue_push_tail (&priv->parse_pending, job);
+    g_cond_broadcast (&priv->parse_cond);
+    g_mutex_unlock (&priv->parse_lock);
+
+    return gst_h264_decoder_decode_parse_jobs (self, parse_ahead);
+  }
+
+  /* parse-ahead was disabled while frames were in flight */
+  ret = gst_h264_decoder_decode_parse_jobs (self, 0);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_release_frame (decoder, frame);
+    return ret;
+  }
+
+  priv->current_frame = frame;
+  priv->last_ret = GST_FLOW_OK;
+
+  gst_buffer_map (in_buf, &map, GST_MAP_READ);
+  decode_ret = gst_h264_decoder_decode_nals (self, &map, 0);
+  gst_buffer_unmap (in_buf, &map);
+
+  return gst_h264_decoder_finish_frame_decoding (self, decode_ret);
+}
+
 static gboolean
 gst_h264_decoder_parse_sps (GstH264Decoder * self, GstH264NalUnit * nalu)
 {
@@ -1220,6 +1575,15 @@ gst_h264_decoder_parse_slice (GstH264Decoder * self, GstH264NalUnit * nalu)
 
   priv->current_slice.nalu = *nalu;
 
+  return gst_h264_decoder_process_slice (self);
+}
+
+/* Decodes priv->current_slice, whose header was already parsed */
+static gboolean
+gst_h264_decoder_process_slice (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
   if (!gst_h264_decoder_preprocess_slice (self, &priv->current_slice))
     return FALSE;
 
@@ -1378,6 +1742,9 @@ gst_h264_decoder_set_format (GstVideoDecoder * decoder,
 
   GST_DEBUG_OBJECT (decoder, "Set format");
 
+  /* The parse thread shares the parser and the stream format */
+  gst_h264_decoder_decode_parse_jobs (self, 0);
+
   if (self->input_state)
     gst_video_codec_state_unref (self->input_state);
 
@@ -1852,6 +2219,25 @@ poc_desc_compare (const GstH264Picture ** a, const GstH264Picture ** b)
   return (*b)->pic_order_cnt - (*a)->pic_order_cnt;
 }
 
+/* Stable insertion sort of the pictures of @list in [@from, @to). The lists
+ * hold at most a DPB worth of pictures, which the DPB returns in decoding
+ * order, already close to the wanted order for most lists, so this is
+ * cheaper than a generic sort for them */
+static void
+sort_pic_list (GArray * list, guint from, guint to, GCompareFunc compare_func)
+{
+  GstH264Picture **pics = (GstH264Picture **) list->data;
+  guint i, j;
+
+  for (i = from + 1; i < to; i++) {
+    GstH264Picture *pic = pics[i];
+
+    for (j = i; j > from && compare_func (&pics[j - 1], &pic) > 0; j--)
+      pics[j] = pics[j - 1];
+    pics[j] = pic;
+  }
+}
+
 static gboolean
 gst_h264_decoder_drain_internal (GstH264Decoder * self)
 {
@@ -2296,6 +2682,7 @@ gst_h264_decoder_set_latency (GstH264Decoder * self, const GstH264SPS * sps,
   GstStructure *structure;
   gint fps_d = 1, fps_n = 0;
   guint32 num_reorder_frames;
+  guint parse_ahead;
 
   caps = gst_pad_get_current_caps (GST_VIDEO_DECODER_SRC_PAD (self));
   if (!caps)
@@ -2323,13 +2710,17 @@ gst_h264_decoder_set_latency (GstH264Decoder * self, const GstH264SPS * sps,
   if (num_reorder_frames > max_dpb_size)
     num_reorder_frames = priv->is_live ? 0 : 1;
 
-  /* Consider output delay wanted by subclass */
-  num_reorder_frames += priv->preferred_output_delay;
+  /* Consider output delay wanted by subclass, and the frames held back while
+   * they are parsed ahead */
+  GST_OBJECT_LOCK (self);
+  parse_ahead = priv->parse_ahead;
+  GST_OBJECT_UNLOCK (self);
+  num_reorder_frames += priv->preferred_output_delay + parse_ahead;
 
   min = gst_util_uint64_scale_int (num_reorder_frames * GST_SECOND, fps_d,
       fps_n);
-  max = gst_util_uint64_scale_int ((max_dpb_size + priv->preferred_output_delay)
-      * GST_SECOND, fps_d, fps_n);
+  max = gst_util_uint64_scale_int ((max_dpb_size + priv->preferred_output_delay
+          + parse_ahead) * GST_SECOND, fps_d, fps_n);
 
   GST_LOG_OBJECT (self,
       "latency min %" G_GUINT64_FORMAT " max %" G_GUINT64_FORMAT, min, max);
@@ -2507,9 +2898,8 @@ gst_h264_decoder_decode_slice (GstH264Decoder * self)
   }
 
 beach:
-  g_array_set_size (priv->ref_pic_list0, 0);
-  g_array_set_size (priv->ref_pic_list1, 0);
-
+  /* ref_pic_list0 and ref_pic_list1 are kept for the next slices of the
+   * picture, see gst_h264_decoder_can_reuse_ref_pic_lists() */
   return ret;
 }
 
@@ -2541,14 +2931,14 @@ construct_ref_pic_lists_p (GstH264Decoder * self,
 
   gst_h264_dpb_get_pictures_short_term_ref (priv->dpb,
       TRUE, FALSE, priv->ref_pic_list_p0);
-  g_array_sort (priv->ref_pic_list_p0, (GCompareFunc) pic_num_desc_compare);
+  sort_pic_list (priv->ref_pic_list_p0, 0, priv->ref_pic_list_p0->len,
+      (GCompareFunc) pic_num_desc_compare);
 
   pos = priv->ref_pic_list_p0->len;
   gst_h264_dpb_get_pictures_long_term_ref (priv->dpb,
       FALSE, priv->ref_pic_list_p0);
-  g_qsort_with_data (&g_array_index (priv->ref_pic_list_p0, gpointer, pos),
-      priv->ref_pic_list_p0->len - pos, sizeof (gpointer),
-      (GCompareDataFunc) long_term_pic_num_asc_compare, NULL);
+  sort_pic_list (priv->ref_pic_list_p0, pos, priv->ref_pic_list_p0->len,
+      (GCompareFunc) long_term_pic_num_asc_compare);
 
 #ifndef GST_DISABLE_GST_DEBUG
   if (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >= GST_LEVEL_DEBUG) {
@@ -2627,7 +3017,8 @@ construct_ref_field_pic_lists_p (GstH264Decoder * self,
    */
   gst_h264_dpb_get_pictures_short_term_ref (priv->dpb,
       TRUE, TRUE, priv->ref_frame_list_0_short_term);
-  g_array_sort (priv->ref_frame_list_0_short_term,
+  sort_pic_list (priv->ref_frame_list_0_short_term, 0,
+      priv->ref_frame_list_0_short_term->len,
       (GCompareFunc) frame_num_wrap_desc_compare);
 
 #ifndef GST_DISABLE_GST_DEBUG
@@ -2650,7 +3041,8 @@ construct_ref_field_pic_lists_p (GstH264Decoder * self,
    */
   gst_h264_dpb_get_pictures_long_term_ref (priv->dpb,
       TRUE, priv->ref_frame_list_long_term);
-  g_array_sort (priv->ref_frame_list_long_term,
+  sort_pic_list (priv->ref_frame_list_long_term, 0,
+      priv->ref_frame_list_long_term->len,
       (GCompareFunc) long_term_frame_idx_asc_compare);
 
 #ifndef GST_DISABLE_GST_DEBUG
@@ -2715,6 +3107,21 @@ lists_are_equal (GArray * l1, GArray * l2)
   return TRUE;
 }
 
+/* Appends the pictures of @src in [@from, @to) to @dest, taking a new
+ * reference on them */
+static void
+append_pic_list_range (GArray * dest, GArray * src, guint from, guint to)
+{
+  guint i;
+
+  for (i = from; i < to; i++) {
+    GstH264Picture *pic = g_array_index (src, GstH264Picture *, i);
+
+    pic = gst_h264_picture_ref (pic);
+    g_array_append_val (dest, pic);
+  }
+}
+
 static gint
 split_ref_pic_list_b (GstH264Decoder * self, GArray * ref_pic_list_b,
     GCompareFunc compare_func)
@@ -2763,7 +3170,7 @@ construct_ref_pic_lists_b (GstH264Decoder * self,
     GstH264Picture * current_picture)
 {
   GstH264DecoderPrivate *priv = self->priv;
-  gint pos;
+  gint pos, split, same;
 
   /* RefPicList0 (8.2.4.2.3) [[1] [2] [3]], where:
    * [1] shortterm ref pics with POC < current_picture's POC sorted by descending POC,
@@ -2784,55 +3191,54 @@ construct_ref_pic_lists_b (GstH264Decoder * self,
   /* First sort ascending, this will put [1] in right place and finish
    * [2]. */
   print_ref_pic_list_b (self, priv->ref_pic_list_b0, "ref_pic_list_b0");
-  g_array_sort (priv->ref_pic_list_b0, (GCompareFunc) poc_asc_compare);
+  sort_pic_list (priv->ref_pic_list_b0, 0, priv->ref_pic_list_b0->len,
+      (GCompareFunc) poc_asc_compare);
   print_ref_pic_list_b (self, priv->ref_pic_list_b0, "ref_pic_list_b0");
 
   /* Find first with POC > current_picture's POC to get first element
    * in [2]... */
-  pos = split_ref_pic_list_b (self, priv->ref_pic_list_b0,
+  split = split_ref_pic_list_b (self, priv->ref_pic_list_b0,
       (GCompareFunc) poc_asc_compare);
 
-  GST_DEBUG_OBJECT (self, "split point %i", pos);
+  GST_DEBUG_OBJECT (self, "split point %i", split);
 
   /* and sort [1] descending, thus finishing sequence [1] [2]. */
-  g_qsort_with_data (priv->ref_pic_list_b0->data, pos, sizeof (gpointer),
-      (GCompareDataFunc) poc_desc_compare, NULL);
+  sort_pic_list (priv->ref_pic_list_b0, 0, split,
+      (GCompareFunc) poc_desc_compare);
 
   /* Now add [3] and sort by ascending long_term_pic_num. */
   pos = priv->ref_pic_list_b0->len;
   gst_h264_dpb_get_pictures_long_term_ref (priv->dpb,
       FALSE, priv->ref_pic_list_b0);
-  g_qsort_with_data (&g_array_index (priv->ref_pic_list_b0, gpointer, pos),
-      priv->ref_pic_list_b0->len - pos, sizeof (gpointer),
-      (GCompareDataFunc) long_term_pic_num_asc_compare, NULL);
+  sort_pic_list (priv->ref_pic_list_b0, pos, priv->ref_pic_list_b0->len,
+      (GCompareFunc) long_term_pic_num_asc_compare);
 
   /* RefPicList1 (8.2.4.2.4) [[1] [2] [3]], where:
    * [1] shortterm ref pics with POC > curr_pic's POC sorted by ascending POC,
    * [2] shortterm ref pics with POC < curr_pic's POC by descending POC,
    * [3] longterm ref pics by ascending long_term_pic_num.
+   *
+   * These are the same pictures as in RefPicList0 in a different order, so
+   * reuse its sorted parts instead of collecting and sorting them again.
+   * [1] is RefPicList0 [2], preceded by the pictures with the same POC as
+   * current_picture found at the start of RefPicList0 [1], [2] is the rest
+   * of RefPicList0 [1] and [3] is RefPicList0 [3].
    */
-  gst_h264_dpb_get_pictures_short_term_ref (priv->dpb,
-      current_picture->pic_order_cnt_type != 0, FALSE, priv->ref_pic_list_b1);
-
-  /* First sort by descending POC. */
-  g_array_sort (priv->ref_pic_list_b1, (GCompareFunc) poc_desc_compare);
-
-  /* Split at first with POC < current_picture's POC to get first element
-   * in [2]... */
-  pos = split_ref_pic_list_b (self, priv->ref_pic_list_b1,
-      (GCompareFunc) poc_desc_compare);
-
-  /* and sort [1] ascending. */
-  g_qsort_with_data (priv->ref_pic_list_b1->data, pos, sizeof (gpointer),
-      (GCompareDataFunc) poc_asc_compare, NULL);
+  for (same = 0; same < split; same++) {
+    GstH264Picture *pic =
+        g_array_index (priv->ref_pic_list_b0, GstH264Picture *, same);
+    if (pic->pic_order_cnt != current_picture->pic_order_cnt)
+      break;
+  }
 
-  /* Now add [3] and sort by ascending long_term_pic_num */
-  pos = priv->ref_pic_list_b1->len;
-  gst_h264_dpb_get_pictures_long_term_ref (priv->dpb,
-      FALSE, priv->ref_pic_list_b1);
-  g_qsort_with_data (&g_array_index (priv->ref_pic_list_b1, gpointer, pos),
-      priv->ref_pic_list_b1->len - pos, sizeof (gpointer),
-      (GCompareDataFunc) long_term_pic_num_asc_compare, NULL);
+  append_pic_list_range (priv->ref_pic_list_b1, priv->ref_pic_list_b0,
+      0, same);
+  append_pic_list_range (priv->ref_pic_list_b1, priv->ref_pic_list_b0,
+      split, pos);
+  append_pic_list_range (priv->ref_pic_list_b1, priv->ref_pic_list_b0,
+      same, split);
+  append_pic_list_range (priv->ref_pic_list_b1, priv->ref_pic_list_b0,
+      pos, priv->ref_pic_list_b0->len);
 
   /* If lists identical, swap first two entries in RefPicList1 (spec
    * 8.2.4.2.3) */
@@ -2879,7 +3285,8 @@ construct_ref_field_pic_lists_b (GstH264Decoder * self,
    * [2]. */
   print_ref_pic_list_b (self, priv->ref_frame_list_0_short_term,
       "ref_frame_list_0_short_term");
-  g_array_sort (priv->ref_frame_list_0_short_term,
+  sort_pic_list (priv->ref_frame_list_0_short_term, 0,
+      priv->ref_frame_list_0_short_term->len,
       (GCompareFunc) poc_asc_compare);
   print_ref_pic_list_b (self, priv->ref_frame_list_0_short_term,
       "ref_frame_list_0_short_term");
@@ -2892,8 +3299,8 @@ construct_ref_field_pic_lists_b (GstH264Decoder * self,
   GST_DEBUG_OBJECT (self, "split point %i", pos);
 
   /* and sort [1] descending, thus finishing sequence [1] [2]. */
-  g_qsort_with_data (priv->ref_frame_list_0_short_term->data, pos,
-      sizeof (gpointer), (GCompareDataFunc) poc_desc_compare, NULL);
+  sort_pic_list (priv->ref_frame_list_0_short_term, 0, pos,
+      (GCompareFunc) poc_desc_compare);
 
   /* refFrameList1ShortTerm (8.2.4.2.4) [[1] [2]], where:
    * [1] shortterm ref pics with POC > curr_pic's POC sorted by ascending POC,
@@ -2904,7 +3311,8 @@ construct_ref_field_pic_lists_b (GstH264Decoder * self,
       priv->ref_frame_list_1_short_term);
 
   /* First sort by descending POC. */
-  g_array_sort (priv->ref_frame_list_1_short_term,
+  sort_pic_list (priv->ref_frame_list_1_short_term, 0,
+      priv->ref_frame_list_1_short_term->len,
       (GCompareFunc) poc_desc_compare);
 
   /* Split at first with POC < current_picture's POC to get first element
@@ -2913,15 +3321,16 @@ construct_ref_field_pic_lists_b (GstH264Decoder * self,
       (GCompareFunc) poc_desc_compare);
 
   /* and sort [1] ascending. */
-  g_qsort_with_data (priv->ref_frame_list_1_short_term->data, pos,
-      sizeof (gpointer), (GCompareDataFunc) poc_asc_compare, NULL);
+  sort_pic_list (priv->ref_frame_list_1_short_term, 0, pos,
+      (GCompareFunc) poc_asc_compare);
 
   /* 8.2.4.2.2 refFrameList0LongTerm,:
    * long-term ref pictures sorted by ascending long_term_frame_idx.
    */
   gst_h264_dpb_get_pictures_long_term_ref (priv->dpb,
       TRUE, priv->ref_frame_list_long_term);
-  g_array_sort (priv->ref_frame_list_long_term,
+  sort_pic_list (priv->ref_frame_list_long_term, 0,
+      priv->ref_frame_list_long_term->len,
       (GCompareFunc) long_term_frame_idx_asc_compare);
 
   /* 8.2.4.2.5 RefPicList0 */
@@ -2981,10 +3390,11 @@ gst_h264_decoder_prepare_ref_pic_lists (GstH264Decoder * self,
   }
   g_array_unref (dpb_array);
 
-  if (!construct_list) {
-    gst_h264_decoder_clear_ref_pic_lists (self);
+  /* Drops the lists of the previous picture */
+  gst_h264_decoder_clear_ref_pic_lists (self);
+
+  if (!construct_list)
     return;
-  }
 
   if (GST_H264_PICTURE_IS_FRAME (current_picture)) {
     construct_ref_pic_lists_p (self, current_picture);
@@ -3000,6 +3410,12 @@ gst_h264_decoder_clear_ref_pic_lists (GstH264Decoder * self)
 {
   GstH264DecoderPrivate *priv = self->priv;
 
+  /* ref_pic_list0 and ref_pic_list1 point to the pictures of these lists
+   * without holding a reference */
+  priv->ref_pic_lists_valid = FALSE;
+  g_array_set_size (priv->ref_pic_list0, 0);
+  g_array_set_size (priv->ref_pic_list1, 0);
+
   g_array_set_size (priv->ref_pic_list_p0, 0);
   g_array_set_size (priv->ref_pic_list_b0, 0);
   g_array_set_size (priv->ref_pic_list_b1, 0);
@@ -3197,11 +3613,31 @@ modify_ref_pic_list (GstH264Decoder * self, int list)
 static void
 copy_pic_list_into (GArray * dest, GArray * src)
 {
-  gint i;
   g_array_set_size (dest, 0);
+  g_array_append_vals (dest, src->data, src->len);
+}
+
+/* Whether the lists built for the previous slice of the current picture
+ * are also the ones of the current slice. They only depend on the slice
+ * type, the number of active references and the list modifications */
+static gboolean
+gst_h264_decoder_can_reuse_ref_pic_lists (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GstH264SliceHdr *slice_hdr = &priv->current_slice.header;
 
-  for (i = 0; i < src->len; i++)
-    g_array_append_val (dest, g_array_index (src, gpointer, i));
+  if (!priv->ref_pic_lists_valid)
+    return FALSE;
+
+  if (slice_hdr->ref_pic_list_modification_flag_l0 ||
+      slice_hdr->ref_pic_list_modification_flag_l1)
+    return FALSE;
+
+  return slice_hdr->type % 5 == priv->ref_pic_lists_slice_type &&
+      slice_hdr->num_ref_idx_l0_active_minus1 ==
+      priv->ref_pic_lists_num_ref_idx_l0_active_minus1 &&
+      slice_hdr->num_ref_idx_l1_active_minus1 ==
+      priv->ref_pic_lists_num_ref_idx_l1_active_minus1;
 }
 
 static gboolean
@@ -3209,22 +3645,45 @@ gst_h264_decoder_modify_ref_pic_lists (GstH264Decoder * self)
 {
   GstH264DecoderPrivate *priv = self->priv;
   GstH264SliceHdr *slice_hdr = &priv->current_slice.header;
+  gboolean ret = TRUE;
+
+  if (gst_h264_decoder_can_reuse_ref_pic_lists (self)) {
+    GST_TRACE_OBJECT (self, "Reusing reference picture lists");
+    return TRUE;
+  }
 
+  priv->ref_pic_lists_valid = FALSE;
   g_array_set_size (priv->ref_pic_list0, 0);
   g_array_set_size (priv->ref_pic_list1, 0);
 
   if (GST_H264_IS_P_SLICE (slice_hdr) || GST_H264_IS_SP_SLICE (slice_hdr)) {
     /* 8.2.4 fill reference picture list RefPicList0 for P or SP slice */
     copy_pic_list_into (priv->ref_pic_list0, priv->ref_pic_list_p0);
-    return modify_ref_pic_list (self, 0);
+    ret = modify_ref_pic_list (self, 0);
   } else if (GST_H264_IS_B_SLICE (slice_hdr)) {
     /* 8.2.4 fill reference picture list RefPicList0 and RefPicList1 for B slice */
     copy_pic_list_into (priv->ref_pic_list0, priv->ref_pic_list_b0);
     copy_pic_list_into (priv->ref_pic_list1, priv->ref_pic_list_b1);
-    return modify_ref_pic_list (self, 0)
+    ret = modify_ref_pic_list (self, 0)
         && modify_ref_pic_list (self, 1);
   }
 
+  if (!ret) {
+    g_array_set_size (priv->ref_pic_list0, 0);
+    g_array_set_size (priv->ref_pic_list1, 0);
+    return FALSE;
+  }
+
+  if (!slice_hdr->ref_pic_list_modification_flag_l0 &&
+      !slice_hdr->ref_pic_list_modification_flag_l1) {
+    priv->ref_pic_lists_valid = TRUE;
+    priv->ref_pic_lists_slice_type = slice_hdr->type % 5;
+    priv->ref_pic_lists_num_ref_idx_l0_active_minus1 =
+        slice_hdr->num_ref_idx_l0_active_minus1;
+    priv->ref_pic_lists_num_ref_idx_l1_active_minus1 =
+        slice_hdr->num_ref_idx_l1_active_minus1;
+  }
+
   return TRUE;
 }
 
@@ -124,6 +124,13 @@ struct _GstH265DecoderPrivate
   GArray *ref_pic_list_tmp;
   GArray *ref_pic_list0;
   GArray *ref_pic_list1;
+
+  /* Whether ref_pic_list0 and ref_pic_list1 were built for a previous slice
+   * of the current picture, and for which kind of slice */
+  gboolean ref_pic_lists_valid;
+  guint ref_pic_lists_slice_type;
+  guint ref_pic_lists_num_ref_idx_l0_active_minus1;
+  guint ref_pic_lists_num_ref_idx_l1_active_minus1;
 };
 
 #define parent_class gst_h265_decoder_parent_class
@@ -147,6 +154,7 @@ static GstFlowReturn gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
 
 static gboolean gst_h265_decoder_finish_current_picture (GstH265Decoder * self);
 static void gst_h265_decoder_clear_ref_pic_sets (GstH265Decoder * self);
+static void gst_h265_decoder_clear_ref_pic_lists (GstH265Decoder * self);
 static void gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush);
 static gboolean gst_h265_decoder_drain_internal (GstH265Decoder * self);
 static gboolean gst_h265_decoder_start_current_picture (GstH265Decoder * self);
@@ -238,6 +246,7 @@ gst_h265_decoder_stop (GstVideoDecoder * decoder)
     priv->dpb = NULL;
   }
 
+  gst_h265_decoder_clear_ref_pic_lists (self);
   gst_h265_decoder_clear_ref_pic_sets (self);
 
   return TRUE;
@@ -453,6 +462,40 @@ gst_h265_decoder_parse_sei (GstH265Decoder * self, GstH265NalUnit * nalu)
   return TRUE;
 }
 
+static void
+gst_h265_decoder_clear_ref_pic_lists (GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  priv->ref_pic_lists_valid = FALSE;
+  g_array_set_size (priv->ref_pic_list0, 0);
+  g_array_set_size (priv->ref_pic_list1, 0);
+}
+
+/* Whether the lists built for the previous slice of the current picture
+ * are also the ones of @slice. Within a picture they only depend on the
+ * slice type, the number of active references and the list modifications */
+static gboolean
+gst_h265_decoder_can_reuse_ref_pic_lists (GstH265Decoder * self,
+    const GstH265Slice * slice)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  const GstH265SliceHdr *slice_hdr = &slice->header;
+
+  if (!priv->ref_pic_lists_valid)
+    return FALSE;
+
+  if (slice_hdr->ref_pic_list_modification.ref_pic_list_modification_flag_l0
+      || slice_hdr->ref_pic_list_modification.ref_pic_list_modification_flag_l1)
+    return FALSE;
+
+  return slice_hdr->type == priv->ref_pic_lists_slice_type &&
+      slice_hdr->num_ref_idx_l0_active_minus1 ==
+      priv->ref_pic_lists_num_ref_idx_l0_active_minus1 &&
+      slice_hdr->num_ref_idx_l1_active_minus1 ==
+      priv->ref_pic_lists_num_ref_idx_l1_active_minus1;
+}
+
 static void
 gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
     GstH265Picture * curr_pic, GstH265Slice * slice,
@@ -469,6 +512,23 @@ gst_h265_decoder_process_ref_pic_lists (GstH265Decoder * self,
   *ref_pic_list0 = priv->ref_pic_list0;
   *ref_pic_list1 = priv->ref_pic_list1;
 
+  if (gst_h265_decoder_can_reuse_ref_pic_lists (self, slice)) {
+    GST_TRACE_OBJECT (self, "Reusing reference picture lists");
+    return;
+  }
+
+  gst_h265_decoder_clear_ref_pic_lists (self);
+
+  if (!ref_mod->ref_pic_list_modification_flag_l0 &&
+      !ref_mod->ref_pic_list_modification_flag_l1) {
+    priv->ref_pic_lists_valid = TRUE;
+    priv->ref_pic_lists_slice_type = slice->header.type;
+    priv->ref_pic_lists_num_ref_idx_l0_active_minus1 =
+        slice->header.num_ref_idx_l0_active_minus1;
+    priv->ref_pic_lists_num_ref_idx_l1_active_minus1 =
+        slice->header.num_ref_idx_l1_active_minus1;
+  }
+
   /* There is nothing to be done for I slices */
   if (GST_H265_IS_I_SLICE (&slice->header))
     return;
@@ -597,13 +657,10 @@ gst_h265_decoder_decode_slice (GstH265Decoder * self)
     gst_h265_decoder_process_ref_pic_lists (self, picture, slice, &l0, &l1);
   }
 
+  /* The lists are kept for the next slices of the picture, see
+   * gst_h265_decoder_can_reuse_ref_pic_lists() */
   ret = klass->decode_slice (self, picture, slice, l0, l1);
 
-  if (priv->process_ref_pic_lists) {
-    g_array_set_size (l0, 0);
-    g_array_set_size (l1, 0);
-  }
-
   return ret;
 }
 
@@ -1609,6 +1666,10 @@ gst_h265_decoder_start_current_picture (GstH265Decoder * self)
     return TRUE;
   }
 
+  /* The lists of the previous picture point to pictures the new reference
+   * picture set may release */
+  gst_h265_decoder_clear_ref_pic_lists (self);
+
   gst_h265_decoder_prepare_rps (self, &priv->current_slice,
       priv->current_picture);
 
@@ -51,6 +51,7 @@ enum
   SIGNAL_ON_ERROR,
   SIGNAL_ON_MESSAGE_DATA,
   SIGNAL_ON_MESSAGE_STRING,
+  SIGNAL_ON_MESSAGE_BUFFER,
   SIGNAL_ON_BUFFERED_AMOUNT_LOW,
   SIGNAL_SEND_DATA,
   SIGNAL_SEND_STRING,
@@ -320,6 +321,26 @@ gst_webrtc_data_channel_class_init (GstWebRTCDataChannelClass * klass)
       g_signal_new ("on-message-string", G_TYPE_FROM_CLASS (klass),
       G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_STRING);
 
+  /**
+   * GstWebRTCDataChannel::on-message-buffer:
+   * @object: the #GstWebRTCDataChannel
+   * @buffer: a #GstBuffer with the binary message received
+   *
+   * Emitted for every binary message received, without copying or
+   * converting the payload, and in the same order as the string messages.
+   * While a handler is connected, binary messages are not emitted through
+   * #GstWebRTCDataChannel::on-message-data anymore.
+   *
+   * Handlers must not block and must take their own reference to @buffer if
+   * they keep it around after returning.
+   *
+   * Since: 1.20
+   */
+  gst_webrtc_data_channel_signals[SIGNAL_ON_MESSAGE_BUFFER] =
+      g_signal_new ("on-message-buffer", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+      GST_TYPE_BUFFER | G_SIGNAL_TYPE_STATIC_SCOPE);
+
   /**
    * GstWebRTCDataChannel::on-buffered-amount-low:
    * @object: the #GstWebRTCDataChannel
@@ -488,6 +509,39 @@ gst_webrtc_data_channel_on_message_string (GstWebRTCDataChannel * channel,
       gst_webrtc_data_channel_signals[SIGNAL_ON_MESSAGE_STRING], 0, str);
 }
 
+/**
+ * gst_webrtc_data_channel_on_message_buffer:
+ * @channel: a #GstWebRTCDataChannel
+ * @buffer: (transfer none): a #GstBuffer
+ *
+ * Signal that the data channel received a binary message, if anyone is
+ * interested in receiving them as #GstBuffer. Should only be used by
+ * subclasses.
+ *
+ * Returns: %TRUE if @buffer was handed to a #GstWebRTCDataChannel::on-message-buffer
+ * handler, %FALSE if the message should be signalled with
+ * gst_webrtc_data_channel_on_message_data() instead.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_webrtc_data_channel_on_message_buffer (GstWebRTCDataChannel * channel,
+    GstBuffer * buffer)
+{
+  g_return_val_if_fail (GST_IS_WEBRTC_DATA_CHANNEL (channel), FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+
+  if (!g_signal_has_handler_pending (channel,
+          gst_webrtc_data_channel_signals[SIGNAL_ON_MESSAGE_BUFFER], 0, TRUE))
+    return FALSE;
+
+  GST_LOG_OBJECT (channel, "Have buffer %" GST_PTR_FORMAT, buffer);
+  g_signal_emit (channel,
+      gst_webrtc_data_channel_signals[SIGNAL_ON_MESSAGE_BUFFER], 0, buffer);
+
+  return TRUE;
+}
+
 /**
  * gst_webrtc_data_channel_on_buffered_amount_low:
  * @channel: a #GstWebRTCDataChannel
@@ -542,6 +596,90 @@ gst_webrtc_data_channel_send_string (GstWebRTCDataChannel * channel,
   klass->send_string (channel, str);
 }
 
+/**
+ * gst_webrtc_data_channel_send_buffer:
+ * @channel: a #GstWebRTCDataChannel
+ * @buffer: (transfer full): a #GstBuffer
+ *
+ * Send @buffer as a binary message over @channel without copying the
+ * payload. An empty @buffer is sent as an empty binary message.
+ *
+ * The size of @buffer is accounted in #GstWebRTCDataChannel:buffered-amount
+ * until it was handed to the SCTP stack, which allows applications to
+ * throttle themselves by polling that property.
+ *
+ * Since: 1.20
+ */
+void
+gst_webrtc_data_channel_send_buffer (GstWebRTCDataChannel * channel,
+    GstBuffer * buffer)
+{
+  GstWebRTCDataChannelClass *klass;
+
+  g_return_if_fail (GST_IS_WEBRTC_DATA_CHANNEL (channel));
+  g_return_if_fail (GST_IS_BUFFER (buffer));
+
+  klass = GST_WEBRTC_DATA_CHANNEL_GET_CLASS (channel);
+  if (klass->send_buffer) {
+    klass->send_buffer (channel, buffer);
+  } else {
+    GstBufferList *list = gst_buffer_list_new_sized (1);
+
+    gst_buffer_list_add (list, buffer);
+    gst_webrtc_data_channel_send_buffer_list (channel, list);
+  }
+}
+
+/**
+ * gst_webrtc_data_channel_send_buffer_list:
+ * @channel: a #GstWebRTCDataChannel
+ * @list: (transfer full): a #GstBufferList
+ *
+ * Send every buffer of @list as a separate binary message over @channel,
+ * in order and without copying the payloads. This is considerably cheaper
+ * than sending the messages one by one.
+ *
+ * Since: 1.20
+ */
+void
+gst_webrtc_data_channel_send_buffer_list (GstWebRTCDataChannel * channel,
+    GstBufferList * list)
+{
+  GstWebRTCDataChannelClass *klass;
+
+  g_return_if_fail (GST_IS_WEBRTC_DATA_CHANNEL (channel));
+  g_return_if_fail (GST_IS_BUFFER_LIST (list));
+
+  klass = GST_WEBRTC_DATA_CHANNEL_GET_CLASS (channel);
+  if (klass->send_buffer_list) {
+    klass->send_buffer_list (channel, list);
+  } else {
+    guint i, len = gst_buffer_list_length (list);
+
+    /* fallback for subclasses only implementing the GBytes API */
+    for (i = 0; i < len; i++) {
+      GstBuffer *buffer = gst_buffer_list_get (list, i);
+      GBytes *bytes = NULL;
+
+      if (gst_buffer_get_size (buffer) > 0) {
+        GstMapInfo info;
+
+        if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
+          GST_ERROR_OBJECT (channel, "Failed to map buffer %" GST_PTR_FORMAT,
+              buffer);
+          continue;
+        }
+        bytes = g_bytes_new (info.data, info.size);
+        gst_buffer_unmap (buffer, &info);
+      }
+      klass->send_data (channel, bytes);
+      if (bytes)
+        g_bytes_unref (bytes);
+    }
+    gst_buffer_list_unref (list);
+  }
+}
+
 /**
  * gst_webrtc_data_channel_close:
  * @channel: a #GstWebRTCDataChannel
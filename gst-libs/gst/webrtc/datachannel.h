@@ -42,6 +42,12 @@ void gst_webrtc_data_channel_send_data (GstWebRTCDataChannel * channel, GBytes *
 GST_WEBRTC_API
 void gst_webrtc_data_channel_send_string (GstWebRTCDataChannel * channel, const gchar * str);
 
+GST_WEBRTC_API
+void gst_webrtc_data_channel_send_buffer (GstWebRTCDataChannel * channel, GstBuffer * buffer);
+
+GST_WEBRTC_API
+void gst_webrtc_data_channel_send_buffer_list (GstWebRTCDataChannel * channel, GstBufferList * list);
+
 GST_WEBRTC_API
 void gst_webrtc_data_channel_close (GstWebRTCDataChannel * channel);
 
@@ -266,8 +266,10 @@ struct _GstWebRTCDataChannelClass
   void              (*send_data)   (GstWebRTCDataChannel * channel, GBytes *data);
   void              (*send_string) (GstWebRTCDataChannel * channel, const gchar *str);
   void              (*close)       (GstWebRTCDataChannel * channel);
+  void              (*send_buffer) (GstWebRTCDataChannel * channel, GstBuffer * buffer);
+  void              (*send_buffer_list) (GstWebRTCDataChannel * channel, GstBufferList * list);
 
-  gpointer           _padding[GST_PADDING];
+  gpointer           _padding[GST_PADDING - 2];
 };
 
 GST_WEBRTC_API
@@ -282,6 +284,9 @@ void gst_webrtc_data_channel_on_error (GstWebRTCDataChannel * channel, GError *
 GST_WEBRTC_API
 void gst_webrtc_data_channel_on_message_data (GstWebRTCDataChannel * channel, GBytes * data);
 
+GST_WEBRTC_API
+gboolean gst_webrtc_data_channel_on_message_buffer (GstWebRTCDataChannel * channel, GstBuffer * buffer);
+
 GST_WEBRTC_API
 void gst_webrtc_data_channel_on_message_string (GstWebRTCDataChannel * channel, const gchar * str);
 
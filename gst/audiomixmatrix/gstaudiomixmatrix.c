@@ -55,6 +55,11 @@
  * g_value_unset (&v);
  * ]|
  *
+ * Matrices where every output channel is a copy of at most one input channel
+ * (identity, truncated identity or a channel reordering) are handled as a
+ * plain channel gather. Otherwise only the non-zero coefficients of each
+ * row are applied, on blocks of deinterleaved samples.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 audiotestsrc ! audio/x-raw,channels=4 ! audiomixmatrix in-channels=4 out-channels=2 channel-mask=-1 matrix="<<(double)1, (double)0, (double)0, (double)0>, <0.0, 1.0, 0.0, 0.0>>" ! audio/x-raw,channels=2 ! autoaudiosink
@@ -67,6 +72,7 @@
 #endif
 
 #include "gstaudiomixmatrix.h"
+#include "gstaudiomixmatrixorc.h"
 
 #include <gst/gst.h>
 #include <stdlib.h>
@@ -76,6 +82,9 @@
 GST_DEBUG_CATEGORY_STATIC (audiomixmatrix_debug);
 #define GST_CAT_DEFAULT audiomixmatrix_debug
 
+/* Number of frames deinterleaved and mixed at once */
+#define BLOCK_FRAMES 256
+
 /* GstAudioMixMatrix properties */
 enum
 {
@@ -232,6 +241,73 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->s16_conv_matrix = NULL;
   self->s32_conv_matrix = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
+  self->gather = NULL;
+  self->nz_offsets = NULL;
+  self->nz_in = NULL;
+  self->scratch = NULL;
+}
+
+static void
+gst_audio_mix_matrix_clear_plan (GstAudioMixMatrix * self)
+{
+  g_clear_pointer (&self->gather, g_free);
+  g_clear_pointer (&self->nz_offsets, g_free);
+  g_clear_pointer (&self->nz_in, g_free);
+  g_clear_pointer (&self->scratch, g_free);
+}
+
+/* Must be called with the object lock */
+static void
+gst_audio_mix_matrix_update_plan (GstAudioMixMatrix * self)
+{
+  gboolean is_gather = TRUE;
+  guint in, out, n_nz = 0;
+
+  gst_audio_mix_matrix_clear_plan (self);
+
+  if (!self->matrix || self->in_channels == 0 || self->out_channels == 0)
+    return;
+
+  self->gather = g_new (gint, self->out_channels);
+  self->nz_offsets = g_new (guint, self->out_channels + 1);
+  self->nz_in = g_new (guint, self->in_channels * self->out_channels);
+
+  for (out = 0; out < self->out_channels; out++) {
+    guint row_nz = 0;
+
+    self->gather[out] = -1;
+    self->nz_offsets[out] = n_nz;
+    for (in = 0; in < self->in_channels; in++) {
+      gdouble coefficient = self->matrix[out * self->in_channels + in];
+
+      if (coefficient == 0)
+        continue;
+
+      self->nz_in[n_nz++] = in;
+      if (coefficient == 1 && row_nz == 0)
+        self->gather[out] = in;
+      else
+        is_gather = FALSE;
+      row_nz++;
+    }
+  }
+  self->nz_offsets[self->out_channels] = n_nz;
+
+  if (is_gather) {
+    GST_DEBUG_OBJECT (self, "Matrix is a channel gather");
+    g_clear_pointer (&self->nz_offsets, g_free);
+    g_clear_pointer (&self->nz_in, g_free);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Matrix has %u non-zero coefficients out of %u",
+      n_nz, self->in_channels * self->out_channels);
+  g_clear_pointer (&self->gather, g_free);
+
+  /* deinterleaved input channels followed by the accumulator, sized for the
+   * largest sample type */
+  self->scratch =
+      g_malloc ((self->in_channels + 1) * BLOCK_FRAMES * sizeof (gint64));
 }
 
 static void
@@ -244,6 +320,8 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  gst_audio_mix_matrix_clear_plan (self);
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
@@ -328,6 +406,9 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
       }
       gst_audio_mix_matrix_convert_s16_matrix (self);
       gst_audio_mix_matrix_convert_s32_matrix (self);
+      GST_OBJECT_LOCK (self);
+      gst_audio_mix_matrix_update_plan (self);
+      GST_OBJECT_UNLOCK (self);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -414,16 +495,202 @@ gst_audio_mix_matrix_change_state (GstElement * element,
 }
 
 
+#define DEFINE_GATHER(type) \
+static void \
+gst_audio_mix_matrix_gather_##type (GstAudioMixMatrix * self, \
+    const type * inarray, type * outarray, guint n_samples) \
+{ \
+  guint inchannels = self->in_channels; \
+  guint outchannels = self->out_channels; \
+  const gint *gather = self->gather; \
+  guint out, sample; \
+  \
+  for (sample = 0; sample < n_samples; sample++) { \
+    for (out = 0; out < outchannels; out++) \
+      outarray[out] = gather[out] < 0 ? 0 : inarray[gather[out]]; \
+    inarray += inchannels; \
+    outarray += outchannels; \
+  } \
+}
+
+DEFINE_GATHER (gint16)
+DEFINE_GATHER (gint32)
+DEFINE_GATHER (gint64)
+
+/* Copies a block of interleaved frames into one contiguous array per
+ * channel, BLOCK_FRAMES apart */
+#define DEFINE_DEINTERLEAVE(intype, outtype) \
+static void \
+gst_audio_mix_matrix_deinterleave_##intype##_##outtype (const intype * inarray, \
+    outtype * planar, guint channels, guint n_samples) \
+{ \
+  guint in, sample; \
+  \
+  for (sample = 0; sample < n_samples; sample++) { \
+    for (in = 0; in < channels; in++) \
+      planar[in * BLOCK_FRAMES + sample] = inarray[in]; \
+    inarray += channels; \
+  } \
+}
+
+DEFINE_DEINTERLEAVE (gfloat, gfloat)
+DEFINE_DEINTERLEAVE (gdouble, gdouble)
+DEFINE_DEINTERLEAVE (gint16, gint32)
+DEFINE_DEINTERLEAVE (gint32, gint64)
+
+static void
+gst_audio_mix_matrix_mix_f32 (GstAudioMixMatrix * self,
+    const gfloat * inarray, gfloat * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  gfloat *planar = self->scratch;
+  gfloat *acc = planar + inchannels * BLOCK_FRAMES;
+  guint start, n, out, k, sample;
+
+  for (start = 0; start < n_samples; start += n) {
+    n = MIN (BLOCK_FRAMES, n_samples - start);
+
+    gst_audio_mix_matrix_deinterleave_gfloat_gfloat (inarray, planar,
+        inchannels, n);
+
+    for (out = 0; out < outchannels; out++) {
+      memset (acc, 0, n * sizeof (gfloat));
+      for (k = self->nz_offsets[out]; k < self->nz_offsets[out + 1]; k++) {
+        guint in = self->nz_in[k];
+
+        audio_mix_matrix_orc_mac_f32 (acc, planar + in * BLOCK_FRAMES,
+            self->matrix[out * inchannels + in], n);
+      }
+      for (sample = 0; sample < n; sample++)
+        outarray[sample * outchannels + out] = acc[sample];
+    }
+
+    inarray += n * inchannels;
+    outarray += n * outchannels;
+  }
+}
+
+static void
+gst_audio_mix_matrix_mix_f64 (GstAudioMixMatrix * self,
+    const gdouble * inarray, gdouble * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  gdouble *planar = self->scratch;
+  gdouble *acc = planar + inchannels * BLOCK_FRAMES;
+  guint start, n, out, k, sample;
+
+  for (start = 0; start < n_samples; start += n) {
+    n = MIN (BLOCK_FRAMES, n_samples - start);
+
+    gst_audio_mix_matrix_deinterleave_gdouble_gdouble (inarray, planar,
+        inchannels, n);
+
+    for (out = 0; out < outchannels; out++) {
+      memset (acc, 0, n * sizeof (gdouble));
+      for (k = self->nz_offsets[out]; k < self->nz_offsets[out + 1]; k++) {
+        guint in = self->nz_in[k];
+
+        audio_mix_matrix_orc_mac_f64 (acc, planar + in * BLOCK_FRAMES,
+            self->matrix[out * inchannels + in], n);
+      }
+      for (sample = 0; sample < n; sample++)
+        outarray[sample * outchannels + out] = acc[sample];
+    }
+
+    inarray += n * inchannels;
+    outarray += n * outchannels;
+  }
+}
+
+/* The integer formats keep the fixed point arithmetic of the conversion
+ * matrices, the inner loops are simple enough for the compiler to
+ * vectorise */
+static void
+gst_audio_mix_matrix_mix_s16 (GstAudioMixMatrix * self,
+    const gint16 * inarray, gint16 * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint shift = self->shift_bytes;
+  const gint32 *conv_matrix = self->s16_conv_matrix;
+  gint32 *planar = self->scratch;
+  gint32 *acc = planar + inchannels * BLOCK_FRAMES;
+  guint start, n, out, k, sample;
+
+  for (start = 0; start < n_samples; start += n) {
+    n = MIN (BLOCK_FRAMES, n_samples - start);
+
+    gst_audio_mix_matrix_deinterleave_gint16_gint32 (inarray, planar,
+        inchannels, n);
+
+    for (out = 0; out < outchannels; out++) {
+      memset (acc, 0, n * sizeof (gint32));
+      for (k = self->nz_offsets[out]; k < self->nz_offsets[out + 1]; k++) {
+        guint in = self->nz_in[k];
+        const gint32 *src = planar + in * BLOCK_FRAMES;
+        gint32 coefficient = conv_matrix[out * inchannels + in];
+
+        for (sample = 0; sample < n; sample++)
+          acc[sample] += src[sample] * coefficient;
+      }
+      for (sample = 0; sample < n; sample++)
+        outarray[sample * outchannels + out] = (gint16) (acc[sample] >> shift);
+    }
+
+    inarray += n * inchannels;
+    outarray += n * outchannels;
+  }
+}
+
+static void
+gst_audio_mix_matrix_mix_s32 (GstAudioMixMatrix * self,
+    const gint32 * inarray, gint32 * outarray, guint n_samples)
+{
+  guint inchannels = self->in_channels;
+  guint outchannels = self->out_channels;
+  guint shift = self->shift_bytes;
+  const gint64 *conv_matrix = self->s32_conv_matrix;
+  gint64 *planar = self->scratch;
+  gint64 *acc = planar + inchannels * BLOCK_FRAMES;
+  guint start, n, out, k, sample;
+
+  for (start = 0; start < n_samples; start += n) {
+    n = MIN (BLOCK_FRAMES, n_samples - start);
+
+    gst_audio_mix_matrix_deinterleave_gint32_gint64 (inarray, planar,
+        inchannels, n);
+
+    for (out = 0; out < outchannels; out++) {
+      memset (acc, 0, n * sizeof (gint64));
+      for (k = self->nz_offsets[out]; k < self->nz_offsets[out + 1]; k++) {
+        guint in = self->nz_in[k];
+        const gint64 *src = planar + in * BLOCK_FRAMES;
+        gint64 coefficient = conv_matrix[out * inchannels + in];
+
+        for (sample = 0; sample < n; sample++)
+          acc[sample] += src[sample] * coefficient;
+      }
+      for (sample = 0; sample < n; sample++)
+        outarray[sample * outchannels + out] = (gint32) (acc[sample] >> shift);
+    }
+
+    inarray += n * inchannels;
+    outarray += n * outchannels;
+  }
+}
+
 static GstFlowReturn
 gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     GstBuffer * inbuf, GstBuffer * outbuf)
 {
   GstMapInfo inmap, outmap;
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint bps = GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info
+      (self->format)) / 8;
+  guint n_samples;
 
   if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
     return GST_FLOW_ERROR;
@@ -433,107 +700,70 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  GST_OBJECT_LOCK (self);
+
+  if (!self->gather && !self->scratch) {
+    GST_OBJECT_UNLOCK (self);
+    gst_buffer_unmap (inbuf, &inmap);
+    gst_buffer_unmap (outbuf, &outmap);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  n_samples = outmap.size / (bps * self->out_channels);
+
+  if (self->gather) {
+    switch (bps) {
+      case 2:
+        gst_audio_mix_matrix_gather_gint16 (self,
+            (const gint16 *) inmap.data, (gint16 *) outmap.data, n_samples);
+        break;
+      case 4:
+        gst_audio_mix_matrix_gather_gint32 (self,
+            (const gint32 *) inmap.data, (gint32 *) outmap.data, n_samples);
+        break;
+      case 8:
+        gst_audio_mix_matrix_gather_gint64 (self,
+            (const gint64 *) inmap.data, (gint64 *) outmap.data, n_samples);
+        break;
+      default:
+        ret = GST_FLOW_NOT_SUPPORTED;
+        break;
+    }
+    goto done;
+  }
+
   switch (self->format) {
     case GST_AUDIO_FORMAT_F32LE:
-    case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F32BE:
+      gst_audio_mix_matrix_mix_f32 (self, (const gfloat *) inmap.data,
+          (gfloat *) outmap.data, n_samples);
       break;
-    }
     case GST_AUDIO_FORMAT_F64LE:
-    case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F64BE:
+      gst_audio_mix_matrix_mix_f64 (self, (const gdouble *) inmap.data,
+          (gdouble *) outmap.data, n_samples);
       break;
-    }
     case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S16BE:
+      gst_audio_mix_matrix_mix_s16 (self, (const gint16 *) inmap.data,
+          (gint16 *) outmap.data, n_samples);
       break;
-    }
     case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S32BE:
+      gst_audio_mix_matrix_mix_s32 (self, (const gint32 *) inmap.data,
+          (gint32 *) outmap.data, n_samples);
       break;
-    }
     default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
-
+      ret = GST_FLOW_NOT_SUPPORTED;
+      break;
   }
 
+done:
+  GST_OBJECT_UNLOCK (self);
+
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static gboolean
@@ -571,6 +801,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -600,6 +831,11 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     default:
       break;
   }
+
+  GST_OBJECT_LOCK (self);
+  gst_audio_mix_matrix_update_plan (self);
+  GST_OBJECT_UNLOCK (self);
+
   return TRUE;
 }
 
@@ -63,6 +63,17 @@ struct _GstAudioMixMatrix
   gint shift_bytes;
 
   GstAudioFormat format;
+
+  /* Mixing plan, rebuilt whenever the matrix changes. If every output
+   * channel is a copy of at most one input channel, gather[out] is that
+   * input channel (or -1 for silence). Otherwise the non-zero coefficients
+   * of output channel out are nz_in[nz_offsets[out]..nz_offsets[out+1]] */
+  gint *gather;
+  guint *nz_offsets;
+  guint *nz_in;
+
+  /* deinterleaved input and accumulator of one block of frames */
+  gpointer scratch;
 };
 
 struct _GstAudioMixMatrixClass
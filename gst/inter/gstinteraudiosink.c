@@ -73,10 +73,12 @@ static gboolean gst_inter_audio_sink_query (GstBaseSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_RING_SIZE
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_RING_SIZE 0
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_audio_sink_sink_template =
@@ -126,6 +128,26 @@ gst_inter_audio_sink_class_init (GstInterAudioSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSink:ring-size:
+   *
+   * Number of audio buffers kept for the interaudiosrc elements of the
+   * channel, each of at least the period time. The sources then read them
+   * without taking the channel lock and without consuming them, so that all
+   * of them get the whole stream. 0 shares a single adapter protected by
+   * the channel lock instead, which the sources take their samples from.
+   *
+   * With a ring every source keeps up to its own buffer-time of audio, so
+   * the ring should be large enough to hold it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RING_SIZE,
+      g_param_spec_uint ("ring-size", "Ring size",
+          "Number of buffers kept for lock-free reading by the sources "
+          "(0 = disabled)", 0, 65536, DEFAULT_RING_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -133,6 +155,7 @@ gst_inter_audio_sink_init (GstInterAudioSink * interaudiosink)
 {
   interaudiosink->channel = g_strdup (DEFAULT_CHANNEL);
   interaudiosink->input_adapter = gst_adapter_new ();
+  interaudiosink->ring_size = DEFAULT_RING_SIZE;
 }
 
 void
@@ -146,6 +169,9 @@ gst_inter_audio_sink_set_property (GObject * object, guint property_id,
       g_free (interaudiosink->channel);
       interaudiosink->channel = g_value_dup_string (value);
       break;
+    case PROP_RING_SIZE:
+      interaudiosink->ring_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -162,6 +188,9 @@ gst_inter_audio_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, interaudiosink->channel);
       break;
+    case PROP_RING_SIZE:
+      g_value_set_uint (value, interaudiosink->ring_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -210,6 +239,10 @@ gst_inter_audio_sink_start (GstBaseSink * sink)
   interaudiosink->surface = gst_inter_surface_get (interaudiosink->channel);
   g_mutex_lock (&interaudiosink->surface->mutex);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
+  if (interaudiosink->ring_size > 0 && !interaudiosink->surface->audio_ring)
+    g_atomic_pointer_set (&interaudiosink->surface->audio_ring,
+        gst_inter_ring_new (MAX (interaudiosink->ring_size, 2)));
 
   /* We want to write latency-time before syncing has happened */
   /* FIXME: The other side can change this value when it starts */
@@ -229,7 +262,11 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
 
   g_mutex_lock (&interaudiosink->surface->mutex);
   gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  /* tells the sources to drop what they have buffered */
+  if (interaudiosink->surface->audio_ring)
+    gst_inter_ring_push (interaudiosink->surface->audio_ring, NULL);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   gst_inter_surface_unref (interaudiosink->surface);
@@ -253,9 +290,12 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 
   g_mutex_lock (&interaudiosink->surface->mutex);
   interaudiosink->surface->audio_info = info;
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
   interaudiosink->info = info;
   /* TODO: Ideally we would drain the source here */
   gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  if (interaudiosink->surface->audio_ring)
+    gst_inter_ring_push (interaudiosink->surface->audio_ring, NULL);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return TRUE;
@@ -273,8 +313,13 @@ gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
 
       if ((n = gst_adapter_available (interaudiosink->input_adapter)) > 0) {
         g_mutex_lock (&interaudiosink->surface->mutex);
-        tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-        gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
+        if (interaudiosink->surface->audio_ring) {
+          tmp = gst_adapter_take_buffer_fast (interaudiosink->input_adapter, n);
+          gst_inter_ring_push (interaudiosink->surface->audio_ring, tmp);
+        } else {
+          tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
+          gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
+        }
         g_mutex_unlock (&interaudiosink->surface->mutex);
       }
       break;
@@ -319,6 +364,19 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
       gst_util_uint64_scale (period_time, interaudiosink->info.rate,
       GST_SECOND);
 
+  if (interaudiosink->surface->audio_ring) {
+    /* Sources drop the samples they are too late for themselves. Periods
+     * are pushed as single buffers, without copying */
+    gst_adapter_push (interaudiosink->input_adapter, gst_buffer_ref (buffer));
+    n = gst_adapter_available (interaudiosink->input_adapter);
+    if (n >= period_samples * bpf)
+      gst_inter_ring_push (interaudiosink->surface->audio_ring,
+          gst_adapter_take_buffer_fast (interaudiosink->input_adapter, n));
+    g_mutex_unlock (&interaudiosink->surface->mutex);
+
+    return GST_FLOW_OK;
+  }
+
   n = gst_adapter_available (interaudiosink->surface->audio_adapter) / bpf;
   while (n > buffer_samples) {
     GST_DEBUG_OBJECT (interaudiosink, "flushing %" GST_TIME_FORMAT,
@@ -40,6 +40,7 @@ struct _GstInterAudioSink
 
   GstInterSurface *surface;
   char *channel;
+  guint ring_size;
 
   GstAdapter *input_adapter;
   GstAudioInfo info;
@@ -163,6 +163,7 @@ gst_inter_audio_src_init (GstInterAudioSrc * interaudiosrc)
   interaudiosrc->buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   interaudiosrc->latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   interaudiosrc->period_time = DEFAULT_AUDIO_PERIOD_TIME;
+  interaudiosrc->adapter = gst_adapter_new ();
 }
 
 void
@@ -223,6 +224,7 @@ gst_inter_audio_src_finalize (GObject * object)
 
   /* clean up object here */
   g_free (interaudiosrc->channel);
+  gst_object_unref (interaudiosrc->adapter);
 
   G_OBJECT_CLASS (gst_inter_audio_src_parent_class)->finalize (object);
 }
@@ -289,8 +291,13 @@ gst_inter_audio_src_start (GstBaseSrc * src)
   interaudiosrc->surface->audio_buffer_time = interaudiosrc->buffer_time;
   interaudiosrc->surface->audio_latency_time = interaudiosrc->latency_time;
   interaudiosrc->surface->audio_period_time = interaudiosrc->period_time;
+  interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
+  interaudiosrc->surface_info_cookie =
+      interaudiosrc->surface->audio_info_cookie;
   g_mutex_unlock (&interaudiosrc->surface->mutex);
 
+  interaudiosrc->ring = NULL;
+
   return TRUE;
 }
 
@@ -303,6 +310,8 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
 
   gst_inter_surface_unref (interaudiosrc->surface);
   interaudiosrc->surface = NULL;
+  interaudiosrc->ring = NULL;
+  gst_adapter_clear (interaudiosrc->adapter);
 
   return TRUE;
 }
@@ -332,11 +341,64 @@ gst_inter_audio_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Moves the buffers added to the ring since the last call to our own
+ * adapter. They are only referenced, so other sources can read them too */
+static void
+gst_inter_audio_src_read_ring (GstInterAudioSrc * interaudiosrc,
+    GstInterRing * ring)
+{
+  GstBuffer *buffer;
+  guint head;
+
+  head = gst_inter_ring_get_head (ring);
+
+  /* Start with what the sink writes next */
+  if (interaudiosrc->ring != ring) {
+    interaudiosrc->ring = ring;
+    interaudiosrc->ring_seq = head;
+  }
+
+  if (head - interaudiosrc->ring_seq >= ring->size) {
+    GST_WARNING_OBJECT (interaudiosrc, "Lost %u buffers",
+        head - interaudiosrc->ring_seq - ring->size + 1);
+    interaudiosrc->ring_seq = head - ring->size + 1;
+  }
+
+  for (; interaudiosrc->ring_seq != head; interaudiosrc->ring_seq++) {
+    if (!gst_inter_ring_get (ring, interaudiosrc->ring_seq, &buffer)) {
+      GST_WARNING_OBJECT (interaudiosrc, "Lost buffer %u",
+          interaudiosrc->ring_seq);
+      continue;
+    }
+
+    /* NULL is pushed when the sink stops or changes format */
+    if (buffer)
+      gst_adapter_push (interaudiosrc->adapter, buffer);
+    else
+      gst_adapter_clear (interaudiosrc->adapter);
+  }
+
+  /* The sink updates the info before pushing audio in a new format, so if
+   * the info changed after reading the audio it is not reliable anymore */
+  if (g_atomic_int_get (&interaudiosrc->surface->audio_info_cookie) !=
+      interaudiosrc->surface_info_cookie) {
+    g_mutex_lock (&interaudiosrc->surface->mutex);
+    interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
+    interaudiosrc->surface_info_cookie =
+        interaudiosrc->surface->audio_info_cookie;
+    g_mutex_unlock (&interaudiosrc->surface->mutex);
+    gst_adapter_clear (interaudiosrc->adapter);
+  }
+}
+
 static GstFlowReturn
 gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
+  GstInterRing *ring;
+  GstAdapter *adapter;
+  GstAudioInfo *info;
   GstCaps *caps;
   GstBuffer *buffer;
   guint n, bpf;
@@ -348,11 +410,22 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
   buffer = NULL;
   caps = NULL;
 
-  g_mutex_lock (&interaudiosrc->surface->mutex);
-  if (interaudiosrc->surface->audio_info.finfo) {
-    if (!gst_audio_info_is_equal (&interaudiosrc->surface->audio_info,
-            &interaudiosrc->info)) {
-      caps = gst_audio_info_to_caps (&interaudiosrc->surface->audio_info);
+  ring = g_atomic_pointer_get (&interaudiosrc->surface->audio_ring);
+  if (ring) {
+    gst_inter_audio_src_read_ring (interaudiosrc, ring);
+    adapter = interaudiosrc->adapter;
+    info = &interaudiosrc->surface_info;
+    period_time = interaudiosrc->period_time;
+  } else {
+    g_mutex_lock (&interaudiosrc->surface->mutex);
+    adapter = interaudiosrc->surface->audio_adapter;
+    info = &interaudiosrc->surface->audio_info;
+    period_time = interaudiosrc->surface->audio_period_time;
+  }
+
+  if (info->finfo) {
+    if (!gst_audio_info_is_equal (info, &interaudiosrc->info)) {
+      caps = gst_audio_info_to_caps (info);
       interaudiosrc->timestamp_offset +=
           gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
           interaudiosrc->info.rate);
@@ -360,26 +433,45 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
+  bpf = info->bpf;
   period_samples =
       gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
 
   if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
+    n = gst_adapter_available (adapter) / bpf;
   else
     n = 0;
 
+  if (ring && period_samples > 0) {
+    guint64 buffer_samples = gst_util_uint64_scale (interaudiosrc->buffer_time,
+        interaudiosrc->info.rate, GST_SECOND);
+
+    /* The sink doesn't know how far behind every source is, so drop what
+     * we are too late for ourselves */
+    while (n > buffer_samples && n > period_samples) {
+      GST_DEBUG_OBJECT (interaudiosrc, "flushing %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (period_time));
+      gst_adapter_flush (adapter, period_samples * bpf);
+      n -= period_samples;
+    }
+  }
+
   if (n > period_samples)
     n = period_samples;
   if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
+    /* The ring buffers are shared with the other sources, so no need to
+     * merge them into a single memory */
+    if (ring)
+      buffer = gst_adapter_take_buffer_fast (adapter, n * bpf);
+    else
+      buffer = gst_adapter_take_buffer (adapter, n * bpf);
   } else {
     buffer = gst_buffer_new ();
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
+
+  if (!ring)
+    g_mutex_unlock (&interaudiosrc->surface->mutex);
 
   if (caps) {
     gboolean ret = gst_base_src_set_caps (src, caps);
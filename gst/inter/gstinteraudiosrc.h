@@ -46,6 +46,13 @@ struct _GstInterAudioSrc
   GstClockTime timestamp_offset;
   GstAudioInfo info;
   guint64 buffer_time, latency_time, period_time;
+
+  /* state for reading the audio ring of the surface */
+  GstInterRing *ring;
+  guint ring_seq;
+  GstAdapter *adapter;
+  GstAudioInfo surface_info;
+  gint surface_info_cookie;
 };
 
 struct _GstInterAudioSrcClass
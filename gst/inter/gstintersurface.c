@@ -81,8 +81,105 @@ gst_inter_surface_unref (GstInterSurface * surface)
     gst_buffer_replace (&surface->video_buffer, NULL);
     gst_buffer_replace (&surface->sub_buffer, NULL);
     gst_object_unref (surface->audio_adapter);
+    if (surface->video_ring)
+      gst_inter_ring_free (surface->video_ring);
+    if (surface->audio_ring)
+      gst_inter_ring_free (surface->audio_ring);
     g_free (surface->name);
     g_free (surface);
   }
   g_mutex_unlock (&mutex);
 }
+
+/* The size is rounded up to a power of two so that sequence numbers map to
+ * the same slot when they wrap around */
+GstInterRing *
+gst_inter_ring_new (guint size)
+{
+  GstInterRing *ring;
+
+  g_return_val_if_fail (size > 1 && size <= G_MAXINT / 2, NULL);
+
+  ring = g_new0 (GstInterRing, 1);
+  ring->size = 1 << g_bit_storage (size - 1);
+  ring->buffers = g_new0 (GstBuffer *, ring->size);
+  ring->retired = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gst_buffer_unref);
+
+  return ring;
+}
+
+void
+gst_inter_ring_free (GstInterRing * ring)
+{
+  guint i;
+
+  for (i = 0; i < ring->size; i++)
+    gst_buffer_replace (&ring->buffers[i], NULL);
+  g_free (ring->buffers);
+  g_ptr_array_unref (ring->retired);
+  g_free (ring);
+}
+
+/* Takes ownership of @buffer, which can be NULL. Must be called with the
+ * surface mutex held. */
+void
+gst_inter_ring_push (GstInterRing * ring, GstBuffer * buffer)
+{
+  guint head = g_atomic_int_get (&ring->head);
+  GstBuffer **slot = &ring->buffers[head & (ring->size - 1)];
+  GstBuffer *old = *slot;
+
+  g_atomic_pointer_set (slot, buffer);
+  g_atomic_int_set (&ring->head, head + 1);
+
+  if (old)
+    g_ptr_array_add (ring->retired, old);
+
+  /* Readers ref a buffer before leaving, so once none is left the buffers
+   * replaced until now can't be looked at anymore */
+  if (ring->retired->len > 0 && g_atomic_int_get (&ring->readers) == 0)
+    g_ptr_array_set_size (ring->retired, 0);
+}
+
+guint
+gst_inter_ring_get_head (GstInterRing * ring)
+{
+  return g_atomic_int_get (&ring->head);
+}
+
+/* Gets a new reference to the buffer at position @seq, which is NULL if
+ * NULL was pushed. Returns FALSE if the buffer was not pushed yet or was
+ * already overwritten. */
+gboolean
+gst_inter_ring_get (GstInterRing * ring, guint seq, GstBuffer ** buffer)
+{
+  GstBuffer *buf;
+  guint head;
+
+  g_atomic_int_inc (&ring->readers);
+
+  head = g_atomic_int_get (&ring->head);
+  if (head - seq - 1 >= ring->size - 1) {
+    g_atomic_int_add (&ring->readers, -1);
+    return FALSE;
+  }
+
+  buf = g_atomic_pointer_get (&ring->buffers[seq & (ring->size - 1)]);
+  if (buf)
+    gst_buffer_ref (buf);
+
+  /* The slot is only overwritten once the writer reaches seq + size */
+  head = g_atomic_int_get (&ring->head);
+  g_atomic_int_add (&ring->readers, -1);
+
+  if (head - seq >= ring->size) {
+    if (buf)
+      gst_buffer_unref (buf);
+    return FALSE;
+  }
+
+  *buffer = buf;
+
+  return TRUE;
+}
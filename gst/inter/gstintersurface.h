@@ -27,6 +27,23 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterRing GstInterRing;
+
+/* Ring of the last buffers written by a sink, which any number of sources
+ * can read without locking. Writers must hold the surface mutex. */
+struct _GstInterRing
+{
+  guint size;
+  GstBuffer **buffers;
+
+  /* number of buffers written so far */
+  gint head;
+  /* number of readers currently accessing the buffers */
+  gint readers;
+
+  /* replaced buffers that readers might still be about to ref */
+  GPtrArray *retired;
+};
 
 struct _GstInterSurface
 {
@@ -38,9 +55,12 @@ struct _GstInterSurface
   /* video */
   GstVideoInfo video_info;
   int video_buffer_count;
+  /* incremented whenever video_info changes */
+  gint video_info_cookie;
 
   /* audio */
   GstAudioInfo audio_info;
+  gint audio_info_cookie;
   guint64 audio_buffer_time;
   guint64 audio_latency_time;
   guint64 audio_period_time;
@@ -48,6 +68,10 @@ struct _GstInterSurface
   GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
   GstAdapter *audio_adapter;
+
+  /* used instead of video_buffer and audio_adapter when set */
+  GstInterRing *video_ring;
+  GstInterRing *audio_ring;
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -58,6 +82,12 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+GstInterRing * gst_inter_ring_new (guint size);
+void gst_inter_ring_free (GstInterRing *ring);
+void gst_inter_ring_push (GstInterRing *ring, GstBuffer *buffer);
+guint gst_inter_ring_get_head (GstInterRing *ring);
+gboolean gst_inter_ring_get (GstInterRing *ring, guint seq, GstBuffer **buffer);
+
 
 G_END_DECLS
 
@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_RING_SIZE
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_RING_SIZE 0
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -120,12 +122,32 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSink:ring-size:
+   *
+   * Number of frames kept for the intervideosrc elements of the channel,
+   * which then read them without taking the channel lock. This avoids
+   * contention when many sources read the same channel. 0 shares a single
+   * frame protected by the channel lock instead.
+   *
+   * The ring is created by the first sink started on the channel and kept
+   * until the channel is destroyed.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RING_SIZE,
+      g_param_spec_uint ("ring-size", "Ring size",
+          "Number of frames kept for lock-free reading by the sources "
+          "(0 = disabled)", 0, 1024, DEFAULT_RING_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->ring_size = DEFAULT_RING_SIZE;
 }
 
 void
@@ -139,6 +161,9 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_RING_SIZE:
+      intervideosink->ring_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -155,6 +180,9 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_RING_SIZE:
+      g_value_set_uint (value, intervideosink->ring_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -201,6 +229,10 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   intervideosink->surface = gst_inter_surface_get (intervideosink->channel);
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
+  if (intervideosink->ring_size > 0 && !intervideosink->surface->video_ring)
+    g_atomic_pointer_set (&intervideosink->surface->video_ring,
+        gst_inter_ring_new (MAX (intervideosink->ring_size, 2)));
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -216,7 +248,10 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
     gst_buffer_unref (intervideosink->surface->video_buffer);
   }
   intervideosink->surface->video_buffer = NULL;
+  if (intervideosink->surface->video_ring)
+    gst_inter_ring_push (intervideosink->surface->video_ring, NULL);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   gst_inter_surface_unref (intervideosink->surface);
@@ -238,6 +273,7 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 
   g_mutex_lock (&intervideosink->surface->mutex);
   intervideosink->surface->video_info = info;
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   intervideosink->info = info;
   g_mutex_unlock (&intervideosink->surface->mutex);
 
@@ -253,11 +289,16 @@ gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
+  if (intervideosink->surface->video_ring) {
+    gst_inter_ring_push (intervideosink->surface->video_ring,
+        gst_buffer_ref (buffer));
+  } else {
+    if (intervideosink->surface->video_buffer) {
+      gst_buffer_unref (intervideosink->surface->video_buffer);
+    }
+    intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
+    intervideosink->surface->video_buffer_count = 0;
   }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return GST_FLOW_OK;
@@ -278,6 +278,14 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->ring_seq = 0;
+  intervideosrc->ring_buffer_count = 0;
+
+  g_mutex_lock (&intervideosrc->surface->mutex);
+  intervideosrc->surface_info = intervideosrc->surface->video_info;
+  intervideosrc->surface_info_cookie =
+      intervideosrc->surface->video_info_cookie;
+  g_mutex_unlock (&intervideosrc->surface->mutex);
 
   return TRUE;
 }
@@ -292,6 +300,7 @@ gst_inter_video_src_stop (GstBaseSrc * src)
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
+  gst_buffer_replace (&intervideosrc->ring_buffer, NULL);
 
   return TRUE;
 }
@@ -321,11 +330,62 @@ gst_inter_video_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Returns the frame to push next, if any, and drops it once it was repeated
+ * for the timeout */
+static GstBuffer *
+gst_inter_video_src_take_frame (GstBuffer ** video_buffer,
+    int *video_buffer_count, guint64 frames, gboolean * is_gap)
+{
+  GstBuffer *buffer = NULL;
+
+  if (*video_buffer) {
+    /* We have a buffer to push */
+    buffer = gst_buffer_ref (*video_buffer);
+
+    /* Can only be true if timeout > 0 */
+    if (*video_buffer_count == frames) {
+      gst_buffer_unref (*video_buffer);
+      *video_buffer = NULL;
+    }
+  }
+
+  if (*video_buffer_count != 0 && *video_buffer_count != (frames + 1)) {
+    /* This is a repeat of the stored buffer or of a black frame */
+    *is_gap = TRUE;
+  }
+
+  (*video_buffer_count)++;
+
+  return buffer;
+}
+
+/* Picks up the latest frame of the ring, if it changed since last time */
+static void
+gst_inter_video_src_read_ring (GstInterVideoSrc * intervideosrc,
+    GstInterRing * ring)
+{
+  GstBuffer *latest;
+  guint head;
+
+  while ((head = gst_inter_ring_get_head (ring)) != intervideosrc->ring_seq) {
+    /* Only fails if the sink wrapped around the whole ring meanwhile */
+    if (gst_inter_ring_get (ring, head - 1, &latest)) {
+      intervideosrc->ring_seq = head;
+      gst_buffer_replace (&intervideosrc->ring_buffer, NULL);
+      intervideosrc->ring_buffer = latest;
+      if (latest)
+        intervideosrc->ring_buffer_count = 0;
+      break;
+    }
+  }
+}
+
 static GstFlowReturn
 gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
+  GstInterRing *ring;
   GstCaps *caps;
   GstBuffer *buffer;
   guint64 frames;
@@ -340,9 +400,32 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
       GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
 
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
+  ring = g_atomic_pointer_get (&intervideosrc->surface->video_ring);
+  if (ring) {
+    gst_inter_video_src_read_ring (intervideosrc, ring);
+    buffer = gst_inter_video_src_take_frame (&intervideosrc->ring_buffer,
+        &intervideosrc->ring_buffer_count, frames, &is_gap);
+  } else {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    buffer =
+        gst_inter_video_src_take_frame (&intervideosrc->surface->video_buffer,
+        &intervideosrc->surface->video_buffer_count, frames, &is_gap);
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+  }
+
+  /* Checked after taking the frame, as the sink updates the info before
+   * rendering frames in a new format */
+  if (g_atomic_int_get (&intervideosrc->surface->video_info_cookie) !=
+      intervideosrc->surface_info_cookie) {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    intervideosrc->surface_info = intervideosrc->surface->video_info;
+    intervideosrc->surface_info_cookie =
+        intervideosrc->surface->video_info_cookie;
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+  }
+
+  if (intervideosrc->surface_info.finfo) {
+    GstVideoInfo tmp_info = intervideosrc->surface_info;
 
     /* We negotiate the framerate ourselves */
     tmp_info.fps_n = intervideosrc->info.fps_n;
@@ -362,26 +445,6 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  if (intervideosrc->surface->video_buffer) {
-    /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
-
-    /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
-  }
-
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
-    /* This is a repeat of the stored buffer or of a black frame */
-    is_gap = TRUE;
-  }
-
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
-
   if (caps) {
     gboolean ret;
     GstStructure *s;
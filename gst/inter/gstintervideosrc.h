@@ -48,6 +48,15 @@ struct _GstInterVideoSrc
   GstBuffer *black_frame;
   int n_frames;
   GstClockTime timestamp_offset;
+
+  /* copy of the surface video info, updated when the cookie changes */
+  GstVideoInfo surface_info;
+  gint surface_info_cookie;
+
+  /* position in the video ring of the surface and last frame read */
+  guint ring_seq;
+  GstBuffer *ring_buffer;
+  int ring_buffer_count;
 };
 
 struct _GstInterVideoSrcClass
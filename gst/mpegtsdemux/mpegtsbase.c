@@ -1933,6 +1933,15 @@ mpegts_base_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       mpegts_base_reset (base);
+      /* Packets on PIDs that are neither PES nor PSI are ignored unless the
+       * subclass wants to look at all of them, so let the packetizer skip
+       * them before parsing */
+      if (!base->push_unknown
+          && !GST_MPEGTS_BASE_GET_CLASS (base)->inspect_packet)
+        mpegts_packetizer_set_pid_filter (base->packetizer, base->is_pes,
+            base->known_psi);
+      else
+        mpegts_packetizer_set_pid_filter (base->packetizer, NULL, NULL);
       break;
     default:
       break;
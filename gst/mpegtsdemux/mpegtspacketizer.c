@@ -730,7 +730,7 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
 static gboolean
 mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
 {
-  gsize available;
+  gsize available, map_size;
 
   if (packetizer->map_size - packetizer->map_offset >= size)
     return TRUE;
@@ -741,15 +741,22 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   if (available < size)
     return FALSE;
 
+  /* Map the first buffer as a whole when it is big enough, which is free.
+   * Otherwise only merge the bytes straddling the buffer boundary so the
+   * rest of the next buffer can be mapped without copying it too */
+  map_size = gst_adapter_available_fast (packetizer->adapter);
+  if (map_size < size)
+    map_size = size;
+
   packetizer->map_data =
-      (guint8 *) gst_adapter_map (packetizer->adapter, available);
+      (guint8 *) gst_adapter_map (packetizer->adapter, map_size);
   if (!packetizer->map_data)
     return FALSE;
 
-  packetizer->map_size = available;
+  packetizer->map_size = map_size;
   packetizer->map_offset = 0;
 
-  GST_LOG ("mapped %" G_GSIZE_FORMAT " bytes from adapter", available);
+  GST_LOG ("mapped %" G_GSIZE_FORMAT " bytes from adapter", map_size);
 
   return TRUE;
 }
@@ -774,9 +781,16 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
   data = packetizer->map_data + packetizer->map_offset;
 
   for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
+    guint8 *sync;
+
     /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    sync = memchr (data + i, PACKET_SYNC_BYTE,
+        size - 3 * MPEGTS_MAX_PACKETSIZE - i);
+    if (!sync) {
+      i = size - 3 * MPEGTS_MAX_PACKETSIZE;
+      break;
+    }
+    i = sync - data;
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -832,8 +846,18 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
     sync_offset = 0;
 
   for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+    guint8 *sync;
+
+    /* memchr() is vectorized in most C libraries, so use it to skip
+     * everything that can't be a sync byte */
+    sync = memchr (data + i, PACKET_SYNC_BYTE, size - 2 * packet_size - i);
+    if (!sync) {
+      i = size - 2 * packet_size;
+      break;
+    }
+    i = sync - data;
+
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
@@ -848,6 +872,22 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   return found;
 }
 
+/* Packets carrying a PCR are always wanted since they are needed to
+ * compute timestamps and offsets, whatever PID they are sent on */
+static inline gboolean
+mpegts_packetizer_pid_wanted (MpegTSPacketizer2 * packetizer,
+    const guint8 * data)
+{
+  guint16 pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+
+  if (MPEGTS_BIT_IS_SET (packetizer->pes_pids, pid) ||
+      MPEGTS_BIT_IS_SET (packetizer->psi_pids, pid))
+    return TRUE;
+
+  return FLAGS_HAS_AFC (data[3]) && data[4] > 0
+      && (data[5] & MPEGTS_AFC_PCR_FLAG);
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
@@ -885,6 +925,11 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE)) {
       GST_DEBUG ("lost sync");
       packetizer->need_sync = TRUE;
+    } else if (packetizer->pes_pids
+        && !mpegts_packetizer_pid_wanted (packetizer, packet_data)) {
+      /* skip the packet without parsing it */
+      packetizer->offset += packet_size;
+      mpegts_packetizer_clear_packet (packetizer, packet);
     } else {
       /* ALL mpeg-ts variants contain 188 bytes of data. Those with bigger
        * packet sizes contain either extra data (timesync, FEC, ..) either
@@ -2513,6 +2558,20 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
   PACKETIZER_GROUP_UNLOCK (packetizer);
 }
 
+/* Restricts the packets returned by mpegts_packetizer_next_packet() to the
+ * PIDs set in either bitfield and to packets carrying a PCR. The bitfields
+ * belong to the caller and are looked up for every packet, so they can be
+ * updated at any time. Pass NULL to get all packets again. */
+void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+    const guint8 * pes_pids, const guint8 * psi_pids)
+{
+  g_return_if_fail (!pes_pids == !psi_pids);
+
+  packetizer->pes_pids = pes_pids;
+  packetizer->psi_pids = psi_pids;
+}
+
 void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
     GstClockTime threshold)
@@ -287,6 +287,10 @@ struct _MpegTSPacketizer2 {
   /* PTS/DTS of last buffer */
   GstClockTime last_pts;
   GstClockTime last_dts;
+
+  /* Bitfields of the PIDs to return packets for, all if NULL */
+  const guint8 *pes_pids;
+  const guint8 *psi_pids;
 };
 
 struct _MpegTSPacketizer2Class {
@@ -380,6 +384,9 @@ mpegts_packetizer_set_reference_offset (MpegTSPacketizer2 * packetizer,
 G_GNUC_INTERNAL void
 mpegts_packetizer_set_pcr_discont_threshold (MpegTSPacketizer2 * packetizer,
 					GstClockTime threshold);
+G_GNUC_INTERNAL void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+				  const guint8 * pes_pids, const guint8 * psi_pids);
 G_END_DECLS
 
 #endif /* GST_MPEGTS_PACKETIZER_H */
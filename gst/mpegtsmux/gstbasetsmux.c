@@ -191,6 +191,9 @@ enum
 
 #define BASETSMUX_DEFAULT_ALIGNMENT    -1
 
+/* packets per output buffer when no alignment is configured */
+#define BASETSMUX_CHUNK_PACKETS 32
+
 #define CLOCK_BASE 9LL
 #define CLOCK_FREQ (CLOCK_BASE * 10000) /* 90 kHz PTS clock */
 #define CLOCK_FREQ_SCR (CLOCK_FREQ * 300)       /* 27 MHz SCR clock */
@@ -293,6 +296,24 @@ steal_si_section (GstMpegtsSectionType * type, TsMuxSection * section,
   return TRUE;
 }
 
+static void
+gst_base_ts_mux_clear_output (GstBaseTsMux * mux)
+{
+  if (mux->out_chunk) {
+    gst_buffer_unmap (mux->out_chunk, &mux->out_chunk_map);
+    gst_buffer_unref (mux->out_chunk);
+    mux->out_chunk = NULL;
+  }
+  mux->out_chunk_fill = 0;
+  mux->out_slice = NULL;
+  mux->out_slice_saved = FALSE;
+
+  if (mux->out_list) {
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
+  }
+}
+
 static void
 gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
 {
@@ -311,8 +332,7 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
   mux->pending_key_unit_ts = GST_CLOCK_TIME_NONE;
   gst_event_replace (&mux->force_key_unit_event, NULL);
 
-  if (mux->out_adapter)
-    gst_adapter_clear (mux->out_adapter);
+  gst_base_ts_mux_clear_output (mux);
   mux->output_ts_offset = GST_CLOCK_TIME_NONE;
 
   if (mux->tsmux) {
@@ -333,6 +353,7 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
 
   gst_event_replace (&mux->force_key_unit_event, NULL);
   gst_buffer_replace (&mux->out_buffer, NULL);
+  gst_buffer_replace (&mux->packet_buffer, NULL);
 
   GST_OBJECT_LOCK (mux);
 
@@ -898,77 +919,88 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
-static GstFlowReturn
-gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
+static gint
+gst_base_ts_mux_get_alignment (GstBaseTsMux * mux)
 {
-  GstBufferList *buffer_list;
   gint align = mux->alignment;
-  gint av, packet_size;
-
-  packet_size = mux->packet_size;
 
   if (align < 0)
     align = mux->automatic_alignment;
 
-  av = gst_adapter_available (mux->out_adapter);
-  GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
-
-  if (av == 0)
-    return GST_FLOW_OK;
-
-  /* no alignment, just push all available data */
-  if (align == 0) {
-    buffer_list = gst_adapter_take_buffer_list (mux->out_adapter, av);
-    return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux),
-        buffer_list);
-  }
+  return align;
+}
 
-  align *= packet_size;
+/* Allocates a chunk with room for a whole aligned buffer, so packets never
+ * need to be merged again before pushing */
+static void
+gst_base_ts_mux_new_chunk (GstBaseTsMux * mux, gsize min_size)
+{
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gsize chunk_size;
 
-  if (!force && align > av)
-    return GST_FLOW_OK;
+  chunk_size = (align > 0 ? align : BASETSMUX_CHUNK_PACKETS) *
+      mux->packet_size;
+  chunk_size = MAX (chunk_size, min_size);
 
-  buffer_list = gst_buffer_list_new_sized ((av / align) + 1);
+  mux->out_chunk = gst_buffer_new_allocate (NULL, chunk_size, NULL);
+  gst_buffer_map (mux->out_chunk, &mux->out_chunk_map, GST_MAP_WRITE);
+  mux->out_chunk_fill = 0;
+}
 
-  GST_LOG_OBJECT (mux, "aligning to %d bytes", align);
-  while (align <= av) {
-    GstBuffer *buf;
-    GstClockTime pts;
+/* Moves the chunk being filled to the list of buffers to push */
+static void
+gst_base_ts_mux_finish_chunk (GstBaseTsMux * mux)
+{
+  if (!mux->out_chunk)
+    return;
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+  gst_buffer_unmap (mux->out_chunk, &mux->out_chunk_map);
 
-    GST_BUFFER_PTS (buf) = pts;
+  if (mux->out_chunk_fill > 0) {
+    gst_buffer_set_size (mux->out_chunk, mux->out_chunk_fill);
 
-    gst_buffer_list_add (buffer_list, buf);
-    av -= align;
+    if (!mux->out_list)
+      mux->out_list = gst_buffer_list_new ();
+    gst_buffer_list_add (mux->out_list, mux->out_chunk);
+  } else {
+    /* allocated for a packet that ended up elsewhere */
+    gst_buffer_unref (mux->out_chunk);
   }
 
-  if (av > 0 && force) {
-    GstBuffer *buf;
-    GstClockTime pts;
-    guint8 *data;
-    guint32 header;
-    gint dummy;
-    GstMapInfo map;
+  mux->out_chunk = NULL;
+  mux->out_chunk_fill = 0;
+}
 
-    GST_LOG_OBJECT (mux, "handling %d leftover bytes", av);
+static GstFlowReturn
+gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
+{
+  GstBufferList *buffer_list;
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gint packet_size = mux->packet_size;
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_buffer_new_and_alloc (align);
+  GST_LOG_OBJECT (mux, "align %d, pending %" G_GSIZE_FORMAT " bytes", align,
+      mux->out_chunk_fill);
 
-    GST_BUFFER_PTS (buf) = pts;
+  /* tsmux outputs every packet before returning, anything still handed out
+   * was dropped */
+  mux->out_slice = NULL;
+  mux->out_slice_saved = FALSE;
 
-    gst_buffer_map (buf, &map, GST_MAP_READ);
-    data = map.data;
+  if (align == 0) {
+    /* no alignment, just push all available data */
+    gst_base_ts_mux_finish_chunk (mux);
+  } else if (force && mux->out_chunk && mux->out_chunk_fill > 0) {
+    guint8 *data;
+    guint32 header;
+    gint dummy;
 
-    gst_adapter_copy (mux->out_adapter, data, 0, av);
-    gst_adapter_clear (mux->out_adapter);
+    GST_LOG_OBJECT (mux, "handling %" G_GSIZE_FORMAT " leftover bytes",
+        mux->out_chunk_fill);
 
-    data += av;
+    data = mux->out_chunk_map.data + mux->out_chunk_fill;
     header = GST_READ_UINT32_BE (data - packet_size);
 
-    dummy = (map.size - av) / packet_size;
+    dummy = (mux->out_chunk_map.size - mux->out_chunk_fill) / packet_size;
     GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
 
     for (; dummy > 0; dummy--) {
@@ -990,21 +1022,87 @@ gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
       /* payload */
       memset (data + offset + 4, 0, GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH - 4);
       data += packet_size;
+      mux->out_chunk_fill += packet_size;
     }
 
-    gst_buffer_unmap (buf, &map);
-    gst_buffer_list_add (buffer_list, buf);
+    gst_base_ts_mux_finish_chunk (mux);
   }
 
+  if (!mux->out_list)
+    return GST_FLOW_OK;
+
+  buffer_list = mux->out_list;
+  mux->out_list = NULL;
+
+  GST_LOG_OBJECT (mux, "pushing %u buffers",
+      gst_buffer_list_length (buffer_list));
+
   return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux), buffer_list);
 }
 
+/* Appends the packet to the chunk being filled. Packets handed out by the
+ * default allocate_packet already live at the fill position and are not
+ * copied again. The chunk takes the timestamps and flags of its first
+ * packet. */
 static GstFlowReturn
 gst_base_ts_mux_collect_packet (GstBaseTsMux * mux, GstBuffer * buf)
 {
-  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (buf));
-  gst_adapter_push (mux->out_adapter, buf);
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  GstMapInfo map;
+  const guint8 *data;
+  guint8 *dest;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  data = map.data;
+
+  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT, map.size);
+
+  if (mux->out_slice && map.data == mux->out_slice) {
+    if (mux->out_slice_saved)
+      data = mux->out_slice_copy;
+    mux->out_slice = NULL;
+    mux->out_slice_saved = FALSE;
+  }
+
+  if (mux->out_chunk && mux->out_chunk_fill > 0) {
+    /* without alignment, key units and headers start a new buffer so that
+     * their flags are not hidden in the middle of a chunk */
+    if (align == 0 && (!GST_BUFFER_FLAG_IS_SET (buf,
+                GST_BUFFER_FLAG_DELTA_UNIT)
+            || GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER) !=
+            GST_BUFFER_FLAG_IS_SET (mux->out_chunk, GST_BUFFER_FLAG_HEADER)))
+      gst_base_ts_mux_finish_chunk (mux);
+    else if (mux->out_chunk_map.size - mux->out_chunk_fill < map.size)
+      gst_base_ts_mux_finish_chunk (mux);
+  } else if (mux->out_chunk && mux->out_chunk_map.size < map.size) {
+    gst_base_ts_mux_finish_chunk (mux);
+  }
+
+  if (!mux->out_chunk)
+    gst_base_ts_mux_new_chunk (mux, map.size);
+
+  dest = mux->out_chunk_map.data + mux->out_chunk_fill;
+  if (data != dest) {
+    /* this packet overtakes the one handed out at the same position, keep
+     * the latter until it is collected */
+    if (mux->out_slice == dest && !mux->out_slice_saved) {
+      memcpy (mux->out_slice_copy, mux->out_slice,
+          GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH);
+      mux->out_slice_saved = TRUE;
+    }
+    memcpy (dest, data, map.size);
+  }
+
+  if (mux->out_chunk_fill == 0)
+    gst_buffer_copy_into (mux->out_chunk, buf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  mux->out_chunk_fill += map.size;
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  if (mux->out_chunk_map.size - mux->out_chunk_fill < mux->packet_size)
+    gst_base_ts_mux_finish_chunk (mux);
 
   return GST_FLOW_OK;
 }
@@ -1838,10 +1936,6 @@ gst_base_ts_mux_dispose (GObject * object)
 
   gst_base_ts_mux_reset (mux, FALSE);
 
-  if (mux->out_adapter) {
-    g_object_unref (mux->out_adapter);
-    mux->out_adapter = NULL;
-  }
   if (mux->prog_map) {
     gst_structure_free (mux->prog_map);
     mux->prog_map = NULL;
@@ -1986,9 +2080,64 @@ static void
 gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
     GstBuffer ** buffer)
 {
-  GstBuffer *buf;
+  GstBuffer *buf = mux->packet_buffer;
+  gsize maxsize;
+  gpointer state = NULL;
+
+  /* Hand out the next free packet of the chunk being filled, so tsmux
+   * writes the packet where it is going to be pushed from. Only one packet
+   * at a time, the next one goes into a separate buffer until the first
+   * was collected. Packets that get a prefix added are left to the
+   * copying path below. */
+  if (mux->packet_size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH
+      && !mux->out_slice) {
+    GstMemory *mem;
+
+    if (!mux->out_chunk)
+      gst_base_ts_mux_new_chunk (mux, mux->packet_size);
+
+    mux->out_slice = mux->out_chunk_map.data + mux->out_chunk_fill;
+
+    /* keep the chunk memory alive, but not the chunk itself, which still
+     * needs to be resized when it is finished */
+    mem = gst_buffer_peek_memory (mux->out_chunk, 0);
+    mem = gst_memory_new_wrapped (0, mux->out_slice, mux->packet_size, 0,
+        mux->packet_size, gst_memory_ref (mem),
+        (GDestroyNotify) gst_memory_unref);
+
+    buf = gst_buffer_new ();
+    gst_buffer_append_memory (buf, mem);
+
+    *buffer = buf;
+    return;
+  }
+
+  /* Any other packet is copied into an output chunk and released again by
+   * the default output_packet, so the same buffer can be written into for
+   * the next packet unless something else kept a reference to it or to
+   * its memory */
+  if (buf && gst_buffer_is_writable (buf)
+      && gst_buffer_is_all_memory_writable (buf)
+      && gst_buffer_n_memory (buf) == 1
+      && gst_buffer_iterate_meta (buf, &state) == NULL) {
+    gst_buffer_get_sizes (buf, NULL, &maxsize);
+
+    if (maxsize >= mux->packet_size) {
+      gst_buffer_set_size (buf, mux->packet_size);
+      GST_BUFFER_FLAGS (buf) = 0;
+      GST_BUFFER_PTS (buf) = GST_CLOCK_TIME_NONE;
+      GST_BUFFER_DTS (buf) = GST_CLOCK_TIME_NONE;
+      GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
+      GST_BUFFER_OFFSET (buf) = GST_BUFFER_OFFSET_NONE;
+      GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET_NONE;
+
+      *buffer = gst_buffer_ref (buf);
+      return;
+    }
+  }
 
   buf = gst_buffer_new_and_alloc (mux->packet_size);
+  gst_buffer_replace (&mux->packet_buffer, buf);
 
   *buffer = buf;
 }
@@ -2121,8 +2270,6 @@ gst_base_ts_mux_class_init (GstBaseTsMuxClass * klass)
 static void
 gst_base_ts_mux_init (GstBaseTsMux * mux)
 {
-  mux->out_adapter = gst_adapter_new ();
-
   /* properties */
   mux->pat_interval = TSMUX_DEFAULT_PAT_INTERVAL;
   mux->pmt_interval = TSMUX_DEFAULT_PMT_INTERVAL;
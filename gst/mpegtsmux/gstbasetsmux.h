@@ -179,7 +179,14 @@ struct GstBaseTsMux {
   gsize automatic_alignment;
 
   /* output buffer aggregation */
-  GstAdapter *out_adapter;
+  GstBuffer *packet_buffer;
+  GstBuffer *out_chunk;
+  GstMapInfo out_chunk_map;
+  gsize out_chunk_fill;
+  guint8 *out_slice;
+  gboolean out_slice_saved;
+  guint8 out_slice_copy[GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH];
+  GstBufferList *out_list;
   GstBuffer *out_buffer;
   GstClockTimeDiff output_ts_offset;
 };
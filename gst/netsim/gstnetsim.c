@@ -23,11 +23,38 @@
  *
  */
 
+/**
+ * SECTION:element-netsim
+ * @title: netsim
+ *
+ * Simulates network delay, jitter, packet loss, duplication and congestion
+ * on the buffers flowing from its sink pad to its src pad.
+ *
+ * Besides the always pads, any number of sink_\%u request pads can be
+ * requested, each of them gets a matching src_\%u pad. Every pair is an
+ * independent stream with its own impairments, set as #GstNetSimPad
+ * properties, while a single thread delivers the delayed buffers of all
+ * the streams.
+ *
+ * Setting #GstNetSim:seed makes every random decision reproducible, so the
+ * same input is dropped, duplicated and delayed the same way on every run.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 netsim name=n sink_0::drop-probability=0.01 \
+ *     sink_1::loss-model=gilbert-elliott sink_1::gilbert-elliott-p=0.01 \
+ *     sink_1::gilbert-elliott-r=0.3 \
+ *     videotestsrc ! rtpvrawpay ! n.sink_0  n.src_0 ! fakesink \
+ *     audiotestsrc ! rtpL16pay ! n.sink_1  n.src_1 ! fakesink
+ * ]|
+ */
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 #include "gstnetsim.h"
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
 #include <float.h>
@@ -54,6 +81,26 @@ distribution_get_type (void)
   return static_g_define_type_id;
 }
 
+static GType
+loss_model_get_type (void)
+{
+  static gsize static_g_define_type_id = 0;
+  if (g_once_init_enter (&static_g_define_type_id)) {
+    static const GEnumValue values[] = {
+      {LOSS_MODEL_BERNOULLI, "Independent losses (drop-probability)",
+          "bernoulli"},
+      {LOSS_MODEL_GILBERT_ELLIOTT,
+            "Bursty losses of a two state Gilbert-Elliott channel",
+          "gilbert-elliott"},
+      {0, NULL, NULL}
+    };
+    GType g_define_type_id =
+        g_enum_register_static ("GstNetSimLossModel", values);
+    g_once_init_leave (&static_g_define_type_id, g_define_type_id);
+  }
+  return static_g_define_type_id;
+}
+
 #define GST_NET_SIM_LOCK(obj)   g_mutex_lock (&obj->mutex)
 #define GST_NET_SIM_UNLOCK(obj) g_mutex_unlock (&obj->mutex)
 #define GST_NET_SIM_SIGNAL(obj) g_cond_signal (&obj->cond)
@@ -74,7 +121,13 @@ enum
   PROP_QUEUE_SIZE,
   PROP_MAX_QUEUE_DELAY,
   PROP_ALLOW_REORDERING,
-  PROP_REPLACE_DROPPED_WITH_EMPTY
+  PROP_REPLACE_DROPPED_WITH_EMPTY,
+  PROP_LOSS_MODEL,
+  PROP_GE_P,
+  PROP_GE_R,
+  PROP_GE_GOOD_LOSS,
+  PROP_GE_BAD_LOSS,
+  PROP_SEED
 };
 
 /* these numbers are nothing but wild guesses and don't reflect any reality */
@@ -91,6 +144,12 @@ enum
 #define DEFAULT_MAX_QUEUE_DELAY 50
 #define DEFAULT_ALLOW_REORDERING TRUE
 #define DEFAULT_REPLACE_DROPPED_WITH_EMPTY FALSE
+#define DEFAULT_LOSS_MODEL LOSS_MODEL_BERNOULLI
+#define DEFAULT_GE_P 0.0
+#define DEFAULT_GE_R 1.0
+#define DEFAULT_GE_GOOD_LOSS 0.0
+#define DEFAULT_GE_BAD_LOSS 1.0
+#define DEFAULT_SEED 0
 
 static GstStaticPadTemplate gst_net_sim_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -104,12 +163,76 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
-G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
+static GstStaticPadTemplate gst_net_sim_sink_request_template =
+GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate gst_net_sim_src_request_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_net_sim_child_proxy_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY,
+        gst_net_sim_child_proxy_init));
 GST_ELEMENT_REGISTER_DEFINE (netsim, "netsim",
     GST_RANK_MARGINAL, GST_TYPE_NET_SIM);
 
+/* Something that expires at a given time, kept in the timer wheel and then
+ * in the link queue of its stream */
+struct _NetSimTimer
+{
+  NetSimTimer *next;
+  GstClockTime time;
+  /* ties between equal times are resolved in scheduling order */
+  guint64 order;
+  /* the token bucket wakeup of a stream rather than a buffer */
+  gboolean is_wakeup;
+};
+
+struct _GstNetSimStream
+{
+  /* must be first, see NET_SIM_STREAM_FROM_WAKEUP() */
+  NetSimTimer wakeup;
+  gboolean wakeup_pending;
+
+  gint refcount;
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  GstNetSimProfile *profile;
+
+  /* only used from the streaming thread of the sink pad */
+  guint index;
+  GRand *rand;
+  NormalDistributionState delay_state;
+  gboolean ge_bad;
+
+  /* protected by the element mutex */
+  guint seqnum;
+  guint bucket_size;
+  GstClockTime prev_time;
+  guint bits_in_queue;
+  GstClockTime last_sync_time;
+  /* buffers out of the wheel, waiting for tokens */
+  NetSimTimerList link;
+  gboolean ready;
+  gboolean removed;
+  GstFlowReturn srcresult;
+};
+
+#define NET_SIM_STREAM_FROM_WAKEUP(timer) ((GstNetSimStream *) (timer))
+
 typedef struct
 {
+  /* must be first, see NET_SIM_BUFFER_FROM_TIMER() */
+  NetSimTimer timer;
+  GstNetSimStream *stream;
   GstBuffer *buf;
   guint size_bits;
   GstClockTime arrival_time;
@@ -118,11 +241,17 @@ typedef struct
   guint seqnum;
 } NetSimBuffer;
 
+#define NET_SIM_BUFFER_FROM_TIMER(timer) ((NetSimBuffer *) (timer))
+
+static void gst_net_sim_stream_unref (GstNetSimStream * stream);
+
 static NetSimBuffer *
-net_sim_buffer_new (GstBuffer * buf,
+net_sim_buffer_new (GstNetSimStream * stream, GstBuffer * buf,
     guint seqnum, GstClockTime arrival_time, GstClockTime delay)
 {
   NetSimBuffer *nsbuf = g_slice_new0 (NetSimBuffer);
+  g_atomic_int_inc (&stream->refcount);
+  nsbuf->stream = stream;
   nsbuf->buf = gst_buffer_ref (buf);
   nsbuf->size_bits = gst_buffer_get_size (buf) * 8;
   nsbuf->seqnum = seqnum;
@@ -144,6 +273,7 @@ net_sim_buffer_free (NetSimBuffer * nsbuf)
   if (G_UNLIKELY (nsbuf == NULL))
     return;
   gst_buffer_unref (nsbuf->buf);
+  gst_net_sim_stream_unref (nsbuf->stream);
   g_slice_free (NetSimBuffer, nsbuf);
 }
 
@@ -152,28 +282,133 @@ net_sim_buffer_push (NetSimBuffer * nsbuf, GstPad * srcpad)
 {
   GstFlowReturn ret;
   ret = gst_pad_push (srcpad, nsbuf->buf);
+  gst_net_sim_stream_unref (nsbuf->stream);
   g_slice_free (NetSimBuffer, nsbuf);
   return ret;
 }
 
-static gint
-nsbuf_compare_seqnum (gconstpointer a, gconstpointer b,
-    G_GNUC_UNUSED gpointer user_data)
+static void
+net_sim_timer_free (NetSimTimer * timer)
 {
-  const NetSimBuffer *buf_a = (NetSimBuffer *) a;
-  const NetSimBuffer *buf_b = (NetSimBuffer *) b;
-  return buf_a->seqnum - buf_b->seqnum;
+  if (timer->is_wakeup)
+    gst_net_sim_stream_unref (NET_SIM_STREAM_FROM_WAKEUP (timer));
+  else
+    net_sim_buffer_free (NET_SIM_BUFFER_FROM_TIMER (timer));
+}
+
+static void
+net_sim_timer_list_append (NetSimTimerList * list, NetSimTimer * timer)
+{
+  timer->next = NULL;
+  if (list->tail)
+    list->tail->next = timer;
+  else
+    list->head = timer;
+  list->tail = timer;
+}
+
+static NetSimTimer *
+net_sim_timer_list_pop (NetSimTimerList * list)
+{
+  NetSimTimer *timer = list->head;
+
+  if (timer) {
+    list->head = timer->next;
+    if (list->head == NULL)
+      list->tail = NULL;
+    timer->next = NULL;
+  }
+  return timer;
+}
+
+static void
+net_sim_timer_list_clear (NetSimTimerList * list)
+{
+  NetSimTimer *timer;
+
+  while ((timer = net_sim_timer_list_pop (list)))
+    net_sim_timer_free (timer);
 }
 
 static gint
-nsbuf_compare_time (gconstpointer a, gconstpointer b,
-    G_GNUC_UNUSED gpointer user_data)
+net_sim_timer_compare (gconstpointer a, gconstpointer b)
 {
-  const NetSimBuffer *buf_a = (NetSimBuffer *) a;
-  const NetSimBuffer *buf_b = (NetSimBuffer *) b;
-  GstClockTime ts_a = buf_a->arrival_time + buf_a->delay;
-  GstClockTime ts_b = buf_b->arrival_time + buf_b->delay;
-  return ts_a - ts_b;
+  const NetSimTimer *timer_a = *(const NetSimTimer **) a;
+  const NetSimTimer *timer_b = *(const NetSimTimer **) b;
+
+  if (timer_a->time != timer_b->time)
+    return timer_a->time < timer_b->time ? -1 : 1;
+  if (timer_a->order != timer_b->order)
+    return timer_a->order < timer_b->order ? -1 : 1;
+  return 0;
+}
+
+static void
+gst_net_sim_profile_init (GstNetSimProfile * profile)
+{
+  profile->min_delay = DEFAULT_MIN_DELAY;
+  profile->max_delay = DEFAULT_MAX_DELAY;
+  profile->delay_distribution = DEFAULT_DELAY_DISTRIBUTION;
+  profile->delay_probability = DEFAULT_DELAY_PROBABILITY;
+  profile->drop_probability = DEFAULT_DROP_PROBABILITY;
+  profile->duplicate_probability = DEFAULT_DUPLICATE_PROBABILITY;
+  profile->loss_model = DEFAULT_LOSS_MODEL;
+  profile->ge_p = DEFAULT_GE_P;
+  profile->ge_r = DEFAULT_GE_R;
+  profile->ge_good_loss = DEFAULT_GE_GOOD_LOSS;
+  profile->ge_bad_loss = DEFAULT_GE_BAD_LOSS;
+  profile->max_kbps = DEFAULT_MAX_KBPS;
+  profile->max_bucket_size = DEFAULT_MAX_BUCKET_SIZE;
+}
+
+/* Streams of request pads get seed + index, so every stream replays the
+ * same decisions whatever the interleaving with the other streams */
+static void
+gst_net_sim_stream_reseed (GstNetSimStream * stream, guint seed)
+{
+  if (seed == 0)
+    g_rand_set_seed (stream->rand, g_random_int ());
+  else
+    g_rand_set_seed (stream->rand, seed + stream->index);
+  stream->delay_state.generate = FALSE;
+  stream->ge_bad = FALSE;
+}
+
+static GstNetSimStream *
+gst_net_sim_stream_new (GstNetSim * netsim, GstPad * sinkpad, GstPad * srcpad,
+    GstNetSimProfile * profile, guint index)
+{
+  GstNetSimStream *stream = g_slice_new0 (GstNetSimStream);
+
+  stream->refcount = 1;
+  stream->wakeup.is_wakeup = TRUE;
+  stream->sinkpad = sinkpad;
+  stream->srcpad = srcpad;
+  stream->profile = profile;
+  stream->index = index;
+  stream->rand = g_rand_new ();
+  gst_net_sim_stream_reseed (stream, netsim->seed);
+  stream->prev_time = GST_CLOCK_TIME_NONE;
+  stream->last_sync_time = 0;
+  stream->srcresult = GST_FLOW_OK;
+  if (profile->max_bucket_size != -1)
+    stream->bucket_size = profile->max_bucket_size * 1000;
+
+  gst_pad_set_element_private (sinkpad, stream);
+  gst_pad_set_element_private (srcpad, stream);
+
+  return stream;
+}
+
+static void
+gst_net_sim_stream_unref (GstNetSimStream * stream)
+{
+  if (!g_atomic_int_dec_and_test (&stream->refcount))
+    return;
+
+  g_assert (stream->link.head == NULL);
+  g_rand_free (stream->rand);
+  g_slice_free (GstNetSimStream, stream);
 }
 
 static gboolean
@@ -295,7 +530,8 @@ get_random_value_gamma (GRand * rand_seed, gint32 low, gint32 high,
 }
 
 static gint
-gst_net_sim_get_tokens (GstNetSim * netsim, GstClockTime now)
+gst_net_sim_get_tokens (GstNetSim * netsim, GstNetSimStream * stream,
+    GstClockTime now)
 {
   gint tokens = 0;
   GstClockTimeDiff elapsed_time = 0;
@@ -304,22 +540,22 @@ gst_net_sim_get_tokens (GstNetSim * netsim, GstClockTime now)
 
   /* check for umlimited kbps and fill up the bucket if that is the case,
    * if not, calculate the number of tokens to add based on the elapsed time */
-  if (netsim->max_kbps == -1)
-    return netsim->max_bucket_size * 1000 - netsim->bucket_size;
+  if (stream->profile->max_kbps == -1)
+    return stream->profile->max_bucket_size * 1000 - stream->bucket_size;
 
   /* get the elapsed time */
-  if (GST_CLOCK_TIME_IS_VALID (netsim->prev_time)) {
-    if (now < netsim->prev_time) {
+  if (GST_CLOCK_TIME_IS_VALID (stream->prev_time)) {
+    if (now < stream->prev_time) {
       GST_WARNING_OBJECT (netsim, "Clock is going backwards!!");
     } else {
-      elapsed_time = GST_CLOCK_DIFF (netsim->prev_time, now);
+      elapsed_time = GST_CLOCK_DIFF (stream->prev_time, now);
     }
   } else {
-    netsim->prev_time = now;
+    stream->prev_time = now;
   }
 
   /* calculate number of tokens and how much time is "spent" by these tokens */
-  max_bps = netsim->max_kbps * 1000;
+  max_bps = stream->profile->max_kbps * 1000;
   tokens = gst_util_uint64_scale_int (elapsed_time, max_bps, GST_SECOND);
   token_time = gst_util_uint64_scale_int (GST_SECOND, tokens, max_bps);
 
@@ -329,116 +565,336 @@ gst_net_sim_get_tokens (GstNetSim * netsim, GstClockTime now)
       GST_TIME_ARGS (token_time));
 
   /* increment the time with how much we spent in terms of whole tokens */
-  netsim->prev_time += token_time;
+  stream->prev_time += token_time;
   return tokens;
 }
 
 static guint
-gst_net_sim_get_missing_tokens (GstNetSim * netsim,
+gst_net_sim_get_missing_tokens (GstNetSim * netsim, GstNetSimStream * stream,
     NetSimBuffer * nsbuf, GstClockTime now)
 {
   gint tokens;
 
   /* with an unlimited bucket-size, we have nothing to do */
-  if (netsim->max_bucket_size == -1)
+  if (stream->profile->max_bucket_size == -1)
     return 0;
 
-  tokens = gst_net_sim_get_tokens (netsim, now);
+  tokens = gst_net_sim_get_tokens (netsim, stream, now);
 
-  netsim->bucket_size =
-      MIN (netsim->max_bucket_size * 1000, netsim->bucket_size + tokens);
+  stream->bucket_size =
+      MIN (stream->profile->max_bucket_size * 1000,
+      stream->bucket_size + tokens);
   GST_LOG_OBJECT (netsim, "Added %d tokens to bucket (contains %u tokens)",
-      tokens, netsim->bucket_size);
+      tokens, stream->bucket_size);
 
-  if (nsbuf->size_bits > netsim->bucket_size) {
+  if (nsbuf->size_bits > stream->bucket_size) {
     GST_DEBUG_OBJECT (netsim, "Buffer size (%u) exeedes bucket size (%u)",
-        nsbuf->size_bits, netsim->bucket_size);
-    return nsbuf->size_bits - netsim->bucket_size;
+        nsbuf->size_bits, stream->bucket_size);
+    return nsbuf->size_bits - stream->bucket_size;
   }
 
-  netsim->bucket_size -= nsbuf->size_bits;
+  stream->bucket_size -= nsbuf->size_bits;
   GST_DEBUG_OBJECT (netsim, "Buffer taking %u tokens (%u left)",
-      nsbuf->size_bits, netsim->bucket_size);
+      nsbuf->size_bits, stream->bucket_size);
   return 0;
 }
 
+/* must be called with GST_NET_SIM_LOCK */
+static void
+gst_net_sim_wheel_insert (GstNetSim * netsim, NetSimTimer * timer)
+{
+  guint64 tick = MAX (timer->time / WHEEL_TICK, netsim->wheel_tick);
+  guint64 delta = tick - netsim->wheel_tick;
+  NetSimTimerList *list;
+
+  if (delta < WHEEL_L0_SLOTS)
+    list = &netsim->wheel_l0[tick & (WHEEL_L0_SLOTS - 1)];
+  else if (delta < WHEEL_L0_SLOTS * WHEEL_L1_SLOTS)
+    list = &netsim->wheel_l1[(tick >> WHEEL_L0_BITS) & (WHEEL_L1_SLOTS - 1)];
+  else
+    list = &netsim->wheel_overflow;
+
+  net_sim_timer_list_append (list, timer);
+}
+
+/* must be called with GST_NET_SIM_LOCK */
+static void
+gst_net_sim_schedule (GstNetSim * netsim, NetSimTimer * timer,
+    GstClockTime time, GstClockTime now)
+{
+  timer->time = time;
+  timer->order = netsim->timer_order++;
+
+  /* an empty wheel restarts from the current time */
+  if (netsim->wheel_timers == 0)
+    netsim->wheel_tick = MAX (netsim->wheel_tick, now / WHEEL_TICK);
+
+  gst_net_sim_wheel_insert (netsim, timer);
+  netsim->wheel_timers++;
+
+  /* make the loop wait for this one if it is earlier */
+  if (time < netsim->next_wakeup && netsim->clock_id)
+    gst_clock_id_unschedule (netsim->clock_id);
+  GST_NET_SIM_SIGNAL (netsim);
+}
+
+/* Moves the timers of the level 1 slot of the block we just entered, and the
+ * ones of the overflow list that came in range, closer to level 0 */
+static void
+gst_net_sim_wheel_cascade (GstNetSim * netsim)
+{
+  guint64 block = netsim->wheel_tick >> WHEEL_L0_BITS;
+  NetSimTimerList list;
+  NetSimTimer *timer;
+
+  list = netsim->wheel_l1[block & (WHEEL_L1_SLOTS - 1)];
+  memset (&netsim->wheel_l1[block & (WHEEL_L1_SLOTS - 1)], 0,
+      sizeof (NetSimTimerList));
+  while ((timer = net_sim_timer_list_pop (&list)))
+    gst_net_sim_wheel_insert (netsim, timer);
+
+  list = netsim->wheel_overflow;
+  memset (&netsim->wheel_overflow, 0, sizeof (NetSimTimerList));
+  while ((timer = net_sim_timer_list_pop (&list)))
+    gst_net_sim_wheel_insert (netsim, timer);
+}
+
+static void
+gst_net_sim_wheel_expire_slot (GstNetSim * netsim, NetSimTimerList * slot,
+    GstClockTime now)
+{
+  NetSimTimerList keep = { NULL, NULL };
+  NetSimTimer *timer;
+
+  while ((timer = net_sim_timer_list_pop (slot))) {
+    if (timer->time <= now) {
+      g_ptr_array_add (netsim->expired, timer);
+      netsim->wheel_timers--;
+    } else {
+      net_sim_timer_list_append (&keep, timer);
+    }
+  }
+  *slot = keep;
+}
+
+/* Collects all the timers due at @now in netsim->expired, in order */
+static void
+gst_net_sim_wheel_advance (GstNetSim * netsim, GstClockTime now)
+{
+  guint64 now_tick = now / WHEEL_TICK;
+
+  while (netsim->wheel_tick < now_tick) {
+    if (netsim->wheel_timers == 0) {
+      netsim->wheel_tick = now_tick;
+      break;
+    }
+
+    gst_net_sim_wheel_expire_slot (netsim,
+        &netsim->wheel_l0[netsim->wheel_tick & (WHEEL_L0_SLOTS - 1)],
+        GST_CLOCK_TIME_NONE);
+    netsim->wheel_tick++;
+    if ((netsim->wheel_tick & (WHEEL_L0_SLOTS - 1)) == 0)
+      gst_net_sim_wheel_cascade (netsim);
+  }
+
+  /* the current tick is only partly over */
+  if (netsim->wheel_tick == now_tick)
+    gst_net_sim_wheel_expire_slot (netsim,
+        &netsim->wheel_l0[now_tick & (WHEEL_L0_SLOTS - 1)], now);
+
+  if (netsim->expired->len > 1)
+    g_ptr_array_sort (netsim->expired, net_sim_timer_compare);
+}
+
+/* Time the loop has to wake up at: the first timer of level 0 or the next
+ * cascade */
+static GstClockTime
+gst_net_sim_wheel_next_time (GstNetSim * netsim)
+{
+  guint i;
+
+  if (netsim->wheel_timers == 0)
+    return GST_CLOCK_TIME_NONE;
+
+  for (i = 0; i < WHEEL_L0_SLOTS; i++) {
+    guint64 tick = netsim->wheel_tick + i;
+    NetSimTimerList *slot = &netsim->wheel_l0[tick & (WHEEL_L0_SLOTS - 1)];
+    GstClockTime next = GST_CLOCK_TIME_NONE;
+    NetSimTimer *timer;
+
+    for (timer = slot->head; timer; timer = timer->next)
+      next = MIN (next, timer->time);
+
+    if (GST_CLOCK_TIME_IS_VALID (next))
+      return next;
+
+    if (((tick + 1) & (WHEEL_L0_SLOTS - 1)) == 0)
+      break;
+  }
+
+  return (((netsim->wheel_tick >> WHEEL_L0_BITS) + 1) << WHEEL_L0_BITS) *
+      WHEEL_TICK;
+}
+
+static void
+gst_net_sim_clear_timers (GstNetSim * netsim)
+{
+  guint i;
+
+  for (i = 0; i < WHEEL_L0_SLOTS; i++)
+    net_sim_timer_list_clear (&netsim->wheel_l0[i]);
+  for (i = 0; i < WHEEL_L1_SLOTS; i++)
+    net_sim_timer_list_clear (&netsim->wheel_l1[i]);
+  net_sim_timer_list_clear (&netsim->wheel_overflow);
+  netsim->wheel_timers = 0;
+}
+
+static void
+gst_net_sim_stream_make_ready (GstNetSim * netsim, GstNetSimStream * stream)
+{
+  if (stream->ready)
+    return;
+
+  g_atomic_int_inc (&stream->refcount);
+  stream->ready = TRUE;
+  g_queue_push_tail (&netsim->ready_streams, stream);
+}
+
+static void
+gst_net_sim_stream_flush_link (GstNetSimStream * stream)
+{
+  NetSimTimer *timer;
+
+  while ((timer = net_sim_timer_list_pop (&stream->link))) {
+    NetSimBuffer *nsbuf = NET_SIM_BUFFER_FROM_TIMER (timer);
+    stream->bits_in_queue -= nsbuf->size_bits;
+    net_sim_buffer_free (nsbuf);
+  }
+}
+
+/* Hands the expired buffers to the link queue of their stream */
 static void
-gst_net_sim_drop_nsbuf (GstNetSim * netsim)
+gst_net_sim_dispatch_expired (GstNetSim * netsim)
+{
+  guint i;
+
+  for (i = 0; i < netsim->expired->len; i++) {
+    NetSimTimer *timer = g_ptr_array_index (netsim->expired, i);
+
+    if (timer->is_wakeup) {
+      GstNetSimStream *stream = NET_SIM_STREAM_FROM_WAKEUP (timer);
+
+      stream->wakeup_pending = FALSE;
+      if (!stream->removed)
+        gst_net_sim_stream_make_ready (netsim, stream);
+      gst_net_sim_stream_unref (stream);
+    } else {
+      NetSimBuffer *nsbuf = NET_SIM_BUFFER_FROM_TIMER (timer);
+      GstNetSimStream *stream = nsbuf->stream;
+
+      if (stream->removed) {
+        net_sim_buffer_free (nsbuf);
+        continue;
+      }
+
+      net_sim_timer_list_append (&stream->link, timer);
+      gst_net_sim_stream_make_ready (netsim, stream);
+    }
+  }
+  g_ptr_array_set_size (netsim->expired, 0);
+}
+
+static void
+gst_net_sim_drop_nsbuf (GstNetSim * netsim, GstNetSimStream * stream)
 {
   NetSimBuffer *nsbuf;
-  nsbuf = g_queue_pop_head (netsim->bqueue);
+  nsbuf = NET_SIM_BUFFER_FROM_TIMER (net_sim_timer_list_pop (&stream->link));
   GST_LOG_OBJECT (netsim, "Dropping buf #%u (tokens)", nsbuf->seqnum);
-  netsim->bits_in_queue -= nsbuf->size_bits;
+  stream->bits_in_queue -= nsbuf->size_bits;
   net_sim_buffer_free (nsbuf);
 }
 
-/* must be called with GST_NET_SIM_LOCK */
-static GstFlowReturn
-gst_net_sim_push_unlocked (GstNetSim * netsim, GstClockTimeDiff jitter)
+/* Pushes the buffers of the link queue of @stream the token bucket lets
+ * through, must be called with GST_NET_SIM_LOCK */
+static void
+gst_net_sim_push_unlocked (GstNetSim * netsim, GstNetSimStream * stream,
+    GstClockTime now)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstClockTime now = gst_clock_get_time (netsim->clock);
-  NetSimBuffer *nsbuf = g_queue_peek_head (netsim->bqueue);
-  GstClockTime sync_time = net_sim_buffer_get_sync_time (nsbuf);
-  guint missing_tokens;
+  while (stream->link.head && !stream->wakeup_pending && !stream->removed) {
+    NetSimBuffer *nsbuf = NET_SIM_BUFFER_FROM_TIMER (stream->link.head);
+    GstClockTime sync_time = net_sim_buffer_get_sync_time (nsbuf);
+    guint missing_tokens;
+    GstFlowReturn ret;
+    GstPad *srcpad;
+
+    missing_tokens = gst_net_sim_get_missing_tokens (netsim, stream, nsbuf,
+        now);
+    if (missing_tokens > 0) {
+      GstClockTime token_delay = gst_util_uint64_scale_int (GST_SECOND,
+          missing_tokens, stream->profile->max_kbps * 1000);
+      GstClockTime new_synctime = now + token_delay;
+      GstClockTime delta = new_synctime - sync_time;
+      nsbuf->token_delay += delta;
+
+      GST_DEBUG_OBJECT (netsim,
+          "Missing %u tokens, delaying buffer #%u additional %" GST_TIME_FORMAT
+          " (total: %" GST_TIME_FORMAT ") for new sync_time: %" GST_TIME_FORMAT,
+          missing_tokens, nsbuf->seqnum, GST_TIME_ARGS (delta),
+          GST_TIME_ARGS (nsbuf->token_delay), GST_TIME_ARGS (new_synctime));
+
+      if (nsbuf->token_delay > netsim->max_queue_delay * GST_MSECOND) {
+        gst_net_sim_drop_nsbuf (netsim, stream);
+        continue;
+      }
 
-  GST_DEBUG_OBJECT (netsim,
-      "now: %" GST_TIME_FORMAT " jitter %" GST_STIME_FORMAT
-      " netsim->max_delay %" GST_STIME_FORMAT, GST_TIME_ARGS (now),
-      GST_STIME_ARGS (jitter),
-      GST_STIME_ARGS (netsim->max_delay * GST_MSECOND));
-
-  missing_tokens = gst_net_sim_get_missing_tokens (netsim, nsbuf, now);
-  if (missing_tokens > 0) {
-    GstClockTime token_delay = gst_util_uint64_scale_int (GST_SECOND,
-        missing_tokens, netsim->max_kbps * 1000);
-    GstClockTime new_synctime = now + token_delay;
-    GstClockTime delta = new_synctime - net_sim_buffer_get_sync_time (nsbuf);
-    nsbuf->token_delay += delta;
-
-    GST_DEBUG_OBJECT (netsim,
-        "Missing %u tokens, delaying buffer #%u additional %" GST_TIME_FORMAT
-        " (total: %" GST_TIME_FORMAT ") for new sync_time: %" GST_TIME_FORMAT,
-        missing_tokens, nsbuf->seqnum, GST_TIME_ARGS (delta),
-        GST_TIME_ARGS (nsbuf->token_delay), GST_TIME_ARGS (sync_time));
-
-    if (nsbuf->token_delay > netsim->max_queue_delay * GST_MSECOND) {
-      gst_net_sim_drop_nsbuf (netsim);
+      /* the whole link waits for the tokens of its first buffer */
+      g_atomic_int_inc (&stream->refcount);
+      stream->wakeup_pending = TRUE;
+      gst_net_sim_schedule (netsim, &stream->wakeup, new_synctime, now);
+      break;
     }
-  } else {
+
     GST_DEBUG_OBJECT (netsim, "Pushing buffer #%u now", nsbuf->seqnum);
-    nsbuf = g_queue_pop_head (netsim->bqueue);
-    netsim->bits_in_queue -= nsbuf->size_bits;
+    net_sim_timer_list_pop (&stream->link);
+    stream->bits_in_queue -= nsbuf->size_bits;
 
+    /* the pad can be released while we push */
+    srcpad = gst_object_ref (stream->srcpad);
     GST_NET_SIM_UNLOCK (netsim);
-    ret = net_sim_buffer_push (nsbuf, netsim->srcpad);
+    ret = net_sim_buffer_push (nsbuf, srcpad);
+    gst_object_unref (srcpad);
     GST_NET_SIM_LOCK (netsim);
-  }
 
-  return ret;
+    if (ret != GST_FLOW_OK && ret != stream->srcresult) {
+      GST_DEBUG_OBJECT (stream->srcpad, "push returned %s",
+          gst_flow_get_name (ret));
+    }
+    stream->srcresult = ret;
+  }
 }
 
 static gint
-gst_new_sim_get_delay_ms (GstNetSim * netsim)
+gst_new_sim_get_delay_ms (GstNetSimStream * stream)
 {
+  GstNetSimProfile *profile = stream->profile;
   gint delay_ms = 0;
 
-  if (netsim->delay_probability == 0 ||
-      g_rand_double (netsim->rand_seed) > netsim->delay_probability)
+  if (profile->delay_probability == 0 ||
+      g_rand_double (stream->rand) > profile->delay_probability)
     return delay_ms;
 
-  switch (netsim->delay_distribution) {
+  switch (profile->delay_distribution) {
     case DISTRIBUTION_UNIFORM:
-      delay_ms = get_random_value_uniform (netsim->rand_seed, netsim->min_delay,
-          netsim->max_delay);
+      delay_ms = get_random_value_uniform (stream->rand, profile->min_delay,
+          profile->max_delay);
       break;
     case DISTRIBUTION_NORMAL:
-      delay_ms = get_random_value_normal (netsim->rand_seed, netsim->min_delay,
-          netsim->max_delay, &netsim->delay_state);
+      delay_ms = get_random_value_normal (stream->rand, profile->min_delay,
+          profile->max_delay, &stream->delay_state);
       break;
     case DISTRIBUTION_GAMMA:
-      delay_ms = get_random_value_gamma (netsim->rand_seed, netsim->min_delay,
-          netsim->max_delay, &netsim->delay_state);
+      delay_ms = get_random_value_gamma (stream->rand, profile->min_delay,
+          profile->max_delay, &stream->delay_state);
       break;
     default:
       g_assert_not_reached ();
@@ -448,60 +904,108 @@ gst_new_sim_get_delay_ms (GstNetSim * netsim)
   return delay_ms;
 }
 
+/* In the Gilbert-Elliott model the channel moves between a good and a bad
+ * state before each packet, with probability p from good to bad and r from
+ * bad to good, and the packet is lost with the loss probability of the new
+ * state. */
+static gboolean
+gst_net_sim_stream_loses_packet (GstNetSimStream * stream)
+{
+  GstNetSimProfile *profile = stream->profile;
+  gfloat loss;
+
+  if (profile->loss_model == LOSS_MODEL_BERNOULLI) {
+    return profile->drop_probability > 0
+        && g_rand_double (stream->rand) < (gdouble) profile->drop_probability;
+  }
+
+  if (stream->ge_bad) {
+    if (profile->ge_r > 0 && g_rand_double (stream->rand) < profile->ge_r)
+      stream->ge_bad = FALSE;
+  } else {
+    if (profile->ge_p > 0 && g_rand_double (stream->rand) < profile->ge_p)
+      stream->ge_bad = TRUE;
+  }
+
+  loss = stream->ge_bad ? profile->ge_bad_loss : profile->ge_good_loss;
+  return loss > 0 && g_rand_double (stream->rand) < (gdouble) loss;
+}
+
 static void
-gst_net_sim_queue_buffer (GstNetSim * netsim, GstBuffer * buf)
+gst_net_sim_queue_buffer (GstNetSim * netsim, GstNetSimStream * stream,
+    GstBuffer * buf)
 {
-  GstClockTime now = gst_clock_get_time (netsim->clock);
-  gint delay_ms = gst_new_sim_get_delay_ms (netsim);
-  NetSimBuffer *nsbuf = net_sim_buffer_new (buf, netsim->seqnum++,
-      now, delay_ms * GST_MSECOND);
+  gint delay_ms = gst_new_sim_get_delay_ms (stream);
+  GstClockTime now, sync_time;
+  NetSimBuffer *nsbuf;
+
+  GST_NET_SIM_LOCK (netsim);
+  now = gst_clock_get_time (netsim->clock);
+  nsbuf = net_sim_buffer_new (stream, buf, stream->seqnum++, now,
+      delay_ms * GST_MSECOND);
 
   if (delay_ms > 0) {
     GST_DEBUG_OBJECT (netsim, "Delaying buffer with %dms", delay_ms);
   }
 
   GST_DEBUG_OBJECT (netsim, "queue_size: %u, bits_in_queue: %u, bufsize: %u",
-      netsim->queue_size * 1000, netsim->bits_in_queue, nsbuf->size_bits);
+      netsim->queue_size * 1000, stream->bits_in_queue, nsbuf->size_bits);
 
-  if (netsim->bits_in_queue > 0 &&
+  if (stream->bits_in_queue > 0 &&
       netsim->queue_size != -1 &&
-      netsim->bits_in_queue + nsbuf->size_bits > netsim->queue_size * 1000) {
+      stream->bits_in_queue + nsbuf->size_bits > netsim->queue_size * 1000) {
     GST_DEBUG_OBJECT (netsim, "dropping buf #%u", nsbuf->seqnum);
-    net_sim_buffer_free (nsbuf);
-  } else {
-    GST_DEBUG_OBJECT (netsim, "queueing buf #%u", nsbuf->seqnum);
-    GST_NET_SIM_LOCK (netsim);
-    g_queue_insert_sorted (netsim->bqueue, nsbuf, netsim->compare_func, NULL);
-    netsim->bits_in_queue += nsbuf->size_bits;
-    GST_NET_SIM_SIGNAL (netsim);
     GST_NET_SIM_UNLOCK (netsim);
+    net_sim_buffer_free (nsbuf);
+    return;
   }
+
+  /* without reordering a buffer can't leave before the previous one */
+  sync_time = net_sim_buffer_get_sync_time (nsbuf);
+  if (!netsim->allow_reordering && sync_time < stream->last_sync_time) {
+    nsbuf->delay += stream->last_sync_time - sync_time;
+    sync_time = stream->last_sync_time;
+  }
+  stream->last_sync_time = sync_time;
+
+  GST_DEBUG_OBJECT (netsim, "queueing buf #%u", nsbuf->seqnum);
+  stream->bits_in_queue += nsbuf->size_bits;
+  gst_net_sim_schedule (netsim, &nsbuf->timer, sync_time, now);
+  GST_NET_SIM_UNLOCK (netsim);
 }
 
 static GstFlowReturn
 gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstNetSim *netsim = GST_NET_SIM_CAST (parent);
+  GstNetSimStream *stream = gst_pad_get_element_private (pad);
+  GstFlowReturn ret;
   gboolean dropped = FALSE;
+  gboolean drop_packet = FALSE;
 
+  GST_NET_SIM_LOCK (netsim);
+  ret = stream->srcresult;
   if (netsim->drop_packets > 0) {
     netsim->drop_packets--;
     GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
         netsim->drop_packets);
+    drop_packet = TRUE;
+  }
+  GST_NET_SIM_UNLOCK (netsim);
+
+  if (drop_packet) {
     dropped = TRUE;
-  } else if (netsim->drop_probability > 0
-      && g_rand_double (netsim->rand_seed) <
-      (gdouble) netsim->drop_probability) {
-    GST_DEBUG_OBJECT (netsim, "Dropping packet");
+  } else if (gst_net_sim_stream_loses_packet (stream)) {
+    GST_DEBUG_OBJECT (pad, "Dropping packet");
     dropped = TRUE;
-  } else if (netsim->duplicate_probability > 0 &&
-      g_rand_double (netsim->rand_seed) <
-      (gdouble) netsim->duplicate_probability) {
-    GST_DEBUG_OBJECT (netsim, "Duplicating packet");
-    gst_net_sim_queue_buffer (netsim, buf);
-    gst_net_sim_queue_buffer (netsim, buf);
+  } else if (stream->profile->duplicate_probability > 0 &&
+      g_rand_double (stream->rand) <
+      (gdouble) stream->profile->duplicate_probability) {
+    GST_DEBUG_OBJECT (pad, "Duplicating packet");
+    gst_net_sim_queue_buffer (netsim, stream, buf);
+    gst_net_sim_queue_buffer (netsim, stream, buf);
   } else {
-    gst_net_sim_queue_buffer (netsim, buf);
+    gst_net_sim_queue_buffer (netsim, stream, buf);
   }
 
   if (dropped && netsim->replace_droppped_with_empty) {
@@ -513,23 +1017,58 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
       buf = gst_buffer_make_writable (buf);
       gst_buffer_resize (buf, 0, header_len);
-      gst_net_sim_queue_buffer (netsim, buf);
+      gst_net_sim_queue_buffer (netsim, stream, buf);
     }
   }
 
   gst_buffer_unref (buf);
 
-  return GST_FLOW_OK;
+  /* let upstream know when downstream of this stream stopped accepting
+   * buffers */
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return GST_FLOW_OK;
+  return ret;
+}
+
+static gboolean
+gst_net_sim_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (parent);
+  GstNetSimStream *stream = gst_pad_get_element_private (pad);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    GST_NET_SIM_LOCK (netsim);
+    stream->srcresult = GST_FLOW_OK;
+    GST_NET_SIM_UNLOCK (netsim);
+  }
+
+  return gst_pad_event_default (pad, parent, event);
 }
 
+static GstIterator *
+gst_net_sim_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+  GstNetSimStream *stream = gst_pad_get_element_private (pad);
+  GstIterator *it;
+  GValue val = G_VALUE_INIT;
+
+  g_value_init (&val, GST_TYPE_PAD);
+  g_value_set_object (&val,
+      GST_PAD_IS_SINK (pad) ? stream->srcpad : stream->sinkpad);
+  it = gst_iterator_new_single (GST_TYPE_PAD, &val);
+  g_value_unset (&val);
+
+  return it;
+}
+
+/* One task serves the streams of all the pads: it waits for the first timer
+ * of the wheel, then pushes everything that is due by then */
 static void
 gst_net_sim_loop (gpointer data)
 {
   GstNetSim *netsim = GST_NET_SIM_CAST (data);
-  GstFlowReturn ret;
-  NetSimBuffer *nsbuf;
-  GstClockTime sync_time;
-  GstClockTimeDiff jitter;
+  GstNetSimStream *stream;
+  GstClockTime next, now;
 
   GST_NET_SIM_LOCK (netsim);
   if (!gst_net_sim_wait_for_clock (netsim))
@@ -538,34 +1077,46 @@ gst_net_sim_loop (gpointer data)
   if (!netsim->running)
     goto pause_task;
 
-  while (netsim->running && g_queue_is_empty (netsim->bqueue))
+  while (netsim->running && netsim->wheel_timers == 0)
     GST_NET_SIM_WAIT (netsim);
 
   if (!netsim->running)
     goto pause_task;
 
-  nsbuf = g_queue_peek_head (netsim->bqueue);
-  sync_time = net_sim_buffer_get_sync_time (nsbuf);
-  netsim->clock_id = gst_clock_new_single_shot_id (netsim->clock, sync_time);
+  next = gst_net_sim_wheel_next_time (netsim);
+  now = gst_clock_get_time (netsim->clock);
 
-  GST_DEBUG_OBJECT (netsim, "Popped buf #%u with sync_time: %" GST_TIME_FORMAT,
-      nsbuf->seqnum, GST_TIME_ARGS (sync_time));
+  if (next > now) {
+    netsim->clock_id = gst_clock_new_single_shot_id (netsim->clock, next);
+    netsim->next_wakeup = next;
 
-  GST_NET_SIM_UNLOCK (netsim);
-  gst_clock_id_wait (netsim->clock_id, &jitter);
-  GST_NET_SIM_LOCK (netsim);
+    GST_LOG_OBJECT (netsim, "Waiting until %" GST_TIME_FORMAT
+        " (%u buffers scheduled)", GST_TIME_ARGS (next), netsim->wheel_timers);
 
-  gst_clock_id_unref (netsim->clock_id);
-  netsim->clock_id = NULL;
+    GST_NET_SIM_UNLOCK (netsim);
+    gst_clock_id_wait (netsim->clock_id, NULL);
+    GST_NET_SIM_LOCK (netsim);
 
-  if (!netsim->running) {
-    goto pause_task;
+    gst_clock_id_unref (netsim->clock_id);
+    netsim->clock_id = NULL;
+    netsim->next_wakeup = GST_CLOCK_TIME_NONE;
+
+    if (!netsim->running)
+      goto pause_task;
+
+    now = gst_clock_get_time (netsim->clock);
   }
 
-  ret = gst_net_sim_push_unlocked (netsim, jitter);
-  if (ret != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (netsim, "pausing task because flow: %d", ret);
-    goto pause_task;
+  gst_net_sim_wheel_advance (netsim, now);
+  gst_net_sim_dispatch_expired (netsim);
+
+  while ((stream = g_queue_pop_head (&netsim->ready_streams))) {
+    stream->ready = FALSE;
+    gst_net_sim_push_unlocked (netsim, stream, now);
+    gst_net_sim_stream_unref (stream);
+
+    if (!netsim->running)
+      goto pause_task;
   }
 
   GST_NET_SIM_UNLOCK (netsim);
@@ -613,6 +1164,397 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
   return result;
 }
 
+static void
+gst_net_sim_setup_stream_pads (GstNetSim * netsim, GstNetSimStream * stream)
+{
+  gst_pad_set_chain_function (stream->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_chain));
+  gst_pad_set_event_function (stream->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_sink_event));
+  gst_pad_set_iterate_internal_links_function (stream->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_iterate_internal_links));
+  gst_pad_set_iterate_internal_links_function (stream->srcpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_iterate_internal_links));
+
+  GST_OBJECT_FLAG_SET (stream->sinkpad,
+      GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
+}
+
+static GstPad *
+gst_net_sim_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, const GstCaps * caps)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (element);
+  GstNetSimStream *stream;
+  GstPad *sinkpad, *srcpad;
+  gchar *pad_name;
+  guint index;
+
+  GST_OBJECT_LOCK (netsim);
+  if (name && sscanf (name, "sink_%u", &index) == 1) {
+    if (index >= netsim->next_pad_index)
+      netsim->next_pad_index = index + 1;
+  } else {
+    index = netsim->next_pad_index++;
+  }
+  GST_OBJECT_UNLOCK (netsim);
+
+  pad_name = g_strdup_printf ("sink_%u", index);
+  sinkpad = g_object_new (GST_TYPE_NET_SIM_PAD, "name", pad_name,
+      "direction", GST_PAD_SINK, "template", templ, NULL);
+  g_free (pad_name);
+
+  pad_name = g_strdup_printf ("src_%u", index);
+  srcpad = gst_pad_new_from_static_template (&gst_net_sim_src_request_template,
+      pad_name);
+  g_free (pad_name);
+
+  /* new streams start with the impairments of the element */
+  GST_NET_SIM_PAD (sinkpad)->profile = netsim->profile;
+  stream = gst_net_sim_stream_new (netsim, sinkpad, srcpad,
+      &GST_NET_SIM_PAD (sinkpad)->profile, index + 1);
+  gst_net_sim_setup_stream_pads (netsim, stream);
+
+  if (!gst_element_add_pad (element, sinkpad)) {
+    GST_WARNING_OBJECT (netsim, "Pad %s:%s already exists",
+        GST_DEBUG_PAD_NAME (sinkpad));
+    gst_object_unref (sinkpad);
+    gst_object_unref (srcpad);
+    gst_net_sim_stream_unref (stream);
+    return NULL;
+  }
+  gst_element_add_pad (element, srcpad);
+
+  gst_child_proxy_child_added (GST_CHILD_PROXY (netsim), G_OBJECT (sinkpad),
+      GST_OBJECT_NAME (sinkpad));
+
+  return sinkpad;
+}
+
+static void
+gst_net_sim_release_pad (GstElement * element, GstPad * pad)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (element);
+  GstNetSimStream *stream = gst_pad_get_element_private (pad);
+
+  if (stream == NULL || stream == netsim->stream)
+    return;
+
+  GST_NET_SIM_LOCK (netsim);
+  stream->removed = TRUE;
+  gst_net_sim_stream_flush_link (stream);
+  GST_NET_SIM_UNLOCK (netsim);
+
+  gst_child_proxy_child_removed (GST_CHILD_PROXY (netsim),
+      G_OBJECT (stream->sinkpad), GST_OBJECT_NAME (stream->sinkpad));
+
+  gst_pad_set_active (stream->srcpad, FALSE);
+  gst_element_remove_pad (element, stream->srcpad);
+  gst_element_remove_pad (element, stream->sinkpad);
+
+  /* buffers still in the wheel are dropped when they expire */
+  gst_net_sim_stream_unref (stream);
+}
+
+static GObject *
+gst_net_sim_child_proxy_get_child_by_index (GstChildProxy * child_proxy,
+    guint index)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (child_proxy);
+  GObject *obj;
+
+  GST_OBJECT_LOCK (netsim);
+  obj = g_list_nth_data (GST_ELEMENT_CAST (netsim)->sinkpads, index);
+  if (obj)
+    gst_object_ref (obj);
+  GST_OBJECT_UNLOCK (netsim);
+
+  return obj;
+}
+
+static guint
+gst_net_sim_child_proxy_get_children_count (GstChildProxy * child_proxy)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (child_proxy);
+  guint count;
+
+  GST_OBJECT_LOCK (netsim);
+  count = GST_ELEMENT_CAST (netsim)->numsinkpads;
+  GST_OBJECT_UNLOCK (netsim);
+
+  return count;
+}
+
+static void
+gst_net_sim_child_proxy_init (gpointer g_iface, gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  iface->get_child_by_index = gst_net_sim_child_proxy_get_child_by_index;
+  iface->get_children_count = gst_net_sim_child_proxy_get_children_count;
+}
+
+static GstStateChangeReturn
+gst_net_sim_change_state (GstElement * element, GstStateChange transition)
+{
+  GstNetSim *netsim = GST_NET_SIM_CAST (element);
+  GstStateChangeReturn ret;
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED && netsim->seed != 0) {
+    GList *l;
+
+    /* replay the same decisions from the start of every run */
+    GST_OBJECT_LOCK (netsim);
+    for (l = element->sinkpads; l; l = l->next) {
+      GstNetSimStream *stream = gst_pad_get_element_private (l->data);
+      gst_net_sim_stream_reseed (stream, netsim->seed);
+    }
+    GST_OBJECT_UNLOCK (netsim);
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_net_sim_parent_class)->change_state (element,
+      transition);
+
+  return ret;
+}
+
+/**
+ * GstNetSimPad:
+ *
+ * The request sink pads of netsim. Every request pad carries its own
+ * impairment profile, initialised from the element's properties when the
+ * pad is requested, so streams sharing the element can be impaired
+ * independently.
+ *
+ * Since: 1.20
+ */
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_MIN_DELAY,
+  PROP_PAD_MAX_DELAY,
+  PROP_PAD_DELAY_DISTRIBUTION,
+  PROP_PAD_DELAY_PROBABILITY,
+  PROP_PAD_DROP_PROBABILITY,
+  PROP_PAD_DUPLICATE_PROBABILITY,
+  PROP_PAD_LOSS_MODEL,
+  PROP_PAD_GE_P,
+  PROP_PAD_GE_R,
+  PROP_PAD_GE_GOOD_LOSS,
+  PROP_PAD_GE_BAD_LOSS,
+  PROP_PAD_MAX_KBPS,
+  PROP_PAD_MAX_BUCKET_SIZE
+};
+
+G_DEFINE_TYPE (GstNetSimPad, gst_net_sim_pad, GST_TYPE_PAD);
+
+static void
+gst_net_sim_pad_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstNetSimPad *pad = GST_NET_SIM_PAD_CAST (object);
+  GstNetSimProfile *profile = &pad->profile;
+
+  switch (prop_id) {
+    case PROP_PAD_MIN_DELAY:
+      profile->min_delay = g_value_get_int (value);
+      break;
+    case PROP_PAD_MAX_DELAY:
+      profile->max_delay = g_value_get_int (value);
+      break;
+    case PROP_PAD_DELAY_DISTRIBUTION:
+      profile->delay_distribution = g_value_get_enum (value);
+      break;
+    case PROP_PAD_DELAY_PROBABILITY:
+      profile->delay_probability = g_value_get_float (value);
+      break;
+    case PROP_PAD_DROP_PROBABILITY:
+      profile->drop_probability = g_value_get_float (value);
+      break;
+    case PROP_PAD_DUPLICATE_PROBABILITY:
+      profile->duplicate_probability = g_value_get_float (value);
+      break;
+    case PROP_PAD_LOSS_MODEL:
+      profile->loss_model = g_value_get_enum (value);
+      break;
+    case PROP_PAD_GE_P:
+      profile->ge_p = g_value_get_float (value);
+      break;
+    case PROP_PAD_GE_R:
+      profile->ge_r = g_value_get_float (value);
+      break;
+    case PROP_PAD_GE_GOOD_LOSS:
+      profile->ge_good_loss = g_value_get_float (value);
+      break;
+    case PROP_PAD_GE_BAD_LOSS:
+      profile->ge_bad_loss = g_value_get_float (value);
+      break;
+    case PROP_PAD_MAX_KBPS:
+      profile->max_kbps = g_value_get_int (value);
+      break;
+    case PROP_PAD_MAX_BUCKET_SIZE:{
+      GstNetSimStream *stream = gst_pad_get_element_private (GST_PAD (pad));
+
+      profile->max_bucket_size = g_value_get_int (value);
+      if (stream && profile->max_bucket_size != -1)
+        stream->bucket_size = profile->max_bucket_size * 1000;
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_net_sim_pad_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstNetSimPad *pad = GST_NET_SIM_PAD_CAST (object);
+  GstNetSimProfile *profile = &pad->profile;
+
+  switch (prop_id) {
+    case PROP_PAD_MIN_DELAY:
+      g_value_set_int (value, profile->min_delay);
+      break;
+    case PROP_PAD_MAX_DELAY:
+      g_value_set_int (value, profile->max_delay);
+      break;
+    case PROP_PAD_DELAY_DISTRIBUTION:
+      g_value_set_enum (value, profile->delay_distribution);
+      break;
+    case PROP_PAD_DELAY_PROBABILITY:
+      g_value_set_float (value, profile->delay_probability);
+      break;
+    case PROP_PAD_DROP_PROBABILITY:
+      g_value_set_float (value, profile->drop_probability);
+      break;
+    case PROP_PAD_DUPLICATE_PROBABILITY:
+      g_value_set_float (value, profile->duplicate_probability);
+      break;
+    case PROP_PAD_LOSS_MODEL:
+      g_value_set_enum (value, profile->loss_model);
+      break;
+    case PROP_PAD_GE_P:
+      g_value_set_float (value, profile->ge_p);
+      break;
+    case PROP_PAD_GE_R:
+      g_value_set_float (value, profile->ge_r);
+      break;
+    case PROP_PAD_GE_GOOD_LOSS:
+      g_value_set_float (value, profile->ge_good_loss);
+      break;
+    case PROP_PAD_GE_BAD_LOSS:
+      g_value_set_float (value, profile->ge_bad_loss);
+      break;
+    case PROP_PAD_MAX_KBPS:
+      g_value_set_int (value, profile->max_kbps);
+      break;
+    case PROP_PAD_MAX_BUCKET_SIZE:
+      g_value_set_int (value, profile->max_bucket_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_net_sim_pad_init (GstNetSimPad * pad)
+{
+  gst_net_sim_profile_init (&pad->profile);
+}
+
+static void
+gst_net_sim_pad_class_init (GstNetSimPadClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->set_property = gst_net_sim_pad_set_property;
+  gobject_class->get_property = gst_net_sim_pad_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_MIN_DELAY,
+      g_param_spec_int ("min-delay", "Minimum delay (ms)",
+          "The minimum delay in ms to apply to buffers",
+          G_MININT, G_MAXINT, DEFAULT_MIN_DELAY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_MAX_DELAY,
+      g_param_spec_int ("max-delay", "Maximum delay (ms)",
+          "The maximum delay (inclusive) in ms to apply to buffers",
+          G_MININT, G_MAXINT, DEFAULT_MAX_DELAY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_DELAY_DISTRIBUTION,
+      g_param_spec_enum ("delay-distribution", "Delay Distribution",
+          "Distribution for the amount of delay",
+          distribution_get_type (), DEFAULT_DELAY_DISTRIBUTION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_DELAY_PROBABILITY,
+      g_param_spec_float ("delay-probability", "Delay Probability",
+          "The Probability a buffer is delayed",
+          0.0, 1.0, DEFAULT_DELAY_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_DROP_PROBABILITY,
+      g_param_spec_float ("drop-probability", "Drop Probability",
+          "The Probability a buffer is dropped",
+          0.0, 1.0, DEFAULT_DROP_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_PAD_DUPLICATE_PROBABILITY,
+      g_param_spec_float ("duplicate-probability", "Duplicate Probability",
+          "The Probability a buffer is duplicated",
+          0.0, 1.0, DEFAULT_DUPLICATE_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_LOSS_MODEL,
+      g_param_spec_enum ("loss-model", "Loss Model",
+          "How the buffers to drop are chosen",
+          loss_model_get_type (), DEFAULT_LOSS_MODEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_GE_P,
+      g_param_spec_float ("gilbert-elliott-p", "Gilbert-Elliott p",
+          "The probability of going from the good to the bad state",
+          0.0, 1.0, DEFAULT_GE_P,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_GE_R,
+      g_param_spec_float ("gilbert-elliott-r", "Gilbert-Elliott r",
+          "The probability of going from the bad to the good state",
+          0.0, 1.0, DEFAULT_GE_R,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_GE_GOOD_LOSS,
+      g_param_spec_float ("gilbert-elliott-good-loss",
+          "Gilbert-Elliott good loss",
+          "The probability a buffer is dropped in the good state",
+          0.0, 1.0, DEFAULT_GE_GOOD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_GE_BAD_LOSS,
+      g_param_spec_float ("gilbert-elliott-bad-loss",
+          "Gilbert-Elliott bad loss",
+          "The probability a buffer is dropped in the bad state",
+          0.0, 1.0, DEFAULT_GE_BAD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_MAX_KBPS,
+      g_param_spec_int ("max-kbps", "Maximum Kbps",
+          "The maximum number of kilobits to let through per second "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_KBPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_MAX_BUCKET_SIZE,
+      g_param_spec_int ("max-bucket-size", "Maximum Bucket Size (Kb)",
+          "The size of the token bucket, related to burstiness resilience "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_MAX_BUCKET_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
 static void
 gst_net_sim_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
@@ -621,33 +1563,33 @@ gst_net_sim_set_property (GObject * object,
 
   switch (prop_id) {
     case PROP_MIN_DELAY:
-      netsim->min_delay = g_value_get_int (value);
+      netsim->profile.min_delay = g_value_get_int (value);
       break;
     case PROP_MAX_DELAY:
-      netsim->max_delay = g_value_get_int (value);
+      netsim->profile.max_delay = g_value_get_int (value);
       break;
     case PROP_DELAY_DISTRIBUTION:
-      netsim->delay_distribution = g_value_get_enum (value);
+      netsim->profile.delay_distribution = g_value_get_enum (value);
       break;
     case PROP_DELAY_PROBABILITY:
-      netsim->delay_probability = g_value_get_float (value);
+      netsim->profile.delay_probability = g_value_get_float (value);
       break;
     case PROP_DROP_PROBABILITY:
-      netsim->drop_probability = g_value_get_float (value);
+      netsim->profile.drop_probability = g_value_get_float (value);
       break;
     case PROP_DUPLICATE_PROBABILITY:
-      netsim->duplicate_probability = g_value_get_float (value);
+      netsim->profile.duplicate_probability = g_value_get_float (value);
       break;
     case PROP_DROP_PACKETS:
       netsim->drop_packets = g_value_get_uint (value);
       break;
     case PROP_MAX_KBPS:
-      netsim->max_kbps = g_value_get_int (value);
+      netsim->profile.max_kbps = g_value_get_int (value);
       break;
     case PROP_MAX_BUCKET_SIZE:
-      netsim->max_bucket_size = g_value_get_int (value);
-      if (netsim->max_bucket_size != -1)
-        netsim->bucket_size = netsim->max_bucket_size * 1000;
+      netsim->profile.max_bucket_size = g_value_get_int (value);
+      if (netsim->profile.max_bucket_size != -1)
+        netsim->stream->bucket_size = netsim->profile.max_bucket_size * 1000;
       break;
     case PROP_QUEUE_SIZE:
       netsim->queue_size = g_value_get_int (value);
@@ -657,14 +1599,28 @@ gst_net_sim_set_property (GObject * object,
       break;
     case PROP_ALLOW_REORDERING:
       netsim->allow_reordering = g_value_get_boolean (value);
-      if (netsim->allow_reordering)
-        netsim->compare_func = nsbuf_compare_time;
-      else
-        netsim->compare_func = nsbuf_compare_seqnum;
       break;
     case PROP_REPLACE_DROPPED_WITH_EMPTY:
       netsim->replace_droppped_with_empty = g_value_get_boolean (value);
       break;
+    case PROP_LOSS_MODEL:
+      netsim->profile.loss_model = g_value_get_enum (value);
+      break;
+    case PROP_GE_P:
+      netsim->profile.ge_p = g_value_get_float (value);
+      break;
+    case PROP_GE_R:
+      netsim->profile.ge_r = g_value_get_float (value);
+      break;
+    case PROP_GE_GOOD_LOSS:
+      netsim->profile.ge_good_loss = g_value_get_float (value);
+      break;
+    case PROP_GE_BAD_LOSS:
+      netsim->profile.ge_bad_loss = g_value_get_float (value);
+      break;
+    case PROP_SEED:
+      netsim->seed = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -679,31 +1635,31 @@ gst_net_sim_get_property (GObject * object,
 
   switch (prop_id) {
     case PROP_MIN_DELAY:
-      g_value_set_int (value, netsim->min_delay);
+      g_value_set_int (value, netsim->profile.min_delay);
       break;
     case PROP_MAX_DELAY:
-      g_value_set_int (value, netsim->max_delay);
+      g_value_set_int (value, netsim->profile.max_delay);
       break;
     case PROP_DELAY_DISTRIBUTION:
-      g_value_set_enum (value, netsim->delay_distribution);
+      g_value_set_enum (value, netsim->profile.delay_distribution);
       break;
     case PROP_DELAY_PROBABILITY:
-      g_value_set_float (value, netsim->delay_probability);
+      g_value_set_float (value, netsim->profile.delay_probability);
       break;
     case PROP_DROP_PROBABILITY:
-      g_value_set_float (value, netsim->drop_probability);
+      g_value_set_float (value, netsim->profile.drop_probability);
       break;
     case PROP_DUPLICATE_PROBABILITY:
-      g_value_set_float (value, netsim->duplicate_probability);
+      g_value_set_float (value, netsim->profile.duplicate_probability);
       break;
     case PROP_DROP_PACKETS:
       g_value_set_uint (value, netsim->drop_packets);
       break;
     case PROP_MAX_KBPS:
-      g_value_set_int (value, netsim->max_kbps);
+      g_value_set_int (value, netsim->profile.max_kbps);
       break;
     case PROP_MAX_BUCKET_SIZE:
-      g_value_set_int (value, netsim->max_bucket_size);
+      g_value_set_int (value, netsim->profile.max_bucket_size);
       break;
     case PROP_QUEUE_SIZE:
       g_value_set_int (value, netsim->queue_size);
@@ -717,6 +1673,24 @@ gst_net_sim_get_property (GObject * object,
     case PROP_REPLACE_DROPPED_WITH_EMPTY:
       g_value_set_boolean (value, netsim->replace_droppped_with_empty);
       break;
+    case PROP_LOSS_MODEL:
+      g_value_set_enum (value, netsim->profile.loss_model);
+      break;
+    case PROP_GE_P:
+      g_value_set_float (value, netsim->profile.ge_p);
+      break;
+    case PROP_GE_R:
+      g_value_set_float (value, netsim->profile.ge_r);
+      break;
+    case PROP_GE_GOOD_LOSS:
+      g_value_set_float (value, netsim->profile.ge_good_loss);
+      break;
+    case PROP_GE_BAD_LOSS:
+      g_value_set_float (value, netsim->profile.ge_bad_loss);
+      break;
+    case PROP_SEED:
+      g_value_set_uint (value, netsim->seed);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -732,20 +1706,21 @@ gst_net_sim_init (GstNetSim * netsim)
   netsim->sinkpad =
       gst_pad_new_from_static_template (&gst_net_sim_sink_template, "sink");
 
+  gst_net_sim_profile_init (&netsim->profile);
+  netsim->seed = DEFAULT_SEED;
+  netsim->stream = gst_net_sim_stream_new (netsim, netsim->sinkpad,
+      netsim->srcpad, &netsim->profile, 0);
+  gst_net_sim_setup_stream_pads (netsim, netsim->stream);
+
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->srcpad);
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->sinkpad);
 
-  netsim->bqueue = g_queue_new ();
   g_mutex_init (&netsim->mutex);
   g_cond_init (&netsim->cond);
-  netsim->rand_seed = g_rand_new ();
-  netsim->prev_time = GST_CLOCK_TIME_NONE;
-
-  GST_OBJECT_FLAG_SET (netsim->sinkpad,
-      GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
+  netsim->next_wakeup = GST_CLOCK_TIME_NONE;
+  netsim->expired = g_ptr_array_new ();
+  g_queue_init (&netsim->ready_streams);
 
-  gst_pad_set_chain_function (netsim->sinkpad,
-      GST_DEBUG_FUNCPTR (gst_net_sim_chain));
   gst_pad_set_activatemode_function (netsim->srcpad,
       GST_DEBUG_FUNCPTR (gst_net_sim_src_activatemode));
 }
@@ -754,14 +1729,21 @@ static void
 gst_net_sim_finalize (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM_CAST (object);
+  GstNetSimStream *stream;
 
-  g_rand_free (netsim->rand_seed);
   g_mutex_clear (&netsim->mutex);
   g_cond_clear (&netsim->cond);
 
   gst_object_replace ((GstObject **) & netsim->clock, NULL);
 
-  g_queue_free_full (netsim->bqueue, (GDestroyNotify) net_sim_buffer_free);
+  while ((stream = g_queue_pop_head (&netsim->ready_streams))) {
+    gst_net_sim_stream_flush_link (stream);
+    gst_net_sim_stream_unref (stream);
+  }
+  gst_net_sim_clear_timers (netsim);
+  g_ptr_array_free (netsim->expired, TRUE);
+  gst_net_sim_stream_flush_link (netsim->stream);
+  gst_net_sim_stream_unref (netsim->stream);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->finalize (object);
 }
@@ -776,6 +1758,10 @@ gst_net_sim_class_init (GstNetSimClass * klass)
       &gst_net_sim_src_template);
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_net_sim_sink_template);
+  gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
+      &gst_net_sim_sink_request_template, GST_TYPE_NET_SIM_PAD);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_net_sim_src_request_template);
 
   gst_element_class_set_metadata (gstelement_class,
       "Network Simulator",
@@ -790,7 +1776,11 @@ gst_net_sim_class_init (GstNetSimClass * klass)
   gobject_class->set_property = gst_net_sim_set_property;
   gobject_class->get_property = gst_net_sim_get_property;
   gstelement_class->set_clock = GST_DEBUG_FUNCPTR (gst_net_sim_set_clock);
-
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_net_sim_change_state);
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_net_sim_request_new_pad);
+  gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_net_sim_release_pad);
   g_object_class_install_property (gobject_class, PROP_MIN_DELAY,
       g_param_spec_int ("min-delay", "Minimum delay (ms)",
           "The minimum delay in ms to apply to buffers",
@@ -920,9 +1910,100 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           DEFAULT_ALLOW_REORDERING,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+
+  /**
+   * GstNetSim:loss-model:
+   *
+   * How the buffers to drop are chosen. With "bernoulli" every buffer is
+   * dropped independently with #GstNetSim:drop-probability. With
+   * "gilbert-elliott" a two state Markov chain produces bursty loss, see the
+   * gilbert-elliott-* properties.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LOSS_MODEL,
+      g_param_spec_enum ("loss-model", "Loss Model",
+          "How the buffers to drop are chosen",
+          loss_model_get_type (), DEFAULT_LOSS_MODEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-p:
+   *
+   * The probability of going from the good to the bad state after each
+   * buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GE_P,
+      g_param_spec_float ("gilbert-elliott-p", "Gilbert-Elliott p",
+          "The probability of going from the good to the bad state",
+          0.0, 1.0, DEFAULT_GE_P,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-r:
+   *
+   * The probability of going from the bad to the good state after each
+   * buffer. The mean burst length is 1 / r buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GE_R,
+      g_param_spec_float ("gilbert-elliott-r", "Gilbert-Elliott r",
+          "The probability of going from the bad to the good state",
+          0.0, 1.0, DEFAULT_GE_R,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-good-loss:
+   *
+   * The probability a buffer is dropped while in the good state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GE_GOOD_LOSS,
+      g_param_spec_float ("gilbert-elliott-good-loss",
+          "Gilbert-Elliott good loss",
+          "The probability a buffer is dropped in the good state",
+          0.0, 1.0, DEFAULT_GE_GOOD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:gilbert-elliott-bad-loss:
+   *
+   * The probability a buffer is dropped while in the bad state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GE_BAD_LOSS,
+      g_param_spec_float ("gilbert-elliott-bad-loss",
+          "Gilbert-Elliott bad loss",
+          "The probability a buffer is dropped in the bad state",
+          0.0, 1.0, DEFAULT_GE_BAD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:seed:
+   *
+   * Seed for the random number generators. With a non-zero seed every
+   * stream draws the same sequence of delays, drops and duplicates each
+   * time the element goes to PAUSED, so a run can be replayed exactly.
+   * 0 picks a random seed.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SEED,
+      g_param_spec_uint ("seed", "Seed",
+          "Seed for the random number generators (0 = random)",
+          0, G_MAXUINT, DEFAULT_SEED,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 
   gst_type_mark_as_plugin_api (distribution_get_type (), 0);
+  gst_type_mark_as_plugin_api (loss_model_get_type (), 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_NET_SIM_PAD, 0);
 }
 
 static gboolean
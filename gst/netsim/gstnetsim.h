@@ -44,8 +44,19 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_NET_SIM))
 #define GST_NET_SIM_CAST(obj) ((GstNetSim *)obj)
 
+#define GST_TYPE_NET_SIM_PAD (gst_net_sim_pad_get_type())
+#define GST_NET_SIM_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_NET_SIM_PAD,GstNetSimPad))
+#define GST_IS_NET_SIM_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_NET_SIM_PAD))
+#define GST_NET_SIM_PAD_CAST(obj) ((GstNetSimPad *)obj)
+
 typedef struct _GstNetSim GstNetSim;
 typedef struct _GstNetSimClass GstNetSimClass;
+typedef struct _GstNetSimPad GstNetSimPad;
+typedef struct _GstNetSimPadClass GstNetSimPadClass;
+typedef struct _GstNetSimStream GstNetSimStream;
+typedef struct _NetSimTimer NetSimTimer;
 
 typedef enum
 {
@@ -54,6 +65,12 @@ typedef enum
   DISTRIBUTION_GAMMA
 } GstNetSimDistribution;
 
+typedef enum
+{
+  LOSS_MODEL_BERNOULLI,
+  LOSS_MODEL_GILBERT_ELLIOTT
+} GstNetSimLossModel;
+
 typedef struct
 {
   gboolean generate;
@@ -61,6 +78,39 @@ typedef struct
   gdouble z1;
 } NormalDistributionState;
 
+/* The impairments applied to one stream */
+typedef struct
+{
+  gint min_delay;
+  gint max_delay;
+  GstNetSimDistribution delay_distribution;
+  gfloat delay_probability;
+  gfloat drop_probability;
+  gfloat duplicate_probability;
+  GstNetSimLossModel loss_model;
+  gfloat ge_p;
+  gfloat ge_r;
+  gfloat ge_good_loss;
+  gfloat ge_bad_loss;
+  gint max_kbps;
+  gint max_bucket_size;
+} GstNetSimProfile;
+
+typedef struct
+{
+  NetSimTimer *head;
+  NetSimTimer *tail;
+} NetSimTimerList;
+
+/* Timer wheel: level 0 has one slot per tick for the next WHEEL_L0_SLOTS
+ * ticks, level 1 one slot per WHEEL_L0_SLOTS ticks beyond that, anything
+ * later waits in the overflow list */
+#define WHEEL_TICK GST_MSECOND
+#define WHEEL_L0_BITS 8
+#define WHEEL_L0_SLOTS (1 << WHEEL_L0_BITS)
+#define WHEEL_L1_BITS 6
+#define WHEEL_L1_SLOTS (1 << WHEEL_L1_BITS)
+
 struct _GstNetSim
 {
   GstElement parent;
@@ -68,35 +118,34 @@ struct _GstNetSim
   GstPad *sinkpad;
   GstPad *srcpad;
 
-  GRand *rand_seed;
-  guint bucket_size;
-  NormalDistributionState delay_state;
-  GstClockTime prev_time;
+  /* stream of the always pads, configured by the element properties */
+  GstNetSimStream *stream;
+  guint next_pad_index;
 
   GstClock *clock;
   GstClockID clock_id;
+  GstClockTime next_wakeup;
   GMutex mutex;
   GCond cond;
   gboolean running;
-  GQueue *bqueue;
-  guint seqnum;
-  GCompareDataFunc compare_func;
-  guint bits_in_queue;
+
+  NetSimTimerList wheel_l0[WHEEL_L0_SLOTS];
+  NetSimTimerList wheel_l1[WHEEL_L1_SLOTS];
+  NetSimTimerList wheel_overflow;
+  guint64 wheel_tick;
+  guint wheel_timers;
+  guint64 timer_order;
+  GPtrArray *expired;
+  GQueue ready_streams;
 
   /* properties */
-  gint min_delay;
-  gint max_delay;
-  GstNetSimDistribution delay_distribution;
-  gfloat delay_probability;
-  gfloat drop_probability;
-  gfloat duplicate_probability;
+  GstNetSimProfile profile;
   guint drop_packets;
-  gint max_kbps;
-  gint max_bucket_size;
   gint queue_size;
   gint max_queue_delay;
   gboolean allow_reordering;
   gboolean replace_droppped_with_empty;
+  guint seed;
 };
 
 struct _GstNetSimClass
@@ -104,7 +153,20 @@ struct _GstNetSimClass
   GstElementClass parent_class;
 };
 
+struct _GstNetSimPad
+{
+  GstPad parent;
+
+  GstNetSimProfile profile;
+};
+
+struct _GstNetSimPadClass
+{
+  GstPadClass parent_class;
+};
+
 GType gst_net_sim_get_type (void);
+GType gst_net_sim_pad_get_type (void);
 GST_ELEMENT_REGISTER_DECLARE (netsim);
 
 G_END_DECLS
@@ -69,6 +69,7 @@ typedef struct
   guint peak_kbps;
   guint32 chunk_size;
   GstRtmpStopCommands stop_commands;
+  gboolean aggregate_messages;
   GstStructure *stats;
 
   /* If both self->lock and OBJECT_LOCK are needed,
@@ -127,6 +128,7 @@ static void connect_task_done (GObject * object, GAsyncResult * result,
 
 static void set_pacing_rate (GstRtmp2Sink * self);
 static void set_chunk_size (GstRtmp2Sink * self);
+static void set_aggregate_messages (GstRtmp2Sink * self);
 
 static GstStructure *gst_rtmp2_sink_get_stats (GstRtmp2Sink * self);
 
@@ -151,6 +153,7 @@ enum
   PROP_CHUNK_SIZE,
   PROP_STATS,
   PROP_STOP_COMMANDS,
+  PROP_AGGREGATE_MESSAGES,
 };
 
 /* pad templates */
@@ -247,6 +250,20 @@ gst_rtmp2_sink_class_init (GstRtmp2SinkClass * klass)
           GST_TYPE_RTMP_STOP_COMMANDS, GST_RTMP_DEFAULT_STOP_COMMANDS,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstRtmp2Sink:aggregate-messages:
+   *
+   * Send audio and video messages that are queued together as RTMP
+   * aggregate messages, reducing the number of chunks and writes.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_AGGREGATE_MESSAGES,
+      g_param_spec_boolean ("aggregate-messages", "Aggregate messages",
+          "Pack queued audio and video messages into aggregate messages",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
   gst_type_mark_as_plugin_api (GST_TYPE_RTMP_LOCATION_HANDLER, 0);
   GST_DEBUG_CATEGORY_INIT (gst_rtmp2_sink_debug_category, "rtmp2sink", 0,
       "debug category for rtmp2sink element");
@@ -386,6 +403,16 @@ gst_rtmp2_sink_set_property (GObject * object, guint property_id,
       self->stop_commands = g_value_get_flags (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_AGGREGATE_MESSAGES:
+      g_mutex_lock (&self->lock);
+
+      GST_OBJECT_LOCK (self);
+      self->aggregate_messages = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+
+      set_aggregate_messages (self);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -488,6 +515,11 @@ gst_rtmp2_sink_get_property (GObject * object, guint property_id,
       g_value_set_flags (value, self->stop_commands);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_AGGREGATE_MESSAGES:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->aggregate_messages);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -1139,6 +1171,7 @@ connect_task_done (GObject * object, GAsyncResult * result, gpointer user_data)
   if (self->connection) {
     set_pacing_rate (self);
     set_chunk_size (self);
+    set_aggregate_messages (self);
     gst_rtmp_connection_set_output_handler (self->connection,
         put_chunk, g_object_ref (self), g_object_unref);
     g_signal_connect_object (self->connection, "error",
@@ -1211,6 +1244,23 @@ set_chunk_size (GstRtmp2Sink * self)
   GST_INFO_OBJECT (self, "Set chunk size to %" G_GUINT32_FORMAT, chunk_size);
 }
 
+static void
+set_aggregate_messages (GstRtmp2Sink * self)
+{
+  gboolean aggregate;
+
+  if (!self->connection)
+    return;
+
+  GST_OBJECT_LOCK (self);
+  aggregate = self->aggregate_messages;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_rtmp_connection_set_aggregate (self->connection, aggregate);
+  GST_INFO_OBJECT (self, "%s aggregate messages",
+      aggregate ? "Enabled" : "Disabled");
+}
+
 static GstStructure *
 gst_rtmp2_sink_get_stats (GstRtmp2Sink * self)
 {
@@ -244,63 +244,59 @@ select_chunk_type (GstRtmpChunkStream * cstream, GstBuffer * buffer)
   return CHUNK_TYPE_3;
 }
 
-static GstBuffer *
-serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
-    ChunkType type)
+static gsize
+chunk_header_size (GstRtmpChunkStream * cstream, ChunkType type)
 {
-  GstRtmpMeta *meta = cstream->meta;
-  guint8 small_stream_id;
-  gsize header_size = chunk_header_sizes[type], offset;
-  gboolean ext_ts;
-  GstBuffer *ret;
-  GstMapInfo map;
-
-  GST_TRACE ("Serializing a chunk of type %d, offset %" G_GUINT32_FORMAT,
-      type, cstream->offset);
+  gsize header_size = chunk_header_sizes[type];
 
   if (cstream->id < CHUNK_STREAM_MIN_TWOBYTE) {
-    small_stream_id = cstream->id;
     header_size += 1;
   } else if (cstream->id < CHUNK_STREAM_MIN_THREEBYTE) {
-    small_stream_id = CHUNK_BYTE_TWOBYTE;
     header_size += 2;
   } else {
-    small_stream_id = CHUNK_BYTE_THREEBYTE;
     header_size += 3;
   }
 
-  ext_ts = needs_ext_ts (meta);
-  if (ext_ts) {
+  if (needs_ext_ts (cstream->meta)) {
     header_size += 4;
   }
 
-  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
+  return header_size;
+}
 
-  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
-  if (!ret) {
-    GST_ERROR ("Failed to allocate chunk buffer");
-    return NULL;
-  }
+/* Writes the header of the next chunk into @data, which must hold
+ * chunk_header_size() bytes */
+static void
+write_chunk_header (GstRtmpChunkStream * cstream, ChunkType type,
+    guint8 * data)
+{
+  GstRtmpMeta *meta = cstream->meta;
+  guint8 small_stream_id;
+  gsize offset;
+  gboolean ext_ts;
 
-  if (!gst_buffer_map (ret, &map, GST_MAP_WRITE)) {
-    GST_ERROR ("Failed to map %" GST_PTR_FORMAT, ret);
-    gst_buffer_unref (ret);
-    return NULL;
+  if (cstream->id < CHUNK_STREAM_MIN_TWOBYTE) {
+    small_stream_id = cstream->id;
+  } else if (cstream->id < CHUNK_STREAM_MIN_THREEBYTE) {
+    small_stream_id = CHUNK_BYTE_TWOBYTE;
+  } else {
+    small_stream_id = CHUNK_BYTE_THREEBYTE;
   }
 
+  ext_ts = needs_ext_ts (meta);
+
   /* Chunk Basic Header */
-  GST_WRITE_UINT8 (map.data, (type << 6) | small_stream_id);
+  GST_WRITE_UINT8 (data, (type << 6) | small_stream_id);
   offset = 1;
 
   switch (small_stream_id) {
     case CHUNK_BYTE_TWOBYTE:
-      GST_WRITE_UINT8 (map.data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT8 (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 1;
       break;
 
     case CHUNK_BYTE_THREEBYTE:
-      GST_WRITE_UINT16_LE (map.data + 1,
-          cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
+      GST_WRITE_UINT16_LE (data + 1, cstream->id - CHUNK_STREAM_MIN_TWOBYTE);
       offset += 2;
       break;
   }
@@ -308,27 +304,57 @@ serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
   switch (type) {
     case CHUNK_TYPE_0:
       /* SRSLY:  "Message stream ID is stored in little-endian format." */
-      GST_WRITE_UINT32_LE (map.data + offset + 7, meta->mstream);
+      GST_WRITE_UINT32_LE (data + offset + 7, meta->mstream);
       /* no break */
     case CHUNK_TYPE_1:
-      GST_WRITE_UINT24_BE (map.data + offset + 3, meta->size);
-      GST_WRITE_UINT8 (map.data + offset + 6, meta->type);
+      GST_WRITE_UINT24_BE (data + offset + 3, meta->size);
+      GST_WRITE_UINT8 (data + offset + 6, meta->type);
       /* no break */
     case CHUNK_TYPE_2:
-      GST_WRITE_UINT24_BE (map.data + offset,
-          ext_ts ? 0xffffff : meta->ts_delta);
+      GST_WRITE_UINT24_BE (data + offset, ext_ts ? 0xffffff : meta->ts_delta);
       /* no break */
     case CHUNK_TYPE_3:
       offset += chunk_header_sizes[type];
 
       if (ext_ts) {
-        GST_WRITE_UINT32_BE (map.data + offset, meta->ts_delta);
+        GST_WRITE_UINT32_BE (data + offset, meta->ts_delta);
         offset += 4;
       }
   }
 
-  g_assert (offset == header_size);
-  GST_MEMDUMP (">>> chunk header", map.data, offset);
+  g_assert (offset == chunk_header_size (cstream, type));
+  GST_MEMDUMP (">>> chunk header", data, offset);
+}
+
+static GstBuffer *
+serialize_next (GstRtmpChunkStream * cstream, guint32 chunk_size,
+    ChunkType type)
+{
+  GstRtmpMeta *meta = cstream->meta;
+  gsize header_size;
+  GstBuffer *ret;
+  GstMapInfo map;
+
+  GST_TRACE ("Serializing a chunk of type %d, offset %" G_GUINT32_FORMAT,
+      type, cstream->offset);
+
+  header_size = chunk_header_size (cstream, type);
+
+  GST_TRACE ("Allocating buffer, header size %" G_GSIZE_FORMAT, header_size);
+
+  ret = gst_buffer_new_allocate (NULL, header_size, NULL);
+  if (!ret) {
+    GST_ERROR ("Failed to allocate chunk buffer");
+    return NULL;
+  }
+
+  if (!gst_buffer_map (ret, &map, GST_MAP_WRITE)) {
+    GST_ERROR ("Failed to map %" GST_PTR_FORMAT, ret);
+    gst_buffer_unref (ret);
+    return NULL;
+  }
+
+  write_chunk_header (cstream, type, map.data);
 
   gst_buffer_unmap (ret, &map);
 
@@ -683,6 +709,75 @@ gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
   return outbuf;
 }
 
+/* Like gst_rtmp_chunk_stream_serialize_all(), but adds the chunks to
+ * @vector, with the headers in its arena and the payload by reference. On
+ * failure, @vector and @cstream are left as they were, as if the message
+ * was never serialized */
+gboolean
+gst_rtmp_chunk_stream_serialize_to_vector (GstRtmpChunkStream * cstream,
+    GstBuffer * buffer, guint32 chunk_size, GstRtmpOutputVector * vector)
+{
+  ChunkType type;
+  GstBuffer *old_buffer;
+  guint32 old_offset;
+  guint64 old_bytes;
+  gsize old_size;
+
+  g_return_val_if_fail (cstream, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (chunk_size, FALSE);
+  g_return_val_if_fail (vector, FALSE);
+
+  type = select_chunk_type (cstream, buffer);
+  g_return_val_if_fail (type >= 0, FALSE);
+
+  GST_TRACE ("Serializing message %" GST_PTR_FORMAT " into stream %"
+      G_GUINT32_FORMAT, buffer, cstream->id);
+
+  gst_rtmp_buffer_dump (buffer, ">>> message");
+
+  /* the headers of the next message are relative to this one */
+  old_buffer = cstream->buffer ? gst_buffer_ref (cstream->buffer) : NULL;
+  old_offset = cstream->offset;
+  old_bytes = cstream->bytes;
+  old_size = gst_rtmp_output_vector_get_size (vector);
+
+  chunk_stream_clear (cstream);
+  chunk_stream_take_buffer (cstream, gst_buffer_ref (buffer));
+
+  do {
+    guint32 payload_size = chunk_stream_next_size (cstream, chunk_size);
+    guint8 *header;
+
+    header = gst_rtmp_output_vector_add_header (vector,
+        chunk_header_size (cstream, type));
+    write_chunk_header (cstream, type, header);
+
+    if (payload_size > 0 && !gst_rtmp_output_vector_add_buffer (vector,
+            buffer, cstream->offset, payload_size)) {
+      goto error;
+    }
+
+    cstream->offset += payload_size;
+    cstream->bytes += payload_size;
+    type = CHUNK_TYPE_3;
+  } while (chunk_stream_next_size (cstream, chunk_size) > 0);
+
+  gst_buffer_replace (&old_buffer, NULL);
+  return TRUE;
+
+error:
+  /* the peer never sees this message */
+  chunk_stream_clear (cstream);
+  if (old_buffer) {
+    chunk_stream_take_buffer (cstream, old_buffer);
+  }
+  cstream->offset = old_offset;
+  cstream->bytes = old_bytes;
+  gst_rtmp_output_vector_truncate (vector, old_size);
+  return FALSE;
+}
+
 GstRtmpChunkStreams *
 gst_rtmp_chunk_streams_new (void)
 {
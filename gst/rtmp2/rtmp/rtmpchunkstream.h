@@ -22,6 +22,7 @@
 #define _GST_RTMP_CHUNK_STREAM_H_
 
 #include "rtmpmessage.h"
+#include "rtmputils.h"
 
 G_BEGIN_DECLS
 
@@ -47,6 +48,8 @@ GstBuffer * gst_rtmp_chunk_stream_serialize_next (GstRtmpChunkStream * cstream,
     guint32 chunk_size);
 GstBuffer * gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
     GstBuffer * buffer, guint32 chunk_size);
+gboolean gst_rtmp_chunk_stream_serialize_to_vector (GstRtmpChunkStream * cstream,
+    GstBuffer * buffer, guint32 chunk_size, GstRtmpOutputVector * vector);
 
 GstRtmpChunkStreams * gst_rtmp_chunk_streams_new (void);
 void gst_rtmp_chunk_streams_free (gpointer ptr);
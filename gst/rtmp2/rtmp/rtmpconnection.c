@@ -37,6 +37,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_rtmp_connection_debug_category);
 
 #define READ_SIZE 8192
 
+/* Limits on the queued messages gathered into a single vectored write */
+#define MAX_WRITE_MESSAGES 16
+#define MAX_WRITE_SIZE (256 * 1024)
+
 typedef void (*GstRtmpConnectionCallback) (GstRtmpConnection * connection);
 
 struct _GstRtmpConnection
@@ -75,6 +79,7 @@ struct _GstRtmpConnection
   GDestroyNotify output_handler_user_data_destroy;
 
   gboolean writing;
+  gint aggregate;               /* atomic */
 
   /* Protects the values below during concurrent access.
    * - Taken by the loop thread when writing, but not reading.
@@ -513,34 +518,148 @@ gst_rtmp_connection_input_ready (GInputStream * is, gpointer user_data)
   return G_SOURCE_CONTINUE;
 }
 
-static void
-gst_rtmp_connection_start_write (GstRtmpConnection * self)
+static gboolean
+is_aggregatable (GstBuffer * message)
 {
-  GOutputStream *os;
-  GstBuffer *message, *chunks;
-  GstRtmpMeta *meta;
-  GstRtmpChunkStream *cstream;
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (message);
 
-  if (self->writing) {
-    return;
+  return meta && (meta->type == GST_RTMP_MESSAGE_TYPE_AUDIO ||
+      meta->type == GST_RTMP_MESSAGE_TYPE_VIDEO);
+}
+
+/* Returns how many of the @n_messages audio and video messages starting at
+ * @messages can be packed into one aggregate message */
+static guint
+count_aggregatable (GstBuffer ** messages, guint n_messages)
+{
+  GstRtmpMeta *first_meta;
+  guint i, n_memory, size;
+
+  if (!is_aggregatable (messages[0]))
+    return 1;
+
+  first_meta = gst_buffer_get_rtmp_meta (messages[0]);
+  /* One memory for the tag header of each message, plus the final
+   * PreviousTagSize */
+  n_memory = 2 + gst_buffer_n_memory (messages[0]);
+  size = GST_RTMP_FLV_TAG_HEADER_SIZE + gst_buffer_get_size (messages[0]) + 4;
+
+  for (i = 1; i < n_messages; i++) {
+    GstBuffer *message = messages[i];
+    GstRtmpMeta *meta;
+
+    if (!is_aggregatable (message))
+      break;
+
+    meta = gst_buffer_get_rtmp_meta (message);
+    if (meta->mstream != first_meta->mstream)
+      break;
+
+    if (GST_BUFFER_DTS (message) < GST_BUFFER_DTS (messages[i - 1]))
+      break;
+
+    n_memory += 1 + gst_buffer_n_memory (message);
+    size += GST_RTMP_FLV_TAG_HEADER_SIZE + gst_buffer_get_size (message) + 4;
+
+    /* Appending more memories than a buffer holds would merge them */
+    if (n_memory > gst_buffer_get_max_memory () ||
+        size > GST_RTMP_MAXIMUM_MESSAGE_SIZE)
+      break;
   }
 
-  message = g_async_queue_try_pop (self->output_queue);
-  if (!message) {
-    return;
+  return i;
+}
+
+static GstMemory *
+new_tag_header (GstBuffer * message, guint32 previous_tag_size)
+{
+  gsize size = GST_RTMP_FLV_TAG_HEADER_SIZE + (previous_tag_size ? 4 : 0);
+  GstMemory *memory = gst_allocator_alloc (NULL, size, NULL);
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (message);
+  GstClockTime dts = GST_BUFFER_DTS (message);
+  guint32 timestamp = 0;
+  GstMapInfo map;
+  guint8 *data;
+
+  if (GST_CLOCK_TIME_IS_VALID (dts)) {
+    timestamp = gst_util_uint64_scale_round (dts, 1, GST_MSECOND);
+  }
+
+  gst_memory_map (memory, &map, GST_MAP_WRITE);
+  data = map.data;
+
+  if (previous_tag_size) {
+    GST_WRITE_UINT32_BE (data, previous_tag_size);
+    data += 4;
+  }
+
+  /* FLVTAG header, see gst_rtmp_flv_tag_parse_header */
+  GST_WRITE_UINT8 (data, meta->type);
+  GST_WRITE_UINT24_BE (data + 1, gst_buffer_get_size (message));
+  GST_WRITE_UINT24_BE (data + 4, timestamp & 0xffffff);
+  GST_WRITE_UINT8 (data + 7, timestamp >> 24);
+  GST_WRITE_UINT24_BE (data + 8, 0);
+
+  gst_memory_unmap (memory, &map);
+
+  return memory;
+}
+
+/* Packs @n_messages messages into an aggregate message as parsed by
+ * gst_rtmp_connection_handle_aggregate, referencing their payloads */
+static GstBuffer *
+gst_rtmp_connection_aggregate (GstRtmpConnection * self,
+    GstBuffer ** messages, guint n_messages)
+{
+  GstRtmpMeta *first_meta = gst_buffer_get_rtmp_meta (messages[0]);
+  GstBuffer *aggregate;
+  guint32 previous_tag_size = 0;
+  GstMemory *memory;
+  GstMapInfo map;
+  guint i;
+
+  aggregate = gst_rtmp_message_new (GST_RTMP_MESSAGE_TYPE_AGGREGATE,
+      first_meta->cstream, first_meta->mstream);
+  GST_BUFFER_DTS (aggregate) = GST_BUFFER_DTS (messages[0]);
+
+  for (i = 0; i < n_messages; i++) {
+    gst_buffer_append_memory (aggregate,
+        new_tag_header (messages[i], previous_tag_size));
+    aggregate = gst_buffer_append (aggregate, gst_buffer_ref (messages[i]));
+    previous_tag_size = GST_RTMP_FLV_TAG_HEADER_SIZE +
+        gst_buffer_get_size (messages[i]);
   }
 
+  memory = gst_allocator_alloc (NULL, 4, NULL);
+  gst_memory_map (memory, &map, GST_MAP_WRITE);
+  GST_WRITE_UINT32_BE (map.data, previous_tag_size);
+  gst_memory_unmap (memory, &map);
+  gst_buffer_append_memory (aggregate, memory);
+
+  GST_LOG_OBJECT (self, "Aggregated %u messages into %" GST_PTR_FORMAT,
+      n_messages, aggregate);
+
+  return aggregate;
+}
+
+static gboolean
+gst_rtmp_connection_serialize (GstRtmpConnection * self, GstBuffer * message,
+    GstRtmpOutputVector * vector)
+{
+  GstRtmpMeta *meta;
+  GstRtmpChunkStream *cstream;
+
   meta = gst_buffer_get_rtmp_meta (message);
   if (!meta) {
     GST_ERROR_OBJECT (self, "No RTMP meta on %" GST_PTR_FORMAT, message);
-    goto out;
+    return FALSE;
   }
 
   if (gst_rtmp_message_is_protocol_control (message)) {
     if (!gst_rtmp_connection_prepare_protocol_control (self, message)) {
       GST_ERROR_OBJECT (self,
           "Failed to prepare protocol control %" GST_PTR_FORMAT, message);
-      goto out;
+      return FALSE;
     }
   }
 
@@ -548,30 +667,94 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
   if (!cstream) {
     GST_ERROR_OBJECT (self, "Failed to get chunk stream for %" GST_PTR_FORMAT,
         message);
-    goto out;
+    return FALSE;
   }
 
-  chunks = gst_rtmp_chunk_stream_serialize_all (cstream, message,
-      self->out_chunk_size);
-  if (!chunks) {
+  if (!gst_rtmp_chunk_stream_serialize_to_vector (cstream, message,
+          self->out_chunk_size, vector)) {
     GST_ERROR_OBJECT (self, "Failed to serialize %" GST_PTR_FORMAT, message);
-    goto out;
+    return FALSE;
   }
 
+  return TRUE;
+}
+
+static void
+gst_rtmp_connection_start_write (GstRtmpConnection * self)
+{
+  GOutputStream *os;
+  GstBuffer *messages[MAX_WRITE_MESSAGES];
+  GstRtmpOutputVector *vector;
+  guint i, n_messages = 0, n;
+  gsize size = 0;
+  gboolean aggregate;
+
+  if (self->writing) {
+    return;
+  }
+
+  /* Gather what is queued into one write. A protocol control message ends
+   * the write, as it only takes effect once written. */
+  while (n_messages < MAX_WRITE_MESSAGES && size < MAX_WRITE_SIZE) {
+    GstBuffer *message = g_async_queue_try_pop (self->output_queue);
+
+    if (!message) {
+      break;
+    }
+
+    messages[n_messages++] = message;
+    size += gst_buffer_get_size (message);
+
+    if (gst_rtmp_message_is_protocol_control (message)) {
+      break;
+    }
+  }
+
+  if (n_messages == 0) {
+    return;
+  }
+
+  vector = gst_rtmp_output_vector_new ();
+  aggregate = g_atomic_int_get (&self->aggregate);
+
+  for (i = 0; i < n_messages; i += n) {
+    n = aggregate ? count_aggregatable (messages + i, n_messages - i) : 1;
+
+    /* A message that fails to serialize leaves the vector as it was and
+     * is dropped */
+    if (n > 1) {
+      GstBuffer *message = gst_rtmp_connection_aggregate (self, messages + i,
+          n);
+      if (!gst_rtmp_connection_serialize (self, message, vector)) {
+        GST_WARNING_OBJECT (self, "Dropping %u aggregated messages", n);
+      }
+      gst_buffer_unref (message);
+    } else if (!gst_rtmp_connection_serialize (self, messages[i], vector)) {
+      GST_WARNING_OBJECT (self, "Dropping %" GST_PTR_FORMAT, messages[i]);
+    }
+  }
+
+  for (i = 0; i < n_messages; i++) {
+    gst_buffer_unref (messages[i]);
+  }
+
+  if (gst_rtmp_output_vector_get_size (vector) == 0) {
+    gst_rtmp_output_vector_free (vector);
+    return;
+  }
+
+  GST_LOG_OBJECT (self, "writing %u messages, %" G_GSIZE_FORMAT " bytes",
+      n_messages, gst_rtmp_output_vector_get_size (vector));
+
   self->writing = TRUE;
   if (self->output_handler) {
     self->output_handler (self, self->output_handler_user_data);
   }
 
   os = g_io_stream_get_output_stream (G_IO_STREAM (self->connection));
-  gst_rtmp_output_stream_write_all_buffer_async (os, chunks, G_PRIORITY_DEFAULT,
-      self->cancellable, gst_rtmp_connection_write_buffer_done,
-      g_object_ref (self));
-
-  gst_buffer_unref (chunks);
-
-out:
-  gst_buffer_unref (message);
+  gst_rtmp_output_stream_write_all_vector_async (os, vector,
+      G_PRIORITY_DEFAULT, self->cancellable,
+      gst_rtmp_connection_write_buffer_done, g_object_ref (self));
 }
 
 static void
@@ -601,7 +784,7 @@ gst_rtmp_connection_write_buffer_done (GObject * obj,
 
   self->writing = FALSE;
 
-  res = gst_rtmp_output_stream_write_all_buffer_finish (os, result,
+  res = gst_rtmp_output_stream_write_all_vector_finish (os, result,
       &bytes_written, &error);
 
   g_mutex_lock (&self->stats_lock);
@@ -1264,6 +1447,17 @@ gst_rtmp_connection_request_window_size (GstRtmpConnection * connection,
       gst_rtmp_message_new_protocol_control (&pc));
 }
 
+/* Whether consecutive queued audio and video messages of the same stream
+ * are sent as one aggregate message */
+void
+gst_rtmp_connection_set_aggregate (GstRtmpConnection * connection,
+    gboolean aggregate)
+{
+  g_return_if_fail (GST_IS_RTMP_CONNECTION (connection));
+
+  g_atomic_int_set (&connection->aggregate, aggregate);
+}
+
 void
 gst_rtmp_connection_set_data_frame (GstRtmpConnection * connection,
     GstBuffer * buffer)
@@ -86,6 +86,9 @@ void gst_rtmp_connection_set_chunk_size (GstRtmpConnection * connection,
 void gst_rtmp_connection_request_window_size (GstRtmpConnection * connection,
     guint32 window_ack_size);
 
+void gst_rtmp_connection_set_aggregate (GstRtmpConnection * connection,
+    gboolean aggregate);
+
 void gst_rtmp_connection_set_data_frame (GstRtmpConnection * connection,
     GstBuffer * buffer);
 
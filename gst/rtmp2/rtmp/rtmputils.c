@@ -32,6 +32,8 @@ static void write_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 static void write_all_buffer_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
+static void write_all_vector_done (GObject * source, GAsyncResult * result,
+    gpointer user_data);
 
 void
 gst_rtmp_byte_array_append_bytes (GByteArray * bytearray, GBytes * bytes)
@@ -257,6 +259,309 @@ gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
   return g_task_propagate_boolean (task, error);
 }
 
+/* A part of a GstRtmpOutputVector, either in the header arena (map == -1)
+ * or in one of the mapped memories */
+typedef struct
+{
+  gint map;
+  gsize offset, size;
+} OutputVectorPart;
+
+struct _GstRtmpOutputVector
+{
+  GByteArray *headers;
+  GArray *maps;
+  GArray *parts;
+  gsize size;
+
+  /* Buffer whose memories were mapped last, starting at maps[last_map] */
+  GstBuffer *last_buffer;
+  guint last_map;
+};
+
+static void
+output_vector_clear_map (gpointer ptr)
+{
+  GstMapInfo *info = ptr;
+  GstMemory *memory = info->memory;
+
+  gst_memory_unmap (memory, info);
+  gst_memory_unref (memory);
+}
+
+GstRtmpOutputVector *
+gst_rtmp_output_vector_new (void)
+{
+  GstRtmpOutputVector *vector = g_slice_new0 (GstRtmpOutputVector);
+
+  vector->headers = g_byte_array_new ();
+  vector->maps = g_array_new (FALSE, FALSE, sizeof (GstMapInfo));
+  g_array_set_clear_func (vector->maps, output_vector_clear_map);
+  vector->parts = g_array_new (FALSE, FALSE, sizeof (OutputVectorPart));
+
+  return vector;
+}
+
+void
+gst_rtmp_output_vector_free (GstRtmpOutputVector * vector)
+{
+  g_return_if_fail (vector);
+
+  g_byte_array_unref (vector->headers);
+  g_array_unref (vector->maps);
+  g_array_unref (vector->parts);
+  gst_buffer_replace (&vector->last_buffer, NULL);
+  g_slice_free (GstRtmpOutputVector, vector);
+}
+
+gsize
+gst_rtmp_output_vector_get_size (GstRtmpOutputVector * vector)
+{
+  g_return_val_if_fail (vector, 0);
+  return vector->size;
+}
+
+static void
+output_vector_add_part (GstRtmpOutputVector * vector, gint map, gsize offset,
+    gsize size)
+{
+  OutputVectorPart *last = NULL;
+
+  if (vector->parts->len > 0) {
+    last = &g_array_index (vector->parts, OutputVectorPart,
+        vector->parts->len - 1);
+  }
+
+  if (last && last->map == map && last->offset + last->size == offset) {
+    last->size += size;
+  } else {
+    OutputVectorPart part = { map, offset, size };
+    g_array_append_val (vector->parts, part);
+  }
+
+  vector->size += size;
+}
+
+/* Drops everything added after the vector was @size bytes long */
+void
+gst_rtmp_output_vector_truncate (GstRtmpOutputVector * vector, gsize size)
+{
+  g_return_if_fail (vector);
+  g_return_if_fail (size <= vector->size);
+
+  while (vector->size > size) {
+    OutputVectorPart *last = &g_array_index (vector->parts, OutputVectorPart,
+        vector->parts->len - 1);
+    gsize drop = MIN (last->size, vector->size - size);
+
+    last->size -= drop;
+    vector->size -= drop;
+
+    /* headers are added at the end of the arena */
+    if (last->map < 0) {
+      g_byte_array_set_size (vector->headers, last->offset + last->size);
+    }
+
+    if (last->size == 0) {
+      g_array_set_size (vector->parts, vector->parts->len - 1);
+    }
+  }
+}
+
+/* Returns @size bytes of the header arena to fill in, valid until the next
+ * call */
+guint8 *
+gst_rtmp_output_vector_add_header (GstRtmpOutputVector * vector, gsize size)
+{
+  guint offset;
+
+  g_return_val_if_fail (vector, NULL);
+
+  offset = vector->headers->len;
+  g_byte_array_set_size (vector->headers, offset + size);
+  output_vector_add_part (vector, -1, offset, size);
+
+  return vector->headers->data + offset;
+}
+
+/* Adds a region of @buffer by reference. Each memory of @buffer is mapped
+ * once, however many regions are added from it in a row. */
+gboolean
+gst_rtmp_output_vector_add_buffer (GstRtmpOutputVector * vector,
+    GstBuffer * buffer, gsize offset, gsize size)
+{
+  guint i, n;
+
+  g_return_val_if_fail (vector, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+
+  if (vector->last_buffer != buffer) {
+    gst_buffer_replace (&vector->last_buffer, buffer);
+    vector->last_map = vector->maps->len;
+
+    n = gst_buffer_n_memory (buffer);
+    for (i = 0; i < n; i++) {
+      GstMemory *memory = gst_buffer_peek_memory (buffer, i);
+      GstMapInfo info;
+
+      if (!gst_memory_map (memory, &info, GST_MAP_READ)) {
+        gst_buffer_replace (&vector->last_buffer, NULL);
+        return FALSE;
+      }
+
+      gst_memory_ref (memory);
+      g_array_append_val (vector->maps, info);
+    }
+  }
+
+  for (i = vector->last_map; size > 0 && i < vector->maps->len; i++) {
+    GstMapInfo *info = &g_array_index (vector->maps, GstMapInfo, i);
+    gsize len;
+
+    if (offset >= info->size) {
+      offset -= info->size;
+      continue;
+    }
+
+    len = MIN (info->size - offset, size);
+    output_vector_add_part (vector, i, offset, len);
+    size -= len;
+    offset = 0;
+  }
+
+  g_return_val_if_fail (size == 0, FALSE);
+  return TRUE;
+}
+
+static inline const guint8 *
+output_vector_part_data (GstRtmpOutputVector * vector,
+    const OutputVectorPart * part)
+{
+  if (part->map < 0)
+    return vector->headers->data + part->offset;
+
+  return g_array_index (vector->maps, GstMapInfo, part->map).data +
+      part->offset;
+}
+
+typedef struct
+{
+  GstRtmpOutputVector *vector;
+  gpointer vectors;
+  gsize bytes_written;
+} WriteAllVectorData;
+
+static void
+write_all_vector_data_free (gpointer ptr)
+{
+  WriteAllVectorData *data = ptr;
+  gst_rtmp_output_vector_free (data->vector);
+  g_free (data->vectors);
+  g_slice_free (WriteAllVectorData, data);
+}
+
+/* Writes all of @vector, taking ownership of it. The parts are passed to a
+ * single vectored write where GLib supports it, so chunk payloads are never
+ * copied. */
+void
+gst_rtmp_output_stream_write_all_vector_async (GOutputStream * stream,
+    GstRtmpOutputVector * vector, int io_priority, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task;
+  WriteAllVectorData *data;
+  guint i, n;
+
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+  g_return_if_fail (vector);
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+
+  data = g_slice_new0 (WriteAllVectorData);
+  data->vector = vector;
+  g_task_set_task_data (task, data, write_all_vector_data_free);
+
+  n = vector->parts->len;
+
+#if GLIB_CHECK_VERSION(2, 60, 0)
+  {
+    GOutputVector *vectors = g_new (GOutputVector, n);
+
+    for (i = 0; i < n; i++) {
+      OutputVectorPart *part = &g_array_index (vector->parts,
+          OutputVectorPart, i);
+      vectors[i].buffer = output_vector_part_data (vector, part);
+      vectors[i].size = part->size;
+    }
+
+    data->vectors = vectors;
+    g_output_stream_writev_all_async (stream, vectors, n, io_priority,
+        cancellable, write_all_vector_done, task);
+  }
+#else
+  {
+    guint8 *flat = g_malloc (vector->size), *pos = flat;
+
+    for (i = 0; i < n; i++) {
+      OutputVectorPart *part = &g_array_index (vector->parts,
+          OutputVectorPart, i);
+      memcpy (pos, output_vector_part_data (vector, part), part->size);
+      pos += part->size;
+    }
+
+    data->vectors = flat;
+    g_output_stream_write_all_async (stream, flat, vector->size, io_priority,
+        cancellable, write_all_vector_done, task);
+  }
+#endif
+}
+
+static void
+write_all_vector_done (GObject * source, GAsyncResult * result,
+    gpointer user_data)
+{
+  GOutputStream *os = G_OUTPUT_STREAM (source);
+  GTask *task = user_data;
+  WriteAllVectorData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+  gboolean res;
+
+#if GLIB_CHECK_VERSION(2, 60, 0)
+  res = g_output_stream_writev_all_finish (os, result, &data->bytes_written,
+      &error);
+#else
+  res = g_output_stream_write_all_finish (os, result, &data->bytes_written,
+      &error);
+#endif
+
+  if (!res) {
+    g_task_return_error (task, error);
+    g_object_unref (task);
+    return;
+  }
+
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+gboolean
+gst_rtmp_output_stream_write_all_vector_finish (GOutputStream * stream,
+    GAsyncResult * result, gsize * bytes_written, GError ** error)
+{
+  WriteAllVectorData *data;
+  GTask *task;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+  task = G_TASK (result);
+
+  data = g_task_get_task_data (task);
+  if (bytes_written) {
+    *bytes_written = data->bytes_written;
+  }
+
+  return g_task_propagate_boolean (task, error);
+}
+
 static const gchar ascii_table[128] = {
   0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
   0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
@@ -46,6 +46,24 @@ void gst_rtmp_output_stream_write_all_buffer_async (GOutputStream * stream,
 gboolean gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
     GAsyncResult * result, gsize * bytes_written, GError ** error);
 
+typedef struct _GstRtmpOutputVector GstRtmpOutputVector;
+
+GstRtmpOutputVector * gst_rtmp_output_vector_new (void);
+void gst_rtmp_output_vector_free (GstRtmpOutputVector * vector);
+gsize gst_rtmp_output_vector_get_size (GstRtmpOutputVector * vector);
+void gst_rtmp_output_vector_truncate (GstRtmpOutputVector * vector,
+    gsize size);
+guint8 * gst_rtmp_output_vector_add_header (GstRtmpOutputVector * vector,
+    gsize size);
+gboolean gst_rtmp_output_vector_add_buffer (GstRtmpOutputVector * vector,
+    GstBuffer * buffer, gsize offset, gsize size);
+
+void gst_rtmp_output_stream_write_all_vector_async (GOutputStream * stream,
+    GstRtmpOutputVector * vector, int io_priority, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data);
+gboolean gst_rtmp_output_stream_write_all_vector_finish (GOutputStream * stream,
+    GAsyncResult * result, gsize * bytes_written, GError ** error);
+
 void gst_rtmp_string_print_escaped (GString * string, const gchar * data,
     gssize size);
 
@@ -90,6 +90,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 /* prototypes */
 
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_scene_change_finalize (GObject * object);
+
+static gboolean gst_scene_change_start (GstBaseTransform * trans);
+static gboolean gst_scene_change_stop (GstBaseTransform * trans);
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
@@ -100,12 +108,40 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_DOWNSCALE,
+  PROP_N_THREADS,
+  PROP_ATTACH_META
 };
 
+#define DEFAULT_DOWNSCALE 1
+#define MAX_DOWNSCALE 8
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_ATTACH_META FALSE
+
+#define SCENE_CHANGE_META_NAME "GstSceneChangeMeta"
+/* Bumped when fields change meaning or are removed, adding fields is fine */
+#define SCENE_CHANGE_META_VERSION 1
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
+/* A horizontal band of the downscaled analysis plane */
+struct _GstSceneChangeBand
+{
+  GstSceneChange *scenechange;
+
+  const guint8 *src;
+  gint src_stride;
+  guint8 *dest;
+  guint y_start;
+  guint y_end;
+
+  /* per column sums of the source rows covered by one plane row */
+  guint16 *acc;
+  guint32 hist[SC_HIST_BINS];
+};
+
 /* class initialization */
 
 G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
@@ -118,7 +154,11 @@ GST_ELEMENT_REGISTER_DEFINE (scenechange, "scenechange",
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
+  static const gchar *tags[] = { NULL };
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
@@ -132,16 +172,210 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
       "Video/Filter", "Detects scene changes in video",
       "David Schleef <ds@entropywave.com>");
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+  gobject_class->finalize = gst_scene_change_finalize;
+  base_transform_class->start = GST_DEBUG_FUNCPTR (gst_scene_change_start);
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_scene_change_stop);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  /**
+   * GstSceneChange:downscale:
+   *
+   * Analyse a copy of the luma plane box-filtered down by this factor in
+   * both directions instead of the full resolution frames. The filtered
+   * planes of the current and previous frame are kept by the element, so
+   * no reference to the previous input buffer is held. With 1, the full
+   * resolution luma planes are compared.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DOWNSCALE,
+      g_param_spec_uint ("downscale", "Downscale",
+          "Factor by which the luma plane is downscaled before analysis",
+          1, MAX_DOWNSCALE, DEFAULT_DOWNSCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:n-threads:
+   *
+   * Number of threads used to downscale the luma plane, 0 for the number
+   * of processors. Only used when #GstSceneChange:downscale is larger
+   * than 1.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Number of threads used for analysis (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:attach-meta:
+   *
+   * Attach a "GstSceneChangeMeta" custom meta to every analysed buffer.
+   * Its structure contains the layout version as an unsigned "version",
+   * currently 1, the picture difference as a double "score", whether a
+   * scene change was detected as a boolean "scene-change" and, when
+   * #GstSceneChange:downscale is larger than 1, the distance between the
+   * luma histograms of the frame and the previous frame as a double
+   * "histogram-distance" between 0 and 1. Consumers should ignore metas
+   * with a version they don't know.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ATTACH_META,
+      g_param_spec_boolean ("attach-meta", "Attach meta",
+          "Attach the analysis results to buffers as GstSceneChangeMeta",
+          DEFAULT_ATTACH_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /* Another module may have registered the name first, the meta is only
+   * attached if that is a custom meta too */
+  if (!gst_meta_get_info (SCENE_CHANGE_META_NAME))
+    gst_meta_register_custom (SCENE_CHANGE_META_NAME, tags, NULL, NULL, NULL);
 }
 
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->downscale = DEFAULT_DOWNSCALE;
+  scenechange->n_threads = DEFAULT_N_THREADS;
+  scenechange->attach_meta = DEFAULT_ATTACH_META;
+
+  g_mutex_init (&scenechange->bands_lock);
+  g_cond_init (&scenechange->bands_cond);
 }
 
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_DEBUG_OBJECT (scenechange, "set_property");
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_DOWNSCALE:
+      scenechange->downscale = g_value_get_uint (value);
+      break;
+    case PROP_N_THREADS:
+      scenechange->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_ATTACH_META:
+      scenechange->attach_meta = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_DEBUG_OBJECT (scenechange, "get_property");
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_DOWNSCALE:
+      g_value_set_uint (value, scenechange->downscale);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, scenechange->n_threads);
+      break;
+    case PROP_ATTACH_META:
+      g_value_set_boolean (value, scenechange->attach_meta);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+static void
+gst_scene_change_free_planes (GstSceneChange * scenechange)
+{
+  guint i;
+
+  if (scenechange->pool) {
+    g_thread_pool_free (scenechange->pool, FALSE, TRUE);
+    scenechange->pool = NULL;
+  }
+  scenechange->pool_threads = 0;
+
+  for (i = 0; i < scenechange->n_bands; i++)
+    g_free (scenechange->bands[i].acc);
+  g_clear_pointer (&scenechange->bands, g_free);
+  scenechange->n_bands = 0;
+
+  g_clear_pointer (&scenechange->planes[0], g_free);
+  g_clear_pointer (&scenechange->planes[1], g_free);
+  scenechange->plane_downscale = 0;
+  scenechange->plane_width = 0;
+  scenechange->plane_height = 0;
+  scenechange->have_old_plane = FALSE;
+}
+
+static void
+gst_scene_change_reset (GstSceneChange * scenechange)
+{
+  gst_buffer_replace (&scenechange->oldbuf, NULL);
+  gst_scene_change_free_planes (scenechange);
+
+  scenechange->n_diffs = 0;
+  memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+}
+
+static void
+gst_scene_change_finalize (GObject * object)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  gst_scene_change_reset (scenechange);
+  g_mutex_clear (&scenechange->bands_lock);
+  g_cond_clear (&scenechange->bands_cond);
+
+  G_OBJECT_CLASS (gst_scene_change_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_scene_change_start (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  GST_DEBUG_OBJECT (scenechange, "start");
+
+  gst_scene_change_reset (scenechange);
+  scenechange->count = 0;
+
+  if (GST_BASE_TRANSFORM_CLASS (gst_scene_change_parent_class)->start)
+    return
+        GST_BASE_TRANSFORM_CLASS (gst_scene_change_parent_class)->start (trans);
+  return TRUE;
+}
+
+static gboolean
+gst_scene_change_stop (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  GST_DEBUG_OBJECT (scenechange, "stop");
+
+  gst_scene_change_reset (scenechange);
+
+  if (GST_BASE_TRANSFORM_CLASS (gst_scene_change_parent_class)->stop)
+    return
+        GST_BASE_TRANSFORM_CLASS (gst_scene_change_parent_class)->stop (trans);
+  return TRUE;
+}
 
 static double
 get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
@@ -158,45 +392,198 @@ get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
   return ((double) score) / (width * height);
 }
 
-static GstFlowReturn
-gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
-    GstVideoFrame * frame)
+/* Box filters the source rows of the band into its rows of the analysis
+ * plane and builds the histogram of the result */
+static void
+downscale_band (GstSceneChangeBand * band)
 {
-  GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
-  GstVideoFrame oldframe;
-  double score_min;
-  double score_max;
-  double threshold;
-  double score;
-  gboolean change;
-  gboolean ret;
-  int i;
+  GstSceneChange *scenechange = band->scenechange;
+  guint factor = scenechange->plane_downscale;
+  guint width = scenechange->plane_width;
+  guint area = factor * factor;
+  guint x, y, r, k;
+
+  memset (band->hist, 0, sizeof (band->hist));
+
+  for (y = band->y_start; y < band->y_end; y++) {
+    const guint8 *src = band->src + (gsize) y * factor * band->src_stride;
+    guint8 *dest = band->dest + (gsize) y * width;
+
+    /* factor² * 255 always fits the 16 bit accumulators */
+    memset (band->acc, 0, width * sizeof (guint16));
+    for (r = 0; r < factor; r++) {
+      for (x = 0; x < width; x++) {
+        const guint8 *s = src + x * factor;
+        guint16 sum = 0;
+
+        for (k = 0; k < factor; k++)
+          sum += s[k];
+        band->acc[x] += sum;
+      }
+      src += band->src_stride;
+    }
 
-  GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
+    for (x = 0; x < width; x++) {
+      dest[x] = (band->acc[x] + area / 2) / area;
+      band->hist[dest[x] * SC_HIST_BINS / 256]++;
+    }
+  }
+}
 
-  if (!scenechange->oldbuf) {
-    scenechange->n_diffs = 0;
-    memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
-    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
-    return GST_FLOW_OK;
+static void
+downscale_band_func (gpointer data, gpointer user_data)
+{
+  GstSceneChangeBand *band = data;
+  GstSceneChange *scenechange = user_data;
+
+  downscale_band (band);
+
+  g_mutex_lock (&scenechange->bands_lock);
+  if (--scenechange->bands_pending == 0)
+    g_cond_signal (&scenechange->bands_cond);
+  g_mutex_unlock (&scenechange->bands_lock);
+}
+
+/* (Re)allocates the analysis planes and bands if the frame size or the
+ * settings changed. Returns FALSE if the previous plane can't be compared
+ * with the next one */
+static gboolean
+gst_scene_change_configure_planes (GstSceneChange * scenechange,
+    GstVideoFrame * frame, guint downscale, guint n_threads)
+{
+  guint width, height, n_bands, i;
+  gsize size;
+
+  width = GST_VIDEO_FRAME_WIDTH (frame) / downscale;
+  height = GST_VIDEO_FRAME_HEIGHT (frame) / downscale;
+  n_bands = CLAMP (n_threads, 1, height);
+
+  if (scenechange->planes[0] && scenechange->plane_downscale == downscale &&
+      scenechange->plane_width == width &&
+      scenechange->plane_height == height &&
+      scenechange->pool_threads == n_threads)
+    return TRUE;
+
+  GST_DEBUG_OBJECT (scenechange, "analysing %ux%u plane with %u bands",
+      width, height, n_bands);
+
+  gst_scene_change_free_planes (scenechange);
+
+  size = (gsize) width * height;
+  scenechange->planes[0] = g_malloc (size);
+  scenechange->planes[1] = g_malloc (size);
+  scenechange->plane_downscale = downscale;
+  scenechange->plane_width = width;
+  scenechange->plane_height = height;
+  scenechange->pool_threads = n_threads;
+
+  scenechange->bands = g_new0 (GstSceneChangeBand, n_bands);
+  scenechange->n_bands = n_bands;
+  for (i = 0; i < n_bands; i++) {
+    GstSceneChangeBand *band = &scenechange->bands[i];
+
+    band->scenechange = scenechange;
+    band->y_start = height * i / n_bands;
+    band->y_end = height * (i + 1) / n_bands;
+    band->acc = g_new (guint16, width);
   }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
+  /* The streaming thread handles the first band itself */
+  if (n_bands > 1) {
+    GError *err = NULL;
+
+    scenechange->pool = g_thread_pool_new (downscale_band_func, scenechange,
+        n_bands - 1, FALSE, &err);
+    if (!scenechange->pool) {
+      GST_WARNING_OBJECT (scenechange, "failed to create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+    }
   }
 
-  score = get_frame_score (&oldframe, frame);
+  return FALSE;
+}
 
-  gst_video_frame_unmap (&oldframe);
+/* Downscales the luma plane of @frame into the current analysis plane.
+ * Returns FALSE if there is no previous plane to compare with */
+static gboolean
+get_downscaled_frame_score (GstSceneChange * scenechange,
+    GstVideoFrame * frame, guint downscale, guint n_threads,
+    double *score, double *hist_distance)
+{
+  guint cur, prev, i, b;
+  guint32 sad = 0;
+  guint32 *hist, *old_hist;
+  guint64 hist_diff = 0;
+  gsize npix;
+
+  if (!gst_scene_change_configure_planes (scenechange, frame, downscale,
+          n_threads))
+    scenechange->have_old_plane = FALSE;
+
+  cur = scenechange->cur_plane;
+  prev = cur ^ 1;
+
+  for (i = 0; i < scenechange->n_bands; i++) {
+    scenechange->bands[i].src = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+    scenechange->bands[i].src_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+    scenechange->bands[i].dest = scenechange->planes[cur];
+  }
+
+  if (scenechange->pool) {
+    scenechange->bands_pending = scenechange->n_bands - 1;
+    for (i = 1; i < scenechange->n_bands; i++)
+      g_thread_pool_push (scenechange->pool, &scenechange->bands[i], NULL);
+
+    downscale_band (&scenechange->bands[0]);
+
+    g_mutex_lock (&scenechange->bands_lock);
+    while (scenechange->bands_pending > 0)
+      g_cond_wait (&scenechange->bands_cond, &scenechange->bands_lock);
+    g_mutex_unlock (&scenechange->bands_lock);
+  } else {
+    for (i = 0; i < scenechange->n_bands; i++)
+      downscale_band (&scenechange->bands[i]);
+  }
+
+  hist = scenechange->hists[cur];
+  memset (hist, 0, sizeof (scenechange->hists[cur]));
+  for (i = 0; i < scenechange->n_bands; i++) {
+    for (b = 0; b < SC_HIST_BINS; b++)
+      hist[b] += scenechange->bands[i].hist[b];
+  }
 
-  gst_buffer_unref (scenechange->oldbuf);
-  scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-  memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+  scenechange->cur_plane = prev;
+
+  if (!scenechange->have_old_plane) {
+    scenechange->have_old_plane = TRUE;
+    return FALSE;
+  }
+
+  npix = (gsize) scenechange->plane_width * scenechange->plane_height;
+
+  orc_sad_nxm_u8 (&sad, scenechange->planes[prev], scenechange->plane_width,
+      scenechange->planes[cur], scenechange->plane_width,
+      scenechange->plane_width, scenechange->plane_height);
+  *score = ((double) sad) / npix;
+
+  old_hist = scenechange->hists[prev];
+  for (b = 0; b < SC_HIST_BINS; b++)
+    hist_diff += ABS ((gint64) hist[b] - (gint64) old_hist[b]);
+  *hist_distance = ((double) hist_diff) / (2 * npix);
+
+  return TRUE;
+}
+
+/* Adds @score to the history and returns whether it is a scene change */
+static gboolean
+gst_scene_change_update_diffs (GstSceneChange * scenechange, double score)
+{
+  double score_min;
+  double score_max;
+  double threshold;
+  gboolean change;
+  int i;
 
   memmove (scenechange->diffs, scenechange->diffs + 1,
       sizeof (double) * (SC_N_DIFFS - 1));
@@ -243,10 +630,104 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
 #endif
 
   if (change) {
-    GstEvent *event;
-
     GST_INFO_OBJECT (scenechange, "%d %g %g %g %d",
         scenechange->n_diffs, score / threshold, score, threshold, change);
+  }
+
+  return change;
+}
+
+static GstFlowReturn
+gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
+    GstVideoFrame * frame)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
+  GstVideoFrame oldframe;
+  guint downscale, n_threads;
+  gboolean attach_meta;
+  double score;
+  double hist_distance = -1.0;
+  gboolean change;
+  gboolean ret;
+
+  GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
+
+  GST_OBJECT_LOCK (scenechange);
+  downscale = scenechange->downscale;
+  n_threads = scenechange->n_threads;
+  attach_meta = scenechange->attach_meta;
+  GST_OBJECT_UNLOCK (scenechange);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  downscale = MIN (downscale, GST_VIDEO_FRAME_WIDTH (frame));
+  downscale = MIN (downscale, GST_VIDEO_FRAME_HEIGHT (frame));
+
+  if (downscale > 1) {
+    if (scenechange->oldbuf) {
+      gst_buffer_replace (&scenechange->oldbuf, NULL);
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+    }
+
+    if (!get_downscaled_frame_score (scenechange, frame, downscale, n_threads,
+            &score, &hist_distance)) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+      return GST_FLOW_OK;
+    }
+  } else {
+    if (scenechange->planes[0])
+      gst_scene_change_free_planes (scenechange);
+
+    if (!scenechange->oldbuf) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+      scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+      memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+      return GST_FLOW_OK;
+    }
+
+    ret =
+        gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+        scenechange->oldbuf, GST_MAP_READ);
+    if (!ret) {
+      GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+      return GST_FLOW_ERROR;
+    }
+
+    score = get_frame_score (&oldframe, frame);
+
+    gst_video_frame_unmap (&oldframe);
+
+    gst_buffer_unref (scenechange->oldbuf);
+    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+  }
+
+  change = gst_scene_change_update_diffs (scenechange, score);
+
+  if (attach_meta) {
+    GstCustomMeta *meta;
+    GstStructure *s;
+
+    meta = gst_buffer_add_custom_meta (frame->buffer, SCENE_CHANGE_META_NAME);
+    if (meta) {
+      s = gst_custom_meta_get_structure (meta);
+      gst_structure_set (s, "version", G_TYPE_UINT, SCENE_CHANGE_META_VERSION,
+          "score", G_TYPE_DOUBLE, score,
+          "scene-change", G_TYPE_BOOLEAN, change, NULL);
+      if (hist_distance >= 0.0)
+        gst_structure_set (s, "histogram-distance", G_TYPE_DOUBLE,
+            hist_distance, NULL);
+    } else {
+      GST_WARNING_OBJECT (scenechange, "%s is not a custom meta, not "
+          "attaching the results", SCENE_CHANGE_META_NAME);
+    }
+  }
+
+  if (change) {
+    GstEvent *event;
 
     event =
         gst_video_event_new_downstream_force_key_unit (GST_BUFFER_PTS
@@ -263,7 +744,6 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
 
 
 
-
 #ifdef TESTING
 /* This is from ds's personal collection.  No, you can't have it. */
 int showreel_changes[] = {
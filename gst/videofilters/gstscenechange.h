@@ -35,16 +35,43 @@ typedef struct _GstSceneChange GstSceneChange;
 typedef struct _GstSceneChangeClass GstSceneChangeClass;
 
 #define SC_N_DIFFS 5
+#define SC_HIST_BINS 64
+
+typedef struct _GstSceneChangeBand GstSceneChangeBand;
 
 struct _GstSceneChange
 {
   GstVideoFilter base_scenechange;
 
+  /* properties */
+  guint downscale;
+  guint n_threads;
+  gboolean attach_meta;
+
   int n_diffs;
   double diffs[SC_N_DIFFS];
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
   int count;
+
+  /* Downscaled luma planes of the current and previous frames, and their
+   * histograms, used when downscale > 1 */
+  guint plane_downscale;
+  guint plane_width;
+  guint plane_height;
+  guint8 *planes[2];
+  guint32 hists[2][SC_HIST_BINS];
+  guint cur_plane;
+  gboolean have_old_plane;
+
+  /* Bands of the analysis plane computed in parallel */
+  GThreadPool *pool;
+  guint pool_threads;
+  GstSceneChangeBand *bands;
+  guint n_bands;
+  GMutex bands_lock;
+  GCond bands_cond;
+  guint bands_pending;
 };
 
 struct _GstSceneChangeClass
@@ -23,6 +23,10 @@
  * The videodiff element highlights the difference between a frame and its
  * previous on the luma plane.
  *
+ * With #GstVideoDiff:motion-meta enabled, the regions that changed are also
+ * attached to the buffers as region of interest metas, which can be used to
+ * find the active parts of screen captures.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v videotestsrc pattern=ball ! videodiff ! videoconvert ! autovideosink
@@ -44,14 +48,50 @@ GST_DEBUG_CATEGORY_STATIC (gst_video_diff_debug_category);
 
 /* prototypes */
 
-static GstFlowReturn gst_video_diff_transform_frame (GstVideoFilter * filter,
-    GstVideoFrame * inframe, GstVideoFrame * outframe);
+static void gst_video_diff_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_video_diff_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_video_diff_finalize (GObject * object);
+
+static gboolean gst_video_diff_stop (GstBaseTransform * trans);
+static gboolean gst_video_diff_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
+static GstFlowReturn gst_video_diff_transform_frame_ip (GstVideoFilter *
+    filter, GstVideoFrame * frame);
+
+enum
+{
+  PROP_0,
+  PROP_MOTION_META,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_MOTION_META FALSE
+#define DEFAULT_N_THREADS 1
+
+/* Size in pixels of the square tiles motion regions are made of */
+#define TILE_SIZE 16
+
+#define VIDEO_FORMATS "{ I420, YV12, Y444, Y42B, Y41B, NV12, NV21, NV16, " \
+    "NV61, NV24, GRAY8, YUY2, UYVY, YVYU, AYUV, VUYA, P010_10LE, P016_LE, " \
+    "I420_10LE, I422_10LE, Y444_10LE, GRAY16_LE }"
 
 #define VIDEO_SRC_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
+    GST_VIDEO_CAPS_MAKE(VIDEO_FORMATS)
 
 #define VIDEO_SINK_CAPS \
-    GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
+    GST_VIDEO_CAPS_MAKE(VIDEO_FORMATS)
+
+/* A band of tile rows of the frame */
+struct _GstVideoDiffBand
+{
+  GstVideoDiff *videodiff;
+  GstVideoFrame *frame;
+  guint y_start;
+  guint y_end;
+};
 
 
 G_DEFINE_TYPE_WITH_CODE (GstVideoDiff, gst_video_diff, GST_TYPE_VIDEO_FILTER,
@@ -63,6 +103,9 @@ GST_ELEMENT_REGISTER_DEFINE (videodiff, "videodiff",
 static void
 gst_video_diff_class_init (GstVideoDiffClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -77,97 +120,448 @@ gst_video_diff_class_init (GstVideoDiffClass * klass)
       "Visualize differences between adjacent video frames",
       "David Schleef <ds@schleef.org>");
 
-  video_filter_class->transform_frame =
-      GST_DEBUG_FUNCPTR (gst_video_diff_transform_frame);
+  gobject_class->set_property = gst_video_diff_set_property;
+  gobject_class->get_property = gst_video_diff_get_property;
+  gobject_class->finalize = gst_video_diff_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_video_diff_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_diff_set_info);
+  video_filter_class->transform_frame_ip =
+      GST_DEBUG_FUNCPTR (gst_video_diff_transform_frame_ip);
+
+  /**
+   * GstVideoDiff:motion-meta:
+   *
+   * Attach a #GstVideoRegionOfInterestMeta of type "motion" for each group
+   * of adjacent 16x16 tiles that changed since the previous frame, so
+   * that downstream elements can tell static regions apart.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MOTION_META,
+      g_param_spec_boolean ("motion-meta", "Motion meta",
+          "Attach region of interest metas for changed regions",
+          DEFAULT_MOTION_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoDiff:n-threads:
+   *
+   * Number of threads the frames are split across, 0 for the number of
+   * processors.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Number of threads used for processing (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_video_diff_init (GstVideoDiff * videodiff)
 {
   videodiff->threshold = 10;
+  videodiff->motion_meta = DEFAULT_MOTION_META;
+  videodiff->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&videodiff->bands_lock);
+  g_cond_init (&videodiff->bands_cond);
 }
 
-static GstFlowReturn
-gst_video_diff_transform_frame_ip_planarY (GstVideoDiff * videodiff,
-    GstVideoFrame * outframe, GstVideoFrame * inframe, GstVideoFrame * oldframe)
-{
-  int width = inframe->info.width;
-  int height = inframe->info.height;
-  int i, j;
-  int threshold = videodiff->threshold;
-  int t = videodiff->t;
-
-  for (j = 0; j < height; j++) {
-    guint8 *d = (guint8 *) outframe->data[0] + outframe->info.stride[0] * j;
-    guint8 *s1 = (guint8 *) oldframe->data[0] + oldframe->info.stride[0] * j;
-    guint8 *s2 = (guint8 *) inframe->data[0] + inframe->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      if ((s2[i] < s1[i] - threshold) || (s2[i] > s1[i] + threshold)) {
-        if ((i + j + t) & 0x4) {
-          d[i] = 16;
-        } else {
-          d[i] = 240;
-        }
-      } else {
-        d[i] = s2[i];
+static void
+gst_video_diff_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  GST_DEBUG_OBJECT (videodiff, "set_property");
+
+  GST_OBJECT_LOCK (videodiff);
+  switch (property_id) {
+    case PROP_MOTION_META:
+      videodiff->motion_meta = g_value_get_boolean (value);
+      break;
+    case PROP_N_THREADS:
+      videodiff->n_threads = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (videodiff);
+}
+
+static void
+gst_video_diff_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  GST_DEBUG_OBJECT (videodiff, "get_property");
+
+  GST_OBJECT_LOCK (videodiff);
+  switch (property_id) {
+    case PROP_MOTION_META:
+      g_value_set_boolean (value, videodiff->motion_meta);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, videodiff->n_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (videodiff);
+}
+
+static void
+gst_video_diff_free_bands (GstVideoDiff * videodiff)
+{
+  if (videodiff->pool) {
+    g_thread_pool_free (videodiff->pool, FALSE, TRUE);
+    videodiff->pool = NULL;
+  }
+  videodiff->pool_threads = 0;
+
+  g_clear_pointer (&videodiff->bands, g_free);
+  videodiff->n_bands = 0;
+}
+
+static void
+gst_video_diff_reset (GstVideoDiff * videodiff)
+{
+  gst_video_diff_free_bands (videodiff);
+
+  g_clear_pointer (&videodiff->previous_luma, g_free);
+  g_clear_pointer (&videodiff->tiles, g_free);
+  g_clear_pointer (&videodiff->tile_stack, g_free);
+  videodiff->previous_luma_stride = 0;
+  videodiff->tiles_x = 0;
+  videodiff->tiles_y = 0;
+  videodiff->have_previous = FALSE;
+}
+
+static void
+gst_video_diff_finalize (GObject * object)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  gst_video_diff_reset (videodiff);
+  g_mutex_clear (&videodiff->bands_lock);
+  g_cond_clear (&videodiff->bands_cond);
+
+  G_OBJECT_CLASS (gst_video_diff_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_video_diff_stop (GstBaseTransform * trans)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (trans);
+
+  GST_DEBUG_OBJECT (videodiff, "stop");
+
+  gst_video_diff_reset (videodiff);
+
+  return TRUE;
+}
+
+static gboolean
+gst_video_diff_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+  guint width = GST_VIDEO_INFO_WIDTH (in_info);
+  guint height = GST_VIDEO_INFO_HEIGHT (in_info);
+  guint bytes = GST_VIDEO_INFO_COMP_DEPTH (in_info, 0) > 8 ? 2 : 1;
+
+  GST_DEBUG_OBJECT (videodiff, "set_info");
+
+  gst_video_diff_reset (videodiff);
+
+  videodiff->previous_luma_stride = (gsize) width * bytes;
+  videodiff->previous_luma =
+      g_malloc (videodiff->previous_luma_stride * height);
+  videodiff->tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+  videodiff->tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+  videodiff->tiles = g_malloc (videodiff->tiles_x * videodiff->tiles_y);
+  videodiff->tile_stack =
+      g_new (guint, videodiff->tiles_x * videodiff->tiles_y);
+
+  return TRUE;
+}
+
+/* Highlights the pixels of @row that differ from @prev by more than
+ * @threshold, replaces @prev with the original row and flags the tiles
+ * containing changed pixels. Written without branches in the inner loop so
+ * that it gets vectorized for planar and semi-planar formats. */
+static inline void
+diff_row_u8 (guint8 * row, gint pstride, guint8 * prev, guint width,
+    gint threshold, gint phase, guint8 * tiles)
+{
+  guint x0, x, end;
+
+  for (x0 = 0; x0 < width; x0 += TILE_SIZE) {
+    guint8 changed = 0;
+
+    end = MIN (x0 + TILE_SIZE, width);
+    for (x = x0; x < end; x++) {
+      gint cur = row[x * pstride];
+      gint diff = ABS (cur - (gint) prev[x]) > threshold;
+
+      prev[x] = cur;
+      row[x * pstride] = diff ? (((x + phase) & 0x4) ? 16 : 240) : cur;
+      changed |= diff;
+    }
+    tiles[x0 / TILE_SIZE] |= changed;
+  }
+}
+
+/* Same as diff_row_u8() for little endian samples of more than 8 bits,
+ * @shift and @depth being those of the luma component */
+static void
+diff_row_u16 (guint8 * row, gint pstride, guint16 * prev, guint width,
+    gint threshold, gint phase, guint shift, guint depth, guint8 * tiles)
+{
+  guint16 low = (16 << (depth - 8)) << shift;
+  guint16 high = (240 << (depth - 8)) << shift;
+  guint x0, x, end;
+
+  threshold <<= depth - 8;
+
+  for (x0 = 0; x0 < width; x0 += TILE_SIZE) {
+    guint8 changed = 0;
+
+    end = MIN (x0 + TILE_SIZE, width);
+    for (x = x0; x < end; x++) {
+      guint8 *p = row + x * pstride;
+      gint cur = GST_READ_UINT16_LE (p) >> shift;
+
+      if (ABS (cur - (gint) prev[x]) > threshold) {
+        GST_WRITE_UINT16_LE (p, ((x + phase) & 0x4) ? low : high);
+        changed = 1;
       }
+      prev[x] = cur;
     }
+    tiles[x0 / TILE_SIZE] |= changed;
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 1); j++) {
-    guint8 *d = (guint8 *) outframe->data[1] + outframe->info.stride[1] * j;
-    guint8 *s = (guint8 *) inframe->data[1] + inframe->info.stride[1] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 1));
+}
+
+static void
+store_row (const guint8 * row, gint pstride, guint8 * prev, guint width,
+    guint shift, guint depth)
+{
+  guint x;
+
+  if (depth > 8) {
+    guint16 *prev16 = (guint16 *) prev;
+
+    for (x = 0; x < width; x++)
+      prev16[x] = GST_READ_UINT16_LE (row + x * pstride) >> shift;
+  } else if (pstride == 1) {
+    memcpy (prev, row, width);
+  } else {
+    for (x = 0; x < width; x++)
+      prev[x] = row[x * pstride];
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 2); j++) {
-    guint8 *d = (guint8 *) outframe->data[2] + outframe->info.stride[2] * j;
-    guint8 *s = (guint8 *) inframe->data[2] + inframe->info.stride[2] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 2));
+}
+
+static void
+gst_video_diff_process_band (GstVideoDiffBand * band)
+{
+  GstVideoDiff *videodiff = band->videodiff;
+  GstVideoFrame *frame = band->frame;
+  guint width = GST_VIDEO_FRAME_WIDTH (frame);
+  guint8 *data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  gint stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  gint pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+  guint shift = GST_VIDEO_FRAME_COMP_SHIFT (frame, 0);
+  guint depth = GST_VIDEO_FRAME_COMP_DEPTH (frame, 0);
+  guint y;
+
+  for (y = band->y_start; y < band->y_end; y++) {
+    guint8 *row = data + (gssize) y * stride;
+    guint8 *prev = videodiff->previous_luma +
+        y * videodiff->previous_luma_stride;
+    guint8 *tiles = videodiff->tiles + (y / TILE_SIZE) * videodiff->tiles_x;
+    gint phase = y + videodiff->t;
+
+    if (!videodiff->have_previous)
+      store_row (row, pstride, prev, width, shift, depth);
+    else if (depth > 8)
+      diff_row_u16 (row, pstride, (guint16 *) prev, width,
+          videodiff->threshold, phase, shift, depth, tiles);
+    else if (pstride == 1)
+      diff_row_u8 (row, 1, prev, width, videodiff->threshold, phase, tiles);
+    else
+      diff_row_u8 (row, pstride, prev, width, videodiff->threshold, phase,
+          tiles);
+  }
+}
+
+static void
+gst_video_diff_band_func (gpointer data, gpointer user_data)
+{
+  GstVideoDiffBand *band = data;
+  GstVideoDiff *videodiff = user_data;
+
+  gst_video_diff_process_band (band);
+
+  g_mutex_lock (&videodiff->bands_lock);
+  if (--videodiff->bands_pending == 0)
+    g_cond_signal (&videodiff->bands_cond);
+  g_mutex_unlock (&videodiff->bands_lock);
+}
+
+/* Splits the frame in bands of whole tile rows, so that no two bands flag
+ * the same tiles */
+static void
+gst_video_diff_configure_bands (GstVideoDiff * videodiff, guint height,
+    guint n_threads)
+{
+  guint n_bands, i;
+
+  if (videodiff->bands && videodiff->pool_threads == n_threads)
+    return;
+
+  gst_video_diff_free_bands (videodiff);
+
+  n_bands = CLAMP (n_threads, 1, videodiff->tiles_y);
+
+  GST_DEBUG_OBJECT (videodiff, "processing frames in %u bands", n_bands);
+
+  videodiff->bands = g_new0 (GstVideoDiffBand, n_bands);
+  videodiff->n_bands = n_bands;
+  videodiff->pool_threads = n_threads;
+  for (i = 0; i < n_bands; i++) {
+    GstVideoDiffBand *band = &videodiff->bands[i];
+
+    band->videodiff = videodiff;
+    band->y_start = MIN (videodiff->tiles_y * i / n_bands * TILE_SIZE, height);
+    band->y_end =
+        MIN (videodiff->tiles_y * (i + 1) / n_bands * TILE_SIZE, height);
+  }
+
+  /* The streaming thread handles the first band itself */
+  if (n_bands > 1) {
+    GError *err = NULL;
+
+    videodiff->pool = g_thread_pool_new (gst_video_diff_band_func, videodiff,
+        n_bands - 1, FALSE, &err);
+    if (!videodiff->pool) {
+      GST_WARNING_OBJECT (videodiff, "failed to create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+    }
+  }
+}
+
+/* Attaches one region of interest meta per group of adjacent changed
+ * tiles */
+static void
+gst_video_diff_add_motion_meta (GstVideoDiff * videodiff, GstBuffer * buffer,
+    guint width, guint height)
+{
+  guint tiles_x = videodiff->tiles_x;
+  guint n_tiles = tiles_x * videodiff->tiles_y;
+  guint8 *tiles = videodiff->tiles;
+  guint *stack = videodiff->tile_stack;
+  guint i;
+
+  for (i = 0; i < n_tiles; i++) {
+    guint min_x, min_y, max_x, max_y;
+    guint x, y, n = 0;
+
+    if (tiles[i] != 1)
+      continue;
+
+    min_x = max_x = i % tiles_x;
+    min_y = max_y = i / tiles_x;
+
+    /* tiles are marked 2 once they belong to a region */
+    tiles[i] = 2;
+    stack[n++] = i;
+    while (n > 0) {
+      guint t = stack[--n];
+
+      x = t % tiles_x;
+      y = t / tiles_x;
+      min_x = MIN (min_x, x);
+      max_x = MAX (max_x, x);
+      min_y = MIN (min_y, y);
+      max_y = MAX (max_y, y);
+
+      if (x > 0 && tiles[t - 1] == 1) {
+        tiles[t - 1] = 2;
+        stack[n++] = t - 1;
+      }
+      if (x + 1 < tiles_x && tiles[t + 1] == 1) {
+        tiles[t + 1] = 2;
+        stack[n++] = t + 1;
+      }
+      if (y > 0 && tiles[t - tiles_x] == 1) {
+        tiles[t - tiles_x] = 2;
+        stack[n++] = t - tiles_x;
+      }
+      if (t + tiles_x < n_tiles && tiles[t + tiles_x] == 1) {
+        tiles[t + tiles_x] = 2;
+        stack[n++] = t + tiles_x;
+      }
+    }
+
+    x = min_x * TILE_SIZE;
+    y = min_y * TILE_SIZE;
+    gst_buffer_add_video_region_of_interest_meta (buffer, "motion", x, y,
+        MIN ((max_x + 1) * TILE_SIZE, width) - x,
+        MIN ((max_y + 1) * TILE_SIZE, height) - y);
   }
-  return GST_FLOW_OK;
 }
 
 static GstFlowReturn
-gst_video_diff_transform_frame (GstVideoFilter * filter,
-    GstVideoFrame * inframe, GstVideoFrame * outframe)
+gst_video_diff_transform_frame_ip (GstVideoFilter * filter,
+    GstVideoFrame * frame)
 {
   GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+  gboolean motion_meta;
+  guint n_threads, i;
 
   GST_DEBUG_OBJECT (videodiff, "transform_frame_ip");
 
-  if (videodiff->previous_buffer) {
-    GstVideoFrame oldframe;
-
-    gst_video_frame_map (&oldframe, &videodiff->oldinfo,
-        videodiff->previous_buffer, GST_MAP_READ);
-
-    switch (inframe->info.finfo->format) {
-      case GST_VIDEO_FORMAT_I420:
-      case GST_VIDEO_FORMAT_Y41B:
-      case GST_VIDEO_FORMAT_Y444:
-      case GST_VIDEO_FORMAT_Y42B:
-        gst_video_diff_transform_frame_ip_planarY (videodiff, outframe,
-            inframe, &oldframe);
-        break;
-      default:
-        g_assert_not_reached ();
-    }
+  GST_OBJECT_LOCK (videodiff);
+  motion_meta = videodiff->motion_meta;
+  n_threads = videodiff->n_threads;
+  GST_OBJECT_UNLOCK (videodiff);
 
-    gst_video_frame_unmap (&oldframe);
-    gst_buffer_unref (videodiff->previous_buffer);
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  gst_video_diff_configure_bands (videodiff, GST_VIDEO_FRAME_HEIGHT (frame),
+      n_threads);
+
+  memset (videodiff->tiles, 0, videodiff->tiles_x * videodiff->tiles_y);
+  for (i = 0; i < videodiff->n_bands; i++)
+    videodiff->bands[i].frame = frame;
+
+  if (videodiff->pool) {
+    videodiff->bands_pending = videodiff->n_bands - 1;
+    for (i = 1; i < videodiff->n_bands; i++)
+      g_thread_pool_push (videodiff->pool, &videodiff->bands[i], NULL);
+
+    gst_video_diff_process_band (&videodiff->bands[0]);
+
+    g_mutex_lock (&videodiff->bands_lock);
+    while (videodiff->bands_pending > 0)
+      g_cond_wait (&videodiff->bands_cond, &videodiff->bands_lock);
+    g_mutex_unlock (&videodiff->bands_lock);
   } else {
-    int k;
-    int j;
-    for (k = 0; k < 3; k++) {
-      for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k); j++) {
-        guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
-        guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
-        memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, k));
-      }
-    }
+    for (i = 0; i < videodiff->n_bands; i++)
+      gst_video_diff_process_band (&videodiff->bands[i]);
   }
 
-  videodiff->previous_buffer = gst_buffer_ref (inframe->buffer);
-  memcpy (&videodiff->oldinfo, &inframe->info, sizeof (GstVideoInfo));
+  if (videodiff->have_previous && motion_meta)
+    gst_video_diff_add_motion_meta (videodiff, frame->buffer,
+        GST_VIDEO_FRAME_WIDTH (frame), GST_VIDEO_FRAME_HEIGHT (frame));
+
+  videodiff->have_previous = TRUE;
 
   return GST_FLOW_OK;
 }
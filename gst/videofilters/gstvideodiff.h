@@ -34,13 +34,35 @@ G_BEGIN_DECLS
 
 typedef struct _GstVideoDiff GstVideoDiff;
 typedef struct _GstVideoDiffClass GstVideoDiffClass;
+typedef struct _GstVideoDiffBand GstVideoDiffBand;
 
 struct _GstVideoDiff
 {
   GstVideoFilter base_videodiff;
 
-  GstBuffer *previous_buffer;
-  GstVideoInfo oldinfo;
+  /* properties */
+  gboolean motion_meta;
+  guint n_threads;
+
+  /* luma samples of the previous frame, one byte or one guint16 per pixel */
+  guint8 *previous_luma;
+  gsize previous_luma_stride;
+  gboolean have_previous;
+
+  /* per tile change flags of the current frame */
+  guint8 *tiles;
+  guint tiles_x;
+  guint tiles_y;
+  guint *tile_stack;
+
+  /* Bands of tile rows processed in parallel */
+  GThreadPool *pool;
+  guint pool_threads;
+  GstVideoDiffBand *bands;
+  guint n_bands;
+  GMutex bands_lock;
+  GCond bands_cond;
+  guint bands_pending;
 
   int threshold;
   int t;
@@ -20,6 +20,11 @@
  * Boston, MA 02110-1301, USA.
  */
 
+/* for memfd_create () */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
@@ -27,6 +32,12 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_SOCKET_H)
+#  define HAVE_FD_PASSING 1
+#  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#endif
 #ifdef _MSC_VER
 /* ssize_t is not available, so match return value of read()/write() on MSVC */
 #define ssize_t int
@@ -35,6 +46,7 @@
 #include <string.h>
 #include <gst/base/gstbytewriter.h>
 #include <gst/gstprotection.h>
+#include <gst/allocators/allocators.h>
 #include "gstipcpipelinecomm.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
@@ -42,7 +54,36 @@ GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
+/* Smaller buffers are cheaper to write on the socket than to pass as fd */
+#define MIN_FD_BUFFER_SIZE 16384
+
+/* Flags of a buffer passed by fd */
+#define FD_BUFFER_FLAG_FD_ATTACHED (1 << 0)
+#define FD_BUFFER_FLAG_SEGMENT (1 << 1)
+
+#define MAX_RECEIVED_FDS 16
+
+/* Set in the flags of a buffer when the sender does not wait for its
+ * result. Does not collide with GstBufferFlags, which are 32 bits */
+#define COMM_BUFFER_FLAG_ASYNC (G_GUINT64_CONSTANT (1) << 63)
+
+/* Successful results of async buffers are acknowledged together, at the
+ * latest after that many buffers */
+#define MAX_PENDING_ACKS 16
+
+/* Shared between the receiving comm and the memories wrapping the received
+ * fds, which can outlive it */
+struct _GstIpcPipelineCommFdCache
+{
+  gint refcount;
+  GMutex lock;
+  GstIpcPipelineComm *comm;
+  GstAllocator *allocator;
+  int fds[GST_IPC_PIPELINE_COMM_N_SEGMENTS];
+};
+
 GQuark QUARK_ID;
+GQuark QUARK_ASYNC;
 
 typedef enum
 {
@@ -68,6 +109,8 @@ typedef struct
   guint32 ret;
   GstQuery *query;
   CommRequestType type;
+  /* nobody waits for the reply, it only completes the window */
+  gboolean async;
   GCond cond;
 } CommRequest;
 
@@ -88,6 +131,7 @@ comm_request_new (guint32 id, CommRequestType type, GstQuery * query)
   req->query = query;
   req->ret = comm_request_ret_get_failure_value (type);
   req->type = type;
+  req->async = FALSE;
 
   return req;
 }
@@ -134,6 +178,77 @@ comm_request_free (CommRequest * req)
   g_free (req);
 }
 
+/* Completes a buffer sent without waiting for its result. Must be called
+ * with comm->mutex held, the request is freed by the caller */
+static void
+comm_request_complete_async (GstIpcPipelineComm * comm, CommRequest * req,
+    GstFlowReturn ret)
+{
+  GST_TRACE_OBJECT (comm->element, "Async buffer %u completed: %s", req->id,
+      gst_flow_get_name (ret));
+
+  /* the first failure is reported to the next buffer */
+  if (ret != GST_FLOW_OK && comm->async_ret == GST_FLOW_OK)
+    comm->async_ret = ret;
+  if (comm->in_flight > 0)
+    comm->in_flight--;
+  g_cond_broadcast (&comm->window_cond);
+}
+
+static gboolean
+cancel_async_request (gpointer key, gpointer value, gpointer user_data)
+{
+  CommRequest *req = (CommRequest *) value;
+
+  if (!req->async)
+    return FALSE;
+
+  comm_request_complete_async ((GstIpcPipelineComm *) user_data, req,
+      GST_FLOW_ERROR);
+  return TRUE;
+}
+
+/* Waits until at most @max buffers are in flight. When waiting for room in
+ * the window (@max > 0), returns early on a failure to report it right away.
+ * If no buffer completes within the ack time, the peer is considered hung
+ * and the buffers in flight fail. Must be called with comm->mutex held */
+static void
+gst_ipc_pipeline_comm_wait_async_buffers (GstIpcPipelineComm * comm,
+    guint max)
+{
+  guint in_flight = comm->in_flight;
+  gint64 end_time = g_get_monotonic_time () + comm->ack_time;
+
+  while (comm->in_flight > max && (max == 0
+          || comm->async_ret == GST_FLOW_OK)) {
+    if (!g_cond_wait_until (&comm->window_cond, &comm->mutex, end_time)
+        && comm->in_flight >= in_flight) {
+      GST_ERROR_OBJECT (comm->element, "Timeout waiting for %u buffers in "
+          "flight", comm->in_flight);
+      g_hash_table_foreach_remove (comm->waiting_ids, cancel_async_request,
+          comm);
+      break;
+    }
+    /* the ack time applies to each buffer */
+    if (comm->in_flight < in_flight) {
+      in_flight = comm->in_flight;
+      end_time = g_get_monotonic_time () + comm->ack_time;
+    }
+  }
+}
+
+/* Waits for the results of all buffers in flight, for serialized events
+ * and queries to be handled after them as without a window. Must be called
+ * with comm->mutex held */
+static void
+gst_ipc_pipeline_comm_drain_async_buffers (GstIpcPipelineComm * comm)
+{
+  if (comm->in_flight > 0)
+    GST_DEBUG_OBJECT (comm->element, "Waiting for %u buffers in flight",
+        comm->in_flight);
+  gst_ipc_pipeline_comm_wait_async_buffers (comm, 0);
+}
+
 static const gchar *
 comm_request_ret_get_name (CommRequestType type, guint32 ret)
 {
@@ -192,6 +307,12 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+      return "FD_BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_RELEASE:
+      return "FD_RELEASE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_ACKS:
+      return "BUFFER_ACKS";
     default:
       return "UNKNOWN";
   }
@@ -262,6 +383,91 @@ write_byte_writer_to_fd (GstIpcPipelineComm * comm, GstByteWriter * bw)
   return ret;
 }
 
+#ifdef HAVE_FD_PASSING
+/* Writes the contents of @bw, with @fd attached to its first byte */
+static gboolean
+write_byte_writer_to_fd_with_fd (GstIpcPipelineComm * comm,
+    GstByteWriter * bw, int fd)
+{
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  union
+  {
+    char buf[CMSG_SPACE (sizeof (int))];
+    struct cmsghdr align;
+  } control;
+  struct cmsghdr *cmsg;
+  ssize_t written;
+  guint8 *data;
+  gboolean ret;
+  guint size;
+
+  size = gst_byte_writer_get_size (bw);
+  data = gst_byte_writer_reset_and_get_data (bw);
+  if (!data)
+    return FALSE;
+
+  memset (&control, 0, sizeof (control));
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+  GST_TRACE_OBJECT (comm->element, "Writing %u bytes and fd %d to fdout",
+      size, fd);
+  do {
+    written = sendmsg (comm->fdout, &msg, MSG_NOSIGNAL);
+  } while (written < 0 && (errno == EAGAIN || errno == EINTR));
+
+  if (written < 0) {
+    GST_ERROR_OBJECT (comm->element, "Failed to send fd: %s",
+        strerror (errno));
+    ret = FALSE;
+  } else {
+    /* the fd went along with the first byte, the rest is written normally */
+    ret = write_to_fd_raw (comm, data + written, size - written);
+  }
+
+  g_free (data);
+  return ret;
+}
+#endif
+
+/* Acknowledges all async buffers up to the last successful one. Must be
+ * called with comm->mutex held */
+static gboolean
+write_pending_buffer_acks_to_fd (GstIpcPipelineComm * comm)
+{
+  const unsigned char payload_type =
+      GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_ACKS;
+  GstByteWriter bw;
+  gboolean ret;
+
+  if (comm->n_pending_acks == 0)
+    return TRUE;
+
+  GST_TRACE_OBJECT (comm->element, "Writing BUFFER_ACKS for %u buffers up to "
+      "%u", comm->n_pending_acks, comm->pending_ack_id);
+  comm->n_pending_acks = 0;
+
+  gst_byte_writer_init (&bw);
+  ret = gst_byte_writer_put_uint8 (&bw, payload_type)
+      && gst_byte_writer_put_uint32_le (&bw, comm->pending_ack_id)
+      && gst_byte_writer_put_uint32_le (&bw, sizeof (guint32))
+      && gst_byte_writer_put_uint32_le (&bw, GST_FLOW_OK)
+      && write_byte_writer_to_fd (comm, &bw);
+  gst_byte_writer_reset (&bw);
+
+  return ret;
+}
+
 static void
 gst_ipc_pipeline_comm_write_ack_to_fd (GstIpcPipelineComm * comm, guint32 id,
     guint32 ret, CommRequestType type)
@@ -272,9 +478,13 @@ gst_ipc_pipeline_comm_write_ack_to_fd (GstIpcPipelineComm * comm, guint32 id,
 
   g_mutex_lock (&comm->mutex);
 
+  /* keep the results in order */
+  gst_byte_writer_init (&bw);
+  if (!write_pending_buffer_acks_to_fd (comm))
+    goto write_failed;
+
   GST_TRACE_OBJECT (comm->element, "Writing ACK for %u: %s (%d)", id,
       comm_request_ret_get_name (type, ret), ret);
-  gst_byte_writer_init (&bw);
   if (!gst_byte_writer_put_uint8 (&bw, payload_type))
     goto write_failed;
   if (!gst_byte_writer_put_uint32_le (&bw, id))
@@ -307,6 +517,27 @@ gst_ipc_pipeline_comm_write_flow_ack_to_fd (GstIpcPipelineComm * comm,
       COMM_REQUEST_TYPE_BUFFER);
 }
 
+/* Acknowledges a buffer. The successful results of async buffers are
+ * batched until @flush is set or enough of them are pending */
+void
+gst_ipc_pipeline_comm_write_buffer_ack_to_fd (GstIpcPipelineComm * comm,
+    guint32 id, gboolean async, GstFlowReturn ret, gboolean flush)
+{
+  if (!async || ret != GST_FLOW_OK) {
+    gst_ipc_pipeline_comm_write_flow_ack_to_fd (comm, id, ret);
+    return;
+  }
+
+  g_mutex_lock (&comm->mutex);
+  comm->pending_ack_id = id;
+  comm->n_pending_acks++;
+  if ((flush || comm->n_pending_acks >= MAX_PENDING_ACKS)
+      && !write_pending_buffer_acks_to_fd (comm))
+    GST_ELEMENT_ERROR (comm->element, RESOURCE, WRITE, (NULL),
+        ("Failed to write to socket"));
+  g_mutex_unlock (&comm->mutex);
+}
+
 void
 gst_ipc_pipeline_comm_write_boolean_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, gboolean ret)
@@ -503,22 +734,229 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+/* How a buffer is passed by fd, sent after the CommBufferMetadata */
+typedef struct
+{
+  guint32 handle;
+  guint32 flags;
+  guint64 maxsize;
+  guint64 offset;
+  guint32 size;
+  /* of the segment, echoed back in the FD_RELEASE */
+  guint32 generation;
+  int fd;
+} CommFdBufferInfo;
+
+#define COMM_FD_BUFFER_INFO_SIZE (4 + 4 + 8 + 8 + 4 + 4)
+
+#ifdef HAVE_FD_PASSING
+static void
+gst_ipc_pipeline_comm_segment_clear (GstIpcPipelineCommSegment * segment)
+{
+  if (segment->data)
+    munmap (segment->data, segment->size);
+  if (segment->fd >= 0)
+    close (segment->fd);
+  segment->fd = -1;
+  segment->data = NULL;
+  segment->size = 0;
+  segment->sent = FALSE;
+  segment->busy = FALSE;
+}
+
+/* The receiver knows nothing about fds sent on a previous fdout */
+static void
+gst_ipc_pipeline_comm_reset_fd_state (GstIpcPipelineComm * comm)
+{
+  struct stat st;
+  guint i;
+
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++)
+    gst_ipc_pipeline_comm_segment_clear (&comm->segments[i]);
+  g_hash_table_remove_all (comm->fd_buffers);
+
+  comm->segments_fdout = comm->fdout;
+  comm->fdout_is_socket = comm->fdout >= 0 && fstat (comm->fdout, &st) == 0
+      && S_ISSOCK (st.st_mode);
+  if (!comm->fdout_is_socket)
+    GST_INFO_OBJECT (comm->element,
+        "fdout is not a socket, buffers will be written as bytes");
+}
+
+static GstIpcPipelineCommSegment *
+gst_ipc_pipeline_comm_get_free_segment (GstIpcPipelineComm * comm,
+    gsize size, guint32 * handle)
+{
+  GstIpcPipelineCommSegment *segment = NULL;
+  guint i;
+
+  /* reuse a free segment large enough, or else replace a free one */
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++) {
+    if (comm->segments[i].busy)
+      continue;
+    if (comm->segments[i].size >= size) {
+      *handle = i;
+      return &comm->segments[i];
+    }
+    if (!segment) {
+      segment = &comm->segments[i];
+      *handle = i;
+    }
+  }
+
+  if (!segment)
+    return NULL;
+
+  gst_ipc_pipeline_comm_segment_clear (segment);
+
+  /* leave some room so slowly growing buffers do not need a new segment
+   * every time */
+  size = GST_ROUND_UP_N (size + size / 8, 4096);
+
+  segment->fd = memfd_create ("ipcpipeline", MFD_CLOEXEC);
+  if (segment->fd < 0)
+    goto failed;
+  if (ftruncate (segment->fd, size) < 0)
+    goto failed;
+  segment->data =
+      mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+  if (segment->data == MAP_FAILED) {
+    segment->data = NULL;
+    goto failed;
+  }
+  segment->size = size;
+
+  GST_DEBUG_OBJECT (comm->element, "Created segment %u of %" G_GSIZE_FORMAT
+      " bytes", *handle, size);
+  return segment;
+
+failed:
+  GST_WARNING_OBJECT (comm->element, "Failed to create shared memory: %s",
+      strerror (errno));
+  gst_ipc_pipeline_comm_segment_clear (segment);
+  return NULL;
+}
+
+/* Decides how to pass @buffer by fd, if it can be */
+static gboolean
+gst_ipc_pipeline_comm_prepare_fd_buffer (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, CommFdBufferInfo * info)
+{
+  GstIpcPipelineCommSegment *segment;
+  GstMemory *mem;
+  gsize size;
+
+  size = gst_buffer_get_size (buffer);
+  if (size < MIN_FD_BUFFER_SIZE)
+    return FALSE;
+
+  if (comm->segments_fdout != comm->fdout)
+    gst_ipc_pipeline_comm_reset_fd_state (comm);
+  if (!comm->fdout_is_socket)
+    return FALSE;
+
+  /* memfd or dmabuf backed buffers are passed as they are, and kept alive
+   * until the receiver is done with them */
+  mem = gst_buffer_peek_memory (buffer, 0);
+  if (gst_buffer_n_memory (buffer) == 1 && gst_is_fd_memory (mem)) {
+    info->handle = comm->next_fd_handle++;
+    if (comm->next_fd_handle < GST_IPC_PIPELINE_COMM_N_SEGMENTS)
+      comm->next_fd_handle = GST_IPC_PIPELINE_COMM_N_SEGMENTS;
+    info->flags = FD_BUFFER_FLAG_FD_ATTACHED;
+    info->fd = gst_fd_memory_get_fd (mem);
+    info->maxsize = mem->maxsize;
+    info->offset = mem->offset;
+    info->size = size;
+    g_hash_table_insert (comm->fd_buffers, GUINT_TO_POINTER (info->handle),
+        gst_buffer_ref (buffer));
+    return TRUE;
+  }
+
+  /* anything else is copied once into a shared memory segment */
+  segment = gst_ipc_pipeline_comm_get_free_segment (comm, size, &info->handle);
+  if (!segment) {
+    GST_LOG_OBJECT (comm->element, "No free segment, writing buffer as bytes");
+    return FALSE;
+  }
+  gst_buffer_extract (buffer, 0, segment->data, size);
+
+  info->flags = FD_BUFFER_FLAG_SEGMENT;
+  if (!segment->sent)
+    info->flags |= FD_BUFFER_FLAG_FD_ATTACHED;
+  info->fd = segment->fd;
+  info->maxsize = segment->size;
+  info->offset = 0;
+  info->size = size;
+  info->generation = ++segment->generation;
+  segment->sent = TRUE;
+  segment->busy = TRUE;
+  return TRUE;
+}
+
+/* The receiver will not release a buffer whose write failed, a late release
+ * of the segment is told apart by its generation */
+static void
+gst_ipc_pipeline_comm_cancel_fd_buffer (GstIpcPipelineComm * comm,
+    const CommFdBufferInfo * info)
+{
+  if (info->flags & FD_BUFFER_FLAG_SEGMENT) {
+    GstIpcPipelineCommSegment *segment = &comm->segments[info->handle];
+
+    segment->busy = FALSE;
+    if (info->flags & FD_BUFFER_FLAG_FD_ATTACHED)
+      segment->sent = FALSE;
+  } else {
+    g_hash_table_remove (comm->fd_buffers, GUINT_TO_POINTER (info->handle));
+  }
+}
+#endif
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
 {
-  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
+  unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
   GstMapInfo map;
   guint32 ret32 = GST_FLOW_OK;
   guint32 size, n;
   CommBufferMetadata meta;
+#ifdef HAVE_FD_PASSING
+  CommFdBufferInfo fd_info = { 0, };
+#endif
   GstFlowReturn ret;
   MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
   GstByteWriter bw;
+  gboolean async = FALSE;
 
   g_mutex_lock (&comm->mutex);
+
+  /* with a window, the result of a buffer is only reported with one of the
+   * following buffers */
+  if (comm->window_size > 1) {
+    gst_ipc_pipeline_comm_wait_async_buffers (comm, comm->window_size - 1);
+    async = TRUE;
+  } else {
+    /* the window was shrunk */
+    gst_ipc_pipeline_comm_drain_async_buffers (comm);
+  }
+
+  if (comm->async_ret != GST_FLOW_OK) {
+    ret = comm->async_ret;
+    comm->async_ret = GST_FLOW_OK;
+    GST_DEBUG_OBJECT (comm->element, "Returning result of a previous "
+        "buffer: %s", gst_flow_get_name (ret));
+    g_mutex_unlock (&comm->mutex);
+    return ret;
+  }
+
   ++comm->send_id;
 
+#ifdef HAVE_FD_PASSING
+  if (comm->pass_fds
+      && gst_ipc_pipeline_comm_prepare_fd_buffer (comm, buffer, &fd_info))
+    payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER;
+#endif
+
   GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
       comm->send_id, buffer);
 
@@ -530,6 +968,8 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   meta.offset = GST_BUFFER_OFFSET (buffer);
   meta.offset_end = GST_BUFFER_OFFSET_END (buffer);
   meta.flags = GST_BUFFER_FLAGS (buffer);
+  if (async)
+    meta.flags |= COMM_BUFFER_FLAG_ASYNC;
 
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
@@ -538,25 +978,63 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     goto write_failed;
   if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
     goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
-    goto write_failed;
-  size = gst_buffer_get_size (buffer);
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+#ifdef HAVE_FD_PASSING
+  if (payload_type == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER) {
+    size = COMM_FD_BUFFER_INFO_SIZE + sizeof (CommBufferMetadata) +
+        repr.total_bytes;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta,
+            sizeof (meta)))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, fd_info.handle))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, fd_info.flags))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, fd_info.maxsize))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, fd_info.offset))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, fd_info.size))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, fd_info.generation))
+      goto write_failed;
+
+    GST_TRACE_OBJECT (comm->element, "Passing buffer %u by fd %d, handle %u",
+        comm->send_id, fd_info.flags & FD_BUFFER_FLAG_FD_ATTACHED ?
+        fd_info.fd : -1, fd_info.handle);
+    if (fd_info.flags & FD_BUFFER_FLAG_FD_ATTACHED) {
+      if (!write_byte_writer_to_fd_with_fd (comm, &bw, fd_info.fd))
+        goto write_failed;
+    } else {
+      if (!write_byte_writer_to_fd (comm, &bw))
+        goto write_failed;
+    }
+  } else
+#endif
+  {
+    size =
+        gst_buffer_get_size (buffer) + sizeof (guint32) +
+        sizeof (CommBufferMetadata) + repr.total_bytes;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta,
+            sizeof (meta)))
+      goto write_failed;
+    size = gst_buffer_get_size (buffer);
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto write_failed;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      goto map_failed;
+    ret = write_to_fd_raw (comm, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    if (!ret)
+      goto write_failed;
+  }
 
   /* meta */
   gst_byte_writer_init (&bw);
@@ -595,10 +1073,21 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   if (!write_byte_writer_to_fd (comm, &bw))
     goto write_failed;
 
-  if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
-          ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
-    goto wait_failed;
-  ret = ret32;
+  if (async) {
+    CommRequest *req;
+
+    req = comm_request_new (comm->send_id, COMM_REQUEST_TYPE_BUFFER, NULL);
+    req->async = TRUE;
+    g_hash_table_insert (comm->waiting_ids, GINT_TO_POINTER (comm->send_id),
+        req);
+    comm->in_flight++;
+    ret = GST_FLOW_OK;
+  } else {
+    if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
+            ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
+      goto wait_failed;
+    ret = ret32;
+  }
 
 done:
   g_mutex_unlock (&comm->mutex);
@@ -609,6 +1098,10 @@ done:
   return ret;
 
 write_failed:
+#ifdef HAVE_FD_PASSING
+  if (payload_type == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER)
+    gst_ipc_pipeline_comm_cancel_fd_buffer (comm, &fd_info);
+#endif
   GST_ELEMENT_ERROR (comm->element, RESOURCE, WRITE, (NULL),
       ("Failed to write to socket"));
   ret = GST_FLOW_COMM_ERROR;
@@ -627,44 +1120,28 @@ map_failed:
   goto done;
 }
 
-static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+static void
+gst_ipc_pipeline_comm_set_buffer_metadata (GstBuffer * buffer,
+    const CommBufferMetadata * meta)
+{
+  GST_BUFFER_PTS (buffer) = meta->pts;
+  GST_BUFFER_DTS (buffer) = meta->dts;
+  GST_BUFFER_DURATION (buffer) = meta->duration;
+  GST_BUFFER_OFFSET (buffer) = meta->offset;
+  GST_BUFFER_OFFSET_END (buffer) = meta->offset_end;
+  GST_BUFFER_FLAGS (buffer) = meta->flags & ~COMM_BUFFER_FLAG_ASYNC;
+  if (meta->flags & COMM_BUFFER_FLAG_ASYNC)
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (buffer), QUARK_ASYNC,
+        GINT_TO_POINTER (1), NULL);
+}
+
+static gboolean
+gst_ipc_pipeline_comm_read_buffer_metas (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, guint32 size)
 {
-  GstBuffer *buffer;
-  CommBufferMetadata meta;
   guint32 n_meta, n;
   const guint8 *payload = NULL;
-  guint32 mapped_size, buffer_data_size;
-
-  /* this should not be called if we don't have enough yet */
-  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
-  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
-
-  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
-  payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload)
-    return NULL;
-  memcpy (&meta, payload, sizeof (CommBufferMetadata));
-  payload += sizeof (CommBufferMetadata);
-  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
-  size -= mapped_size;
-  gst_adapter_unmap (comm->adapter);
-  gst_adapter_flush (comm->adapter, mapped_size);
-
-  if (buffer_data_size == 0) {
-    buffer = gst_buffer_new ();
-  } else {
-    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
-    gst_adapter_flush (comm->adapter, buffer_data_size);
-  }
-  size -= buffer_data_size;
-
-  GST_BUFFER_PTS (buffer) = meta.pts;
-  GST_BUFFER_DTS (buffer) = meta.dts;
-  GST_BUFFER_DURATION (buffer) = meta.duration;
-  GST_BUFFER_OFFSET (buffer) = meta.offset;
-  GST_BUFFER_OFFSET_END (buffer) = meta.offset_end;
-  GST_BUFFER_FLAGS (buffer) = meta.flags;
+  guint32 mapped_size;
 
   /* If you don't call that, the GType isn't yet known at the
      g_type_from_name below */
@@ -672,10 +1149,8 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
 
   mapped_size = size;
   payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload) {
-    gst_buffer_unref (buffer);
-    return NULL;
-  }
+  if (!payload)
+    return FALSE;
   memcpy (&n_meta, payload, sizeof (n_meta));
   payload += sizeof (n_meta);
 
@@ -724,7 +1199,256 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
   gst_adapter_unmap (comm->adapter);
   gst_adapter_flush (comm->adapter, mapped_size);
 
+  return TRUE;
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  const guint8 *payload = NULL;
+  guint32 mapped_size, buffer_data_size;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  if (buffer_data_size == 0) {
+    buffer = gst_buffer_new ();
+  } else {
+    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
+    gst_adapter_flush (comm->adapter, buffer_data_size);
+  }
+  size -= buffer_data_size;
+
+  gst_ipc_pipeline_comm_set_buffer_metadata (buffer, &meta);
+
+  if (!gst_ipc_pipeline_comm_read_buffer_metas (comm, buffer, size)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  return buffer;
+}
+
+static GstIpcPipelineCommFdCache *
+gst_ipc_pipeline_comm_fd_cache_new (GstIpcPipelineComm * comm)
+{
+  GstIpcPipelineCommFdCache *cache;
+  guint i;
+
+  cache = g_new0 (GstIpcPipelineCommFdCache, 1);
+  cache->refcount = 1;
+  g_mutex_init (&cache->lock);
+  cache->comm = comm;
+  cache->allocator = gst_fd_allocator_new ();
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++)
+    cache->fds[i] = -1;
+
+  return cache;
+}
+
+static GstIpcPipelineCommFdCache *
+gst_ipc_pipeline_comm_fd_cache_ref (GstIpcPipelineCommFdCache * cache)
+{
+  g_atomic_int_inc (&cache->refcount);
+  return cache;
+}
+
+static void
+gst_ipc_pipeline_comm_fd_cache_unref (GstIpcPipelineCommFdCache * cache)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&cache->refcount))
+    return;
+
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++) {
+    if (cache->fds[i] >= 0)
+      close (cache->fds[i]);
+  }
+  gst_object_unref (cache->allocator);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+static void
+gst_ipc_pipeline_comm_write_fd_release_to_fd (GstIpcPipelineComm * comm,
+    guint32 handle, guint32 generation)
+{
+  const unsigned char payload_type =
+      GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_RELEASE;
+  GstByteWriter bw;
+
+  g_mutex_lock (&comm->mutex);
+
+  GST_TRACE_OBJECT (comm->element, "Writing FD_RELEASE for handle %u",
+      handle);
+  gst_byte_writer_init (&bw);
+  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, handle))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, 4))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, generation))
+    goto write_failed;
+
+  if (!write_byte_writer_to_fd (comm, &bw))
+    goto write_failed;
+
+done:
+  g_mutex_unlock (&comm->mutex);
+  gst_byte_writer_reset (&bw);
+  return;
+
+write_failed:
+  /* the peer may already be gone, this is not worth an error */
+  GST_WARNING_OBJECT (comm->element, "Failed to write FD_RELEASE");
+  goto done;
+}
+
+typedef struct
+{
+  GstIpcPipelineCommFdCache *cache;
+  guint32 handle;
+  guint32 generation;
+} FdRelease;
+
+/* Called when the last user of a memory passed by fd is gone, possibly
+ * after the comm was cleared */
+static void
+fd_memory_released (gpointer user_data, GstMiniObject * obj)
+{
+  FdRelease *release = user_data;
+  GstIpcPipelineCommFdCache *cache = release->cache;
+
+  g_mutex_lock (&cache->lock);
+  if (cache->comm)
+    gst_ipc_pipeline_comm_write_fd_release_to_fd (cache->comm,
+        release->handle, release->generation);
+  g_mutex_unlock (&cache->lock);
+
+  gst_ipc_pipeline_comm_fd_cache_unref (cache);
+  g_free (release);
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_fd_buffer (GstIpcPipelineComm * comm,
+    guint32 size)
+{
+  GstIpcPipelineCommFdCache *cache = comm->fd_cache;
+  GstBuffer *buffer;
+  GstMemory *mem;
+  CommBufferMetadata meta;
+  CommFdBufferInfo info;
+  FdRelease *release;
+  const guint8 *payload = NULL;
+  guint32 mapped_size;
+  int fd = -1;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >=
+      sizeof (CommBufferMetadata) + COMM_FD_BUFFER_INFO_SIZE, NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + COMM_FD_BUFFER_INFO_SIZE;
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  info.handle = GST_READ_UINT32_LE (payload);
+  info.flags = GST_READ_UINT32_LE (payload + 4);
+  info.maxsize = GST_READ_UINT64_LE (payload + 8);
+  info.offset = GST_READ_UINT64_LE (payload + 16);
+  info.size = GST_READ_UINT32_LE (payload + 24);
+  info.generation = GST_READ_UINT32_LE (payload + 28);
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  if (info.flags & FD_BUFFER_FLAG_FD_ATTACHED) {
+    if (g_queue_is_empty (&comm->received_fds))
+      goto no_fd;
+    fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds));
+  }
+
+  if (info.flags & FD_BUFFER_FLAG_SEGMENT) {
+    if (info.handle >= GST_IPC_PIPELINE_COMM_N_SEGMENTS) {
+      if (fd >= 0)
+        close (fd);
+      goto no_fd;
+    }
+
+    /* segments are cached and recycled by the sender, which only replaces
+     * them once all their memories are released */
+    g_mutex_lock (&cache->lock);
+    if (fd >= 0) {
+      if (cache->fds[info.handle] >= 0)
+        close (cache->fds[info.handle]);
+      cache->fds[info.handle] = fd;
+    }
+    fd = cache->fds[info.handle];
+    g_mutex_unlock (&cache->lock);
+    if (fd < 0)
+      goto no_fd;
+
+    mem = gst_fd_allocator_alloc (cache->allocator, fd, info.maxsize,
+        GST_FD_MEMORY_FLAG_DONT_CLOSE);
+  } else {
+    if (fd < 0)
+      goto no_fd;
+
+    mem = gst_fd_allocator_alloc (cache->allocator, fd, info.maxsize,
+        GST_FD_MEMORY_FLAG_NONE);
+  }
+
+  if (!mem) {
+    GST_ERROR_OBJECT (comm->element, "Failed to wrap fd %d", fd);
+    gst_adapter_flush (comm->adapter, size);
+    return NULL;
+  }
+
+  /* the sender reuses the memory when we are done, it must not be written */
+  gst_memory_resize (mem, info.offset, info.size);
+  GST_MINI_OBJECT_FLAG_SET (mem, GST_MEMORY_FLAG_READONLY);
+
+  release = g_new (FdRelease, 1);
+  release->cache = gst_ipc_pipeline_comm_fd_cache_ref (cache);
+  release->handle = info.handle;
+  release->generation = info.generation;
+  gst_mini_object_weak_ref (GST_MINI_OBJECT_CAST (mem), fd_memory_released,
+      release);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+  gst_ipc_pipeline_comm_set_buffer_metadata (buffer, &meta);
+
+  if (!gst_ipc_pipeline_comm_read_buffer_metas (comm, buffer, size)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
   return buffer;
+
+no_fd:
+  GST_ERROR_OBJECT (comm->element, "No fd for buffer with handle %u",
+      info.handle);
+  gst_adapter_flush (comm->adapter, size);
+  return NULL;
 }
 
 static gboolean
@@ -745,6 +1469,7 @@ gst_ipc_pipeline_comm_write_sink_message_event_to_fd (GstIpcPipelineComm * comm,
       FALSE);
 
   g_mutex_lock (&comm->mutex);
+  gst_ipc_pipeline_comm_drain_async_buffers (comm);
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element,
@@ -909,12 +1634,28 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
   char *str = NULL;
   const GstStructure *structure;
   GstByteWriter bw;
+  GstFlowReturn async_ret = GST_FLOW_OK;
 
   /* we special case sink-message event as gst can't serialize/de-serialize it */
   if (GST_EVENT_TYPE (event) == GST_EVENT_SINK_MESSAGE)
     return gst_ipc_pipeline_comm_write_sink_message_event_to_fd (comm, event);
 
   g_mutex_lock (&comm->mutex);
+  if (!upstream && GST_EVENT_IS_SERIALIZED (event)) {
+    gst_ipc_pipeline_comm_drain_async_buffers (comm);
+    /* results from before a flush or a new stream are not relevant anymore */
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP
+        || GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START) {
+      comm->async_ret = GST_FLOW_OK;
+    } else if (comm->async_ret != GST_FLOW_OK) {
+      async_ret = comm->async_ret;
+      GST_DEBUG_OBJECT (comm->element, "A buffer before %s event failed: %s",
+          GST_EVENT_TYPE_NAME (event), gst_flow_get_name (async_ret));
+      /* no buffer follows to report it to */
+      if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+        comm->async_ret = GST_FLOW_OK;
+    }
+  }
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element, "Writing event %u: %" GST_PTR_FORMAT,
@@ -976,6 +1717,15 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
     goto write_failed;
   ret = ret32;
 
+  /* the event still goes through, but fails like it would on a pad that
+   * returned the failure */
+  if (async_ret != GST_FLOW_OK) {
+    ret = FALSE;
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS
+        && (async_ret == GST_FLOW_NOT_LINKED || async_ret < GST_FLOW_EOS))
+      GST_ELEMENT_FLOW_ERROR (comm->element, async_ret);
+  }
+
 done:
   g_mutex_unlock (&comm->mutex);
   g_free (str);
@@ -1055,6 +1805,8 @@ gst_ipc_pipeline_comm_write_query_to_fd (GstIpcPipelineComm * comm,
   GstByteWriter bw;
 
   g_mutex_lock (&comm->mutex);
+  if (!upstream && GST_QUERY_IS_SERIALIZED (query))
+    gst_ipc_pipeline_comm_drain_async_buffers (comm);
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element, "Writing query %u: %" GST_PTR_FORMAT,
@@ -1604,24 +2356,56 @@ done:
 void
 gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
 {
+  guint i;
+
   g_mutex_init (&comm->mutex);
   comm->element = element;
   comm->fdin = comm->fdout = -1;
   comm->ack_time = DEFAULT_ACK_TIME;
+  comm->window_size = 1;
+  comm->async_ret = GST_FLOW_OK;
+  g_cond_init (&comm->window_cond);
   comm->waiting_ids =
       g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
       (GDestroyNotify) comm_request_free);
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+
+  comm->segments_fdout = -1;
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++)
+    comm->segments[i].fd = -1;
+  comm->fd_buffers = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) gst_buffer_unref);
+  comm->next_fd_handle = GST_IPC_PIPELINE_COMM_N_SEGMENTS;
+  g_queue_init (&comm->received_fds);
+  comm->fd_cache = gst_ipc_pipeline_comm_fd_cache_new (comm);
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+#ifdef HAVE_FD_PASSING
+  guint i;
+
+  for (i = 0; i < GST_IPC_PIPELINE_COMM_N_SEGMENTS; i++)
+    gst_ipc_pipeline_comm_segment_clear (&comm->segments[i]);
+#endif
+  g_hash_table_destroy (comm->fd_buffers);
+  while (!g_queue_is_empty (&comm->received_fds))
+    close (GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds)));
+
+  /* memories still in use elsewhere keep the cache, but can no longer
+   * notify us */
+  g_mutex_lock (&comm->fd_cache->lock);
+  comm->fd_cache->comm = NULL;
+  g_mutex_unlock (&comm->fd_cache->lock);
+  gst_ipc_pipeline_comm_fd_cache_unref (comm->fd_cache);
+
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
+  g_cond_clear (&comm->window_cond);
   g_mutex_clear (&comm->mutex);
 }
 
@@ -1640,20 +2424,27 @@ cancel_request (gpointer key, gpointer value, gpointer user_data,
   g_cond_signal (&req->cond);
 }
 
-static void
+static gboolean
 cancel_request_error (gpointer key, gpointer value, gpointer user_data)
 {
   CommRequest *req = (CommRequest *) value;
   GstFlowReturn fret = comm_request_ret_get_failure_value (req->type);
 
+  /* nobody waits for async requests, drop them right away */
+  if (req->async) {
+    comm_request_complete_async ((GstIpcPipelineComm *) user_data, req, fret);
+    return TRUE;
+  }
+
   cancel_request (key, value, user_data, fret);
+  return FALSE;
 }
 
 void
 gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm, gboolean cleanup)
 {
   g_mutex_lock (&comm->mutex);
-  g_hash_table_foreach (comm->waiting_ids, cancel_request_error, comm);
+  g_hash_table_foreach_remove (comm->waiting_ids, cancel_request_error, comm);
   if (cleanup) {
     g_hash_table_unref (comm->waiting_ids);
     comm->waiting_ids =
@@ -1685,6 +2476,12 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
     return FALSE;
   }
 
+  if (req->async) {
+    comm_request_complete_async (comm, req, ret);
+    g_hash_table_remove (comm->waiting_ids, GINT_TO_POINTER (id));
+    return TRUE;
+  }
+
   GST_TRACE_OBJECT (comm->element, "Got reply %d (%s) for request %u", ret,
       comm_request_ret_get_name (req->type, ret), req->id);
   req->replied = TRUE;
@@ -1706,6 +2503,79 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+static ssize_t
+read_from_fd (GstIpcPipelineComm * comm, void *data, size_t size)
+{
+#ifdef HAVE_FD_PASSING
+  /* fds passed along with buffers are queued until their chunk is read */
+  if (comm->fdin_is_socket) {
+    struct msghdr msg = { 0, };
+    struct iovec iov;
+    union
+    {
+      char buf[CMSG_SPACE (sizeof (int) * MAX_RECEIVED_FDS)];
+      struct cmsghdr align;
+    } control;
+    struct cmsghdr *cmsg;
+    ssize_t sz;
+
+    iov.iov_base = data;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    sz = recvmsg (comm->pollFDin.fd, &msg, MSG_CMSG_CLOEXEC);
+    if (sz <= 0)
+      return sz;
+
+    if (msg.msg_flags & MSG_CTRUNC)
+      GST_WARNING_OBJECT (comm->element, "Too many fds received, some lost");
+
+    for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+      guint i, n_fds;
+
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        continue;
+
+      n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+      for (i = 0; i < n_fds; i++) {
+        int fd;
+
+        memcpy (&fd, CMSG_DATA (cmsg) + i * sizeof (int), sizeof (int));
+        GST_TRACE_OBJECT (comm->element, "Received fd %d", fd);
+        g_queue_push_tail (&comm->received_fds, GINT_TO_POINTER (fd));
+      }
+    }
+
+    return sz;
+  }
+#endif
+
+  return read (comm->pollFDin.fd, data, size);
+}
+
+typedef struct
+{
+  GstIpcPipelineComm *comm;
+  guint32 id;
+} BufferAcks;
+
+static gboolean
+ack_async_buffer (gpointer key, gpointer value, gpointer user_data)
+{
+  CommRequest *req = (CommRequest *) value;
+  BufferAcks *acks = user_data;
+
+  /* ids wrap around, compare them as a distance */
+  if (!req->async || (gint32) (req->id - acks->id) > 0)
+    return FALSE;
+
+  comm_request_complete_async (acks->comm, req, GST_FLOW_OK);
+  return TRUE;
+}
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1733,6 +2603,14 @@ again:
       comm->pollFDin.fd = comm->fdin;
       gst_poll_add_fd (comm->poll, &comm->pollFDin);
       gst_poll_fd_ctl_read (comm->poll, &comm->pollFDin, TRUE);
+#ifdef HAVE_FD_PASSING
+      {
+        struct stat st;
+
+        comm->fdin_is_socket = fstat (comm->fdin, &st) == 0
+            && S_ISSOCK (st.st_mode);
+      }
+#endif
     }
   }
 
@@ -1752,7 +2630,7 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+    sz = read_from_fd (comm, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1817,6 +2695,9 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_RELEASE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_ACKS:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1853,6 +2734,27 @@ read_many (GstIpcPipelineComm * comm)
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
       }
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_ACKS:
+      {
+        BufferAcks acks = { comm, comm->id };
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        /* all async buffers up to this id were pushed successfully */
+        GST_TRACE_OBJECT (comm->element, "Got BUFFER_ACKS up to id %u",
+            comm->id);
+        g_mutex_lock (&comm->mutex);
+        g_hash_table_foreach_remove (comm->waiting_ids, ack_async_buffer,
+            &acks);
+        g_mutex_unlock (&comm->mutex);
+
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_QUERY_RESULT:
       {
         GstQuery *query = NULL;
@@ -1881,6 +2783,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
       {
         GstBuffer *buf;
 
@@ -1888,7 +2791,11 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+        if (comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER)
+          buf = gst_ipc_pipeline_comm_read_fd_buffer (comm,
+              comm->payload_length);
+        else
+          buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
         if (!buf)
           goto buffer_failed;
 
@@ -1912,6 +2819,49 @@ read_many (GstIpcPipelineComm * comm)
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
       }
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_RELEASE:
+      {
+        guint32 generation;
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+        if (comm->payload_length < 4) {
+          GST_WARNING_OBJECT (comm->element, "Invalid FD_RELEASE of %u bytes",
+              comm->payload_length);
+          gst_adapter_flush (comm->adapter, comm->payload_length);
+          comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+          break;
+        }
+        payload = gst_adapter_map (comm->adapter, 4);
+        generation = GST_READ_UINT32_LE (payload);
+        gst_adapter_unmap (comm->adapter);
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        /* the receiver is done with the buffer passed with this handle */
+        GST_TRACE_OBJECT (comm->element, "Got FD_RELEASE for handle %u, "
+            "generation %u", comm->id, generation);
+        g_mutex_lock (&comm->mutex);
+        if (comm->id < GST_IPC_PIPELINE_COMM_N_SEGMENTS) {
+          GstIpcPipelineCommSegment *segment = &comm->segments[comm->id];
+
+          /* only the release of the current use frees the segment, older
+           * ones can still come in after a failed write made it free */
+          if (segment->generation == generation)
+            segment->busy = FALSE;
+          else
+            GST_DEBUG_OBJECT (comm->element, "Ignoring release of generation "
+                "%u of segment %u, now at %u", generation, comm->id,
+                segment->generation);
+        } else {
+          g_hash_table_remove (comm->fd_buffers, GUINT_TO_POINTER (comm->id));
+        }
+        g_mutex_unlock (&comm->mutex);
+
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_EVENT:
       {
         GstEvent *event;
@@ -2324,6 +3274,7 @@ gst_ipc_pipeline_comm_plugin_init (void)
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_comm_debug, "ipcpipelinecomm", 0,
         "ipc pipeline comm");
     QUARK_ID = g_quark_from_static_string ("ipcpipeline-id");
+    QUARK_ASYNC = g_quark_from_static_string ("ipcpipeline-async");
     REGISTER_SERIALIZATION_NO_COMPARE (gst_event_get_type (), event);
     g_once_init_leave (&once, (gsize) 1);
   }
@@ -32,6 +32,8 @@ G_BEGIN_DECLS
 #define GST_FLOW_COMM_ERROR GST_FLOW_CUSTOM_ERROR_1
 
 extern GQuark QUARK_ID;
+/* set on received buffers whose sender does not wait for their result */
+extern GQuark QUARK_ASYNC;
 
 typedef enum {
   GST_IPC_PIPELINE_COMM_STATE_TYPE = 0,
@@ -51,8 +53,32 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_RELEASE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_ACKS,
 } GstIpcPipelineCommDataType;
 
+/* Number of shared memory segments a sender recycles for passing buffers by
+ * file descriptor. Handles below this value refer to one of them, handles
+ * above refer to a file descriptor memory of the buffer itself. */
+#define GST_IPC_PIPELINE_COMM_N_SEGMENTS 8
+
+typedef struct
+{
+  int fd;
+  gsize size;
+  guint8 *data;
+  /* whether the receiver has the fd already */
+  gboolean sent;
+  /* whether the receiver still uses the contents */
+  gboolean busy;
+  /* bumped every time the segment is handed out, so that a release of a
+   * previous use does not free the current one */
+  guint32 generation;
+} GstIpcPipelineCommSegment;
+
+typedef struct _GstIpcPipelineCommFdCache GstIpcPipelineCommFdCache;
+
 typedef struct
 {
   GstElement *element;
@@ -76,6 +102,29 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* buffers in flight without waiting for their result, sender side */
+  guint window_size;
+  guint in_flight;
+  GstFlowReturn async_ret;
+  GCond window_cond;
+
+  /* successful results not acknowledged yet, receiver side */
+  guint32 pending_ack_id;
+  guint n_pending_acks;
+
+  /* buffers passed as file descriptors, sender side */
+  gboolean pass_fds;
+  int segments_fdout;
+  gboolean fdout_is_socket;
+  GstIpcPipelineCommSegment segments[GST_IPC_PIPELINE_COMM_N_SEGMENTS];
+  GHashTable *fd_buffers;
+  guint32 next_fd_handle;
+
+  /* buffers passed as file descriptors, receiver side */
+  gboolean fdin_is_socket;
+  GQueue received_fds;
+  GstIpcPipelineCommFdCache *fd_cache;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
@@ -95,6 +144,8 @@ void gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm,
 
 void gst_ipc_pipeline_comm_write_flow_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, GstFlowReturn ret);
+void gst_ipc_pipeline_comm_write_buffer_ack_to_fd (GstIpcPipelineComm * comm,
+    guint32 id, gboolean async, GstFlowReturn ret, gboolean flush);
 void gst_ipc_pipeline_comm_write_boolean_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, gboolean ret);
 void gst_ipc_pipeline_comm_write_state_change_ack_to_fd (
@@ -66,7 +66,16 @@
  * GError are serialized differently).
  *
  * Buffers are transported by writing their content directly on the socket.
- * More efficient ways for memory sharing could be implemented in the future.
+ * When #GstIpcPipelineSink:pass-fds is enabled and fdout is a unix socket,
+ * large buffers are passed as file descriptors instead: buffers backed by a
+ * single memfd or dmabuf memory are shared as they are, others are copied
+ * once into one of a few recycled shared memory segments. Each side then
+ * only writes a small header on the socket.
+ *
+ * By default, every buffer waits for the flow return of its push on the
+ * other side, so the throughput is bound by the round-trip time. Setting
+ * #GstIpcPipelineSink:window-size lets several buffers be in flight, with
+ * their flow returns reported asynchronously.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,11 +108,15 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_PASS_FDS,
+  PROP_WINDOW_SIZE,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_PASS_FDS FALSE
+#define DEFAULT_WINDOW_SIZE 1
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -179,6 +192,40 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:pass-fds:
+   *
+   * Pass large buffers as file descriptors over fdout instead of writing
+   * their contents, when fdout is a unix socket. The receiving ipcpipelinesrc
+   * must support this too.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PASS_FDS,
+      g_param_spec_boolean ("pass-fds", "Pass fds",
+          "Pass large buffers as file descriptors when possible",
+          DEFAULT_PASS_FDS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIpcPipelineSink:window-size:
+   *
+   * Maximum number of buffers sent without waiting for their flow return.
+   * With 1, every buffer waits for its flow return from the other side.
+   * With more, a flow return is only reported with one of the following
+   * buffers, and the results of successfully pushed buffers are
+   * acknowledged in batches. Serialized events and queries still wait for
+   * all buffers sent before them, and a serialized event fails if one of
+   * these buffers failed. If no buffer completes within
+   * #GstIpcPipelineSink:ack-time, the buffers in flight fail.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
+      g_param_spec_uint ("window-size", "Window size",
+          "Maximum number of buffers in flight (1 = wait for each buffer)",
+          1, G_MAXINT, DEFAULT_WINDOW_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -214,6 +261,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_ipc_pipeline_comm_init (&sink->comm, GST_ELEMENT (sink));
   sink->comm.read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
   sink->comm.ack_time = DEFAULT_ACK_TIME;
+  sink->comm.pass_fds = DEFAULT_PASS_FDS;
+  sink->comm.window_size = DEFAULT_WINDOW_SIZE;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
@@ -275,6 +324,15 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_PASS_FDS:
+      sink->comm.pass_fds = g_value_get_boolean (value);
+      break;
+    case PROP_WINDOW_SIZE:
+      g_mutex_lock (&sink->comm.mutex);
+      sink->comm.window_size = g_value_get_uint (value);
+      g_cond_broadcast (&sink->comm.window_cond);
+      g_mutex_unlock (&sink->comm.mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -300,6 +358,12 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_PASS_FDS:
+      g_value_set_boolean (value, sink->comm.pass_fds);
+      break;
+    case PROP_WINDOW_SIZE:
+      g_value_set_uint (value, sink->comm.window_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -480,11 +480,21 @@ gst_ipc_pipeline_src_loop (GstIpcPipelineSrc * src)
 
   if (GST_IS_BUFFER (object)) {
     GstBuffer *buf = GST_BUFFER (object);
+    gboolean async, more;
+
+    async = gst_mini_object_get_qdata (GST_MINI_OBJECT (buf), QUARK_ASYNC)
+        != NULL;
     GST_DEBUG_OBJECT (src, "Pushing queued buffer: %" GST_PTR_FORMAT, buf);
     ret = gst_pad_push (src->srcpad, buf);
     GST_DEBUG_OBJECT (src, "pushed id %u, ret: %s", id,
         gst_flow_get_name (ret));
-    gst_ipc_pipeline_comm_write_flow_ack_to_fd (&src->comm, id, ret);
+
+    /* the results of async buffers are sent together once we caught up */
+    g_mutex_lock (&src->comm.mutex);
+    more = src->queued != NULL;
+    g_mutex_unlock (&src->comm.mutex);
+    gst_ipc_pipeline_comm_write_buffer_ack_to_fd (&src->comm, id, async, ret,
+        !more);
   } else if (GST_IS_EVENT (object)) {
     GstEvent *event = GST_EVENT (object);
     GST_DEBUG_OBJECT (src, "Pushing queued event: %" GST_PTR_FORMAT, event);
@@ -58,7 +58,9 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_MEMFD,
+  PROP_HUGE_PAGES
 };
 
 struct GstShmClient
@@ -69,6 +71,8 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_MEMFD (FALSE)
+#define DEFAULT_HUGE_PAGES (FALSE)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -357,6 +361,8 @@ gst_shm_sink_init (GstShmSink * self)
   self->unlock = FALSE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->memfd = DEFAULT_MEMFD;
+  self->huge_pages = DEFAULT_HUGE_PAGES;
 
   gst_allocation_params_init (&self->params);
 }
@@ -419,6 +425,41 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:memfd:
+   *
+   * Back the shared memory with anonymous memory whose file descriptor is
+   * passed to the sources over the control socket instead of a named POSIX
+   * shared memory object. Only sources of the same version or newer can
+   * connect to such a sink.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MEMFD,
+      g_param_spec_boolean ("memfd",
+          "Use anonymous memory",
+          "Pass an anonymous memory file descriptor to the sources instead of "
+          "a shm path. This may be modified during the NULL->READY transition",
+          DEFAULT_MEMFD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShmSink:huge-pages:
+   *
+   * Try to back the shared memory with huge pages, which reduces the TLB
+   * pressure when large raw video frames are written and read. The shm
+   * size is rounded up to a multiple of the huge page size. Falls back to
+   * regular pages if none are available. Only used if #GstShmSink:memfd
+   * is enabled.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_HUGE_PAGES,
+      g_param_spec_boolean ("huge-pages",
+          "Use huge pages",
+          "Try to use huge pages for the anonymous shared memory. "
+          "This may be modified during the NULL->READY transition",
+          DEFAULT_HUGE_PAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -507,6 +548,16 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_MEMFD:
+      GST_OBJECT_LOCK (object);
+      self->memfd = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_HUGE_PAGES:
+      GST_OBJECT_LOCK (object);
+      self->huge_pages = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -536,6 +587,12 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_MEMFD:
+      g_value_set_boolean (value, self->memfd);
+      break;
+    case PROP_HUGE_PAGES:
+      g_value_set_boolean (value, self->huge_pages);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -551,6 +608,7 @@ gst_shm_sink_start (GstBaseSink * bsink)
 {
   GstShmSink *self = GST_SHM_SINK (bsink);
   GError *err = NULL;
+  int flags = 0;
 
   self->stop = FALSE;
 
@@ -563,7 +621,14 @@ gst_shm_sink_start (GstBaseSink * bsink)
   GST_DEBUG_OBJECT (self, "Creating new socket at %s"
       " with shared memory of %d bytes", self->socket_path, self->size);
 
-  self->pipe = sp_writer_create (self->socket_path, self->size, self->perms);
+  if (self->memfd) {
+    flags |= SP_WRITER_MEMFD;
+    if (self->huge_pages)
+      flags |= SP_WRITER_HUGE_PAGES;
+  }
+
+  self->pipe = sp_writer_create_full (self->socket_path, self->size,
+      self->perms, flags);
 
   if (!self->pipe) {
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
@@ -910,22 +975,29 @@ pollthread_func (gpointer data)
 
       if (gst_poll_fd_can_read (self->poll, &gclient->pollfd)) {
         int rv;
-        gpointer tag = NULL;
+        gboolean pending;
 
-        GST_OBJECT_LOCK (self);
-        rv = sp_writer_recv (self->pipe, gclient->client, &tag);
-        GST_OBJECT_UNLOCK (self);
+        /* A client releases buffers in bursts, handle all the acks that
+         * were read at once */
+        do {
+          gpointer tag = NULL;
 
-        if (rv < 0) {
-          GST_WARNING_OBJECT (self, "One client has read error,"
-              " closing (retval: %d errno: %d)", rv, errno);
-          goto close_client;
-        }
+          GST_OBJECT_LOCK (self);
+          rv = sp_writer_recv (self->pipe, gclient->client, &tag);
+          pending = sp_writer_client_has_pending (gclient->client);
+          GST_OBJECT_UNLOCK (self);
+
+          if (rv < 0) {
+            GST_WARNING_OBJECT (self, "One client has read error,"
+                " closing (retval: %d errno: %d)", rv, errno);
+            goto close_client;
+          }
 
-        g_assert (rv == 0 || tag == NULL);
+          g_assert (rv == 0 || tag == NULL);
 
-        if (rv == 0)
-          gst_buffer_unref (tag);
+          if (rv == 0)
+            gst_buffer_unref (tag);
+        } while (pending);
       }
       continue;
     close_client:
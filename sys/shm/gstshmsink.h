@@ -63,6 +63,8 @@ struct _GstShmSink
   gboolean stop;
   gboolean unlock;
   GstClockTimeDiff buffer_time;
+  gboolean memfd;
+  gboolean huge_pages;
 
   GCond cond;
 
@@ -341,7 +341,14 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GST_OBJECT_UNLOCK (self);
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
+    gboolean pending;
+
+    /* Commands read ahead with a previous buffer don't wake up the poll */
+    GST_OBJECT_LOCK (self);
+    pending = sp_client_has_pending (pipe->pipe);
+    GST_OBJECT_UNLOCK (self);
+
+    if (!pending && gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
       if (errno == EBUSY)
         goto flushing;
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -352,19 +359,19 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
     if (self->unlocked)
       goto flushing;
 
-    if (gst_poll_fd_has_closed (self->poll, &self->pollfd)) {
+    if (!pending && gst_poll_fd_has_closed (self->poll, &self->pollfd)) {
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
           ("Control socket has closed"));
       goto error;
     }
 
-    if (gst_poll_fd_has_error (self->poll, &self->pollfd)) {
+    if (!pending && gst_poll_fd_has_error (self->poll, &self->pollfd)) {
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
           ("Control socket has error"));
       goto error;
     }
 
-    if (gst_poll_fd_can_read (self->poll, &self->pollfd)) {
+    if (pending || gst_poll_fd_can_read (self->poll, &self->pollfd)) {
       buf = NULL;
       GST_LOG_OBJECT (self, "Reading from pipe");
       GST_OBJECT_LOCK (self);
@@ -33,6 +33,11 @@
 #include <string.h>
 #include <assert.h>
 
+/* Released blocks are sorted by the position of the highest bit of their
+ * size, so that a block of the same class can be found without walking the
+ * whole chain */
+#define SIZE_CLASSES (sizeof (unsigned long) * 8)
+
 /* This is the allocated space to hold multiple blocks */
 struct _ShmAllocSpace
 {
@@ -41,6 +46,11 @@ struct _ShmAllocSpace
 
   /* chained list of the blocks contained in this space */
   ShmAllocBlock *blocks;
+
+  /* Blocks that are not used anymore but still hold their place in the
+   * chain, per size class */
+  ShmAllocBlock *free_blocks[SIZE_CLASSES];
+  unsigned int num_free_blocks;
 };
 
 /* A single block of data */
@@ -58,8 +68,22 @@ struct _ShmAllocBlock
 
   /* Pointer to the next block in the chain */
   ShmAllocBlock *next;
+
+  /* Pointer to the next released block of the same size class */
+  ShmAllocBlock *next_free;
 };
 
+static unsigned int
+size_class (unsigned long size)
+{
+  unsigned int idx = 0;
+
+  while (size >>= 1)
+    idx++;
+
+  return idx;
+}
+
 
 ShmAllocSpace *
 shm_alloc_space_new (size_t size)
@@ -73,16 +97,76 @@ shm_alloc_space_new (size_t size)
   return self;
 }
 
+/* Drops all the released blocks from the chain to make their space
+ * available to blocks of other sizes */
+static void
+shm_alloc_space_flush_free_blocks (ShmAllocSpace * self)
+{
+  ShmAllocBlock *item = NULL;
+  ShmAllocBlock *prev_item = NULL;
+  ShmAllocBlock *next = NULL;
+
+  if (self->num_free_blocks == 0)
+    return;
+
+  for (item = self->blocks; item; item = next) {
+    next = item->next;
+
+    if (item->use_count > 0) {
+      prev_item = item;
+      continue;
+    }
+
+    if (prev_item)
+      prev_item->next = next;
+    else
+      self->blocks = next;
+    spalloc_free (ShmAllocBlock, item);
+  }
+
+  memset (self->free_blocks, 0, sizeof (self->free_blocks));
+  self->num_free_blocks = 0;
+}
+
 void
 shm_alloc_space_free (ShmAllocSpace * self)
 {
-  assert (self && self->blocks == NULL);
+  assert (self);
+  shm_alloc_space_flush_free_blocks (self);
+  assert (self->blocks == NULL);
   spalloc_free (ShmAllocSpace, self);
 }
 
 
-ShmAllocBlock *
-shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+/* Takes back a released block of the same size class that is big enough,
+ * buffers of a stream mostly all have the same size */
+static ShmAllocBlock *
+shm_alloc_space_reuse_block (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocBlock *item = NULL;
+  ShmAllocBlock *prev_item = NULL;
+  unsigned int idx = size_class (size);
+
+  for (item = self->free_blocks[idx]; item; item = item->next_free) {
+    if (item->size >= size) {
+      if (prev_item)
+        prev_item->next_free = item->next_free;
+      else
+        self->free_blocks[idx] = item->next_free;
+      self->num_free_blocks--;
+
+      item->next_free = NULL;
+      item->use_count = 1;
+      return item;
+    }
+    prev_item = item;
+  }
+
+  return NULL;
+}
+
+static ShmAllocBlock *
+shm_alloc_space_find_block (ShmAllocSpace * self, unsigned long size)
 {
   ShmAllocBlock *block;
   ShmAllocBlock *item = NULL;
@@ -125,31 +209,42 @@ shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
   return block;
 }
 
+ShmAllocBlock *
+shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocBlock *block;
+
+  block = shm_alloc_space_reuse_block (self, size);
+  if (block)
+    return block;
+
+  block = shm_alloc_space_find_block (self, size);
+  if (block || self->num_free_blocks == 0)
+    return block;
+
+  /* The space may only be full of released blocks of other sizes */
+  shm_alloc_space_flush_free_blocks (self);
+
+  return shm_alloc_space_find_block (self, size);
+}
+
 unsigned long
 shm_alloc_space_alloc_block_get_offset (ShmAllocBlock * block)
 {
   return block->offset;
 }
 
+/* The block keeps its place in the chain until it is either reused for a
+ * buffer of the same size class or flushed when the space is full */
 static void
 shm_alloc_space_free_block (ShmAllocBlock * block)
 {
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
   ShmAllocSpace *self = block->space;
+  unsigned int idx = size_class (block->size);
 
-  for (item = self->blocks; item; item = item->next) {
-    if (item == block) {
-      if (prev_item)
-        prev_item->next = item->next;
-      else
-        self->blocks = item->next;
-      break;
-    }
-    prev_item = item;
-  }
-
-  spalloc_free (ShmAllocBlock, block);
+  block->next_free = self->free_blocks[idx];
+  self->free_blocks[idx] = block;
+  self->num_free_blocks++;
 }
 
 ShmAllocBlock *
@@ -158,7 +253,8 @@ shm_alloc_space_block_get (ShmAllocSpace * self, unsigned long offset)
   ShmAllocBlock *block = NULL;
 
   for (block = self->blocks; block; block = block->next) {
-    if (block->offset <= offset && (block->offset + block->size) > offset)
+    if (block->use_count > 0 && block->offset <= offset &&
+        (block->offset + block->size) > offset)
       return block;
   }
 
@@ -177,6 +273,6 @@ shm_alloc_space_block_dec (ShmAllocBlock * block)
 {
   block->use_count--;
 
-  if (block->use_count <= 0)
+  if (block->use_count == 0)
     shm_alloc_space_free_block (block);
 }
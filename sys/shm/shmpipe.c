@@ -22,6 +22,10 @@
  * THE SOFTWARE.
  */
 
+/* for memfd_create () */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -56,6 +60,8 @@
  * type 1: new shm area
  * Area length
  * Size of path (followed by path)
+ * If the size of the path is 0, the area is anonymous and its file
+ * descriptor is passed along with the packet as SCM_RIGHTS
  *
  * type 2: Close shm area:
  * No payload
@@ -75,6 +81,11 @@
 
 #define LISTEN_BACKLOG 10
 
+/* Commands are read ahead in chunks, so that a burst of buffers or acks
+ * only costs one syscall */
+#define RECV_BUF_SIZE 4096
+#define MAX_RECV_FDS 4
+
 enum
 {
   COMMAND_NEW_SHM_AREA = 1,
@@ -84,6 +95,7 @@ enum
 };
 
 typedef struct _ShmArea ShmArea;
+typedef struct _ShmRecvBuf ShmRecvBuf;
 
 struct _ShmArea
 {
@@ -104,6 +116,17 @@ struct _ShmArea
   ShmArea *next;
 };
 
+struct _ShmRecvBuf
+{
+  char *data;
+  size_t start;
+  size_t end;
+
+  /* File descriptors received along with the data and not claimed yet */
+  int fds[MAX_RECV_FDS];
+  int num_fds;
+};
+
 struct _ShmBuffer
 {
   int use_count;
@@ -132,9 +155,12 @@ struct _ShmPipe
   void *data;
 
   ShmArea *shm_area;
+  int area_flags;
 
   int next_area_id;
 
+  ShmRecvBuf recv_buf;
+
   ShmBuffer *buffers;
 
   int num_clients;
@@ -147,6 +173,8 @@ struct _ShmClient
 {
   int fd;
 
+  ShmRecvBuf recv_buf;
+
   ShmClient *next;
 };
 
@@ -182,7 +210,8 @@ struct CommandBuffer
   } payload;
 };
 
-static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size);
+static ShmArea *sp_open_shm (char *path, int fd, int id, mode_t perms,
+    size_t size, int flags);
 static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
@@ -196,8 +225,35 @@ static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
   return NULL;                                          \
   } while (0)
 
+static void
+sp_recv_buf_clear (ShmRecvBuf * rb)
+{
+  int i;
+
+  for (i = 0; i < rb->num_fds; i++)
+    close (rb->fds[i]);
+  rb->num_fds = 0;
+
+  free (rb->data);
+  rb->data = NULL;
+  rb->start = rb->end = 0;
+}
+
 ShmPipe *
 sp_writer_create (const char *path, size_t size, mode_t perms)
+{
+  return sp_writer_create_full (path, size, perms, 0);
+}
+
+/* sp_writer_create_full:
+ * @area_flags: #SP_WRITER_MEMFD to back the areas with anonymous memory whose
+ *  file descriptor is passed to the readers, this requires readers that
+ *  support it. #SP_WRITER_HUGE_PAGES to also try to use huge pages.
+ */
+
+ShmPipe *
+sp_writer_create_full (const char *path, size_t size, mode_t perms,
+    int area_flags)
 {
   ShmPipe *self = spalloc_new (ShmPipe);
   int flags;
@@ -244,7 +300,9 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
   if (listen (self->main_socket, LISTEN_BACKLOG) < 0)
     RETURN_ERROR ("listen() failed (%d): %s\n", errno, strerror (errno));
 
-  self->shm_area = sp_open_shm (NULL, ++self->next_area_id, perms, size);
+  self->area_flags = area_flags;
+  self->shm_area = sp_open_shm (NULL, -1, ++self->next_area_id, perms, size,
+      area_flags);
 
   self->perms = perms;
 
@@ -263,15 +321,109 @@ sp_writer_create (const char *path, size_t size, mode_t perms)
   return NULL;                                            \
   } while (0)
 
+#if defined(HAVE_MEMFD_CREATE) && defined(MFD_HUGETLB)
+/* Size of the default huge pages, which hugetlb memfds are a multiple of,
+ * or 0 if unknown */
+static size_t
+sp_get_huge_page_size (void)
+{
+  char line[128];
+  unsigned long kb = 0;
+  FILE *f;
+
+  f = fopen ("/proc/meminfo", "r");
+  if (!f)
+    return 0;
+
+  while (fgets (line, sizeof (line), f)) {
+    if (sscanf (line, "Hugepagesize: %lu kB", &kb) == 1)
+      break;
+  }
+  fclose (f);
+
+  return (size_t) kb * 1024;
+}
+#endif
+
+/* Creates an anonymous area, using huge pages if requested and if any are
+ * available, falling back to regular pages otherwise */
+static int
+sp_open_memfd (ShmArea * area, size_t size, int flags)
+{
+#ifdef HAVE_MEMFD_CREATE
+#ifdef MFD_HUGETLB
+  size_t huge_page_size = 0;
+
+  if (flags & SP_WRITER_HUGE_PAGES)
+    huge_page_size = sp_get_huge_page_size ();
+
+  if (huge_page_size > 0) {
+    size_t huge_size =
+        (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+    area->shm_fd = memfd_create ("shmpipe", MFD_CLOEXEC | MFD_HUGETLB);
+    if (area->shm_fd >= 0) {
+      /* Huge pages are reserved by the mmap(), which fails if there are not
+       * enough of them */
+      if (ftruncate (area->shm_fd, huge_size) == 0)
+        area->shm_area_buf = mmap (NULL, huge_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, area->shm_fd, 0);
+
+      if (area->shm_area_buf != MAP_FAILED) {
+        area->shm_area_len = huge_size;
+        return 0;
+      }
+    }
+
+    fprintf (stderr, "Could not allocate %lu bytes of huge pages (%d): %s,"
+        " using regular pages\n", (unsigned long) huge_size, errno,
+        strerror (errno));
+
+    if (area->shm_fd >= 0) {
+      close (area->shm_fd);
+      area->shm_fd = -1;
+    }
+  }
+#endif
+
+  area->shm_fd = memfd_create ("shmpipe", MFD_CLOEXEC);
+  if (area->shm_fd < 0)
+    return -1;
+
+  if (ftruncate (area->shm_fd, size))
+    return -1;
+
+  area->shm_area_buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      area->shm_fd, 0);
+  if (area->shm_area_buf == MAP_FAILED)
+    return -1;
+
+#ifdef MADV_HUGEPAGE
+  /* Transparent huge pages for shmem are only used if the system is
+   * configured to honour the advice */
+  if (flags & SP_WRITER_HUGE_PAGES)
+    madvise (area->shm_area_buf, size, MADV_HUGEPAGE);
+#endif
+
+  return 0;
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
 /* sp_open_shm:
  * @path: Path of the shm area for a reader,
  *  NULL if this is a writer (then it will allocate its own path)
+ * @fd: File descriptor of an anonymous area for a reader, or -1
+ * @area_flags: #SP_WRITER_MEMFD to create an anonymous area as a writer
  *
  * Opens a ShmArea
  */
 
 static ShmArea *
-sp_open_shm (char *path, int id, mode_t perms, size_t size)
+sp_open_shm (char *path, int fd, int id, mode_t perms, size_t size,
+    int area_flags)
 {
   ShmArea *area = spalloc_new (ShmArea);
   char tmppath[32];
@@ -286,8 +438,25 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
 
   area->shm_area_len = size;
 
-  area->is_writer = (path == NULL);
+  area->is_writer = (path == NULL && fd < 0);
+
+  area->id = id;
 
+  if (fd >= 0) {
+    area->shm_fd = fd;
+    area->shm_area_buf = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (area->shm_area_buf == MAP_FAILED)
+      RETURN_ERROR ("mmap failed (%d): %s\n", errno, strerror (errno));
+    return area;
+  }
+
+  if (area->is_writer && (area_flags & SP_WRITER_MEMFD)) {
+    if (sp_open_memfd (area, size, area_flags) < 0)
+      RETURN_ERROR ("Could not create anonymous memory area (%d): %s\n",
+          errno, strerror (errno));
+    area->allocspace = shm_alloc_space_new (area->shm_area_len);
+    return area;
+  }
 
   if (path)
     flags = O_RDONLY;
@@ -331,8 +500,6 @@ sp_open_shm (char *path, int id, mode_t perms, size_t size)
   if (area->shm_area_buf == MAP_FAILED)
     RETURN_ERROR ("mmap failed (%d): %s\n", errno, strerror (errno));
 
-  area->id = id;
-
   if (!path)
     area->allocspace = shm_alloc_space_new (area->shm_area_len);
 
@@ -425,6 +592,8 @@ sp_dec (ShmPipe * self)
   while (self->shm_area)
     sp_shm_area_dec (self, self->shm_area);
 
+  sp_recv_buf_clear (&self->recv_buf);
+
   spalloc_free (ShmPipe, self);
 }
 
@@ -484,6 +653,55 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+/* Sends the command with the path of the area in a single message, or with
+ * its file descriptor if it is anonymous */
+static int
+send_new_area (int fd, ShmArea * area)
+{
+  struct CommandBuffer cb = { 0 };
+  struct msghdr msg = { 0 };
+  struct iovec iov[2];
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } cmsg;
+  size_t len = sizeof (struct CommandBuffer);
+
+  cb.type = COMMAND_NEW_SHM_AREA;
+  cb.area_id = area->id;
+  cb.payload.new_shm_area.size = area->shm_area_len;
+
+  iov[0].iov_base = &cb;
+  iov[0].iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 1;
+
+  if (area->shm_area_name) {
+    cb.payload.new_shm_area.path_size = strlen (area->shm_area_name) + 1;
+    iov[1].iov_base = area->shm_area_name;
+    iov[1].iov_len = cb.payload.new_shm_area.path_size;
+    msg.msg_iovlen = 2;
+    len += iov[1].iov_len;
+  } else {
+    struct cmsghdr *hdr;
+
+    memset (&cmsg, 0, sizeof (cmsg));
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof (cmsg.buf);
+    hdr = CMSG_FIRSTHDR (&msg);
+    hdr->cmsg_level = SOL_SOCKET;
+    hdr->cmsg_type = SCM_RIGHTS;
+    hdr->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (hdr), &area->shm_fd, sizeof (int));
+  }
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != (ssize_t) len)
+    return 0;
+
+  return 1;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -491,12 +709,12 @@ sp_writer_resize (ShmPipe * self, size_t size)
   ShmArea *old_current;
   ShmClient *client;
   int c = 0;
-  int pathlen;
 
   if (self->shm_area->shm_area_len == size)
     return 0;
 
-  newarea = sp_open_shm (NULL, ++self->next_area_id, self->perms, size);
+  newarea = sp_open_shm (NULL, -1, ++self->next_area_id, self->perms, size,
+      self->area_flags);
 
   if (!newarea)
     return -1;
@@ -505,8 +723,6 @@ sp_writer_resize (ShmPipe * self, size_t size)
   newarea->next = self->shm_area;
   self->shm_area = newarea;
 
-  pathlen = strlen (newarea->shm_area_name) + 1;
-
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
 
@@ -514,13 +730,7 @@ sp_writer_resize (ShmPipe * self, size_t size)
             old_current->id))
       continue;
 
-    cb.payload.new_shm_area.size = newarea->shm_area_len;
-    cb.payload.new_shm_area.path_size = pathlen;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_SHM_AREA, newarea->id))
-      continue;
-
-    if (send (client->fd, newarea->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-        pathlen)
+    if (!send_new_area (client->fd, newarea))
       continue;
     c++;
   }
@@ -638,17 +848,103 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
   return c;
 }
 
+/* Makes sure at least @needed bytes are in the read ahead buffer. Only the
+ * first read may fail with EAGAIN, the rest of a partially received
+ * message follows right away.
+ */
 static int
-recv_command (int fd, struct CommandBuffer *cb)
+recv_fill (int fd, ShmRecvBuf * rb, size_t needed)
 {
-  int retval;
+  if (!rb->data)
+    rb->data = malloc (RECV_BUF_SIZE);
+
+  while (rb->end - rb->start < needed) {
+    struct msghdr msg = { 0 };
+    struct iovec iov;
+    struct cmsghdr *hdr;
+    union
+    {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE (sizeof (int) * MAX_RECV_FDS)];
+    } cmsg;
+    int flags = 0;
+    ssize_t retval;
+
+    if (rb->start > 0) {
+      memmove (rb->data, rb->data + rb->start, rb->end - rb->start);
+      rb->end -= rb->start;
+      rb->start = 0;
+    }
 
-  retval = recv (fd, cb, sizeof (struct CommandBuffer), MSG_DONTWAIT);
-  if (retval == sizeof (struct CommandBuffer)) {
-    return 1;
-  } else {
-    return 0;
+    iov.iov_base = rb->data + rb->end;
+    iov.iov_len = RECV_BUF_SIZE - rb->end;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof (cmsg.buf);
+
+    if (rb->end == 0)
+      flags |= MSG_DONTWAIT;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+    retval = recvmsg (fd, &msg, flags);
+    if (retval <= 0)
+      return 0;
+    rb->end += retval;
+
+    for (hdr = CMSG_FIRSTHDR (&msg); hdr; hdr = CMSG_NXTHDR (&msg, hdr)) {
+      int *fds = (int *) CMSG_DATA (hdr);
+      int i, n;
+
+      if (hdr->cmsg_level != SOL_SOCKET || hdr->cmsg_type != SCM_RIGHTS)
+        continue;
+
+      n = (hdr->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+      for (i = 0; i < n; i++) {
+        if (rb->num_fds < MAX_RECV_FDS)
+          rb->fds[rb->num_fds++] = fds[i];
+        else
+          close (fds[i]);
+      }
+    }
   }
+
+  return 1;
+}
+
+static int
+recv_command (int fd, ShmRecvBuf * rb, struct CommandBuffer *cb)
+{
+  if (!recv_fill (fd, rb, sizeof (struct CommandBuffer)))
+    return 0;
+
+  memcpy (cb, rb->data + rb->start, sizeof (struct CommandBuffer));
+  rb->start += sizeof (struct CommandBuffer);
+
+  return 1;
+}
+
+static int
+recv_buf_has_command (ShmRecvBuf * rb)
+{
+  return rb->end - rb->start >= sizeof (struct CommandBuffer);
+}
+
+static int
+recv_buf_take_fd (ShmRecvBuf * rb)
+{
+  int fd;
+
+  if (rb->num_fds == 0)
+    return -1;
+
+  fd = rb->fds[0];
+  rb->num_fds--;
+  memmove (rb->fds, rb->fds + 1, sizeof (int) * rb->num_fds);
+
+  return fd;
 }
 
 long int
@@ -658,28 +954,45 @@ sp_client_recv (ShmPipe * self, char **buf)
   ShmArea *newarea;
   ShmArea *area;
   struct CommandBuffer cb;
-  int retval;
+  unsigned int path_size;
+  int fd;
 
-  if (!recv_command (self->main_socket, &cb))
+  if (!recv_command (self->main_socket, &self->recv_buf, &cb))
     return -1;
 
   switch (cb.type) {
     case COMMAND_NEW_SHM_AREA:
-      assert (cb.payload.new_shm_area.path_size > 0);
       assert (cb.payload.new_shm_area.size > 0);
+      path_size = cb.payload.new_shm_area.path_size;
 
-      area_name = malloc (cb.payload.new_shm_area.path_size + 1);
-      retval = recv (self->main_socket, area_name,
-          cb.payload.new_shm_area.path_size, 0);
-      if (retval != cb.payload.new_shm_area.path_size) {
-        free (area_name);
-        return -3;
+      if (path_size == 0) {
+        fd = recv_buf_take_fd (&self->recv_buf);
+        if (fd < 0)
+          return -3;
+
+        newarea = sp_open_shm (NULL, fd, cb.area_id, 0,
+            cb.payload.new_shm_area.size, 0);
+        if (!newarea)
+          return -4;
+
+        newarea->next = self->shm_area;
+        self->shm_area = newarea;
+        break;
       }
+
+      if (path_size > RECV_BUF_SIZE - sizeof (struct CommandBuffer) ||
+          !recv_fill (self->main_socket, &self->recv_buf, path_size))
+        return -3;
+
+      area_name = malloc (path_size + 1);
+      memcpy (area_name, self->recv_buf.data + self->recv_buf.start,
+          path_size);
+      self->recv_buf.start += path_size;
       /* Ensure area_name is NULL terminated */
-      area_name[retval] = 0;
+      area_name[path_size] = 0;
 
-      newarea = sp_open_shm (area_name, cb.area_id, 0,
-          cb.payload.new_shm_area.size);
+      newarea = sp_open_shm (area_name, -1, cb.area_id, 0,
+          cb.payload.new_shm_area.size, 0);
       free (area_name);
       if (!newarea)
         return -4;
@@ -721,7 +1034,7 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
   ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
 
-  if (!recv_command (client->fd, &cb))
+  if (!recv_command (client->fd, &client->recv_buf, &cb))
     return -1;
 
   switch (cb.type) {
@@ -809,8 +1122,6 @@ sp_writer_accept_client (ShmPipe * self)
 {
   ShmClient *client = NULL;
   int fd;
-  struct CommandBuffer cb = { 0 };
-  int pathlen = strlen (self->shm_area->shm_area_name) + 1;
 
 
   fd = accept (self->main_socket, NULL, NULL);
@@ -820,20 +1131,13 @@ sp_writer_accept_client (ShmPipe * self)
     return NULL;
   }
 
-  cb.payload.new_shm_area.size = self->shm_area->shm_area_len;
-  cb.payload.new_shm_area.path_size = pathlen;
-  if (!send_command (fd, &cb, COMMAND_NEW_SHM_AREA, self->shm_area->id)) {
+  if (!send_new_area (fd, self->shm_area)) {
     fprintf (stderr, "Sending new shm area failed: %s", strerror (errno));
     goto error;
   }
 
-  if (send (fd, self->shm_area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-      pathlen) {
-    fprintf (stderr, "Sending new shm area path failed: %s", strerror (errno));
-    goto error;
-  }
-
   client = spalloc_new (ShmClient);
+  memset (client, 0, sizeof (ShmClient));
   client->fd = fd;
 
   /* Prepend ot linked list */
@@ -931,6 +1235,7 @@ again:
 
   self->num_clients--;
 
+  sp_recv_buf_clear (&client->recv_buf);
   spalloc_free (ShmClient, client);
 }
 
@@ -955,6 +1260,21 @@ sp_writer_get_client_fd (ShmClient * client)
   return client->fd;
 }
 
+/* Returns whether commands were already read from the socket, these have to
+ * be handled before waiting for the socket to be readable again */
+
+int
+sp_writer_client_has_pending (ShmClient * client)
+{
+  return recv_buf_has_command (&client->recv_buf);
+}
+
+int
+sp_client_has_pending (ShmPipe * self)
+{
+  return recv_buf_has_command (&self->recv_buf);
+}
+
 int
 sp_writer_pending_writes (ShmPipe * self)
 {
@@ -80,7 +80,15 @@ typedef struct _ShmBuffer ShmBuffer;
 
 typedef void (*sp_buffer_free_callback) (void * tag, void * user_data);
 
+enum
+{
+  SP_WRITER_MEMFD = (1 << 0),
+  SP_WRITER_HUGE_PAGES = (1 << 1)
+};
+
 ShmPipe *sp_writer_create (const char *path, size_t size, mode_t perms);
+ShmPipe *sp_writer_create_full (const char *path, size_t size, mode_t perms,
+    int flags);
 const char *sp_writer_get_path (ShmPipe *pipe);
 void sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
     void * user_data);
@@ -105,6 +113,7 @@ ShmClient * sp_writer_accept_client (ShmPipe * self);
 void sp_writer_close_client (ShmPipe *self, ShmClient * client,
     sp_buffer_free_callback callback, void * user_data);
 int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
+int sp_writer_client_has_pending (ShmClient * client);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
@@ -114,6 +123,7 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
+int sp_client_has_pending (ShmPipe * self);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
 void sp_client_close (ShmPipe * self);
 
@@ -0,0 +1,301 @@
+/* GStreamer
+ *
+ * abrsim.c: replay bandwidth traces through the adaptive demux bitrate
+ * selection algorithms
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Simulates the download and playback of a stream with a fixed bitrate
+ * ladder over a bandwidth trace, once for each GstAdaptiveDemuxAbr
+ * algorithm, and reports the average bitrate, the number of switches and
+ * the time spent rebuffering. Simulated time is used throughout, so the
+ * results only depend on the trace.
+ *
+ * The trace file has one line per period of constant network conditions:
+ *   DURATION_SECONDS BANDWIDTH_KBPS [LATENCY_MS]
+ * It is repeated if shorter than the stream. Without a trace file a random
+ * trace with a fixed seed is used.
+ *
+ * Usage: abrsim [TRACE_FILE] [FRAGMENTS]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gst/gst.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
+
+#define DEFAULT_FRAGMENTS 150
+#define FRAGMENT_DURATION (4 * GST_SECOND)
+#define MAX_BUFFER_LEVEL (30 * GST_SECOND)
+#define BITRATE_LIMIT 0.8
+
+static const guint64 ladder[] = {
+  400000, 800000, 1500000, 3000000, 5000000, 8000000
+};
+
+typedef struct
+{
+  GstClockTime duration;
+  guint64 bandwidth;            /* bits per second */
+  GstClockTime latency;
+} TracePeriod;
+
+typedef struct
+{
+  GArray *periods;
+  GstClockTime duration;
+} Trace;
+
+static void
+trace_add (Trace * trace, GstClockTime duration, guint64 bandwidth,
+    GstClockTime latency)
+{
+  TracePeriod period = { duration, MAX (bandwidth, 1), latency };
+
+  g_array_append_val (trace->periods, period);
+  trace->duration += duration;
+}
+
+static gboolean
+trace_load (Trace * trace, const gchar * filename)
+{
+  gchar *contents, **lines;
+  GError *err = NULL;
+  guint i;
+
+  if (!g_file_get_contents (filename, &contents, NULL, &err)) {
+    g_printerr ("Failed to read %s: %s\n", filename, err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (i = 0; lines[i]; i++) {
+    gdouble duration, kbps, latency_ms = 0;
+    gint n;
+
+    g_strstrip (lines[i]);
+    if (lines[i][0] == '\0' || lines[i][0] == '#')
+      continue;
+
+    n = sscanf (lines[i], "%lf %lf %lf", &duration, &kbps, &latency_ms);
+    if (n < 2 || duration <= 0 || kbps < 0 || latency_ms < 0) {
+      g_printerr ("Invalid trace line %u: %s\n", i + 1, lines[i]);
+      continue;
+    }
+
+    trace_add (trace, duration * GST_SECOND, kbps * 1000,
+        latency_ms * GST_MSECOND);
+  }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return trace->duration > 0;
+}
+
+/* Random walk between 300 kbps and 12 Mbps with sudden drops */
+static void
+trace_generate (Trace * trace)
+{
+  GRand *rand = g_rand_new_with_seed (42);
+  gdouble kbps = 4000;
+  guint i;
+
+  for (i = 0; i < 200; i++) {
+    gdouble kbps_now = kbps;
+
+    if (g_rand_int_range (rand, 0, 10) == 0)
+      kbps_now /= g_rand_double_range (rand, 3, 10);
+
+    trace_add (trace, g_rand_int_range (rand, 1, 10) * GST_SECOND,
+        MAX (kbps_now, 300) * 1000,
+        g_rand_int_range (rand, 20, 200) * GST_MSECOND);
+
+    kbps = CLAMP (kbps * g_rand_double_range (rand, 0.6, 1.5), 300, 12000);
+  }
+
+  g_rand_free (rand);
+}
+
+static const TracePeriod *
+trace_find (Trace * trace, GstClockTime time, GstClockTime * period_end)
+{
+  GstClockTime start = time - time % trace->duration;
+  guint i;
+
+  for (i = 0; i < trace->periods->len; i++) {
+    const TracePeriod *period =
+        &g_array_index (trace->periods, TracePeriod, i);
+
+    if (time < start + period->duration) {
+      *period_end = start + period->duration;
+      return period;
+    }
+    start += period->duration;
+  }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+/* Downloads @bytes starting at @time, returns when the last byte arrives
+ * and sets @latency to the time to first byte */
+static GstClockTime
+trace_download (Trace * trace, GstClockTime time, guint64 bytes,
+    GstClockTime * latency)
+{
+  const TracePeriod *period;
+  GstClockTime period_end;
+  guint64 bits = bytes * 8;
+
+  period = trace_find (trace, time, &period_end);
+  *latency = period->latency;
+  time += period->latency;
+
+  while (bits > 0) {
+    guint64 period_bits;
+
+    period = trace_find (trace, time, &period_end);
+    period_bits = gst_util_uint64_scale (period->bandwidth,
+        period_end - time, GST_SECOND);
+
+    if (period_bits >= bits) {
+      time += gst_util_uint64_scale_ceil (bits, GST_SECOND,
+          period->bandwidth);
+      bits = 0;
+    } else {
+      time = period_end;
+      bits -= period_bits;
+    }
+  }
+
+  return time;
+}
+
+static void
+simulate (Trace * trace, GstAdaptiveDemuxAbrAlgorithm algorithm,
+    guint num_fragments)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  GEnumValue *value;
+  GstClockTime now = 0, buffer_level = 0, stalled = 0, startup = 0;
+  guint64 bitrate_sum = 0;
+  guint i, index = 0, switches = 0;
+  gboolean playing = FALSE;
+
+  gst_adaptive_demux_abr_set_algorithm (abr, algorithm);
+  gst_adaptive_demux_abr_set_bitrates (abr, ladder, G_N_ELEMENTS (ladder));
+
+  for (i = 0; i < num_fragments; i++) {
+    GstClockTime end, download_time, latency;
+    guint64 bytes, target;
+    guint new_index;
+
+    /* wait for room in the buffer */
+    if (buffer_level + FRAGMENT_DURATION > MAX_BUFFER_LEVEL) {
+      GstClockTime wait =
+          buffer_level + FRAGMENT_DURATION - MAX_BUFFER_LEVEL;
+
+      now += wait;
+      buffer_level -= wait;
+    }
+
+    bytes = gst_util_uint64_scale (ladder[index], FRAGMENT_DURATION,
+        8 * GST_SECOND);
+    end = trace_download (trace, now, bytes, &latency);
+    download_time = end - now;
+    now = end;
+
+    if (playing) {
+      if (download_time > buffer_level) {
+        stalled += download_time - buffer_level;
+        buffer_level = 0;
+      } else {
+        buffer_level -= download_time;
+      }
+    }
+    buffer_level += FRAGMENT_DURATION;
+    bitrate_sum += ladder[index];
+
+    if (!playing) {
+      playing = TRUE;
+      startup = now;
+    }
+
+    gst_adaptive_demux_abr_add_sample (abr, bytes, download_time, latency);
+    target = gst_adaptive_demux_abr_select_bitrate (abr, BITRATE_LIMIT,
+        FRAGMENT_DURATION, buffer_level);
+
+    /* same as the subclasses: the highest bitrate not above the target, or
+     * the lowest one */
+    new_index = G_N_ELEMENTS (ladder) - 1;
+    while (new_index > 0 && ladder[new_index] > target)
+      new_index--;
+    if (new_index != index)
+      switches++;
+    index = new_index;
+  }
+
+  value = g_enum_get_value (g_type_class_peek
+      (GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM), algorithm);
+  g_print ("%-15s %8.0f kbps %5u switches %8.3f s stalled %6.3f s startup\n",
+      value->value_nick, (gdouble) bitrate_sum / num_fragments / 1000,
+      switches, (gdouble) stalled / GST_SECOND,
+      (gdouble) startup / GST_SECOND);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint num_fragments = DEFAULT_FRAGMENTS;
+  Trace trace = { NULL, 0 };
+  GEnumClass *algorithms;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  trace.periods = g_array_new (FALSE, FALSE, sizeof (TracePeriod));
+  if (argc > 1) {
+    if (!trace_load (&trace, argv[1]))
+      g_error ("No usable trace in %s", argv[1]);
+  } else {
+    trace_generate (&trace);
+  }
+  if (argc > 2)
+    num_fragments = MAX (atoi (argv[2]), 1);
+
+  g_print ("%u fragments of %" GST_TIME_FORMAT " over a %.1f s trace\n",
+      num_fragments, GST_TIME_ARGS (FRAGMENT_DURATION),
+      (gdouble) trace.duration / GST_SECOND);
+
+  algorithms = g_type_class_ref (GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM);
+  for (i = 0; i < algorithms->n_values; i++)
+    simulate (&trace, algorithms->values[i].value, num_fragments);
+  g_type_class_unref (algorithms);
+
+  g_array_free (trace.periods, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,281 @@
+/* GStreamer
+ *
+ * audiomixmatrix.c: benchmark the audiomixmatrix transform
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes buffers through audiomixmatrix for each sample format and a few
+ * channel layouts, and compares the time spent with a naive reference
+ * loop that applies every coefficient of the matrix to every frame, which
+ * is what the element used to do:
+ *  - dense: every input channel contributes to every output channel
+ *  - sparse: every output channel mixes a quarter of the input channels
+ *  - gather: every output channel is a copy of one input channel
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <gst/check/gstharness.h>
+
+#define DEFAULT_FRAMES (48000 * 20)
+#define FRAMES_PER_BUFFER 1024
+
+typedef enum
+{
+  MATRIX_DENSE,
+  MATRIX_SPARSE,
+  MATRIX_GATHER
+} MatrixType;
+
+static const gchar *matrix_type_names[] = { "dense", "sparse", "gather" };
+
+static gdouble *
+create_matrix (MatrixType type, guint in_channels, guint out_channels)
+{
+  gdouble *matrix = g_new0 (gdouble, in_channels * out_channels);
+  guint in, out;
+
+  for (out = 0; out < out_channels; out++) {
+    for (in = 0; in < in_channels; in++) {
+      gdouble *coefficient = &matrix[out * in_channels + in];
+
+      switch (type) {
+        case MATRIX_DENSE:
+          *coefficient = 1.0 / in_channels;
+          break;
+        case MATRIX_SPARSE:
+          if (in % 4 == out % 4)
+            *coefficient = 4.0 / in_channels;
+          break;
+        case MATRIX_GATHER:
+          if (in == out % in_channels)
+            *coefficient = 1.0;
+          break;
+      }
+    }
+  }
+
+  return matrix;
+}
+
+static void
+set_matrix (GstElement * element, const gdouble * matrix, guint in_channels,
+    guint out_channels)
+{
+  GValue v = G_VALUE_INIT;
+  guint in, out;
+
+  g_object_set (element, "in-channels", in_channels, "out-channels",
+      out_channels, "channel-mask", G_GUINT64_CONSTANT (0), NULL);
+
+  g_value_init (&v, GST_TYPE_ARRAY);
+  for (out = 0; out < out_channels; out++) {
+    GValue row = G_VALUE_INIT;
+
+    g_value_init (&row, GST_TYPE_ARRAY);
+    for (in = 0; in < in_channels; in++) {
+      GValue itm = G_VALUE_INIT;
+
+      g_value_init (&itm, G_TYPE_DOUBLE);
+      g_value_set_double (&itm, matrix[out * in_channels + in]);
+      gst_value_array_append_value (&row, &itm);
+      g_value_unset (&itm);
+    }
+    gst_value_array_append_value (&v, &row);
+    g_value_unset (&row);
+  }
+  g_object_set_property (G_OBJECT (element), "matrix", &v);
+  g_value_unset (&v);
+}
+
+#define DEFINE_REFERENCE(name, type, acctype, conv) \
+static void \
+reference_##name (const type * inarray, type * outarray, \
+    const gdouble * matrix, guint in_channels, guint out_channels, \
+    guint n_samples) \
+{ \
+  guint sample, in, out; \
+  \
+  for (sample = 0; sample < n_samples; sample++) { \
+    for (out = 0; out < out_channels; out++) { \
+      acctype outval = 0; \
+      for (in = 0; in < in_channels; in++) \
+        outval += inarray[sample * in_channels + in] * \
+            conv (matrix[out * in_channels + in]); \
+      outarray[sample * out_channels + out] = (type) outval; \
+    } \
+  } \
+}
+
+#define FLOAT_COEFF(c) (c)
+#define FIXED_COEFF(c) ((gint32) ((c) * (1 << 10)))
+
+DEFINE_REFERENCE (f32, gfloat, gfloat, FLOAT_COEFF)
+DEFINE_REFERENCE (f64, gdouble, gdouble, FLOAT_COEFF)
+DEFINE_REFERENCE (s16, gint16, gint32, FIXED_COEFF)
+DEFINE_REFERENCE (s32, gint32, gint64, FIXED_COEFF)
+
+static gdouble
+run_reference (GstAudioFormat format, const gdouble * matrix,
+    guint in_channels, guint out_channels, guint num_frames)
+{
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  guint bps = GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8;
+  gpointer indata, outdata;
+  GstClockTime start;
+  guint frames;
+
+  indata = g_malloc0 (FRAMES_PER_BUFFER * in_channels * bps);
+  outdata = g_malloc0 (FRAMES_PER_BUFFER * out_channels * bps);
+
+  start = gst_util_get_timestamp ();
+  for (frames = 0; frames < num_frames; frames += FRAMES_PER_BUFFER) {
+    switch (format) {
+      case GST_AUDIO_FORMAT_F32:
+        reference_f32 (indata, outdata, matrix, in_channels, out_channels,
+            FRAMES_PER_BUFFER);
+        break;
+      case GST_AUDIO_FORMAT_F64:
+        reference_f64 (indata, outdata, matrix, in_channels, out_channels,
+            FRAMES_PER_BUFFER);
+        break;
+      case GST_AUDIO_FORMAT_S16:
+        reference_s16 (indata, outdata, matrix, in_channels, out_channels,
+            FRAMES_PER_BUFFER);
+        break;
+      case GST_AUDIO_FORMAT_S32:
+        reference_s32 (indata, outdata, matrix, in_channels, out_channels,
+            FRAMES_PER_BUFFER);
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+  }
+
+  g_free (indata);
+  g_free (outdata);
+
+  return (gdouble) (gst_util_get_timestamp () - start) / GST_SECOND;
+}
+
+static gdouble
+run_element (GstAudioFormat format, const gdouble * matrix, guint in_channels,
+    guint out_channels, guint num_frames)
+{
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  guint bps = GST_AUDIO_FORMAT_INFO_WIDTH (finfo) / 8;
+  GstHarness *h;
+  GstBuffer *inbuf;
+  GstClockTime start, end;
+  gchar *incaps, *outcaps;
+  guint frames;
+
+  h = gst_harness_new ("audiomixmatrix");
+  set_matrix (h->element, matrix, in_channels, out_channels);
+
+  incaps = g_strdup_printf ("audio/x-raw, format=(string)%s, "
+      "layout=(string)interleaved, rate=(int)48000, channels=(int)%u, "
+      "channel-mask=(bitmask)0x0", finfo->name, in_channels);
+  outcaps = g_strdup_printf ("audio/x-raw, format=(string)%s, "
+      "layout=(string)interleaved, rate=(int)48000, channels=(int)%u, "
+      "channel-mask=(bitmask)0x0", finfo->name, out_channels);
+  gst_harness_set_caps_str (h, incaps, outcaps);
+  g_free (incaps);
+  g_free (outcaps);
+
+  inbuf = gst_buffer_new_allocate (NULL,
+      FRAMES_PER_BUFFER * in_channels * bps, NULL);
+  gst_buffer_memset (inbuf, 0, 0, FRAMES_PER_BUFFER * in_channels * bps);
+
+  start = gst_util_get_timestamp ();
+  for (frames = 0; frames < num_frames; frames += FRAMES_PER_BUFFER) {
+    if (gst_harness_push (h, gst_buffer_ref (inbuf)) != GST_FLOW_OK)
+      g_error ("Failed to push buffer");
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_buffer_unref (inbuf);
+  gst_harness_teardown (h);
+
+  return (gdouble) (end - start) / GST_SECOND;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const GstAudioFormat formats[] = {
+    GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_F64,
+    GST_AUDIO_FORMAT_S16, GST_AUDIO_FORMAT_S32
+  };
+  static const guint layouts[][2] = {
+    {16, 2}, {32, 2}, {64, 2}, {64, 8}, {16, 16}, {64, 64}
+  };
+  guint num_frames = DEFAULT_FRAMES;
+  GstElementFactory *factory;
+  guint f, l, t;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    num_frames = atoi (argv[1]);
+
+  factory = gst_element_factory_find ("audiomixmatrix");
+  if (!factory) {
+    g_printerr ("audiomixmatrix element not available\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  g_print ("%-6s %-7s %8s %12s %12s %8s\n", "format", "matrix", "channels",
+      "reference s", "element s", "speedup");
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (l = 0; l < G_N_ELEMENTS (layouts); l++) {
+      for (t = MATRIX_DENSE; t <= MATRIX_GATHER; t++) {
+        guint in_channels = layouts[l][0];
+        guint out_channels = layouts[l][1];
+        gdouble *matrix;
+        gdouble ref_secs, secs;
+        gchar *channels;
+
+        matrix = create_matrix (t, in_channels, out_channels);
+        ref_secs = run_reference (formats[f], matrix, in_channels,
+            out_channels, num_frames);
+        secs = run_element (formats[f], matrix, in_channels, out_channels,
+            num_frames);
+        g_free (matrix);
+
+        channels = g_strdup_printf ("%u->%u", in_channels, out_channels);
+        g_print ("%-6s %-7s %8s %12.3f %12.3f %7.2fx\n",
+            gst_audio_format_to_string (formats[f]), matrix_type_names[t],
+            channels, ref_secs, secs, ref_secs / secs);
+        g_free (channels);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,305 @@
+/* GStreamer
+ *
+ * h264slices.c: benchmark the per slice overhead of the H.264 decoder
+ * base class
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Feeds a generated 1080p stream with one slice per macroblock row,
+ * alternating P and B reference pictures with 4 reference frames, to a
+ * GstH264Decoder subclass which does nothing but request the reference
+ * picture lists. Reports the time spent in the base class per slice.
+ *
+ * Usage: h264slices [FRAMES]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+#include <gst/codecs/gsth264decoder.h>
+
+#define DEFAULT_FRAMES 600
+#define WIDTH_MBS 120
+#define HEIGHT_MBS 68
+#define NUM_REF_FRAMES 4
+
+typedef struct
+{
+  GstH264Decoder parent;
+
+  guint64 num_slices;
+} GstH264BenchDecoder;
+
+typedef struct
+{
+  GstH264DecoderClass parent_class;
+} GstH264BenchDecoderClass;
+
+GType gst_h264_bench_decoder_get_type (void);
+
+G_DEFINE_TYPE (GstH264BenchDecoder, gst_h264_bench_decoder,
+    GST_TYPE_H264_DECODER);
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-h264"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-raw"));
+
+static gboolean
+gst_h264_bench_decoder_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps, gint max_dpb_size)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_h264_bench_decoder_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH264BenchDecoder *self = (GstH264BenchDecoder *) decoder;
+
+  self->num_slices++;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_h264_bench_decoder_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  gst_h264_picture_unref (picture);
+  gst_video_decoder_release_frame (GST_VIDEO_DECODER (decoder), frame);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_h264_bench_decoder_class_init (GstH264BenchDecoderClass * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "H.264 benchmark decoder", "Codec/Decoder/Video",
+      "Decodes nothing", "GStreamer");
+
+  h264decoder_class->new_sequence = gst_h264_bench_decoder_new_sequence;
+  h264decoder_class->decode_slice = gst_h264_bench_decoder_decode_slice;
+  h264decoder_class->output_picture = gst_h264_bench_decoder_output_picture;
+}
+
+static void
+gst_h264_bench_decoder_init (GstH264BenchDecoder * self)
+{
+  gst_h264_decoder_set_process_ref_pic_lists (GST_H264_DECODER (self), TRUE);
+}
+
+typedef struct
+{
+  guint8 data[32];
+  guint bit;
+} BitWriter;
+
+static void
+put_bits (BitWriter * bw, guint32 value, guint n)
+{
+  while (n--) {
+    g_assert (bw->bit / 8 < sizeof (bw->data));
+    if (value & (1u << n))
+      bw->data[bw->bit / 8] |= 0x80 >> (bw->bit % 8);
+    bw->bit++;
+  }
+}
+
+static void
+put_ue (BitWriter * bw, guint32 value)
+{
+  guint n = g_bit_storage (value + 1);
+
+  put_bits (bw, 0, n - 1);
+  put_bits (bw, value + 1, n);
+}
+
+/* Appends the NAL unit with a start code and emulation prevention */
+static void
+append_nal (GByteArray * array, guint8 header, BitWriter * bw)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  static const guint8 epb = 0x03;
+  guint i, zeros = 0;
+
+  /* rbsp_trailing_bits */
+  put_bits (bw, 1, 1);
+  while (bw->bit % 8)
+    put_bits (bw, 0, 1);
+
+  g_byte_array_append (array, start_code, sizeof (start_code));
+  g_byte_array_append (array, &header, 1);
+
+  for (i = 0; i < bw->bit / 8; i++) {
+    if (zeros == 2 && bw->data[i] <= 0x03) {
+      g_byte_array_append (array, &epb, 1);
+      zeros = 0;
+    }
+    g_byte_array_append (array, &bw->data[i], 1);
+    zeros = bw->data[i] ? 0 : zeros + 1;
+  }
+}
+
+static void
+append_parameter_sets (GByteArray * array)
+{
+  BitWriter sps = { {0}, 0 }, pps = { {0}, 0 };
+
+  put_bits (&sps, 77, 8);       /* profile_idc: main */
+  put_bits (&sps, 0, 8);        /* constraint_set flags */
+  put_bits (&sps, 42, 8);       /* level_idc */
+  put_ue (&sps, 0);             /* seq_parameter_set_id */
+  put_ue (&sps, 0);             /* log2_max_frame_num_minus4 */
+  put_ue (&sps, 2);             /* pic_order_cnt_type */
+  put_ue (&sps, NUM_REF_FRAMES);        /* max_num_ref_frames */
+  put_bits (&sps, 0, 1);        /* gaps_in_frame_num_value_allowed_flag */
+  put_ue (&sps, WIDTH_MBS - 1); /* pic_width_in_mbs_minus1 */
+  put_ue (&sps, HEIGHT_MBS - 1);        /* pic_height_in_map_units_minus1 */
+  put_bits (&sps, 1, 1);        /* frame_mbs_only_flag */
+  put_bits (&sps, 1, 1);        /* direct_8x8_inference_flag */
+  put_bits (&sps, 0, 1);        /* frame_cropping_flag */
+  put_bits (&sps, 0, 1);        /* vui_parameters_present_flag */
+  append_nal (array, 0x67, &sps);
+
+  put_ue (&pps, 0);             /* pic_parameter_set_id */
+  put_ue (&pps, 0);             /* seq_parameter_set_id */
+  put_bits (&pps, 0, 1);        /* entropy_coding_mode_flag */
+  put_bits (&pps, 0, 1);        /* bottom_field_pic_order_in_frame_present */
+  put_ue (&pps, 0);             /* num_slice_groups_minus1 */
+  put_ue (&pps, NUM_REF_FRAMES - 1);    /* num_ref_idx_l0_default_active_minus1 */
+  put_ue (&pps, NUM_REF_FRAMES - 1);    /* num_ref_idx_l1_default_active_minus1 */
+  put_bits (&pps, 0, 1);        /* weighted_pred_flag */
+  put_bits (&pps, 0, 2);        /* weighted_bipred_idc */
+  put_ue (&pps, 0);             /* pic_init_qp_minus26 */
+  put_ue (&pps, 0);             /* pic_init_qs_minus26 */
+  put_ue (&pps, 0);             /* chroma_qp_index_offset */
+  put_bits (&pps, 1, 1);        /* deblocking_filter_control_present_flag */
+  put_bits (&pps, 0, 1);        /* constrained_intra_pred_flag */
+  put_bits (&pps, 0, 1);        /* redundant_pic_cnt_present_flag */
+  append_nal (array, 0x68, &pps);
+}
+
+static void
+append_slice (GByteArray * array, guint idx, guint first_mb)
+{
+  BitWriter bw = { {0}, 0 };
+  gboolean idr = idx == 0;
+  gboolean b_slice = idx % 2 == 0;
+
+  put_ue (&bw, first_mb);       /* first_mb_in_slice */
+  put_ue (&bw, idr ? 7 : b_slice ? 6 : 5);      /* slice_type: I, B or P */
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  put_bits (&bw, idx % 16, 4);  /* frame_num */
+  if (idr) {
+    put_ue (&bw, 0);            /* idr_pic_id */
+    put_bits (&bw, 0, 1);       /* no_output_of_prior_pics_flag */
+    put_bits (&bw, 0, 1);       /* long_term_reference_flag */
+  } else {
+    if (b_slice)
+      put_bits (&bw, 1, 1);     /* direct_spatial_mv_pred_flag */
+    put_bits (&bw, 0, 1);       /* num_ref_idx_active_override_flag */
+    put_bits (&bw, 0, 1);       /* ref_pic_list_modification_flag_l0 */
+    if (b_slice)
+      put_bits (&bw, 0, 1);     /* ref_pic_list_modification_flag_l1 */
+    put_bits (&bw, 0, 1);       /* adaptive_ref_pic_marking_mode_flag */
+  }
+  put_ue (&bw, 0);              /* slice_qp_delta */
+  put_ue (&bw, 1);              /* disable_deblocking_filter_idc */
+  append_nal (array, idr ? 0x65 : 0x41, &bw);
+}
+
+static GstBuffer *
+create_frame (guint idx)
+{
+  GByteArray *array = g_byte_array_new ();
+  GstBuffer *buf;
+  gsize size;
+  guint row;
+
+  if (idx == 0)
+    append_parameter_sets (array);
+  for (row = 0; row < HEIGHT_MBS; row++)
+    append_slice (array, idx, row * WIDTH_MBS);
+
+  size = array->len;
+  buf = gst_buffer_new_wrapped (g_byte_array_free (array, FALSE), size);
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) =
+      gst_util_uint64_scale_int (idx, GST_SECOND, 60);
+
+  return buf;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint num_frames = DEFAULT_FRAMES;
+  GstH264BenchDecoder *dec;
+  GstBuffer **frames;
+  GstHarness *h;
+  GstClockTime start, end;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    num_frames = MAX (atoi (argv[1]), 1);
+
+  frames = g_new (GstBuffer *, num_frames);
+  for (i = 0; i < num_frames; i++)
+    frames[i] = create_frame (i);
+
+  dec = g_object_new (gst_h264_bench_decoder_get_type (), NULL);
+  h = gst_harness_new_with_element (GST_ELEMENT (dec), "sink", "src");
+  gst_harness_set_src_caps_str (h, "video/x-h264, "
+      "stream-format = (string) byte-stream, alignment = (string) au, "
+      "width = (int) 1920, height = (int) 1088, framerate = (fraction) 60/1");
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < num_frames; i++) {
+    if (gst_harness_push (h, frames[i]) != GST_FLOW_OK)
+      g_error ("Failed to decode frame %u", i);
+  }
+  gst_harness_push_event (h, gst_event_new_eos ());
+  end = gst_util_get_timestamp ();
+
+  g_print ("%u frames, %" G_GUINT64_FORMAT " slices in %.3f s\n", num_frames,
+      dec->num_slices, (gdouble) (end - start) / GST_SECOND);
+  if (dec->num_slices > 0)
+    g_print ("%.1f ns per slice\n",
+        (gdouble) (end - start) / dec->num_slices);
+
+  gst_harness_teardown (h);
+  gst_object_unref (dec);
+  g_free (frames);
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* GStreamer
+ *
+ * hlsplaylist.c: benchmark HLS media playlist updates and lookups
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Feeds a live media playlist with a large sliding window to the hlsdemux
+ * playlist parser, moving the window by one segment per update as a live
+ * DVR stream would, and reports the time spent per playlist update and per
+ * lookup of the segment containing a position.
+ *
+ * Usage: hlsplaylist [SEGMENTS] [UPDATES]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gst/gst.h>
+
+#undef GST_CAT_DEFAULT
+#include "m3u8.h"
+#include "m3u8.c"
+
+GST_DEBUG_CATEGORY (hls_debug);
+
+#define DEFAULT_SEGMENTS 10000
+#define DEFAULT_UPDATES 100
+#define NUM_LOOKUPS 1000000
+#define SEGMENT_DURATION 6
+
+static gchar *
+create_playlist (guint first, guint num_segments)
+{
+  GString *s = g_string_new (NULL);
+  guint i;
+
+  g_string_append_printf (s, "#EXTM3U\n#EXT-X-VERSION:3\n"
+      "#EXT-X-TARGETDURATION:%u\n#EXT-X-MEDIA-SEQUENCE:%u\n",
+      SEGMENT_DURATION, first);
+  for (i = first; i < first + num_segments; i++)
+    g_string_append_printf (s, "#EXTINF:%u.000,\nsegment-%08u.ts\n",
+        SEGMENT_DURATION, i);
+
+  return g_string_free (s, FALSE);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint num_segments = DEFAULT_SEGMENTS;
+  guint num_updates = DEFAULT_UPDATES;
+  GstClockTime start, end, window;
+  gchar **playlists;
+  GstM3U8 *m3u8;
+  GRand *rand;
+  guint i, found = 0;
+  gdouble secs;
+
+  gst_init (&argc, &argv);
+  GST_DEBUG_CATEGORY_INIT (hls_debug, "hlsdemux", 0, "hlsdemux");
+
+  if (argc > 1)
+    num_segments = MAX (atoi (argv[1]), 1);
+  if (argc > 2)
+    num_updates = MAX (atoi (argv[2]), 1);
+
+  playlists = g_new (gchar *, num_updates + 1);
+  for (i = 0; i <= num_updates; i++)
+    playlists[i] = create_playlist (i, num_segments);
+
+  m3u8 = gst_m3u8_new ();
+  gst_m3u8_set_uri (m3u8, "http://localhost/live/playlist.m3u8", NULL,
+      "playlist.m3u8");
+  if (!gst_m3u8_update (m3u8, playlists[0]))
+    g_error ("Failed to parse the initial playlist");
+
+  start = gst_util_get_timestamp ();
+  for (i = 1; i <= num_updates; i++) {
+    if (!gst_m3u8_update (m3u8, playlists[i]))
+      g_error ("Failed to update the playlist to sequence %u", i);
+  }
+  end = gst_util_get_timestamp ();
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%u segments, %u updates in %.3f s\n", num_segments, num_updates,
+      secs);
+  g_print ("%.1f us per update, %.1f ns per segment\n",
+      secs * G_USEC_PER_SEC / num_updates,
+      (gdouble) (end - start) / num_updates / num_segments);
+
+  window = (GstClockTime) num_segments * SEGMENT_DURATION * GST_SECOND;
+  rand = g_rand_new_with_seed (0);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_LOOKUPS; i++) {
+    GstClockTime position = g_rand_double (rand) * window;
+
+    if (gst_m3u8_find_file_index (m3u8, position) < num_segments)
+      found++;
+  }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%u of %u lookups in %.3f s, %.1f ns per lookup\n", found,
+      NUM_LOOKUPS, (gdouble) (end - start) / GST_SECOND,
+      (gdouble) (end - start) / NUM_LOOKUPS);
+
+  g_rand_free (rand);
+  gst_m3u8_unref (m3u8);
+  g_free (playlists);
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+/* GStreamer
+ *
+ * nalparse.c: benchmark H.264 and H.265 byte-stream parsing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Splits an Annex B elementary stream file into NAL units, parses the
+ * parameter sets and slice headers as h264parse and h265parse do, and
+ * reports the stream bitrate handled per second of wall clock time.
+ *
+ * Usage: nalparse h264|h265 FILE [ITERATIONS]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+#define DEFAULT_ITERATIONS 10
+
+static guint
+parse_h264 (const guint8 * data, gsize size)
+{
+  GstH264NalParser *parser;
+  GstH264NalUnit nalu;
+  GstH264SliceHdr slice;
+  GstH264ParserResult res;
+  guint offset = 0, n_nals = 0;
+
+  parser = gst_h264_nal_parser_new ();
+
+  while (TRUE) {
+    res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+      break;
+
+    switch (nalu.type) {
+      case GST_H264_NAL_SPS:
+      case GST_H264_NAL_PPS:
+        gst_h264_parser_parse_nal (parser, &nalu);
+        break;
+      case GST_H264_NAL_SLICE:
+      case GST_H264_NAL_SLICE_IDR:
+        gst_h264_parser_parse_slice_hdr (parser, &nalu, &slice, TRUE, TRUE);
+        break;
+      default:
+        break;
+    }
+
+    n_nals++;
+    offset = nalu.offset + nalu.size;
+    if (res == GST_H264_PARSER_NO_NAL_END)
+      break;
+  }
+
+  gst_h264_nal_parser_free (parser);
+
+  return n_nals;
+}
+
+static guint
+parse_h265 (const guint8 * data, gsize size)
+{
+  GstH265Parser *parser;
+  GstH265NalUnit nalu;
+  GstH265SliceHdr slice;
+  GstH265ParserResult res;
+  guint offset = 0, n_nals = 0;
+
+  parser = gst_h265_parser_new ();
+
+  while (TRUE) {
+    res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+      break;
+
+    switch (nalu.type) {
+      case GST_H265_NAL_VPS:
+      case GST_H265_NAL_SPS:
+      case GST_H265_NAL_PPS:
+        gst_h265_parser_parse_nal (parser, &nalu);
+        break;
+      default:
+        if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT &&
+            gst_h265_parser_parse_slice_hdr (parser, &nalu,
+                &slice) == GST_H265_PARSER_OK)
+          gst_h265_slice_hdr_free (&slice);
+        break;
+    }
+
+    n_nals++;
+    offset = nalu.offset + nalu.size;
+    if (res == GST_H265_PARSER_NO_NAL_END)
+      break;
+  }
+
+  gst_h265_parser_free (parser);
+
+  return n_nals;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint (*parse) (const guint8 * data, gsize size);
+  guint iterations = DEFAULT_ITERATIONS;
+  GstClockTime start, end;
+  GError *err = NULL;
+  gchar *data;
+  gsize size;
+  guint i, n_nals = 0;
+  gdouble secs;
+
+  gst_init (&argc, &argv);
+
+  if (argc < 3) {
+    g_printerr ("Usage: %s h264|h265 FILE [ITERATIONS]\n", argv[0]);
+    return 1;
+  }
+
+  if (strcmp (argv[1], "h264") == 0) {
+    parse = parse_h264;
+  } else if (strcmp (argv[1], "h265") == 0) {
+    parse = parse_h265;
+  } else {
+    g_printerr ("Unknown codec %s\n", argv[1]);
+    return 1;
+  }
+
+  if (argc > 3)
+    iterations = MAX (atoi (argv[3]), 1);
+
+  if (!g_file_get_contents (argv[2], &data, &size, &err)) {
+    g_printerr ("Could not read %s: %s\n", argv[2], err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++)
+    n_nals = parse ((const guint8 *) data, size);
+  end = gst_util_get_timestamp ();
+
+  g_free (data);
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%u NAL units, %" G_GSIZE_FORMAT " bytes, %u iterations\n",
+      n_nals, size, iterations);
+  g_print ("%.3f s, %.1f Mbit/s\n", secs,
+      (gdouble) size * iterations * 8 / secs / 1000000);
+
+  return 0;
+}
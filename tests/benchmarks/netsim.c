@@ -0,0 +1,187 @@
+/* GStreamer
+ *
+ * netsim.c: benchmark the scheduling of delayed buffers in netsim
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes buffers from one thread per stream into the request pads of a
+ * single netsim, every buffer being delayed by a random 1-20 ms on the
+ * system clock, and reports the buffers per second delivered and the CPU
+ * time spent for an increasing number of streams.
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <gst/gst.h>
+
+#define DEFAULT_BUFFERS 20000
+#define BUFFER_SIZE 1200
+
+typedef struct
+{
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  guint num_buffers;
+  GThread *thread;
+} Stream;
+
+static gint received;
+
+static GstFlowReturn
+count_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  g_atomic_int_inc (&received);
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static gpointer
+push_stream (gpointer data)
+{
+  Stream *stream = data;
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+  guint i;
+
+  for (i = 0; i < stream->num_buffers; i++) {
+    if (gst_pad_push (stream->srcpad, gst_buffer_ref (buf)) != GST_FLOW_OK)
+      g_error ("Failed to push buffer");
+  }
+  gst_buffer_unref (buf);
+
+  return NULL;
+}
+
+static void
+run (guint num_streams, guint num_buffers)
+{
+  GstElement *netsim = gst_element_factory_make ("netsim", NULL);
+  Stream *streams = g_new0 (Stream, num_streams);
+  GstClock *sysclock = gst_system_clock_obtain ();
+  GstClockTime start, end;
+  GstSegment segment;
+  clock_t cpu_start, cpu_end;
+  gdouble secs, cpu_secs;
+  guint i, total = num_streams * num_buffers;
+
+  g_object_set (netsim, "delay-probability", 1.0, "min-delay", 1,
+      "max-delay", 20, NULL);
+  gst_element_set_clock (netsim, sysclock);
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+
+  for (i = 0; i < num_streams; i++) {
+    Stream *stream = &streams[i];
+    GstPad *element_pad;
+    gchar *name;
+
+    stream->num_buffers = num_buffers;
+    stream->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+    stream->sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+    gst_pad_set_chain_function (stream->sinkpad, count_chain);
+
+    element_pad = gst_element_request_pad_simple (netsim, "sink_%u");
+    gst_pad_link (stream->srcpad, element_pad);
+    gst_object_unref (element_pad);
+
+    name = g_strdup_printf ("src_%u", i);
+    element_pad = gst_element_get_static_pad (netsim, name);
+    gst_pad_link (element_pad, stream->sinkpad);
+    gst_object_unref (element_pad);
+    g_free (name);
+
+    gst_pad_set_active (stream->srcpad, TRUE);
+    gst_pad_set_active (stream->sinkpad, TRUE);
+  }
+
+  gst_element_set_state (netsim, GST_STATE_PLAYING);
+
+  for (i = 0; i < num_streams; i++) {
+    gchar *stream_id = g_strdup_printf ("stream-%u", i);
+
+    gst_pad_push_event (streams[i].srcpad, gst_event_new_stream_start
+        (stream_id));
+    gst_pad_push_event (streams[i].srcpad, gst_event_new_segment (&segment));
+    g_free (stream_id);
+  }
+
+  g_atomic_int_set (&received, 0);
+  start = gst_util_get_timestamp ();
+  cpu_start = clock ();
+
+  for (i = 0; i < num_streams; i++)
+    streams[i].thread = g_thread_new ("push", push_stream, &streams[i]);
+  for (i = 0; i < num_streams; i++)
+    g_thread_join (streams[i].thread);
+
+  while (g_atomic_int_get (&received) < total)
+    g_usleep (1000);
+
+  cpu_end = clock ();
+  end = gst_util_get_timestamp ();
+
+  gst_element_set_state (netsim, GST_STATE_NULL);
+
+  for (i = 0; i < num_streams; i++) {
+    gst_pad_set_active (streams[i].srcpad, FALSE);
+    gst_pad_set_active (streams[i].sinkpad, FALSE);
+    gst_object_unref (streams[i].srcpad);
+    gst_object_unref (streams[i].sinkpad);
+  }
+  g_free (streams);
+  gst_object_unref (netsim);
+  gst_object_unref (sysclock);
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  cpu_secs = (gdouble) (cpu_end - cpu_start) / CLOCKS_PER_SEC;
+  g_print ("%7u %10u %10.3f %12.0f %10.3f %8.1f%%\n", num_streams, total,
+      secs, total / secs, cpu_secs, 100.0 * cpu_secs / secs);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const guint num_streams[] = { 1, 4, 16, 64 };
+  guint num_buffers = DEFAULT_BUFFERS;
+  GstElementFactory *factory;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    num_buffers = atoi (argv[1]);
+
+  factory = gst_element_factory_find ("netsim");
+  if (!factory) {
+    g_printerr ("netsim element not available\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  g_print ("%7s %10s %10s %12s %10s %9s\n", "streams", "buffers", "wall s",
+      "buffers/s", "cpu s", "cpu");
+
+  for (i = 0; i < G_N_ELEMENTS (num_streams); i++)
+    run (num_streams[i], num_buffers / num_streams[i]);
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+/* GStreamer
+ *
+ * srtloopback.c: benchmark SRT reception over the loopback interface
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Streams 1316 byte messages at a fixed bitrate from an srtsink listener to
+ * an srtsrc caller on localhost, and reports the received bitrate and the
+ * process CPU time spent per megabit.
+ *
+ * Usage: srtloopback [MBITS_PER_SEC] [SECONDS] [PORT]
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+
+#define DEFAULT_MBITS_PER_SEC 100
+#define DEFAULT_SECONDS 10
+#define DEFAULT_PORT 7009
+#define MESSAGE_SIZE 1316
+
+static guint64 received_bytes;
+static guint64 received_messages;
+
+static GstPadProbeReturn
+count_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      received_bytes += gst_buffer_get_size (gst_buffer_list_get (list, i));
+    received_messages += len;
+  } else {
+    received_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+    received_messages++;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gdouble
+cpu_seconds (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void
+check_error (GstBus * bus, const gchar * what)
+{
+  GstMessage *msg;
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  if (msg) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_error ("Error in %s: %s", what, err->message);
+  }
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint mbits = DEFAULT_MBITS_PER_SEC;
+  guint seconds = DEFAULT_SECONDS;
+  guint port = DEFAULT_PORT;
+  GstElement *sender, *receiver, *src, *sink;
+  GstBus *sender_bus, *receiver_bus;
+  GstMessage *msg;
+  GstPad *pad;
+  GstClockTime start, end;
+  gdouble cpu_start, cpu, secs, sent_mbit, received_mbit;
+  guint64 num_messages;
+  gchar *uri;
+  GError *err = NULL;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    mbits = MAX (atoi (argv[1]), 1);
+  if (argc > 2)
+    seconds = MAX (atoi (argv[2]), 1);
+  if (argc > 3)
+    port = atoi (argv[3]);
+
+  num_messages = (guint64) mbits * 1000000 / 8 / MESSAGE_SIZE * seconds;
+
+  uri = g_strdup_printf ("srt://:%u?mode=listener", port);
+  sender = gst_parse_launch ("fakesrc name=src sizetype=fixed filltype=zero "
+      "! srtsink name=sink wait-for-connection=true sync=false async=false",
+      &err);
+  if (!sender)
+    g_error ("Failed to create sender: %s", err->message);
+  src = gst_bin_get_by_name (GST_BIN (sender), "src");
+  g_object_set (src, "sizemax", MESSAGE_SIZE, "num-buffers",
+      (gint) num_messages, "datarate", mbits * 1000000 / 8, "sync", TRUE,
+      NULL);
+  sink = gst_bin_get_by_name (GST_BIN (sender), "sink");
+  g_object_set (sink, "uri", uri, NULL);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+  g_free (uri);
+
+  uri = g_strdup_printf ("srt://127.0.0.1:%u", port);
+  receiver = gst_parse_launch ("srtsrc name=src ! fakesink name=sink "
+      "sync=false async=false", &err);
+  if (!receiver)
+    g_error ("Failed to create receiver: %s", err->message);
+  src = gst_bin_get_by_name (GST_BIN (receiver), "src");
+  g_object_set (src, "uri", uri, NULL);
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST, count_probe,
+      NULL, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (src);
+  g_free (uri);
+
+  sender_bus = gst_element_get_bus (sender);
+  receiver_bus = gst_element_get_bus (receiver);
+
+  cpu_start = cpu_seconds ();
+  start = gst_util_get_timestamp ();
+
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+  gst_element_set_state (sender, GST_STATE_PLAYING);
+
+  /* srtsink does not forward EOS, so stop the receiver once the sender is
+   * done and the last messages had time to arrive */
+  msg = gst_bus_timed_pop_filtered (sender_bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_error ("Error in sender: %s", err->message);
+  }
+  gst_message_unref (msg);
+  g_usleep (G_USEC_PER_SEC / 2);
+  check_error (receiver_bus, "receiver");
+
+  end = gst_util_get_timestamp ();
+  cpu = cpu_seconds () - cpu_start;
+
+  gst_element_set_state (sender, GST_STATE_NULL);
+  gst_element_set_state (receiver, GST_STATE_NULL);
+  gst_object_unref (sender_bus);
+  gst_object_unref (receiver_bus);
+  gst_object_unref (sender);
+  gst_object_unref (receiver);
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  sent_mbit = (gdouble) num_messages * MESSAGE_SIZE * 8 / 1000000;
+  received_mbit = (gdouble) received_bytes * 8 / 1000000;
+
+  g_print ("%" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " messages, "
+      "%.1f of %.1f Mbit received in %.3f s\n", received_messages,
+      num_messages, received_mbit, sent_mbit, secs);
+  g_print ("%.3f s CPU, %.3f ms CPU per Mbit\n", cpu,
+      received_mbit > 0 ? cpu * 1000 / received_mbit : 0.0);
+
+  return 0;
+}
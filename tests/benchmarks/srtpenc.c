@@ -0,0 +1,166 @@
+/* GStreamer
+ *
+ * srtpenc.c: benchmark the SRTP protection path of srtpenc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes RTP packets through srtpenc and reports packets per second for
+ * the two protection paths:
+ *  - copy: the input buffers are shared, srtpenc copies them into buffers
+ *    from its pool (this is what every packet used to cost)
+ *  - in-place: the input buffers are writable and have room for the SRTP
+ *    trailer, srtpenc protects them without any allocation or copy
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+#define RTP_HEADER_LEN 12
+#define DEFAULT_PACKETS 200000
+#define DEFAULT_PAYLOAD_SIZE 1200
+
+static const guint8 master_key[30] = {
+  0x01, 0x23, 0x45, 0x67, 0x89, 0x01, 0x23, 0x45, 0x67, 0x89,
+  0x01, 0x23, 0x45, 0x67, 0x89, 0x01, 0x23, 0x45, 0x67, 0x89,
+  0x01, 0x23, 0x45, 0x67, 0x89, 0x01, 0x23, 0x45, 0x67, 0x89
+};
+
+static GstBuffer *
+create_rtp_packet (guint16 seqnum, guint payload_size)
+{
+  GstAllocationParams params;
+  GstBuffer *buf;
+  GstMemory *mem;
+  GstMapInfo map;
+
+  /* leave room after the packet for the SRTP trailer */
+  gst_allocation_params_init (&params);
+  params.padding = 64;
+
+  mem = gst_allocator_alloc (NULL, RTP_HEADER_LEN + payload_size, &params);
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0xab, map.size);
+  map.data[0] = 0x80;
+  map.data[1] = 96;
+  GST_WRITE_UINT16_BE (map.data + 2, seqnum);
+  GST_WRITE_UINT32_BE (map.data + 4, seqnum * 3000);
+  GST_WRITE_UINT32_BE (map.data + 8, 0x12345678);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstHarness *
+create_harness (void)
+{
+  GstHarness *h;
+  GstBuffer *key;
+
+  h = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0", "rtp_src_0");
+  key = gst_buffer_new_memdup (master_key, sizeof (master_key));
+  g_object_set (h->element, "key", key, NULL);
+  gst_buffer_unref (key);
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp, media=(string)video, "
+      "clock-rate=(int)90000, encoding-name=(string)VP8, payload=(int)96, "
+      "ssrc=(uint)305419896");
+
+  return h;
+}
+
+static void
+run (const gchar * name, guint num_packets, guint payload_size,
+    gboolean in_place)
+{
+  GstHarness *h;
+  GstBuffer **packets;
+  GstClockTime start, end;
+  gdouble secs;
+  guint i;
+
+  h = create_harness ();
+
+  /* prepare the input up front so only srtpenc is measured */
+  packets = g_new (GstBuffer *, num_packets);
+  for (i = 0; i < num_packets; i++)
+    packets[i] = create_rtp_packet (i, payload_size);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < num_packets; i++) {
+    GstBuffer *in = packets[i];
+
+    /* keeping a ref makes the input read-only for srtpenc */
+    if (!in_place)
+      gst_buffer_ref (in);
+
+    if (gst_harness_push (h, in) != GST_FLOW_OK)
+      g_error ("Failed to push packet %u", i);
+    gst_buffer_unref (gst_harness_pull (h));
+  }
+  end = gst_util_get_timestamp ();
+
+  for (i = 0; i < num_packets; i++) {
+    if (!in_place)
+      gst_buffer_unref (packets[i]);
+  }
+  g_free (packets);
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%-9s %8u packets of %5u bytes in %8.3f s: %12.0f packets/s\n",
+      name, num_packets, payload_size, secs, num_packets / secs);
+
+  gst_harness_teardown (h);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint num_packets = DEFAULT_PACKETS;
+  guint payload_size = DEFAULT_PAYLOAD_SIZE;
+  GstElementFactory *factory;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    num_packets = atoi (argv[1]);
+  if (argc > 2)
+    payload_size = atoi (argv[2]);
+
+  factory = gst_element_factory_find ("srtpenc");
+  if (!factory) {
+    g_printerr ("srtpenc element not available\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  run ("copy", num_packets, payload_size, FALSE);
+  run ("in-place", num_packets, payload_size, TRUE);
+
+  return 0;
+}
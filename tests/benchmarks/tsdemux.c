@@ -0,0 +1,152 @@
+/* GStreamer
+ *
+ * tsdemux.c: benchmark demuxing of captured transport streams
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Demuxes a transport stream file in push mode for a few input buffer
+ * sizes, from the 7 packets of an UDP datagram to large file reads, and
+ * reports the transport stream bitrate handled per second of wall clock
+ * time.
+ *
+ * Usage: tsdemux FILE [ITERATIONS]
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+
+#define DEFAULT_ITERATIONS 5
+
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, GstBin * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (pipeline, sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    g_error ("Failed to link %s", GST_PAD_NAME (pad));
+  gst_object_unref (sinkpad);
+}
+
+static gdouble
+run_once (const gchar * location, guint blocksize)
+{
+  GstElement *pipeline, *src, *queue, *demux;
+  GstBus *bus;
+  GstMessage *msg;
+  GstClockTime start, end;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  demux = gst_element_factory_make ("tsdemux", NULL);
+  g_object_set (src, "location", location, "blocksize", blocksize, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, queue, demux, NULL);
+  /* The queue forces tsdemux into push mode, as when receiving from the
+   * network */
+  if (!gst_element_link_many (src, queue, demux, NULL))
+    g_error ("Failed to link pipeline");
+  g_signal_connect (demux, "pad-added", G_CALLBACK (pad_added_cb), pipeline);
+
+  bus = gst_element_get_bus (pipeline);
+
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  end = gst_util_get_timestamp ();
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_error ("Error demuxing %s: %s", location, err->message);
+  }
+
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return (gdouble) (end - start) / GST_SECOND;
+}
+
+static void
+run (const gchar * location, guint64 size, guint blocksize, guint iterations)
+{
+  gdouble secs, best = G_MAXDOUBLE;
+  guint i;
+
+  for (i = 0; i < iterations; i++) {
+    secs = run_once (location, blocksize);
+    best = MIN (best, secs);
+  }
+
+  g_print ("%9u %10.3f %12.1f\n", blocksize, best, size * 8 / best / 1000000);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const guint blocksizes[] = { 7 * 188, 32 * 188, 4096, 65536 };
+  guint iterations = DEFAULT_ITERATIONS;
+  GstElementFactory *factory;
+  GStatBuf st;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  if (argc < 2) {
+    g_printerr ("Usage: %s FILE [ITERATIONS]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 2)
+    iterations = MAX (atoi (argv[2]), 1);
+
+  if (g_stat (argv[1], &st) != 0) {
+    g_printerr ("Could not stat %s\n", argv[1]);
+    return 1;
+  }
+
+  factory = gst_element_factory_find ("tsdemux");
+  if (!factory) {
+    g_printerr ("tsdemux element not available\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  g_print ("%9s %10s %12s\n", "blocksize", "wall s", "Mbit/s");
+
+  for (i = 0; i < G_N_ELEMENTS (blocksizes); i++)
+    run (argv[1], st.st_size, blocksizes[i], iterations);
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+/* GStreamer
+ *
+ * tsmux.c: benchmark constant bitrate muxing with mpegtsmux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Muxes a high bitrate H.264 stream into a constant bitrate transport
+ * stream for a few output alignments, and reports the transport stream
+ * bitrate produced per second of wall clock time and the number of
+ * output buffers.
+ *
+ * Run with GST_PLUGIN_PATH pointing to the build directory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+#define DEFAULT_SECONDS 20
+#define FRAMERATE 25
+#define VIDEO_BITRATE (40 * 1000 * 1000)
+#define MUX_BITRATE (50 * 1000 * 1000)
+
+#define VIDEO_CAPS "video/x-h264, stream-format=(string)byte-stream, " \
+    "alignment=(string)nal, framerate=(fraction)25/1"
+
+static void
+count_output (GstBuffer * buf, guint64 * bytes, guint * buffers)
+{
+  *bytes += gst_buffer_get_size (buf);
+  *buffers += 1;
+  gst_buffer_unref (buf);
+}
+
+static void
+run (gint alignment, guint seconds)
+{
+  GstHarness *h;
+  GstBuffer *inbuf, *outbuf;
+  GstClockTime start, end, ts = 0;
+  guint frame_size = VIDEO_BITRATE / 8 / FRAMERATE;
+  guint64 bytes = 0;
+  guint buffers = 0;
+  gdouble secs;
+  guint i;
+
+  h = gst_harness_new_with_padnames ("mpegtsmux", "sink_%d", "src");
+  g_object_set (h->element, "bitrate", (guint64) MUX_BITRATE, "alignment",
+      alignment, NULL);
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS);
+
+  inbuf = gst_buffer_new_allocate (NULL, frame_size, NULL);
+  gst_buffer_memset (inbuf, 0, 0, frame_size);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < seconds * FRAMERATE; i++) {
+    GstBuffer *buf = gst_buffer_copy (inbuf);
+
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = ts;
+    GST_BUFFER_DURATION (buf) = GST_SECOND / FRAMERATE;
+    if (i % FRAMERATE != 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    ts += GST_SECOND / FRAMERATE;
+
+    if (gst_harness_push (h, buf) != GST_FLOW_OK)
+      g_error ("Failed to push buffer");
+
+    while ((outbuf = gst_harness_try_pull (h)))
+      count_output (outbuf, &bytes, &buffers);
+  }
+
+  gst_harness_push_event (h, gst_event_new_eos ());
+  while (gst_harness_pull_until_eos (h, &outbuf) && outbuf)
+    count_output (outbuf, &bytes, &buffers);
+  end = gst_util_get_timestamp ();
+
+  gst_buffer_unref (inbuf);
+  gst_harness_teardown (h);
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%9d %10.3f %12.1f %10u %10.1f\n", alignment, secs,
+      bytes * 8 / secs / 1000000, buffers, (gdouble) bytes / buffers);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const gint alignments[] = { 0, 1, 7, 32 };
+  guint seconds = DEFAULT_SECONDS;
+  GstElementFactory *factory;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    seconds = atoi (argv[1]);
+
+  factory = gst_element_factory_find ("mpegtsmux");
+  if (!factory) {
+    g_printerr ("mpegtsmux element not available\n");
+    return 1;
+  }
+  gst_object_unref (factory);
+
+  g_print ("%9s %10s %12s %10s %10s\n", "alignment", "wall s", "Mbit/s",
+      "buffers", "bytes/buf");
+
+  for (i = 0; i < G_N_ELEMENTS (alignments); i++)
+    run (alignments[i], seconds);
+
+  return 0;
+}
@@ -726,6 +726,119 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+static GMutex prefetch_test_lock;
+static GCond prefetch_test_cond;
+static guint prefetch_test_requests;
+
+static gboolean
+gst_hlsdemux_test_prefetch_src_start (GstTestHTTPSrc * src,
+    const gchar * uri, GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  gboolean ret;
+
+  /* fragments are requested from both the download and the prefetch task */
+  g_mutex_lock (&prefetch_test_lock);
+  ret = gst_hlsdemux_test_src_start (src, uri, input_data, user_data);
+
+  if (g_str_has_suffix (uri, ".ts")) {
+    if (GST_OBJECT_PARENT (src) == NULL) {
+      /* the prefetch task downloads with a source element of its own, the
+       * source elements of the streams are in their bin */
+      prefetch_test_requests++;
+      g_cond_broadcast (&prefetch_test_cond);
+    } else if (g_str_has_suffix (uri, "001.ts")) {
+      gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+      /* the upcoming fragments are prefetched while the first one is still
+       * being downloaded */
+      while (prefetch_test_requests == 0) {
+        if (!g_cond_wait_until (&prefetch_test_cond, &prefetch_test_lock,
+                end_time))
+          break;
+      }
+    }
+  }
+  g_mutex_unlock (&prefetch_test_lock);
+
+  return ret;
+}
+
+static void
+testPrefetchPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+}
+
+/*
+ * Test that fragments are downloaded ahead of time by the prefetch task, and
+ * that they are pushed in order and are not requested a second time
+ */
+GST_START_TEST (testPrefetch)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  guint i;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  prefetch_test_requests = 0;
+  http_src_callbacks.src_start = gst_hlsdemux_test_prefetch_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  assert_equals_uint64 (gst_value_array_get_size (requests),
+      G_N_ELEMENTS (inputTestData) - 1);
+  /* the download and prefetch tasks run concurrently, so only check that
+   * every URI was requested exactly once */
+  for (i = 0; inputTestData[i].uri; ++i) {
+    guint j, count = 0;
+
+    for (j = 0; j < gst_value_array_get_size (requests); ++j) {
+      const gchar *uri =
+          g_value_get_string (gst_value_array_get_value (requests, j));
+
+      if (g_strcmp0 (uri, inputTestData[i].uri) == 0)
+        count++;
+    }
+    fail_unless (count == 1, "%s requested %u times", inputTestData[i].uri,
+        count);
+  }
+
+  /* at least 002.ts was prefetched, while 001.ts was being downloaded */
+  fail_unless (prefetch_test_requests > 0, "nothing was prefetched");
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -737,6 +850,7 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
+  tcase_add_test (tc_basicTest, testPrefetch);
   tcase_add_test (tc_basicTest, testSeek);
   tcase_add_test (tc_basicTest, testSeekKeyUnitPosition);
   tcase_add_test (tc_basicTest, testSeekPosition);
@@ -366,7 +366,7 @@ GST_START_TEST (test_load_main_playlist_rendition)
   master = load_playlist (ON_DEMAND_PLAYLIST);
   variant = master->default_variant;
 
-  assert_equals_int (g_list_length (variant->m3u8->files), 4);
+  assert_equals_int (variant->m3u8->files->len, 4);
   assert_equals_int (master->version, 0);
 
   gst_hls_master_playlist_unref (master);
@@ -476,13 +476,14 @@ check_on_demand_playlist (const gchar * data)
   /* Check that we are not live */
   assert_equals_int (gst_m3u8_is_live (pl), FALSE);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/004.ts");
   assert_equals_int (file->sequence, 3);
 
@@ -532,14 +533,15 @@ GST_START_TEST (test_live_playlist)
   assert_equals_int (gst_m3u8_is_live (pl), TRUE);
   assert_equals_int (pl->sequence, 2680);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2680.ts");
   assert_equals_int (file->sequence, 2680);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2683.ts");
   assert_equals_int (file->sequence, 2683);
@@ -567,7 +569,7 @@ GST_START_TEST (test_live_playlist_rotated)
 
   assert_equals_int (pl->sequence, 2680);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 2680);
 
   ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
@@ -579,7 +581,7 @@ GST_START_TEST (test_live_playlist_rotated)
   /* FIXME: Sequence should last - 3. Should it? */
   assert_equals_int (pl->sequence, 3001);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 3001);
 
   gst_hls_master_playlist_unref (master);
@@ -599,13 +601,13 @@ GST_START_TEST (test_playlist_with_doubles_duration)
   pl = master->default_variant->m3u8;
 
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.321);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.6789);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.2344);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.92);
   fail_unless (gst_m3u8_get_seek_range (pl, &start, &stop));
   assert_equals_int64 (start, 0);
@@ -631,26 +633,26 @@ GST_START_TEST (test_playlist_with_encryption)
   master = load_playlist (AES_128_ENCRYPTED_PLAYLIST);
   pl = master->default_variant->m3u8;
 
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
 
   /* Check all media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key.bin");
   fail_unless (memcmp (&file->iv, iv2, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 4));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 4));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
@@ -670,7 +672,7 @@ GST_START_TEST (test_update_invalid_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup ("#INVALID"));
   assert_equals_int (ret, FALSE);
 
@@ -689,26 +691,90 @@ GST_START_TEST (test_update_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup (ON_DEMAND_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   gst_hls_master_playlist_unref (master);
 
   /* Test updates in live playlists */
   master = load_playlist (LIVE_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Add a new entry to the playlist and check the update */
   live_pl = g_strdup_printf ("%s\n%s\n%s", LIVE_PLAYLIST, "#EXTINF:8",
       "https://priv.example.com/fileSequence2683.ts");
   ret = gst_m3u8_update (pl, live_pl);
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
   /* Test sliding window */
   ret = gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_update_playlist_sliding_window)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file, *kept;
+  gboolean ret;
+
+  master = load_playlist ("#EXTM3U\n"
+      "#EXT-X-TARGETDURATION:8\n"
+      "#EXT-X-MEDIA-SEQUENCE:10\n"
+      "#EXTINF:8,\nseg10.ts\n"
+      "#EXTINF:8,\nseg11.ts\n" "#EXTINF:8,\nseg12.ts\n");
+  pl = master->default_variant->m3u8;
+  assert_equals_int (pl->files->len, 3);
+  kept = gst_m3u8_media_file_ref (g_ptr_array_index (pl->files, 1));
+  assert_equals_string (kept->uri, "http://localhost/seg11.ts");
+
+  /* Segments that are still in the window are kept as they are */
+  ret = gst_m3u8_update (pl, g_strdup ("#EXTM3U\n"
+          "#EXT-X-TARGETDURATION:8\n"
+          "#EXT-X-MEDIA-SEQUENCE:11\n"
+          "#EXTINF:8,\nseg11.ts\n"
+          "#EXTINF:8,\nseg12.ts\n" "#EXTINF:8,\nseg13.ts\n"));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (pl->files->len, 3);
+  fail_unless (g_ptr_array_index (pl->files, 0) == kept);
+  assert_equals_uint64 (kept->start, 0);
+  file = g_ptr_array_index (pl->files, 2);
+  assert_equals_string (file->uri, "http://localhost/seg13.ts");
+  assert_equals_int (file->sequence, 13);
+  assert_equals_uint64 (file->start, 16 * GST_SECOND);
+
+  /* Same sequence with a different URI must be rejected */
+  ret = gst_m3u8_update (pl, g_strdup ("#EXTM3U\n"
+          "#EXT-X-TARGETDURATION:8\n"
+          "#EXT-X-MEDIA-SEQUENCE:11\n"
+          "#EXTINF:8,\nother11.ts\n" "#EXTINF:8,\nseg12.ts\n"));
+  assert_equals_int (ret, FALSE);
+
+  gst_m3u8_media_file_unref (kept);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_find_file_index)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  assert_equals_int (gst_m3u8_find_file_index (pl, 0), 0);
+  assert_equals_int (gst_m3u8_find_file_index (pl, 8 * GST_SECOND - 1), 0);
+  assert_equals_int (gst_m3u8_find_file_index (pl, 8 * GST_SECOND), 1);
+  assert_equals_int (gst_m3u8_find_file_index (pl, 31 * GST_SECOND), 3);
+  assert_equals_int (gst_m3u8_find_file_index (pl, 32 * GST_SECOND), 4);
+
   gst_hls_master_playlist_unref (master);
 }
 
@@ -724,9 +790,9 @@ GST_START_TEST (test_playlist_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -749,16 +815,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 100);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -772,16 +839,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 0);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -845,6 +913,47 @@ GST_START_TEST (test_get_next_fragment)
 
 GST_END_TEST;
 
+GST_START_TEST (test_peek_fragment)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *mf;
+
+  master = load_playlist (BYTE_RANGES_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  /* Peeking does not move the current fragment */
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 0);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 2);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 2000);
+  gst_m3u8_media_file_unref (mf);
+
+  gst_m3u8_advance_fragment (pl, TRUE);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 1);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 2000);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, FALSE, 1);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  /* Past the end of the playlist */
+  fail_unless (gst_m3u8_peek_fragment (pl, TRUE, 3) == NULL);
+  fail_unless (gst_m3u8_peek_fragment (pl, FALSE, 2) == NULL);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_get_duration)
 {
   GstHLSMasterPlaylist *master;
@@ -1413,9 +1522,10 @@ GST_START_TEST (test_map_tag)
   GstHLSMasterPlaylist *master;
   GstHLSVariantStream *stream;
   GstM3U8 *m3u8;
-  GList *files, *walk;
+  GPtrArray *files;
   GstM3U8MediaFile *seg1, *seg2, *seg3;
   GstM3U8InitFile *init1, *init2;
+  guint i;
 
   /* Test EXT-X-MAP tag
    * This M3U8 has two EXT-X-MAP tag.
@@ -1434,18 +1544,18 @@ GST_START_TEST (test_map_tag)
 
   files = m3u8->files;
   fail_unless (m3u8 != NULL);
-  assert_equals_int (g_list_length (files), 3);
-  for (walk = files; walk; walk = g_list_next (walk)) {
-    GstM3U8MediaFile *file = (GstM3U8MediaFile *) walk->data;
+  assert_equals_int (files->len, 3);
+  for (i = 0; i < files->len; i++) {
+    GstM3U8MediaFile *file = g_ptr_array_index (files, i);
 
     GstM3U8InitFile *init_file = file->init_file;
     fail_unless (init_file != NULL);
     fail_unless (init_file->uri != NULL);
   }
 
-  seg1 = g_list_nth_data (files, 0);
-  seg2 = g_list_nth_data (files, 1);
-  seg3 = g_list_nth_data (files, 2);
+  seg1 = g_ptr_array_index (files, 0);
+  seg2 = g_ptr_array_index (files, 1);
+  seg3 = g_ptr_array_index (files, 2);
 
   /* Segment 1 and 2 share the identical init segment */
   fail_unless (seg1->init_file == seg2->init_file);
@@ -1495,9 +1605,12 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
   tcase_add_test (tc_m3u8, test_update_playlist);
+  tcase_add_test (tc_m3u8, test_update_playlist_sliding_window);
+  tcase_add_test (tc_m3u8, test_find_file_index);
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
+  tcase_add_test (tc_m3u8, test_peek_fragment);
   tcase_add_test (tc_m3u8, test_get_duration);
   tcase_add_test (tc_m3u8, test_get_target_duration);
   tcase_add_test (tc_m3u8, test_get_stream_for_bitrate);
@@ -586,6 +586,208 @@ GST_START_TEST (test_keyframe_flag_propagation)
 
 GST_END_TEST;
 
+#define CHUNK_TEST_BUFFERS 45
+#define CHUNK_TEST_KEYFRAME(i) ((i) % KEYFRAME_DISTANCE == 2)
+
+static gboolean chunk_test_eos;
+
+static GstPadProbeReturn
+chunk_test_eos_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS) {
+    g_mutex_lock (&check_mutex);
+    chunk_test_eos = TRUE;
+    g_cond_signal (&check_cond);
+    g_mutex_unlock (&check_mutex);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Muxes a header buffer followed by a mix of key and delta units and
+ * returns the output up to EOS */
+static GList *
+run_chunk_test (guint alignment, guint64 bitrate)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GList *result;
+  guint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "alignment", alignment, "bitrate", bitrate, NULL);
+
+  chunk_test_eos = FALSE;
+  gst_pad_add_probe (mysinkpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      chunk_test_eos_probe, NULL, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < CHUNK_TEST_BUFFERS; i++) {
+    GstBuffer *inbuffer;
+
+    /* sizes picked to end packets at varying chunk offsets */
+    inbuffer = gst_buffer_new_and_alloc (i == 0 ? 10 : 500 + 397 * (i % 7));
+    gst_buffer_memset (inbuffer, 0, i, gst_buffer_get_size (inbuffer));
+    GST_BUFFER_PTS (inbuffer) = i * 40 * GST_MSECOND;
+
+    if (i == 0)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_HEADER);
+    if (!CHUNK_TEST_KEYFRAME (i))
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  g_mutex_lock (&check_mutex);
+  while (!chunk_test_eos)
+    g_cond_wait (&check_cond, &check_mutex);
+  result = buffers;
+  buffers = NULL;
+  g_mutex_unlock (&check_mutex);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+
+  return result;
+}
+
+static GByteArray *
+chunk_test_concat (GList * bufs)
+{
+  GByteArray *data = g_byte_array_new ();
+
+  for (; bufs; bufs = bufs->next) {
+    GstMapInfo map;
+
+    gst_buffer_map (bufs->data, &map, GST_MAP_READ);
+    g_byte_array_append (data, map.data, map.size);
+    gst_buffer_unmap (bufs->data, &map);
+  }
+
+  return data;
+}
+
+static void
+check_chunks (GList * bufs, guint alignment)
+{
+  guint n_pes = 0, n_keyunit = 0, n_header = 0;
+
+  fail_unless (bufs != NULL);
+
+  for (; bufs; bufs = bufs->next) {
+    GstBuffer *buf = bufs->data;
+    gboolean keyunit, header;
+    GstMapInfo map;
+    gsize offset;
+
+    keyunit = !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    header = GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER);
+    n_keyunit += keyunit;
+    n_header += header;
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+
+    if (alignment > 0)
+      fail_unless_equals_int (map.size, alignment * 188);
+    else
+      fail_unless (map.size > 0 && map.size % 188 == 0);
+
+    for (offset = 0; offset < map.size; offset += 188) {
+      const guint8 *data = map.data + offset;
+      guint pid;
+
+      fail_unless_equals_int (data[0], 0x47);
+      pid = GST_READ_UINT16_BE (data + 1) & 0x1FFF;
+
+      /* only look at the start of the PES packet of every input buffer */
+      if (pid < 0x40 || pid == 0x1FFF || !(data[1] & 0x40))
+        continue;
+      if (data[3] & 0x20)
+        data += 1 + data[4];
+      fail_unless_equals_int (GST_READ_UINT24_BE (data + 4), 0x000001);
+
+      /* without alignment, headers and key units start a buffer of their
+       * own, so they are the ones its flags come from */
+      if (alignment == 0) {
+        fail_unless_equals_int (header, n_pes == 0);
+        if (CHUNK_TEST_KEYFRAME (n_pes))
+          fail_unless (keyunit);
+      }
+      n_pes++;
+    }
+
+    gst_buffer_unmap (buf, &map);
+  }
+
+  fail_unless_equals_int (n_pes, CHUNK_TEST_BUFFERS);
+
+  if (alignment == 0) {
+    fail_unless_equals_int (n_header, 1);
+    fail_unless_equals_int (n_keyunit,
+        (CHUNK_TEST_BUFFERS - 3) / KEYFRAME_DISTANCE + 1);
+  }
+}
+
+static void
+check_chunk_alignment (guint64 bitrate)
+{
+  GList *unaligned, *aligned;
+  GByteArray *unaligned_data, *aligned_data;
+  gsize offset;
+
+  unaligned = run_chunk_test (0, bitrate);
+  aligned = run_chunk_test (7, bitrate);
+
+  check_chunks (unaligned, 0);
+  check_chunks (aligned, 7);
+
+  /* the packet stream does not depend on how it is split into buffers,
+   * apart from the null packets filling the last aligned buffer */
+  unaligned_data = chunk_test_concat (unaligned);
+  aligned_data = chunk_test_concat (aligned);
+
+  fail_unless (aligned_data->len >= unaligned_data->len);
+  fail_unless (aligned_data->len - unaligned_data->len < 7 * 188);
+  fail_unless (memcmp (aligned_data->data, unaligned_data->data,
+          unaligned_data->len) == 0);
+
+  for (offset = unaligned_data->len; offset < aligned_data->len;
+      offset += 188)
+    fail_unless_equals_int (GST_READ_UINT16_BE (aligned_data->data +
+            offset + 1) & 0x1FFF, 0x1FFF);
+
+  g_byte_array_unref (unaligned_data);
+  g_byte_array_unref (aligned_data);
+  g_list_free_full (unaligned, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (aligned, (GDestroyNotify) gst_buffer_unref);
+}
+
+GST_START_TEST (test_chunks)
+{
+  check_chunk_alignment (0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_chunks_bitrate)
+{
+  /* with a bitrate, PCR packets are written while the packet they precede
+   * is still being filled */
+  check_chunk_alignment (4 * 1000 * 1000);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsmux_suite (void)
 {
@@ -599,6 +801,8 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
+  tcase_add_test (tc_chain, test_chunks);
+  tcase_add_test (tc_chain, test_chunks_bitrate);
   tcase_add_test (tc_chain, test_reappearing_pad_while_playing);
   tcase_add_test (tc_chain, test_reappearing_pad_while_stopped);
   tcase_add_test (tc_chain, test_unused_pad);
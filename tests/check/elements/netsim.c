@@ -51,6 +51,114 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+#define NUM_BUFFERS 200
+#define SENTINEL_OFFSET G_MAXUINT64
+
+/* Pushes NUM_BUFFERS buffers then a sentinel that is never dropped, and
+ * returns a string with one character per buffer telling whether it was
+ * received */
+static gchar *
+run_loss_pattern (GstHarness * h, GObject * profile)
+{
+  gchar *received = g_malloc0 (NUM_BUFFERS + 1);
+  GstBuffer *buf;
+  guint i;
+
+  memset (received, '-', NUM_BUFFERS);
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  for (i = 0; i < NUM_BUFFERS; i++) {
+    buf = gst_harness_create_buffer (h, 100);
+    GST_BUFFER_OFFSET (buf) = i;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  g_object_set (profile, "loss-model", 0, "drop-probability", 0.0, NULL);
+  buf = gst_harness_create_buffer (h, 100);
+  GST_BUFFER_OFFSET (buf) = SENTINEL_OFFSET;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  while ((buf = gst_harness_pull (h))) {
+    guint64 offset = GST_BUFFER_OFFSET (buf);
+    gst_buffer_unref (buf);
+    if (offset == SENTINEL_OFFSET)
+      break;
+    fail_unless (offset < NUM_BUFFERS);
+    received[offset] = 'x';
+  }
+
+  return received;
+}
+
+static gchar *
+run_seeded_gilbert_elliott (guint seed)
+{
+  GstHarness *h = gst_harness_new ("netsim");
+  gchar *received;
+
+  g_object_set (h->element, "seed", seed, "loss-model", 1,
+      "gilbert-elliott-p", 0.1, "gilbert-elliott-r", 0.3,
+      "gilbert-elliott-good-loss", 0.05, "gilbert-elliott-bad-loss", 0.8,
+      NULL);
+  received = run_loss_pattern (h, G_OBJECT (h->element));
+  gst_harness_teardown (h);
+
+  return received;
+}
+
+GST_START_TEST (netsim_seeded_replay)
+{
+  gchar *first = run_seeded_gilbert_elliott (42);
+  gchar *second = run_seeded_gilbert_elliott (42);
+  gchar *other = run_seeded_gilbert_elliott (43);
+
+  /* some, but not all, buffers are lost */
+  fail_unless (strchr (first, 'x') != NULL);
+  fail_unless (strchr (first, '-') != NULL);
+
+  /* the same seed replays the same losses */
+  fail_unless_equals_string (first, second);
+  fail_if (g_str_equal (first, other));
+
+  g_free (first);
+  g_free (second);
+  g_free (other);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_request_pad_profile)
+{
+  GstElement *netsim = gst_element_factory_make ("netsim", NULL);
+  GstPad *sinkpad, *srcpad;
+  GstHarness *h;
+  gchar *received;
+  gfloat drop_probability;
+
+  sinkpad = gst_element_request_pad_simple (netsim, "sink_%u");
+  fail_unless_equals_string (GST_PAD_NAME (sinkpad), "sink_0");
+  srcpad = gst_element_get_static_pad (netsim, "src_0");
+  fail_unless (srcpad != NULL);
+  gst_object_unref (srcpad);
+
+  /* the stream of the pad is impaired, not the one of the always pads */
+  gst_child_proxy_set (GST_CHILD_PROXY (netsim),
+      "sink_0::drop-probability", 1.0, NULL);
+  g_object_get (netsim, "drop-probability", &drop_probability, NULL);
+  fail_unless_equals_float (drop_probability, 0.0);
+
+  h = gst_harness_new_with_element (netsim, "sink_0", "src_0");
+  received = run_loss_pattern (h, G_OBJECT (sinkpad));
+  fail_unless (strchr (received, 'x') == NULL);
+  g_free (received);
+
+  gst_object_unref (sinkpad);
+  gst_harness_teardown (h);
+  gst_object_unref (netsim);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -60,6 +168,8 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_seeded_replay);
+  tcase_add_test (tc_chain, netsim_request_pad_profile);
 
   return s;
 }
@@ -0,0 +1,184 @@
+/* GStreamer
+ *
+ * unit test for scenechange
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#define WIDTH 64
+#define HEIGHT 64
+#define CAPS_STR "video/x-raw,format=I420,width=64,height=64,framerate=30/1"
+
+/* frames of the first scene before the cut, enough to fill the history of
+ * scores the detection compares with */
+#define SCENE_FRAMES 8
+
+#define LUMA_BEFORE 16
+#define LUMA_AFTER 235
+
+static GstBuffer *
+create_frame (guint8 luma, guint n)
+{
+  GstVideoInfo info;
+  GstBuffer *buffer;
+  gsize chroma_offset;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+
+  chroma_offset = GST_VIDEO_INFO_PLANE_OFFSET (&info, 1);
+  gst_buffer_memset (buffer, 0, luma, chroma_offset);
+  gst_buffer_memset (buffer, chroma_offset, 128,
+      GST_VIDEO_INFO_SIZE (&info) - chroma_offset);
+
+  GST_BUFFER_PTS (buffer) = gst_util_uint64_scale (n, GST_SECOND, 30);
+  GST_BUFFER_DURATION (buffer) = gst_util_uint64_scale (1, GST_SECOND, 30);
+
+  return buffer;
+}
+
+static void
+check_meta (GstBuffer * buffer, gdouble score, gboolean scene_change,
+    gdouble histogram_distance)
+{
+  GstCustomMeta *meta;
+  GstStructure *s;
+  gdouble d;
+  gboolean b;
+  guint version;
+
+  meta = gst_buffer_get_custom_meta (buffer, "GstSceneChangeMeta");
+  fail_unless (meta != NULL);
+  s = gst_custom_meta_get_structure (meta);
+
+  fail_unless (gst_structure_get_uint (s, "version", &version));
+  fail_unless_equals_int (version, 1);
+  fail_unless (gst_structure_get_double (s, "score", &d));
+  fail_unless_equals_float (d, score);
+  fail_unless (gst_structure_get_boolean (s, "scene-change", &b));
+  fail_unless_equals_int (b, scene_change);
+
+  if (histogram_distance >= 0.0) {
+    fail_unless (gst_structure_get_double (s, "histogram-distance", &d));
+    fail_unless_equals_float (d, histogram_distance);
+  } else {
+    fail_if (gst_structure_has_field (s, "histogram-distance"));
+  }
+}
+
+static gboolean
+has_force_key_unit_event (GstHarness * h)
+{
+  GstEvent *event;
+  gboolean found = FALSE;
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (gst_video_event_is_force_key_unit (event))
+      found = TRUE;
+    gst_event_unref (event);
+  }
+
+  return found;
+}
+
+static void
+run_cut (const gchar * launch, gboolean with_histogram)
+{
+  GstHarness *h = gst_harness_new_parse (launch);
+  GstBuffer *buffer;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  /* The first frame has nothing to be compared with */
+  buffer = gst_harness_push_and_pull (h, create_frame (LUMA_BEFORE, 0));
+  fail_if (gst_buffer_get_custom_meta (buffer, "GstSceneChangeMeta"));
+  gst_buffer_unref (buffer);
+
+  for (i = 1; i < SCENE_FRAMES; i++) {
+    buffer = gst_harness_push_and_pull (h, create_frame (LUMA_BEFORE, i));
+    check_meta (buffer, 0.0, FALSE, with_histogram ? 0.0 : -1.0);
+    gst_buffer_unref (buffer);
+  }
+  fail_if (has_force_key_unit_event (h));
+
+  /* Every luma sample changes by the same amount and the histograms have
+   * no bin in common */
+  buffer = gst_harness_push_and_pull (h, create_frame (LUMA_AFTER, i));
+  check_meta (buffer, LUMA_AFTER - LUMA_BEFORE, TRUE,
+      with_histogram ? 1.0 : -1.0);
+  gst_buffer_unref (buffer);
+  fail_unless (has_force_key_unit_event (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_meta_cut)
+{
+  run_cut ("scenechange attach-meta=true", FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_meta_cut_downscaled)
+{
+  run_cut ("scenechange attach-meta=true downscale=4 n-threads=2", TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_no_meta_by_default)
+{
+  GstHarness *h = gst_harness_new ("scenechange");
+  GstBuffer *buffer;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  for (i = 0; i < 3; i++) {
+    buffer = gst_harness_push_and_pull (h, create_frame (LUMA_BEFORE, i));
+    fail_if (gst_buffer_get_custom_meta (buffer, "GstSceneChangeMeta"));
+    gst_buffer_unref (buffer);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+scenechange_suite (void)
+{
+  Suite *s = suite_create ("scenechange");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_meta_cut);
+  tcase_add_test (tc_chain, test_meta_cut_downscaled);
+  tcase_add_test (tc_chain, test_no_meta_by_default);
+
+  return s;
+}
+
+GST_CHECK_MAIN (scenechange);
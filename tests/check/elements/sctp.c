@@ -0,0 +1,248 @@
+/* GStreamer
+ *
+ * unit test for sctpenc and sctpdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+/* Larger than the 16 KiB fragments sctpenc sends messages in */
+#define MESSAGE_SIZE (40 * 1024)
+#define NUM_MESSAGES 20
+#define NUM_STREAMS 2
+
+#define STREAM_PATTERN(stream_id) (0x10 * (stream_id) + (stream_id))
+
+static GMutex test_lock;
+static GCond test_cond;
+static gboolean established;
+static guint received[NUM_STREAMS + 1];
+static gboolean received_corrupted;
+
+static void
+on_association_established (GstElement * sctpenc, gboolean is_established,
+    gpointer user_data)
+{
+  g_mutex_lock (&test_lock);
+  established = is_established;
+  g_cond_broadcast (&test_cond);
+  g_mutex_unlock (&test_lock);
+}
+
+static void
+on_handoff (GstElement * fakesink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  guint stream_id = GPOINTER_TO_UINT (user_data);
+  GstMapInfo map;
+  gsize i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  g_mutex_lock (&test_lock);
+  /* Each buffer has to be a whole message from the right stream */
+  if (map.size != MESSAGE_SIZE)
+    received_corrupted = TRUE;
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != STREAM_PATTERN (stream_id)) {
+      received_corrupted = TRUE;
+      break;
+    }
+  }
+  received[stream_id]++;
+  g_cond_broadcast (&test_cond);
+  g_mutex_unlock (&test_lock);
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+on_pad_added (GstElement * sctpdec, GstPad * pad, GstBin * pipeline)
+{
+  GstElement *fakesink;
+  GstPad *sinkpad;
+  guint stream_id;
+
+  fail_unless (sscanf (GST_PAD_NAME (pad), "src_%u", &stream_id) == 1);
+  fail_unless (stream_id >= 1 && stream_id <= NUM_STREAMS);
+
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (fakesink, "signal-handoffs", TRUE, "sync", FALSE,
+      "async", FALSE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (on_handoff),
+      GUINT_TO_POINTER (stream_id));
+  gst_bin_add (pipeline, fakesink);
+
+  sinkpad = gst_element_get_static_pad (fakesink, "sink");
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (fakesink);
+}
+
+typedef struct
+{
+  GstPad *srcpad;
+  guint stream_id;
+} Sender;
+
+static gpointer
+send_messages (Sender * sender)
+{
+  GstSegment segment;
+  gchar *stream_id;
+  guint i;
+
+  stream_id = g_strdup_printf ("sctp-%u", sender->stream_id);
+  gst_pad_push_event (sender->srcpad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (sender->srcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < NUM_MESSAGES; i++) {
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, MESSAGE_SIZE, NULL);
+    GstFlowReturn ret;
+
+    gst_buffer_memset (buffer, 0, STREAM_PATTERN (sender->stream_id),
+        MESSAGE_SIZE);
+    ret = gst_pad_push (sender->srcpad, buffer);
+    if (ret != GST_FLOW_OK)
+      return GINT_TO_POINTER (ret);
+  }
+
+  return GINT_TO_POINTER (GST_FLOW_OK);
+}
+
+/* Two peers, each with an encoder and a decoder sharing one association,
+ * connected back to back */
+GST_START_TEST (test_concurrent_large_messages)
+{
+  GstElement *pipeline, *enc1, *dec1, *enc2, *dec2;
+  Sender senders[NUM_STREAMS];
+  GThread *threads[NUM_STREAMS];
+  gint64 end_time;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  enc1 = gst_element_factory_make ("sctpenc", NULL);
+  dec1 = gst_element_factory_make ("sctpdec", NULL);
+  enc2 = gst_element_factory_make ("sctpenc", NULL);
+  dec2 = gst_element_factory_make ("sctpdec", NULL);
+  fail_unless (enc1 && dec1 && enc2 && dec2);
+
+  g_object_set (enc1, "sctp-association-id", 1, "remote-sctp-port", 5000,
+      NULL);
+  g_object_set (dec1, "sctp-association-id", 1, "local-sctp-port", 5000,
+      NULL);
+  g_object_set (enc2, "sctp-association-id", 2, "remote-sctp-port", 5000,
+      NULL);
+  g_object_set (dec2, "sctp-association-id", 2, "local-sctp-port", 5000,
+      NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), enc1, dec1, enc2, dec2, NULL);
+  fail_unless (gst_element_link (enc1, dec2));
+  fail_unless (gst_element_link (enc2, dec1));
+
+  g_signal_connect (enc1, "sctp-association-established",
+      G_CALLBACK (on_association_established), NULL);
+  g_signal_connect (dec2, "pad-added", G_CALLBACK (on_pad_added), pipeline);
+
+  established = FALSE;
+  received_corrupted = FALSE;
+  memset (received, 0, sizeof (received));
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&test_lock);
+  while (!established) {
+    if (!g_cond_wait_until (&test_cond, &test_lock, end_time))
+      break;
+  }
+  g_mutex_unlock (&test_lock);
+  fail_unless (established, "association not established");
+
+  for (i = 0; i < NUM_STREAMS; i++) {
+    gchar *name = g_strdup_printf ("sink_%u", i + 1);
+    GstPad *sinkpad = gst_element_request_pad_simple (enc1, name);
+
+    fail_unless (sinkpad != NULL);
+    senders[i].stream_id = i + 1;
+    senders[i].srcpad = gst_pad_new ("src", GST_PAD_SRC);
+    fail_unless_equals_int (gst_pad_link (senders[i].srcpad, sinkpad),
+        GST_PAD_LINK_OK);
+    gst_pad_set_active (senders[i].srcpad, TRUE);
+    gst_object_unref (sinkpad);
+    g_free (name);
+  }
+
+  /* Both streams send their messages at the same time, the fragments of one
+   * message must not be interleaved with the other stream */
+  for (i = 0; i < NUM_STREAMS; i++)
+    threads[i] = g_thread_new ("sender", (GThreadFunc) send_messages,
+        &senders[i]);
+  for (i = 0; i < NUM_STREAMS; i++) {
+    fail_unless_equals_int (GPOINTER_TO_INT (g_thread_join (threads[i])),
+        GST_FLOW_OK);
+  }
+
+  end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&test_lock);
+  while (received[1] < NUM_MESSAGES || received[2] < NUM_MESSAGES) {
+    if (!g_cond_wait_until (&test_cond, &test_lock, end_time))
+      break;
+  }
+  fail_unless_equals_int (received[1], NUM_MESSAGES);
+  fail_unless_equals_int (received[2], NUM_MESSAGES);
+  fail_if (received_corrupted);
+  g_mutex_unlock (&test_lock);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  for (i = 0; i < NUM_STREAMS; i++) {
+    GstPad *sinkpad = gst_pad_get_peer (senders[i].srcpad);
+
+    gst_pad_set_active (senders[i].srcpad, FALSE);
+    gst_pad_unlink (senders[i].srcpad, sinkpad);
+    gst_element_release_request_pad (enc1, sinkpad);
+    gst_object_unref (sinkpad);
+    gst_object_unref (senders[i].srcpad);
+  }
+
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *
+sctp_suite (void)
+{
+  Suite *s = suite_create ("sctp");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_concurrent_large_messages);
+
+  return s;
+}
+
+GST_CHECK_MAIN (sctp);
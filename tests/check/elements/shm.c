@@ -42,7 +42,7 @@ GstElement *src, *sink;
 GstPad *sinkpad, *srcpad;
 
 static void
-setup_shm (void)
+setup_shm_full (gboolean memfd, gboolean huge_pages)
 {
   gchar *socket_path = NULL;
 
@@ -52,7 +52,8 @@ setup_shm (void)
   srcpad = gst_check_setup_src_pad (sink, &src_template);
   sinkpad = gst_check_setup_sink_pad (src, &sink_template);
 
-  g_object_set (sink, "socket-path", "shm-unit-test", NULL);
+  g_object_set (sink, "socket-path", "shm-unit-test", "memfd", memfd,
+      "huge-pages", huge_pages, NULL);
 
   fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) ==
       GST_STATE_CHANGE_ASYNC);
@@ -69,6 +70,27 @@ setup_shm (void)
       GST_STATE_CHANGE_SUCCESS);
 }
 
+static void
+setup_shm (void)
+{
+  setup_shm_full (FALSE, FALSE);
+}
+
+#ifdef HAVE_MEMFD_CREATE
+static void
+setup_shm_memfd (void)
+{
+  setup_shm_full (TRUE, FALSE);
+}
+
+/* falls back to regular pages if the system has no huge pages to spare */
+static void
+setup_shm_memfd_huge_pages (void)
+{
+  setup_shm_full (TRUE, TRUE);
+}
+#endif
+
 static void
 teardown_shm (void)
 {
@@ -169,6 +191,63 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+/* Buffers from the allocator of the sink are written in place, check that
+ * the source maps the same memory */
+GST_START_TEST (test_shm_alloc_contents)
+{
+  GstBuffer *buf;
+  GstQuery *query;
+  GstCaps *caps = gst_caps_new_empty_simple ("application/x-test");
+  GstAllocator *alloc;
+  GstAllocationParams params;
+  GstSegment segment;
+  GList *l;
+  guint i;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  query = gst_query_new_allocation (caps, FALSE);
+  gst_caps_unref (caps);
+  fail_unless (gst_pad_peer_query (srcpad, query));
+  fail_unless (gst_query_get_n_allocation_params (query) == 1);
+  gst_query_parse_nth_allocation_param (query, 0, &alloc, &params);
+  fail_unless (alloc != NULL);
+  gst_query_unref (query);
+
+  for (i = 0; i < 3; i++) {
+    buf = gst_buffer_new_allocate (alloc, 4096, &params);
+    fail_unless (buf != NULL);
+    gst_buffer_memset (buf, 0, 'a' + i, 4096);
+    fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+  }
+  gst_object_unref (alloc);
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 3)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    GstMapInfo map;
+    gsize j;
+
+    buf = l->data;
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, 4096);
+    for (j = 0; j < map.size; j++)
+      fail_unless_equals_int (map.data[j], 'a' + i);
+    gst_buffer_unmap (buf, &map);
+  }
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_shm_live)
 {
   GstElement *producer, *consumer;
@@ -239,8 +318,24 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_alloc_contents);
+  suite_add_tcase (s, tc);
+
+#ifdef HAVE_MEMFD_CREATE
+  tc = tcase_create ("shm-memfd");
+  tcase_add_checked_fixture (tc, setup_shm_memfd, NULL);
+  tcase_add_test (tc, test_shm_sysmem_alloc);
+  tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_alloc_contents);
   suite_add_tcase (s, tc);
 
+  tc = tcase_create ("shm-memfd-huge-pages");
+  tcase_add_checked_fixture (tc, setup_shm_memfd_huge_pages, NULL);
+  tcase_add_test (tc, test_shm_sysmem_alloc);
+  tcase_add_test (tc, test_shm_alloc_contents);
+  suite_add_tcase (s, tc);
+#endif
+
   tc = tcase_create ("shm2");
   tcase_add_test (tc, test_shm_live);
   suite_add_tcase (s, tc);
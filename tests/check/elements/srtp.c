@@ -207,6 +207,124 @@ GST_START_TEST (test_roc)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_rtp_packet_with_padding (guint16 seqnum, gsize padding)
+{
+  GstAllocationParams params;
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  gst_allocation_params_init (&params);
+  params.padding = padding;
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, 172, &params));
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0xd5, map.size);
+  map.data[0] = 0x80;
+  map.data[1] = 8;
+  GST_WRITE_UINT16_BE (map.data + 2, seqnum);
+  GST_WRITE_UINT32_BE (map.data + 4, seqnum * 160);
+  GST_WRITE_UINT32_BE (map.data + 8, 1356955624);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+GST_START_TEST (test_srtpenc_in_place)
+{
+  GstHarness *h;
+  GstBuffer *in, *out, *shared;
+  GstMemory *in_mem;
+
+  h = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0", "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (h->element), "key",
+      "012345678901234567890123456789012345678901234567890123456789");
+  gst_harness_set_src_caps_str (h,
+      "application/x-rtp, payload=(int)8, ssrc=(uint)1356955624");
+
+  /* writable with room for the trailer: protected without a copy */
+  in = create_rtp_packet_with_padding (1, 64);
+  in_mem = gst_buffer_peek_memory (in, 0);
+  out = gst_harness_push_and_pull (h, in);
+  fail_unless (out == in);
+  fail_unless (gst_buffer_peek_memory (out, 0) == in_mem);
+  fail_unless_equals_int (gst_buffer_get_size (out), 172 + 10);
+  gst_buffer_unref (out);
+
+  /* no room for the trailer: copied */
+  in = create_rtp_packet_with_padding (2, 0);
+  out = gst_harness_push_and_pull (h, in);
+  fail_unless (out != in);
+  fail_unless_equals_int (gst_buffer_get_size (out), 172 + 10);
+  gst_buffer_unref (out);
+
+  /* shared with the caller: copied, caller's data untouched */
+  shared = create_rtp_packet_with_padding (3, 64);
+  out = gst_harness_push_and_pull (h, gst_buffer_ref (shared));
+  fail_unless (out != shared);
+  fail_unless_equals_int (gst_buffer_get_size (shared), 172);
+  fail_unless (gst_buffer_memcmp (out, 12, "\xd5\xd5\xd5\xd5", 4) != 0);
+  fail_unless (gst_buffer_memcmp (shared, 12, "\xd5\xd5\xd5\xd5", 4) == 0);
+  gst_buffer_unref (out);
+  gst_buffer_unref (shared);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_srtpenc_buffer_list_threads)
+{
+  GstElement *srtpenc;
+  GstHarness *h;
+  GstBufferList *list;
+  guint i;
+
+  /* n-threads can only be changed in READY */
+  srtpenc = gst_element_factory_make ("srtpenc", NULL);
+  g_object_set (srtpenc, "n-threads", 4, NULL);
+  h = gst_harness_new_with_element (srtpenc, "rtp_sink_0", "rtp_src_0");
+  gst_object_unref (srtpenc);
+  gst_util_set_object_arg (G_OBJECT (h->element), "key",
+      "012345678901234567890123456789012345678901234567890123456789");
+  gst_harness_set_src_caps_str (h,
+      "application/x-rtp, payload=(int)8, ssrc=(uint)1356955624");
+
+  /* interleave a few SSRCs so the list is split across threads */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 64; i++) {
+    GstBuffer *buf = create_rtp_packet_with_padding (i, 0);
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    GST_WRITE_UINT32_BE (map.data + 8, 1356955624 + i % 4);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_harness_push_list (h, list), GST_FLOW_OK);
+
+  /* output keeps the input order */
+  for (i = 0; i < 64; i++) {
+    GstBuffer *out = gst_harness_pull (h);
+    GstMapInfo map;
+
+    fail_unless (out != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (out), 172 + 10);
+    gst_buffer_map (out, &map, GST_MAP_READ);
+    fail_unless_equals_int (GST_READ_UINT16_BE (map.data + 2), i);
+    fail_unless_equals_int (GST_READ_UINT32_BE (map.data + 8),
+        1356955624 + i % 4);
+    gst_buffer_unmap (out, &map);
+    gst_buffer_unref (out);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 #ifdef HAVE_SRTP2
 
 GST_START_TEST (test_simple_mki)
@@ -352,6 +470,8 @@ srtp_suite (void)
   tcase_add_test (tc_chain, test_create_and_unref);
   tcase_add_test (tc_chain, test_play);
   tcase_add_test (tc_chain, test_roc);
+  tcase_add_test (tc_chain, test_srtpenc_in_place);
+  tcase_add_test (tc_chain, test_srtpenc_buffer_list_threads);
 #ifdef HAVE_SRTP2
   tcase_add_test (tc_chain, test_simple_mki);
   tcase_add_test (tc_chain, test_srtpdec_multiple_mki);
@@ -0,0 +1,223 @@
+/* GStreamer
+ *
+ * unit test for videodiff
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+#define CAPS_STR "video/x-raw,format=GRAY8,width=64,height=48,framerate=30/1"
+
+#define BACKGROUND 100
+#define FOREGROUND 200
+
+typedef struct
+{
+  guint x, y, w, h;
+} Rect;
+
+/* Two changed areas, the first one within a single 16x16 tile, the second
+ * one covering two tiles */
+static const Rect changes[] = {
+  {20, 4, 8, 8},
+  {40, 32, 24, 16},
+};
+
+/* A change below the threshold of 10 */
+#define SMALL_CHANGE_X 50
+#define SMALL_CHANGE_Y 10
+
+static gboolean
+in_changes (guint x, guint y)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (changes); i++) {
+    if (x >= changes[i].x && x < changes[i].x + changes[i].w &&
+        y >= changes[i].y && y < changes[i].y + changes[i].h)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static GstBuffer *
+create_frame (gboolean changed)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, WIDTH * HEIGHT, NULL);
+  GstMapInfo map;
+  guint x, y;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      guint8 value = BACKGROUND;
+
+      if (changed && in_changes (x, y))
+        value = FOREGROUND;
+      else if (changed && x == SMALL_CHANGE_X && y == SMALL_CHANGE_Y)
+        value = BACKGROUND + 5;
+      map.data[y * WIDTH + x] = value;
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* Checks that the changed pixels, and only those, are highlighted with the
+ * striped pattern */
+static void
+check_frame (GstBuffer * buffer, gboolean highlighted)
+{
+  GstMapInfo map;
+  guint x, y;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      guint8 expected = BACKGROUND;
+
+      if (in_changes (x, y))
+        expected = highlighted ? (((x + y) & 0x4) ? 16 : 240) : FOREGROUND;
+      else if (x == SMALL_CHANGE_X && y == SMALL_CHANGE_Y)
+        expected = BACKGROUND + 5;
+
+      fail_unless_equals_int_hex (map.data[y * WIDTH + x], expected);
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+check_regions (GstBuffer * buffer, guint n_regions)
+{
+  /* the changed areas extended to whole tiles */
+  static const Rect regions[] = {
+    {16, 0, 16, 16},
+    {32, 32, 32, 16},
+  };
+  GstVideoRegionOfInterestMeta *meta;
+  gpointer state = NULL;
+  gboolean found[G_N_ELEMENTS (regions)] = { FALSE, };
+  guint i, n = 0;
+
+  while ((meta = (GstVideoRegionOfInterestMeta *)
+          gst_buffer_iterate_meta_filtered (buffer, &state,
+              GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+    fail_unless_equals_string (g_quark_to_string (meta->roi_type), "motion");
+
+    for (i = 0; i < G_N_ELEMENTS (regions); i++) {
+      if (meta->x == regions[i].x && meta->y == regions[i].y &&
+          meta->w == regions[i].w && meta->h == regions[i].h) {
+        fail_if (found[i]);
+        found[i] = TRUE;
+        break;
+      }
+    }
+    fail_unless (i < G_N_ELEMENTS (regions),
+        "unexpected region %ux%u at %u,%u", meta->w, meta->h, meta->x,
+        meta->y);
+    n++;
+  }
+
+  fail_unless_equals_int (n, n_regions);
+}
+
+static void
+run_diff (const gchar * launch)
+{
+  GstHarness *h = gst_harness_new_parse (launch);
+  GstBuffer *buffer;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  /* Nothing to compare the first frame with */
+  buffer = gst_harness_push_and_pull (h, create_frame (FALSE));
+  check_frame (buffer, FALSE);
+  check_regions (buffer, 0);
+  gst_buffer_unref (buffer);
+
+  buffer = gst_harness_push_and_pull (h, create_frame (TRUE));
+  check_frame (buffer, TRUE);
+  check_regions (buffer, G_N_ELEMENTS (changes));
+  gst_buffer_unref (buffer);
+
+  /* The previous frame is remembered as it was received, not highlighted */
+  buffer = gst_harness_push_and_pull (h, create_frame (TRUE));
+  check_frame (buffer, FALSE);
+  check_regions (buffer, 0);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_diff)
+{
+  run_diff ("videodiff motion-meta=true");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_diff_threads)
+{
+  run_diff ("videodiff motion-meta=true n-threads=3");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_no_meta_by_default)
+{
+  GstHarness *h = gst_harness_new ("videodiff");
+  GstBuffer *buffer;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  gst_buffer_unref (gst_harness_push_and_pull (h, create_frame (FALSE)));
+  buffer = gst_harness_push_and_pull (h, create_frame (TRUE));
+  check_frame (buffer, TRUE);
+  check_regions (buffer, 0);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+videodiff_suite (void)
+{
+  Suite *s = suite_create ("videodiff");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_diff);
+  tcase_add_test (tc_chain, test_diff_threads);
+  tcase_add_test (tc_chain, test_no_meta_by_default);
+
+  return s;
+}
+
+GST_CHECK_MAIN (videodiff);
@@ -1588,6 +1588,97 @@ GST_START_TEST (test_session_stats)
 
 GST_END_TEST;
 
+static gboolean
+_max_stats_timestamp (GQuark field_id, const GValue * value, double *max_ts)
+{
+  const GstStructure *s;
+  double ts;
+
+  fail_unless (GST_VALUE_HOLDS_STRUCTURE (value));
+  s = gst_value_get_structure (value);
+  fail_unless (gst_structure_get_double (s, "timestamp", &ts));
+  *max_ts = MAX (*max_ts, ts);
+
+  return TRUE;
+}
+
+static gboolean
+_min_stats_timestamp (GQuark field_id, const GValue * value, double *min_ts)
+{
+  double ts;
+
+  fail_unless (gst_structure_get_double (gst_value_get_structure (value),
+          "timestamp", &ts));
+  *min_ts = MIN (*min_ts, ts);
+
+  return TRUE;
+}
+
+static GstStructure *
+_get_stats_sync (GstElement * webrtc, const gchar * signal, double since)
+{
+  GstPromise *p = gst_promise_new ();
+  GstStructure *s;
+
+  if (since < 0)
+    g_signal_emit_by_name (webrtc, signal, NULL, p);
+  else
+    g_signal_emit_by_name (webrtc, signal, NULL, since, p);
+  fail_unless_equals_int (gst_promise_wait (p), GST_PROMISE_RESULT_REPLIED);
+  s = gst_structure_copy (gst_promise_get_reply (p));
+  gst_promise_unref (p);
+
+  return s;
+}
+
+GST_START_TEST (test_changed_stats)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GstStructure *stats, *changed, *unchanged;
+  double max_ts = 0.0, min_ts = G_MAXDOUBLE;
+
+  t->on_negotiation_needed = NULL;
+  test_validate_sdp (t, NULL, NULL);
+
+  stats = _get_stats_sync (t->webrtc1, "get-stats", -1.0);
+  validate_stats (stats);
+  fail_unless (gst_structure_n_fields (stats) > 0);
+  gst_structure_foreach (stats, (GstStructureForeachFunc) _max_stats_timestamp,
+      &max_ts);
+
+  /* all of the stats are newer than 0 */
+  changed = _get_stats_sync (t->webrtc1, "get-changed-stats", 0.0);
+  fail_unless_equals_int (gst_structure_n_fields (changed),
+      gst_structure_n_fields (stats));
+  gst_structure_free (changed);
+
+  /* nothing changes without any streams */
+  changed = _get_stats_sync (t->webrtc1, "get-changed-stats", max_ts);
+  fail_unless_equals_int (gst_structure_n_fields (changed), 0);
+  gst_structure_free (changed);
+
+  /* get-changed-stats keeps the time the values last changed */
+  changed = _get_stats_sync (t->webrtc1, "get-changed-stats", 0.0);
+  unchanged = _get_stats_sync (t->webrtc1, "get-changed-stats", 0.0);
+  fail_unless (gst_structure_is_equal (changed, unchanged));
+  gst_structure_free (unchanged);
+
+  /* while get-stats reports the time of the request */
+  unchanged = _get_stats_sync (t->webrtc1, "get-stats", -1.0);
+  fail_unless_equals_int (gst_structure_n_fields (unchanged),
+      gst_structure_n_fields (changed));
+  gst_structure_foreach (unchanged,
+      (GstStructureForeachFunc) _min_stats_timestamp, &min_ts);
+  fail_unless (min_ts > max_ts);
+  gst_structure_free (unchanged);
+  gst_structure_free (changed);
+
+  gst_structure_free (stats);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_add_transceiver)
 {
   struct test_webrtc *t = test_webrtc_new ();
@@ -2016,6 +2107,204 @@ GST_START_TEST (test_data_channel_transfer_data)
 
 GST_END_TEST;
 
+static void
+on_message_data_not_reached (GObject * channel, GBytes * data,
+    gpointer user_data)
+{
+  g_assert_not_reached ();
+}
+
+static void
+on_message_buffer (GObject * channel, GstBuffer * buffer,
+    struct test_webrtc *t)
+{
+  guint n_received = GPOINTER_TO_UINT (g_object_get_data (channel,
+          "n-received"));
+
+  /* the second message is the empty one */
+  if (n_received == 0) {
+    fail_unless (gst_buffer_memcmp (buffer, 0, test_string,
+            strlen (test_string)) == 0);
+    fail_unless_equals_int (gst_buffer_get_size (buffer), strlen (test_string));
+  } else {
+    fail_unless_equals_int (gst_buffer_get_size (buffer), 0);
+  }
+
+  g_object_set_data (channel, "n-received", GUINT_TO_POINTER (++n_received));
+  if (n_received == 2)
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+static void
+have_data_channel_transfer_buffer (struct test_webrtc *t, GstElement * element,
+    GObject * our, gpointer user_data)
+{
+  GObject *other = user_data;
+  GstBufferList *list = gst_buffer_list_new ();
+
+  g_signal_connect (our, "on-message-data",
+      G_CALLBACK (on_message_data_not_reached), NULL);
+  g_signal_connect (our, "on-message-buffer", G_CALLBACK (on_message_buffer),
+      t);
+
+  g_signal_connect (other, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  gst_buffer_list_add (list, gst_buffer_new_wrapped_full
+      (GST_MEMORY_FLAG_READONLY, (gpointer) test_string, strlen (test_string),
+          0, strlen (test_string), NULL, NULL));
+  gst_buffer_list_add (list, gst_buffer_new ());
+  gst_webrtc_data_channel_send_buffer_list (GST_WEBRTC_DATA_CHANNEL (other),
+      list);
+}
+
+GST_START_TEST (test_data_channel_transfer_buffer)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GObject *channel = NULL;
+  VAL_SDP_INIT (media_count, _count_num_sdp_media, GUINT_TO_POINTER (1), NULL);
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, &media_count);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_data_channel = have_data_channel_transfer_buffer;
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &channel);
+  g_assert_nonnull (channel);
+  t->data_channel_data = channel;
+  g_signal_connect (channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &offer, 1 << STATE_CUSTOM, FALSE);
+
+  g_object_unref (channel);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
+#define N_INTERLEAVED_MESSAGES 20
+
+/* Even messages are strings and odd ones are binary, each containing its
+ * index */
+static void
+check_interleaved_message (GObject * channel, const gchar * data, gsize size,
+    gboolean is_string, struct test_webrtc *t)
+{
+  guint n_received = GPOINTER_TO_UINT (g_object_get_data (channel,
+          "n-received"));
+  gchar *expected = g_strdup_printf ("%u", n_received);
+
+  fail_unless_equals_int (is_string, n_received % 2 == 0);
+  fail_unless_equals_int (size, strlen (expected));
+  fail_unless (memcmp (data, expected, size) == 0);
+  g_free (expected);
+
+  g_object_set_data (channel, "n-received", GUINT_TO_POINTER (++n_received));
+  if (n_received == N_INTERLEAVED_MESSAGES)
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+static void
+on_interleaved_string (GObject * channel, const gchar * str,
+    struct test_webrtc *t)
+{
+  check_interleaved_message (channel, str, strlen (str), TRUE, t);
+}
+
+static void
+on_interleaved_buffer (GObject * channel, GstBuffer * buffer,
+    struct test_webrtc *t)
+{
+  GstMapInfo map;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  check_interleaved_message (channel, (const gchar *) map.data, map.size,
+      FALSE, t);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+have_data_channel_transfer_interleaved (struct test_webrtc *t,
+    GstElement * element, GObject * our, gpointer user_data)
+{
+  GObject *other = user_data;
+  guint i;
+
+  g_signal_connect (our, "on-message-data",
+      G_CALLBACK (on_message_data_not_reached), NULL);
+  g_signal_connect (our, "on-message-string",
+      G_CALLBACK (on_interleaved_string), t);
+  g_signal_connect (our, "on-message-buffer",
+      G_CALLBACK (on_interleaved_buffer), t);
+
+  g_signal_connect (other, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  for (i = 0; i < N_INTERLEAVED_MESSAGES; i++) {
+    gchar *str = g_strdup_printf ("%u", i);
+
+    if (i % 2 == 0) {
+      g_signal_emit_by_name (other, "send-string", str);
+      g_free (str);
+    } else {
+      GBytes *data = g_bytes_new_take (str, strlen (str));
+
+      g_signal_emit_by_name (other, "send-data", data);
+      g_bytes_unref (data);
+    }
+  }
+}
+
+/* on-message-string and on-message-buffer must be emitted in the order the
+ * messages were sent */
+GST_START_TEST (test_data_channel_transfer_interleaved)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GObject *channel = NULL;
+  VAL_SDP_INIT (media_count, _count_num_sdp_media, GUINT_TO_POINTER (1), NULL);
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, &media_count);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_data_channel = have_data_channel_transfer_interleaved;
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &channel);
+  g_assert_nonnull (channel);
+  t->data_channel_data = channel;
+  g_signal_connect (channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &offer, 1 << STATE_CUSTOM, FALSE);
+
+  g_object_unref (channel);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 static void
 have_data_channel_create_data_channel (struct test_webrtc *t,
     GstElement * element, GObject * our, gpointer user_data)
@@ -4250,6 +4539,7 @@ webrtcbin_suite (void)
   if (nicesrc && nicesink && dtlssrtpenc && dtlssrtpdec) {
     tcase_add_test (tc, test_sdp_no_media);
     tcase_add_test (tc, test_session_stats);
+    tcase_add_test (tc, test_changed_stats);
     tcase_add_test (tc, test_audio);
     tcase_add_test (tc, test_ice_port_restriction);
     tcase_add_test (tc, test_audio_video);
@@ -4284,6 +4574,8 @@ webrtcbin_suite (void)
       tcase_add_test (tc, test_data_channel_remote_notify);
       tcase_add_test (tc, test_data_channel_transfer_string);
       tcase_add_test (tc, test_data_channel_transfer_data);
+      tcase_add_test (tc, test_data_channel_transfer_buffer);
+      tcase_add_test (tc, test_data_channel_transfer_interleaved);
       tcase_add_test (tc, test_data_channel_create_after_negotiate);
       tcase_add_test (tc, test_data_channel_close);
       tcase_add_test (tc, test_data_channel_low_threshold);
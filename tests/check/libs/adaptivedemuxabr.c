@@ -0,0 +1,178 @@
+/* GStreamer
+ *
+ * unit test for the adaptive demux bitrate selection
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/adaptivedemux/gstadaptivedemuxabr.h>
+
+/* bytes transferred in one second at @bitrate */
+#define BYTES_PER_SECOND(bitrate) ((bitrate) / 8)
+
+GST_START_TEST (test_moving_average)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+
+  fail_unless_equals_int (gst_adaptive_demux_abr_get_algorithm (abr),
+      GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_MOVING_AVERAGE);
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 0);
+
+  /* the time to first byte is part of the samples */
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1000000),
+      GST_SECOND / 2, GST_SECOND / 4);
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 2000000);
+
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (4000000),
+      GST_SECOND, 0);
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (3000000),
+      GST_SECOND, 0);
+  /* the average of the last 3 fragments */
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 3000000);
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 0.5,
+          GST_SECOND, GST_CLOCK_TIME_NONE), 1500000);
+
+  /* never above the last fragment */
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1000000),
+      GST_SECOND, 0);
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 1000000);
+
+  gst_adaptive_demux_abr_reset (abr);
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 0);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_harmonic_mean)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+
+  gst_adaptive_demux_abr_set_algorithm (abr,
+      GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_HARMONIC_MEAN);
+
+  /* the time to first byte is left out of the throughput */
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1000000),
+      GST_SECOND + 100 * GST_MSECOND, 100 * GST_MSECOND);
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (2000000),
+      GST_SECOND + 100 * GST_MSECOND, 100 * GST_MSECOND);
+
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_bandwidth (abr), 1333333);
+  assert_equals_uint64 (gst_adaptive_demux_abr_get_latency (abr),
+      100 * GST_MSECOND);
+
+  /* and accounted for once per fragment instead */
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 1.0,
+          GST_SECOND, GST_CLOCK_TIME_NONE), 1199999);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ewma)
+{
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+  guint64 bandwidth;
+  guint i;
+
+  gst_adaptive_demux_abr_set_algorithm (abr,
+      GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_EWMA);
+
+  /* the averages are not biased towards 0 at startup */
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (4000000),
+      GST_SECOND, GST_CLOCK_TIME_NONE);
+  bandwidth = gst_adaptive_demux_abr_get_bandwidth (abr);
+  fail_unless (bandwidth >= 3999999 && bandwidth <= 4000000,
+      "unexpected bandwidth %" G_GUINT64_FORMAT, bandwidth);
+
+  /* drops are followed quickly */
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1000000),
+      3 * GST_SECOND, GST_CLOCK_TIME_NONE);
+  bandwidth = gst_adaptive_demux_abr_get_bandwidth (abr);
+  fail_unless (bandwidth < 2000000,
+      "unexpected bandwidth %" G_GUINT64_FORMAT, bandwidth);
+
+  /* short peaks are ignored */
+  for (i = 0; i < 5; i++)
+    gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1000000),
+        GST_SECOND, GST_CLOCK_TIME_NONE);
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (8000000),
+      GST_SECOND, GST_CLOCK_TIME_NONE);
+  bandwidth = gst_adaptive_demux_abr_get_bandwidth (abr);
+  fail_unless (bandwidth < 4000000,
+      "unexpected bandwidth %" G_GUINT64_FORMAT, bandwidth);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_buffer_based)
+{
+  static const guint64 bitrates[] = { 4000000, 1000000, 2000000 };
+  GstAdaptiveDemuxAbr *abr = gst_adaptive_demux_abr_new ();
+
+  gst_adaptive_demux_abr_set_algorithm (abr,
+      GST_ADAPTIVE_DEMUX_ABR_ALGORITHM_BUFFER_BASED);
+  gst_adaptive_demux_abr_set_bitrates (abr, bitrates, G_N_ELEMENTS (bitrates));
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (10000000),
+      GST_SECOND, 0);
+
+  /* without a buffer level this is the harmonic mean */
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 1.0,
+          2 * GST_SECOND, GST_CLOCK_TIME_NONE), 10000000);
+
+  /* lowest bitrate with an empty buffer, highest one close to the target */
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 1.0,
+          2 * GST_SECOND, 0), 1000000);
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 1.0,
+          2 * GST_SECOND, 18 * GST_SECOND), 4000000);
+
+  /* a full buffer does not allow going above the throughput */
+  gst_adaptive_demux_abr_reset (abr);
+  gst_adaptive_demux_abr_add_sample (abr, BYTES_PER_SECOND (1500000),
+      GST_SECOND, 0);
+  assert_equals_uint64 (gst_adaptive_demux_abr_select_bitrate (abr, 1.0,
+          2 * GST_SECOND, 18 * GST_SECOND), 1000000);
+
+  gst_adaptive_demux_abr_free (abr);
+}
+
+GST_END_TEST;
+
+static Suite *
+adaptivedemuxabr_suite (void)
+{
+  Suite *s = suite_create ("adaptivedemuxabr");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_moving_average);
+  tcase_add_test (tc_chain, test_harmonic_mean);
+  tcase_add_test (tc_chain, test_ewma);
+  tcase_add_test (tc_chain, test_buffer_based);
+
+  return s;
+}
+
+GST_CHECK_MAIN (adaptivedemuxabr);
@@ -0,0 +1,401 @@
+/* GStreamer
+ *
+ * Unit tests for the GstH264Decoder base class
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/codecs/gsth264decoder.h>
+
+#define NUM_FRAMES 12
+/* Frame starting with a new SPS, PPS and IDR picture */
+#define SECOND_IDR_FRAME 7
+
+/* Dummy decoder recording the subclass calls it gets */
+
+typedef struct
+{
+  GstH264Decoder parent;
+
+  GString *calls;
+} GstH264TestDecoder;
+
+typedef struct
+{
+  GstH264DecoderClass parent_class;
+} GstH264TestDecoderClass;
+
+GType gst_h264_test_decoder_get_type (void);
+
+G_DEFINE_TYPE (GstH264TestDecoder, gst_h264_test_decoder,
+    GST_TYPE_H264_DECODER);
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h264, stream-format = (string) byte-stream, "
+        "alignment = (string) au"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw, format = (string) GRAY8"));
+
+static gboolean
+gst_h264_test_decoder_new_sequence (GstH264Decoder * decoder,
+    const GstH264SPS * sps, gint max_dpb_size)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+  GstVideoCodecState *state;
+
+  g_string_append_printf (self->calls, "sequence %dx%d;",
+      sps->width, sps->height);
+
+  state = gst_video_decoder_set_output_state (GST_VIDEO_DECODER (decoder),
+      GST_VIDEO_FORMAT_GRAY8, sps->width, sps->height, decoder->input_state);
+  gst_video_codec_state_unref (state);
+
+  return gst_video_decoder_negotiate (GST_VIDEO_DECODER (decoder));
+}
+
+static gboolean
+gst_h264_test_decoder_decode_slice (GstH264Decoder * decoder,
+    GstH264Picture * picture, GstH264Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+
+  g_string_append_printf (self->calls, "slice %d frame_num %d poc %d refs %u;",
+      picture->system_frame_number, slice->header.frame_num,
+      picture->pic_order_cnt, ref_pic_list0->len);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_h264_test_decoder_output_picture (GstH264Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH264Picture * picture)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) decoder;
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+  GstFlowReturn ret;
+
+  g_string_append_printf (self->calls, "output %d poc %d;",
+      frame->system_frame_number, picture->pic_order_cnt);
+  gst_h264_picture_unref (picture);
+
+  ret = gst_video_decoder_allocate_output_frame (vdec, frame);
+  if (ret != GST_FLOW_OK) {
+    gst_video_decoder_drop_frame (vdec, frame);
+    return ret;
+  }
+
+  return gst_video_decoder_finish_frame (vdec, frame);
+}
+
+static void
+gst_h264_test_decoder_finalize (GObject * object)
+{
+  GstH264TestDecoder *self = (GstH264TestDecoder *) object;
+
+  g_string_free (self->calls, TRUE);
+
+  G_OBJECT_CLASS (gst_h264_test_decoder_parent_class)->finalize (object);
+}
+
+static void
+gst_h264_test_decoder_class_init (GstH264TestDecoderClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstH264DecoderClass *h264decoder_class = GST_H264_DECODER_CLASS (klass);
+
+  object_class->finalize = gst_h264_test_decoder_finalize;
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "H.264 test decoder", "Codec/Decoder/Video",
+      "Records the calls of the H.264 decoder base class", "GStreamer");
+
+  h264decoder_class->new_sequence = gst_h264_test_decoder_new_sequence;
+  h264decoder_class->decode_slice = gst_h264_test_decoder_decode_slice;
+  h264decoder_class->output_picture = gst_h264_test_decoder_output_picture;
+}
+
+static void
+gst_h264_test_decoder_init (GstH264TestDecoder * self)
+{
+  self->calls = g_string_new (NULL);
+}
+
+/* Minimal bitstream writer for a baseline profile stream of 16x16 pictures */
+
+typedef struct
+{
+  guint8 data[32];
+  guint bit;
+} BitWriter;
+
+static void
+put_bits (BitWriter * bw, guint32 value, guint n)
+{
+  while (n--) {
+    fail_unless (bw->bit / 8 < sizeof (bw->data));
+    if (value & (1u << n))
+      bw->data[bw->bit / 8] |= 0x80 >> (bw->bit % 8);
+    bw->bit++;
+  }
+}
+
+static void
+put_ue (BitWriter * bw, guint32 value)
+{
+  guint n = g_bit_storage (value + 1);
+
+  put_bits (bw, 0, n - 1);
+  put_bits (bw, value + 1, n);
+}
+
+static void
+put_trailing_bits (BitWriter * bw)
+{
+  put_bits (bw, 1, 1);
+  while (bw->bit % 8)
+    put_bits (bw, 0, 1);
+}
+
+/* Appends a start code, the NAL header and the RBSP with emulation
+ * prevention */
+static void
+append_nal (GByteArray * array, guint8 header, BitWriter * bw)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  guint i, zeros = 0;
+
+  put_trailing_bits (bw);
+
+  g_byte_array_append (array, start_code, sizeof (start_code));
+  g_byte_array_append (array, &header, 1);
+
+  for (i = 0; i < bw->bit / 8; i++) {
+    if (zeros == 2 && bw->data[i] <= 0x03) {
+      static const guint8 epb = 0x03;
+
+      g_byte_array_append (array, &epb, 1);
+      zeros = 0;
+    }
+    g_byte_array_append (array, &bw->data[i], 1);
+    zeros = bw->data[i] ? 0 : zeros + 1;
+  }
+}
+
+static void
+append_parameter_sets (GByteArray * array)
+{
+  BitWriter sps = { {0}, 0 }, pps = { {0}, 0 };
+
+  put_bits (&sps, 66, 8);       /* profile_idc: baseline */
+  put_bits (&sps, 0, 8);        /* constraint_set flags */
+  put_bits (&sps, 10, 8);       /* level_idc */
+  put_ue (&sps, 0);             /* seq_parameter_set_id */
+  put_ue (&sps, 0);             /* log2_max_frame_num_minus4 */
+  put_ue (&sps, 2);             /* pic_order_cnt_type */
+  put_ue (&sps, 1);             /* max_num_ref_frames */
+  put_bits (&sps, 0, 1);        /* gaps_in_frame_num_value_allowed_flag */
+  put_ue (&sps, 0);             /* pic_width_in_mbs_minus1 */
+  put_ue (&sps, 0);             /* pic_height_in_map_units_minus1 */
+  put_bits (&sps, 1, 1);        /* frame_mbs_only_flag */
+  put_bits (&sps, 1, 1);        /* direct_8x8_inference_flag */
+  put_bits (&sps, 0, 1);        /* frame_cropping_flag */
+  put_bits (&sps, 0, 1);        /* vui_parameters_present_flag */
+  append_nal (array, 0x67, &sps);
+
+  put_ue (&pps, 0);             /* pic_parameter_set_id */
+  put_ue (&pps, 0);             /* seq_parameter_set_id */
+  put_bits (&pps, 0, 1);        /* entropy_coding_mode_flag */
+  put_bits (&pps, 0, 1);        /* bottom_field_pic_order_in_frame_present */
+  put_ue (&pps, 0);             /* num_slice_groups_minus1 */
+  put_ue (&pps, 0);             /* num_ref_idx_l0_default_active_minus1 */
+  put_ue (&pps, 0);             /* num_ref_idx_l1_default_active_minus1 */
+  put_bits (&pps, 0, 1);        /* weighted_pred_flag */
+  put_bits (&pps, 0, 2);        /* weighted_bipred_idc */
+  put_ue (&pps, 0);             /* pic_init_qp_minus26 */
+  put_ue (&pps, 0);             /* pic_init_qs_minus26 */
+  put_ue (&pps, 0);             /* chroma_qp_index_offset */
+  put_bits (&pps, 1, 1);        /* deblocking_filter_control_present_flag */
+  put_bits (&pps, 0, 1);        /* constrained_intra_pred_flag */
+  put_bits (&pps, 0, 1);        /* redundant_pic_cnt_present_flag */
+  append_nal (array, 0x68, &pps);
+}
+
+static void
+append_slice (GByteArray * array, gboolean idr, guint frame_num)
+{
+  BitWriter bw = { {0}, 0 };
+
+  put_ue (&bw, 0);              /* first_mb_in_slice */
+  put_ue (&bw, idr ? 7 : 5);    /* slice_type: I or P */
+  put_ue (&bw, 0);              /* pic_parameter_set_id */
+  put_bits (&bw, frame_num, 4); /* frame_num */
+  if (idr) {
+    put_ue (&bw, 0);            /* idr_pic_id */
+    put_bits (&bw, 0, 1);       /* no_output_of_prior_pics_flag */
+    put_bits (&bw, 0, 1);       /* long_term_reference_flag */
+  } else {
+    put_bits (&bw, 0, 1);       /* num_ref_idx_active_override_flag */
+    put_bits (&bw, 0, 1);       /* ref_pic_list_modification_flag_l0 */
+    put_bits (&bw, 0, 1);       /* adaptive_ref_pic_marking_mode_flag */
+  }
+  put_ue (&bw, 0);              /* slice_qp_delta */
+  put_ue (&bw, 1);              /* disable_deblocking_filter_idc */
+  append_nal (array, idr ? 0x65 : 0x41, &bw);
+}
+
+static GstBuffer *
+create_frame (guint idx)
+{
+  GByteArray *array = g_byte_array_new ();
+  gboolean idr = idx == 0 || idx == SECOND_IDR_FRAME;
+  guint frame_num = idx < SECOND_IDR_FRAME ? idx : idx - SECOND_IDR_FRAME;
+  GstBuffer *buf;
+  gsize size;
+
+  if (idr)
+    append_parameter_sets (array);
+  append_slice (array, idr, frame_num);
+
+  size = array->len;
+  buf = gst_buffer_new_wrapped (g_byte_array_free (array, FALSE), size);
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = idx * 40 * GST_MSECOND;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+  if (!idr)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buf;
+}
+
+static GstHarness *
+create_harness (guint parse_ahead)
+{
+  GstElement *dec;
+  GstHarness *h;
+
+  dec = g_object_new (gst_h264_test_decoder_get_type (), "parse-ahead",
+      parse_ahead, NULL);
+  h = gst_harness_new_with_element (dec, "sink", "src");
+  gst_object_unref (dec);
+
+  gst_harness_set_src_caps_str (h, "video/x-h264, "
+      "stream-format = (string) byte-stream, alignment = (string) au, "
+      "width = (int) 16, height = (int) 16, framerate = (fraction) 25/1");
+
+  return h;
+}
+
+/* Decodes the test stream and returns the subclass calls and the output
+ * timestamps */
+static gchar *
+decode_stream (guint parse_ahead)
+{
+  GstHarness *h = create_harness (parse_ahead);
+  GstH264TestDecoder *dec = (GstH264TestDecoder *) h->element;
+  GString *result;
+  GstBuffer *buf;
+  guint i;
+
+  for (i = 0; i < NUM_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  result = g_string_new (dec->calls->str);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), NUM_FRAMES);
+  while ((buf = gst_harness_try_pull (h))) {
+    g_string_append_printf (result, "buffer %" GST_TIME_FORMAT ";",
+        GST_TIME_ARGS (GST_BUFFER_PTS (buf)));
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+
+  return g_string_free (result, FALSE);
+}
+
+GST_START_TEST (test_h264_decoder_parse_ahead)
+{
+  static const guint depths[] = { 1, 2, NUM_FRAMES + 4 };
+  gchar *expected, *result;
+  guint i;
+
+  expected = decode_stream (0);
+  GST_INFO ("calls without parse-ahead: %s", expected);
+  fail_unless (strstr (expected, "sequence 16x16;") != NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (depths); i++) {
+    result = decode_stream (depths[i]);
+    fail_unless_equals_string (result, expected);
+    g_free (result);
+  }
+
+  g_free (expected);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_decoder_parse_ahead_flush)
+{
+  GstHarness *h = create_harness (4);
+  GstSegment segment;
+  guint i;
+
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i)),
+        GST_FLOW_OK);
+
+  /* Frames still in flight are dropped */
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_harness_push_event (h, gst_event_new_segment (&segment)));
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  for (i = 0; i < NUM_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), NUM_FRAMES);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264decoder_suite (void)
+{
+  Suite *s = suite_create ("H264 decoder base class");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h264_decoder_parse_ahead);
+  tcase_add_test (tc_chain, test_h264_decoder_parse_ahead_flush);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h264decoder);
@@ -102,6 +102,68 @@ GST_START_TEST (test_nal_writer_emulation_preventation)
 
 GST_END_TEST;
 
+GST_START_TEST (test_scan_for_start_codes)
+{
+  static const guint8 data[] = {
+    0xff, 0x00, 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x65,
+    0x00, 0x00, 0x03, 0x01, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0x00, 0x00, 0x01,
+    0x41, 0x00, 0x00, 0x01
+  };
+
+  assert_equals_int (scan_for_start_codes (data, sizeof (data)), 8);
+  assert_equals_int (scan_for_start_codes (data + 9, sizeof (data) - 9), 12);
+  /* a start code needs at least one byte after it */
+  assert_equals_int (scan_for_start_codes (data + 21, 3), -1);
+  assert_equals_int (scan_for_start_codes (data + 21, 4), 0);
+  assert_equals_int (scan_for_start_codes (data + 22, sizeof (data) - 22),
+      -1);
+  assert_equals_int (scan_for_start_codes (data, 0), -1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_nal_reader_emulation_prevention)
+{
+  guint8 data[256];
+  guint i, pos = 0, n_epb = 0;
+  guint8 byte;
+
+  /* epb patterns spread over several look-ahead windows, including
+   * consecutive ones and 0x03 bytes which must be kept */
+  for (i = 0; i < 40; i++) {
+    data[pos++] = 0x00;
+    data[pos++] = 0x00;
+    data[pos++] = 0x03;
+    n_epb++;
+    data[pos++] = i % 4;
+    if (i % 3 == 0) {
+      data[pos++] = 0x03;
+      data[pos++] = 0x00;
+    }
+  }
+
+  {
+    NalReader nr;
+    guint expected = 0;
+
+    nal_reader_init (&nr, data, pos);
+    for (i = 0; i < pos; i++) {
+      /* rebuild the expected RBSP on the fly */
+      if (i >= 2 && data[i] == 0x03 && data[i - 1] == 0x00
+          && data[i - 2] == 0x00)
+        continue;
+      fail_unless (nal_reader_get_bits_uint8 (&nr, &byte, 8));
+      assert_equals_int (byte, data[i]);
+      expected++;
+    }
+    fail_if (nal_reader_get_bits_uint8 (&nr, &byte, 8));
+    assert_equals_int (nal_reader_get_epb_count (&nr), n_epb);
+    assert_equals_int (expected + n_epb, pos);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 nalutils_suite (void)
 {
@@ -112,6 +174,8 @@ nalutils_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_nal_writer_init);
   tcase_add_test (tc_chain, test_nal_writer_emulation_preventation);
+  tcase_add_test (tc_chain, test_scan_for_start_codes);
+  tcase_add_test (tc_chain, test_nal_reader_emulation_prevention);
 
   return s;
 }
@@ -5804,6 +5804,390 @@ GST_START_TEST (test_wavparse_master_process_crash)
 
 GST_END_TEST;
 
+/**** buffer passing tests ****/
+
+/* These run the master and the slave pipelines in the same process, with
+ * a test pad pushing buffers into the ipcpipelinesink */
+
+static GstStaticPadTemplate buffer_test_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+/* smaller buffers are always written as bytes */
+#define FD_BUFFER_SIZE (64 * 1024)
+/* shared memory segments the sender recycles */
+#define N_SEGMENTS 8
+
+typedef struct
+{
+  GstElement *master, *slave;
+  GstElement *ipcpipelinesink, *ipcpipelinesrc, *fakesink;
+  GstPad *srcpad;
+  int fds[4];
+  guint n_fds;
+
+  GMutex lock;
+  GCond cond;
+  GQueue received;
+} buffer_test_data;
+
+static void
+buffer_test_handoff (GstElement * fakesink, GstBuffer * buffer, GstPad * pad,
+    buffer_test_data * d)
+{
+  g_mutex_lock (&d->lock);
+  g_queue_push_tail (&d->received, gst_buffer_ref (buffer));
+  g_cond_broadcast (&d->cond);
+  g_mutex_unlock (&d->lock);
+}
+
+static void
+buffer_test_setup (buffer_test_data * d, gboolean use_socket,
+    gboolean pass_fds, guint window_size)
+{
+  GstPad *sinkpad;
+  GstSegment segment;
+  int master_fdin, master_fdout, slave_fdin, slave_fdout;
+
+  memset (d, 0, sizeof (*d));
+  g_mutex_init (&d->lock);
+  g_cond_init (&d->cond);
+  g_queue_init (&d->received);
+
+  if (use_socket) {
+    FAIL_IF (socketpair (AF_UNIX, SOCK_STREAM, 0, d->fds) < 0);
+    d->n_fds = 2;
+    master_fdin = master_fdout = d->fds[0];
+    slave_fdin = slave_fdout = d->fds[1];
+  } else {
+    FAIL_IF (pipe2 (d->fds, O_NONBLOCK) < 0);
+    FAIL_IF (pipe2 (d->fds + 2, O_NONBLOCK) < 0);
+    d->n_fds = 4;
+    master_fdout = d->fds[1];
+    slave_fdin = d->fds[0];
+    slave_fdout = d->fds[3];
+    master_fdin = d->fds[2];
+  }
+
+  d->master = gst_pipeline_new ("master");
+  d->ipcpipelinesink = gst_element_factory_make ("ipcpipelinesink", NULL);
+  g_object_set (d->ipcpipelinesink, "fdin", master_fdin, "fdout",
+      master_fdout, "pass-fds", pass_fds, "window-size", window_size, NULL);
+  gst_bin_add (GST_BIN (d->master), d->ipcpipelinesink);
+
+  d->slave = gst_element_factory_make ("ipcslavepipeline", NULL);
+  d->ipcpipelinesrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  g_object_set (d->ipcpipelinesrc, "fdin", slave_fdin, "fdout", slave_fdout,
+      NULL);
+  d->fakesink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (d->fakesink, "sync", FALSE, "async", FALSE, "signal-handoffs",
+      TRUE, NULL);
+  g_signal_connect (d->fakesink, "handoff", G_CALLBACK (buffer_test_handoff),
+      d);
+  gst_bin_add_many (GST_BIN (d->slave), d->ipcpipelinesrc, d->fakesink, NULL);
+  FAIL_UNLESS (gst_element_link (d->ipcpipelinesrc, d->fakesink));
+
+  d->srcpad = gst_pad_new_from_static_template (&buffer_test_src_template,
+      "src");
+  sinkpad = gst_element_get_static_pad (d->ipcpipelinesink, "sink");
+  FAIL_UNLESS (gst_pad_link (d->srcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (d->srcpad, TRUE);
+
+  FAIL_IF (gst_element_set_state (d->master, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  FAIL_UNLESS (gst_pad_push_event (d->srcpad,
+          gst_event_new_stream_start ("buffer-test")));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  FAIL_UNLESS (gst_pad_push_event (d->srcpad,
+          gst_event_new_segment (&segment)));
+}
+
+static void
+buffer_test_teardown (buffer_test_data * d)
+{
+  guint i;
+
+  gst_pad_set_active (d->srcpad, FALSE);
+  gst_element_set_state (d->master, GST_STATE_NULL);
+  gst_element_set_state (d->slave, GST_STATE_NULL);
+  g_signal_emit_by_name (d->ipcpipelinesink, "disconnect", NULL);
+  g_signal_emit_by_name (d->ipcpipelinesrc, "disconnect", NULL);
+
+  g_queue_clear_full (&d->received, (GDestroyNotify) gst_buffer_unref);
+  gst_object_unref (d->srcpad);
+  gst_object_unref (d->master);
+  gst_object_unref (d->slave);
+  for (i = 0; i < d->n_fds; i++)
+    close (d->fds[i]);
+  g_mutex_clear (&d->lock);
+  g_cond_clear (&d->cond);
+}
+
+static GstFlowReturn
+buffer_test_push (buffer_test_data * d, gsize size, guint8 value)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, size, NULL);
+
+  gst_buffer_memset (buffer, 0, value, size);
+  return gst_pad_push (d->srcpad, buffer);
+}
+
+/* Waits for @n buffers in total to be received */
+static void
+buffer_test_wait_received (buffer_test_data * d, guint n)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&d->lock);
+  while (d->received.length < n) {
+    if (!g_cond_wait_until (&d->cond, &d->lock, end_time))
+      break;
+  }
+  FAIL_UNLESS_EQUALS_INT (d->received.length, n);
+  g_mutex_unlock (&d->lock);
+}
+
+/* Checks the contents of received buffer @idx, and whether it was passed by
+ * file descriptor */
+static void
+buffer_test_check_received (buffer_test_data * d, guint idx, gsize size,
+    guint8 value, gboolean by_fd)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gsize i;
+
+  g_mutex_lock (&d->lock);
+  buffer = g_queue_peek_nth (&d->received, idx);
+  g_mutex_unlock (&d->lock);
+  FAIL_UNLESS (buffer);
+
+  FAIL_UNLESS_EQUALS_INT (gst_memory_is_type (gst_buffer_peek_memory (buffer,
+              0), "fd"), by_fd);
+  FAIL_UNLESS (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  FAIL_UNLESS_EQUALS_INT (map.size, size);
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != value)
+      break;
+  }
+  FAIL_UNLESS (i == map.size);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+buffer_test_release_received (buffer_test_data * d)
+{
+  g_mutex_lock (&d->lock);
+  g_queue_clear_full (&d->received, (GDestroyNotify) gst_buffer_unref);
+  g_mutex_unlock (&d->lock);
+}
+
+/* Only memfd backed segments are passed by fd */
+#ifdef HAVE_MEMFD_CREATE
+GST_START_TEST (test_pass_fds_segments)
+{
+  buffer_test_data d;
+  guint i;
+
+  buffer_test_setup (&d, TRUE, TRUE, 1);
+
+  /* every segment is in use by the receiver, which keeps the buffers */
+  for (i = 0; i < N_SEGMENTS; i++)
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, FD_BUFFER_SIZE, i),
+        GST_FLOW_OK);
+  /* so the next ones fall back to being written as bytes */
+  for (; i < N_SEGMENTS + 2; i++)
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, FD_BUFFER_SIZE, i),
+        GST_FLOW_OK);
+  /* as are small buffers */
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, i), GST_FLOW_OK);
+
+  buffer_test_wait_received (&d, N_SEGMENTS + 3);
+  for (i = 0; i < N_SEGMENTS + 2; i++)
+    buffer_test_check_received (&d, i, FD_BUFFER_SIZE, i, i < N_SEGMENTS);
+  buffer_test_check_received (&d, i, 100, i, FALSE);
+
+  /* releasing the buffers frees the segments. The release reaches the
+   * sender before the result of the next buffer, so that one can be passed
+   * by fd again */
+  buffer_test_release_received (&d);
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 0), GST_FLOW_OK);
+  buffer_test_wait_received (&d, 1);
+  buffer_test_release_received (&d);
+
+  for (i = 0; i < N_SEGMENTS; i++)
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, FD_BUFFER_SIZE, 0x80 + i),
+        GST_FLOW_OK);
+  buffer_test_wait_received (&d, N_SEGMENTS);
+  for (i = 0; i < N_SEGMENTS; i++)
+    buffer_test_check_received (&d, i, FD_BUFFER_SIZE, 0x80 + i, TRUE);
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
+/* Segments are reused over and over if the receiver releases the buffers
+ * right away, which also checks that the receiver does not see data written
+ * for a later use of a segment */
+GST_START_TEST (test_pass_fds_reuse)
+{
+  buffer_test_data d;
+  guint i;
+
+  buffer_test_setup (&d, TRUE, TRUE, 1);
+
+  for (i = 0; i < 4 * N_SEGMENTS; i++) {
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, FD_BUFFER_SIZE, i),
+        GST_FLOW_OK);
+    buffer_test_wait_received (&d, 1);
+    buffer_test_check_received (&d, 0, FD_BUFFER_SIZE, i, TRUE);
+    buffer_test_release_received (&d);
+  }
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+#endif
+
+/* Only unix sockets can pass file descriptors */
+GST_START_TEST (test_pass_fds_pipe)
+{
+  buffer_test_data d;
+  guint i;
+
+  buffer_test_setup (&d, FALSE, TRUE, 1);
+
+  for (i = 0; i < 4; i++)
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, FD_BUFFER_SIZE, i),
+        GST_FLOW_OK);
+  buffer_test_wait_received (&d, 4);
+  for (i = 0; i < 4; i++)
+    buffer_test_check_received (&d, i, FD_BUFFER_SIZE, i, FALSE);
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_window_size)
+{
+  buffer_test_data d;
+  guint i;
+
+  buffer_test_setup (&d, TRUE, FALSE, 4);
+
+  for (i = 0; i < 50; i++)
+    FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 1000 + i, i), GST_FLOW_OK);
+  /* waits for all buffers in flight */
+  FAIL_UNLESS (gst_pad_push_event (d.srcpad, gst_event_new_eos ()));
+  buffer_test_wait_received (&d, 50);
+  for (i = 0; i < 50; i++)
+    buffer_test_check_received (&d, i, 1000 + i, i, FALSE);
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+fail_buffer_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gst_buffer_unref (GST_PAD_PROBE_INFO_BUFFER (info));
+  GST_PAD_PROBE_INFO_FLOW_RETURN (info) = GST_FLOW_ERROR;
+  return GST_PAD_PROBE_HANDLED;
+}
+
+/* A failure is reported to the next buffer after it is known */
+GST_START_TEST (test_window_size_failure)
+{
+  buffer_test_data d;
+  GstPad *pad;
+  GstQuery *query;
+
+  buffer_test_setup (&d, TRUE, FALSE, 4);
+  pad = gst_element_get_static_pad (d.fakesink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, fail_buffer_probe, NULL,
+      NULL);
+  gst_object_unref (pad);
+
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 0), GST_FLOW_OK);
+  /* serialized queries wait for the buffers in flight */
+  query = gst_query_new_drain ();
+  gst_pad_peer_query (d.srcpad, query);
+  gst_query_unref (query);
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 1), GST_FLOW_ERROR);
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
+/* Nothing follows an EOS, so a failure before it is reported by it */
+GST_START_TEST (test_window_size_failure_eos)
+{
+  buffer_test_data d;
+  GstPad *pad;
+  GstBus *bus;
+  GstMessage *msg;
+
+  buffer_test_setup (&d, TRUE, FALSE, 4);
+  pad = gst_element_get_static_pad (d.fakesink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, fail_buffer_probe, NULL,
+      NULL);
+  gst_object_unref (pad);
+
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 0), GST_FLOW_OK);
+  FAIL_IF (gst_pad_push_event (d.srcpad, gst_event_new_eos ()));
+
+  bus = gst_element_get_bus (d.master);
+  msg = gst_bus_timed_pop_filtered (bus, 0, GST_MESSAGE_ERROR);
+  FAIL_UNLESS (msg);
+  FAIL_UNLESS (GST_MESSAGE_SRC (msg) == GST_OBJECT (d.ipcpipelinesink));
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+block_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  return GST_PAD_PROBE_OK;
+}
+
+/* A peer that does not acknowledge buffers anymore does not block the
+ * sender forever */
+GST_START_TEST (test_window_size_timeout)
+{
+  buffer_test_data d;
+  GstPad *pad;
+  gulong probe;
+
+  buffer_test_setup (&d, TRUE, FALSE, 2);
+  g_object_set (d.ipcpipelinesink, "ack-time",
+      (guint64) (100 * G_TIME_SPAN_MILLISECOND), NULL);
+  pad = gst_element_get_static_pad (d.fakesink, "sink");
+  probe = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+      block_probe, NULL, NULL);
+
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 0), GST_FLOW_OK);
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 1), GST_FLOW_OK);
+  /* the window is full, and nothing completes */
+  FAIL_UNLESS_EQUALS_INT (buffer_test_push (&d, 100, 2), GST_FLOW_ERROR);
+
+  gst_pad_remove_probe (pad, probe);
+  gst_object_unref (pad);
+  buffer_test_teardown (&d);
+}
+
+GST_END_TEST;
+
 static Suite *
 ipcpipeline_suite (void)
 {
@@ -6061,6 +6445,20 @@ ipcpipeline_suite (void)
      with the master pipeline. */
   tcase_add_test (tc_chain, test_wavparse_master_process_crash);
 
+  /* buffer passing tests run both pipelines in the same process and check
+     how buffers are passed to the slave */
+  tc_chain = tcase_create ("buffers");
+  suite_add_tcase (s, tc_chain);
+#ifdef HAVE_MEMFD_CREATE
+  tcase_add_test (tc_chain, test_pass_fds_segments);
+  tcase_add_test (tc_chain, test_pass_fds_reuse);
+#endif
+  tcase_add_test (tc_chain, test_pass_fds_pipe);
+  tcase_add_test (tc_chain, test_window_size);
+  tcase_add_test (tc_chain, test_window_size_failure);
+  tcase_add_test (tc_chain, test_window_size_failure_eos);
+  tcase_add_test (tc_chain, test_window_size_timeout);
+
   return s;
 }
 